@@ -6,7 +6,10 @@ CREATE TABLE device_%deviceid_directories (
 CREATE TABLE device_%deviceid_subdirectories (
   directory_id INTEGER NOT NULL,
   path TEXT NOT NULL,
-  mtime INTEGER NOT NULL
+  mtime INTEGER NOT NULL,
+  inode INTEGER NOT NULL DEFAULT 0,
+  child_count INTEGER NOT NULL DEFAULT 0,
+  entries_hash INTEGER NOT NULL DEFAULT 0
 );
 
 CREATE TABLE device_%deviceid_songs (
@@ -0,0 +1,7 @@
+ALTER TABLE %allsubdirectoriestables ADD COLUMN inode INTEGER NOT NULL DEFAULT 0;
+
+ALTER TABLE %allsubdirectoriestables ADD COLUMN child_count INTEGER NOT NULL DEFAULT 0;
+
+ALTER TABLE %allsubdirectoriestables ADD COLUMN entries_hash INTEGER NOT NULL DEFAULT 0;
+
+UPDATE schema_version SET version=19;
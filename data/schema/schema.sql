@@ -4,7 +4,7 @@ CREATE TABLE IF NOT EXISTS schema_version (
 
 DELETE FROM schema_version;
 
-INSERT INTO schema_version (version) VALUES (18);
+INSERT INTO schema_version (version) VALUES (20);
 
 CREATE TABLE IF NOT EXISTS directories (
   path TEXT NOT NULL,
@@ -14,7 +14,10 @@ CREATE TABLE IF NOT EXISTS directories (
 CREATE TABLE IF NOT EXISTS subdirectories (
   directory_id INTEGER NOT NULL,
   path TEXT NOT NULL,
-  mtime INTEGER NOT NULL
+  mtime INTEGER NOT NULL,
+  inode INTEGER NOT NULL DEFAULT 0,
+  child_count INTEGER NOT NULL DEFAULT 0,
+  entries_hash INTEGER NOT NULL DEFAULT 0
 );
 
 CREATE TABLE IF NOT EXISTS songs (
@@ -762,7 +765,9 @@ CREATE TABLE IF NOT EXISTS playlist_items (
   musicbrainz_work_id TEXT,
 
   ebur128_integrated_loudness_lufs REAL,
-  ebur128_loudness_range_lu REAL
+  ebur128_loudness_range_lu REAL,
+
+  position INTEGER NOT NULL DEFAULT 0
 
 );
 
@@ -795,6 +800,8 @@ CREATE INDEX IF NOT EXISTS idx_album ON songs (album);
 
 CREATE INDEX IF NOT EXISTS idx_title ON songs (title);
 
+CREATE INDEX IF NOT EXISTS idx_playlist_items_position ON playlist_items (playlist, position);
+
 CREATE VIEW IF NOT EXISTS duplicated_songs as select artist dup_artist, album dup_album, title dup_title from songs as inner_songs where artist != '' and album != '' and title != '' and unavailable = 0 group by artist, album , title having count(*) > 1;
 
 CREATE VIRTUAL TABLE IF NOT EXISTS songs_fts USING fts5(
@@ -23,6 +23,7 @@
 
 #include <cstring>
 #include <cmath>
+#include <algorithm>
 
 #include <glib.h>
 
@@ -261,17 +262,25 @@ static gboolean gst_fastspectrum_stop(GstBaseTransform *trans) {
 
 // Mixing data readers
 
+// The block is split where it wraps around the ring buffer, so the loops have no modulo and can be vectorized by the compiler.
+template<typename T>
+static void input_data_mixed(const T *in, double *out, guint len, double max_value, guint op, guint nfft) {
+
+  const guint first = std::min(len, nfft - op);
+  for (guint j = 0; j < first; j++) {
+    out[op + j] = in[j] / max_value;
+  }
+  for (guint j = first; j < len; j++) {
+    out[j - first] = in[j] / max_value;
+  }
+
+}
+
 static void input_data_mixed_float(const guint8 *_in, double *out, guint len, double max_value, guint op, guint nfft) {
 
   Q_UNUSED(max_value);
 
-  const gfloat *in = reinterpret_cast<const gfloat*>(_in);
-  guint ip = 0;
-
-  for (guint j = 0; j < len; j++) {
-    out[op] = in[ip++];
-    op = (op + 1) % nfft;
-  }
+  input_data_mixed(reinterpret_cast<const gfloat*>(_in), out, len, 1.0, op, nfft);
 
 }
 
@@ -279,25 +288,13 @@ static void input_data_mixed_double(const guint8 *_in, double *out, guint len, d
 
   Q_UNUSED(max_value);
 
-  const gdouble *in = reinterpret_cast<const gdouble*>(_in);
-  guint ip = 0;
-
-  for (guint j = 0; j < len; j++) {
-    out[op] = in[ip++];
-    op = (op + 1) % nfft;
-  }
+  input_data_mixed(reinterpret_cast<const gdouble*>(_in), out, len, 1.0, op, nfft);
 
 }
 
 static void input_data_mixed_int32_max(const guint8 *_in, double *out, guint len, double max_value, guint op, guint nfft) {
 
-  const gint32 *in = reinterpret_cast<const gint32*>(_in);
-  guint ip = 0;
-
-  for (guint j = 0; j < len; j++) {
-    out[op] = in[ip++] / max_value;
-    op = (op + 1) % nfft;
-  }
+  input_data_mixed(reinterpret_cast<const gint32*>(_in), out, len, max_value, op, nfft);
 
 }
 
@@ -314,7 +311,7 @@ static void input_data_mixed_int24_max(const guint8 *_in, double *out, guint len
     }
 
     out[op] = value / max_value;
-    op = (op + 1) % nfft;
+    if (++op == nfft) op = 0;
     _in += 3;
   }
 
@@ -322,13 +319,7 @@ static void input_data_mixed_int24_max(const guint8 *_in, double *out, guint len
 
 static void input_data_mixed_int16_max(const guint8 *_in, double *out, guint len, double max_value, guint op, guint nfft) {
 
-  const gint16 *in = reinterpret_cast<const gint16*>(_in);
-  guint ip = 0;
-
-  for (guint j = 0; j < len; j++) {
-    out[op] = in[ip++] / max_value;
-    op = (op + 1) % nfft;
-  }
+  input_data_mixed(reinterpret_cast<const gint16*>(_in), out, len, max_value, op, nfft);
 
 }
 
@@ -372,19 +363,19 @@ static void gst_fastspectrum_run_fft(GstFastSpectrum *spectrum, guint input_pos)
   guint bands = spectrum->bands;
   guint nfft = 2 * bands - 2;
 
-  for (guint i = 0; i < nfft; i++) {
-    spectrum->fft_input[i] = spectrum->input_ring_buffer[(input_pos + i) % nfft];
-  }
+  // The oldest sample is at input_pos, copy the ring buffer in two parts instead of wrapping every index.
+  std::copy(spectrum->input_ring_buffer + input_pos, spectrum->input_ring_buffer + nfft, spectrum->fft_input);
+  std::copy(spectrum->input_ring_buffer, spectrum->input_ring_buffer + input_pos, spectrum->fft_input + (nfft - input_pos));
 
   // Should be safe to execute the same plan multiple times in parallel.
   fftw_execute(spectrum->plan);
 
   // Calculate magnitude in db
+  const gdouble scale = 1.0 / (static_cast<gdouble>(nfft) * static_cast<gdouble>(nfft));
   for (guint i = 0; i < bands; i++) {
     gdouble val = spectrum->fft_output[i][0] * spectrum->fft_output[i][0];
     val += spectrum->fft_output[i][1] * spectrum->fft_output[i][1];
-    val /= nfft * nfft;
-    spectrum->spect_magnitude[i] += val;
+    spectrum->spect_magnitude[i] += val * scale;
   }
 
 }
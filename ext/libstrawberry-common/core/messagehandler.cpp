@@ -17,14 +17,26 @@
 
 #include "messagehandler.h"
 
+#include <cstring>
+
 #include <QObject>
 #include <QAbstractSocket>
 #include <QDataStream>
 #include <QIODevice>
 #include <QLocalSocket>
+#include <QSharedMemory>
 #include <QByteArray>
 
 #include "core/logging.h"
+#include "core/sharedmemoryring.h"
+
+namespace {
+// Set in the length of a frame that refers to a message in the shared memory instead of carrying it.
+constexpr quint32 kSharedMemoryReferenceFlag = 0x80000000;
+constexpr quint32 kSharedMemoryReferenceLength = 3 * sizeof(quint32);
+}  // namespace
+
+const int _MessageHandlerBase::kSharedMemoryThreshold = 64 * 1024;
 
 _MessageHandlerBase::_MessageHandlerBase(QIODevice *device, QObject *parent)
     : QObject(parent),
@@ -32,8 +44,12 @@ _MessageHandlerBase::_MessageHandlerBase(QIODevice *device, QObject *parent)
       flush_abstract_socket_(nullptr),
       flush_local_socket_(nullptr),
       reading_protobuf_(false),
+      reading_shared_memory_reference_(false),
       expected_length_(0),
-      is_device_closed_(false) {
+      is_device_closed_(false),
+      shared_memory_(nullptr),
+      send_ring_(nullptr),
+      receive_ring_(nullptr) {
   if (device) {
     SetDevice(device);
   }
@@ -62,6 +78,30 @@ void _MessageHandlerBase::SetDevice(QIODevice *device) {
 
 }
 
+_MessageHandlerBase::~_MessageHandlerBase() {
+
+  delete send_ring_;
+  delete receive_ring_;
+
+}
+
+void _MessageHandlerBase::SetSharedMemory(QSharedMemory *shared_memory, const bool worker_side) {
+
+  delete send_ring_;
+  delete receive_ring_;
+  send_ring_ = nullptr;
+
+  shared_memory_ = shared_memory;
+  receive_ring_ = new SharedMemoryRing(shared_memory, worker_side ? 0 : 1);
+
+  if (worker_side) {
+    send_ring_ = new SharedMemoryRing(shared_memory, 1);
+    // An empty reference tells the pool side that we are attached.
+    WriteSharedMemoryReference(0, 0, 0);
+  }
+
+}
+
 void _MessageHandlerBase::DeviceReadyRead() {
 
   while (device_->bytesAvailable() > 0) {
@@ -70,6 +110,11 @@ void _MessageHandlerBase::DeviceReadyRead() {
       QDataStream s(device_);
       s >> expected_length_;
 
+      reading_shared_memory_reference_ = (expected_length_ & kSharedMemoryReferenceFlag) != 0;
+      if (reading_shared_memory_reference_) {
+        expected_length_ &= ~kSharedMemoryReferenceFlag;
+      }
+
       reading_protobuf_ = true;
     }
 
@@ -79,7 +124,35 @@ void _MessageHandlerBase::DeviceReadyRead() {
     // Did we get everything?
     if (buffer_.size() == expected_length_) {
       // Parse the message
-      if (!RawMessageArrived(buffer_.data())) {
+      if (reading_shared_memory_reference_) {
+        quint32 position = 0;
+        quint32 size = 0;
+        quint32 advance = 0;
+        QDataStream s(buffer_.data());
+        s >> position >> size >> advance;
+        if (!receive_ring_ || expected_length_ != kSharedMemoryReferenceLength) {
+          qLog(Error) << "Unexpected shared memory message";
+          device_->close();
+          return;
+        }
+        if (size == 0) {
+          // The worker has attached to the shared memory.
+          if (!send_ring_ && shared_memory_) {
+            send_ring_ = new SharedMemoryRing(shared_memory_, 0);
+          }
+        }
+        else {
+          // Parse the message right from the shared memory, and give the space back afterwards.
+          const bool success = RawMessageArrived(QByteArray::fromRawData(receive_ring_->Data(position), static_cast<int>(size)));
+          receive_ring_->Release(advance);
+          if (!success) {
+            qLog(Error) << "Malformed protobuf message";
+            device_->close();
+            return;
+          }
+        }
+      }
+      else if (!RawMessageArrived(buffer_.data())) {
         qLog(Error) << "Malformed protobuf message";
         device_->close();
         return;
@@ -97,6 +170,17 @@ void _MessageHandlerBase::DeviceReadyRead() {
 
 void _MessageHandlerBase::WriteMessage(const QByteArray &data) {
 
+  if (data.length() >= kSharedMemoryThreshold) {
+    quint32 position = 0;
+    quint32 advance = 0;
+    char *shared_data = ReserveSharedMemory(data.length(), &position, &advance);
+    if (shared_data) {
+      memcpy(shared_data, data.constData(), static_cast<size_t>(data.length()));
+      WriteSharedMemoryReference(position, static_cast<quint32>(data.length()), advance);
+      return;
+    }
+  }
+
   QDataStream s(device_);
   s << static_cast<quint32>(data.length());
   s.writeRawData(data.data(), static_cast<int>(data.length()));
@@ -111,6 +195,31 @@ void _MessageHandlerBase::WriteMessage(const QByteArray &data) {
 
 }
 
+char *_MessageHandlerBase::ReserveSharedMemory(const qint64 size, quint32 *position, quint32 *advance) {
+
+  if (!send_ring_ || size > static_cast<qint64>(~kSharedMemoryReferenceFlag)) return nullptr;
+
+  return send_ring_->Reserve(static_cast<quint32>(size), position, advance);
+
+}
+
+void _MessageHandlerBase::WriteSharedMemoryReference(const quint32 position, const quint32 size, const quint32 advance) {
+
+  send_ring_->Commit(advance);
+
+  QDataStream s(device_);
+  s << (kSharedMemoryReferenceLength | kSharedMemoryReferenceFlag);
+  s << position << size << advance;
+
+  if (flush_abstract_socket_) {
+    ((qobject_cast<QAbstractSocket*>(device_))->*(flush_abstract_socket_))();
+  }
+  else if (flush_local_socket_) {
+    ((qobject_cast<QLocalSocket*>(device_))->*(flush_local_socket_))();
+  }
+
+}
+
 void _MessageHandlerBase::DeviceClosed() {
   is_device_closed_ = true;
   AbortAll();
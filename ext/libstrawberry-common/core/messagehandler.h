@@ -28,12 +28,15 @@
 #include <QByteArray>
 #include <QMap>
 #include <QString>
+#include <QElapsedTimer>
 #include <QLocalSocket>
 #include <QAbstractSocket>
 
 #include "core/messagereply.h"
+#include "core/sharedmemoryring.h"
 
 class QIODevice;
+class QSharedMemory;
 
 // Reads and writes uint32 length encoded protobufs to a socket.
 // This base QObject is separate from AbstractMessageHandler because moc can't handle templated classes.
@@ -44,12 +47,27 @@ class _MessageHandlerBase : public QObject {
  public:
   // device can be nullptr, in which case you must call SetDevice before writing any messages.
   _MessageHandlerBase(QIODevice *device, QObject *parent);
+  ~_MessageHandlerBase() override;
 
   void SetDevice(QIODevice *device);
 
+  // Sends messages of kSharedMemoryThreshold bytes or more through the shared memory segment instead of the device, when there is room.
+  // The pool side uses the first half of the segment for sending, the worker side the second half.
+  // The worker side tells the pool side that it has attached to the segment, the pool side doesn't send anything through it before that.
+  void SetSharedMemory(QSharedMemory *shared_memory, const bool worker_side);
+
   // After this is true, messages cannot be sent to the handler any more.
   bool is_device_closed() const { return is_device_closed_; }
 
+  // True when large messages are sent through the shared memory.
+  bool is_shared_memory_attached() const { return send_ring_ != nullptr; }
+
+  static const int kSharedMemoryThreshold;
+
+ signals:
+  // Emitted on the handler's thread when a request got its final reply or was aborted, so another request can be sent.
+  void RequestFinished();
+
  protected slots:
   void WriteMessage(const QByteArray &data);
   void DeviceReadyRead();
@@ -59,6 +77,11 @@ class _MessageHandlerBase : public QObject {
   virtual bool RawMessageArrived(const QByteArray &data) = 0;
   virtual void AbortAll() = 0;
 
+  // Returns where to write a message of size bytes in the shared memory, or nullptr if it should be sent through the device.
+  char *ReserveSharedMemory(const qint64 size, quint32 *position, quint32 *advance);
+  // Tells the other side to read the message written to the reserved shared memory.
+  void WriteSharedMemoryReference(const quint32 position, const quint32 size, const quint32 advance);
+
  protected:
   typedef bool (QAbstractSocket::*FlushAbstractSocket)();
   typedef bool (QLocalSocket::*FlushLocalSocket)();
@@ -68,10 +91,15 @@ class _MessageHandlerBase : public QObject {
   FlushLocalSocket flush_local_socket_;
 
   bool reading_protobuf_;
+  bool reading_shared_memory_reference_;
   quint32 expected_length_;
   QBuffer buffer_;
 
   bool is_device_closed_;
+
+  QSharedMemory *shared_memory_;
+  SharedMemoryRing *send_ring_;
+  SharedMemoryRing *receive_ring_;
 };
 
 // Reads and writes uint32 length encoded MessageType messages to a socket.
@@ -100,26 +128,62 @@ class AbstractMessageHandler : public _MessageHandlerBase {
   // Sets the "id" field of reply to the same as the request, and sends the reply on the socket.  Used on the worker side.
   void SendReply(const MessageType &request, MessageType *reply);
 
+  // Number of requests that are waiting for their final reply.
+  int pending_replies_count() const { return pending_replies_.count(); }
+
+  // Number of requests answered, and the total and highest time in milliseconds from sending a request until its final reply.
+  qint64 replies_count() const { return replies_count_; }
+  qint64 total_latency() const { return total_latency_; }
+  qint64 max_latency() const { return max_latency_; }
+
  protected:
   // Called when a message is received from the socket.
   virtual void MessageArrived(const MessageType &message) { Q_UNUSED(message); }
 
+  // Return true if the message is one of several replies to the same request, and more will follow.
+  virtual bool IsPartialReply(const MessageType &message) const { Q_UNUSED(message); return false; }
+
   // _MessageHandlerBase
   bool RawMessageArrived(const QByteArray &data) override;
   void AbortAll() override;
 
  private:
   QMap<int, ReplyType*> pending_replies_;
+
+  QElapsedTimer latency_timer_;
+  QMap<int, qint64> request_sent_time_;
+  qint64 replies_count_;
+  qint64 total_latency_;
+  qint64 max_latency_;
 };
 
 template<typename MT>
 AbstractMessageHandler<MT>::AbstractMessageHandler(QIODevice *device, QObject *parent)
-    : _MessageHandlerBase(device, parent) {}
+    : _MessageHandlerBase(device, parent),
+      replies_count_(0),
+      total_latency_(0),
+      max_latency_(0) {
+
+  latency_timer_.start();
+
+}
 
 template<typename MT>
 void AbstractMessageHandler<MT>::SendMessage(const MessageType &message) {
   Q_ASSERT(QThread::currentThread() == thread());
 
+  // Serialize large messages straight into the shared memory.
+  const qint64 size = static_cast<qint64>(message.ByteSizeLong());
+  if (size >= kSharedMemoryThreshold) {
+    quint32 position = 0;
+    quint32 advance = 0;
+    char *shared_data = ReserveSharedMemory(size, &position, &advance);
+    if (shared_data && message.SerializeToArray(shared_data, static_cast<int>(size))) {
+      WriteSharedMemoryReference(position, static_cast<quint32>(size), advance);
+      return;
+    }
+  }
+
   std::string data = message.SerializeAsString();
   WriteMessage(QByteArray(data.data(), data.size()));
 }
@@ -133,6 +197,7 @@ void AbstractMessageHandler<MT>::SendMessageAsync(const MessageType &message) {
 template<typename MT>
 void AbstractMessageHandler<MT>::SendRequest(ReplyType *reply) {
   pending_replies_[reply->id()] = reply;
+  request_sent_time_[reply->id()] = latency_timer_.elapsed();
   SendMessage(reply->request_message());
 }
 
@@ -152,8 +217,18 @@ bool AbstractMessageHandler<MT>::RawMessageArrived(const QByteArray &data) {
 
   if (pending_replies_.contains(message.id())) {
     // This is a reply to a message that we created earlier.
-    ReplyType *reply = pending_replies_.take(message.id());
-    reply->SetReply(message);
+    if (IsPartialReply(message)) {
+      pending_replies_[message.id()]->SetPartialReply(message);
+    }
+    else {
+      ReplyType *reply = pending_replies_.take(message.id());
+      const qint64 latency = latency_timer_.elapsed() - request_sent_time_.take(message.id());
+      ++replies_count_;
+      total_latency_ += latency;
+      max_latency_ = qMax(max_latency_, latency);
+      reply->SetReply(message);
+      emit RequestFinished();
+    }
   }
   else {
     MessageArrived(message);
@@ -166,10 +241,15 @@ bool AbstractMessageHandler<MT>::RawMessageArrived(const QByteArray &data) {
 template<typename MT>
 void AbstractMessageHandler<MT>::AbortAll() {
 
+  if (pending_replies_.isEmpty()) return;
+
   for (ReplyType *reply : pending_replies_) {
     reply->Abort();
   }
   pending_replies_.clear();
+  request_sent_time_.clear();
+
+  emit RequestFinished();
 
 }
 
@@ -19,6 +19,7 @@
 #include "messagereply.h"
 
 #include <QObject>
+#include <QMutexLocker>
 #include <QtDebug>
 
 #include "core/logging.h"
@@ -38,8 +39,12 @@ bool _MessageReplyBase::WaitForFinished() {
 void _MessageReplyBase::Abort() {
 
   Q_ASSERT(!finished_);
-  finished_ = true;
-  success_ = false;
+  {
+    QMutexLocker l(&replies_mutex_);
+    finished_ = true;
+    success_ = false;
+    replies_condition_.wakeAll();
+  }
 
   emit Finished();
   qLog(Debug) << "Releasing ID" << id() << "(aborted)";
@@ -21,6 +21,9 @@
 
 #include <QtGlobal>
 #include <QObject>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
 #include <QSemaphore>
 #include <QString>
 #include <QTimer>
@@ -47,12 +50,18 @@ class _MessageReplyBase : public QObject {
 
  signals:
   void Finished();
+  // Emitted for each partial reply of a request that is answered with more than one message.
+  void PartialReplyArrived();
 
  protected:
   bool finished_;
   bool success_;
 
   QSemaphore semaphore_;
+
+  // Protects the partial replies, and wakes up WaitForNextReplies().
+  QMutex replies_mutex_;
+  QWaitCondition replies_condition_;
 };
 
 // A reply future class that is returned immediately for requests that will occur in the background.  Similar to QNetworkReply.
@@ -66,15 +75,23 @@ class MessageReply : public _MessageReplyBase {
   const MessageType &message() const { return reply_message_; }
 
   void SetReply(const MessageType &message);
+  void SetPartialReply(const MessageType &message);
+
+  // Waits until partial replies or the final reply arrive, and moves them to messages.
+  // Returns false when the reply is finished and there is nothing more to take.  Never call this from the MessageHandler's thread.
+  bool WaitForNextReplies(QList<MessageType> *messages);
 
  private:
   MessageType request_message_;
   MessageType reply_message_;
+
+  QList<MessageType> partial_replies_;
+  bool reply_taken_;
 };
 
 
 template<typename MessageType>
-MessageReply<MessageType>::MessageReply(const MessageType &request_message, QObject *parent) : _MessageReplyBase(parent) {
+MessageReply<MessageType>::MessageReply(const MessageType &request_message, QObject *parent) : _MessageReplyBase(parent), reply_taken_(false) {
   request_message_.MergeFrom(request_message);
 }
 
@@ -83,9 +100,13 @@ void MessageReply<MessageType>::SetReply(const MessageType &message) {
 
   Q_ASSERT(!finished_);
 
-  reply_message_.MergeFrom(message);
-  finished_ = true;
-  success_ = true;
+  {
+    QMutexLocker l(&replies_mutex_);
+    reply_message_.MergeFrom(message);
+    finished_ = true;
+    success_ = true;
+    replies_condition_.wakeAll();
+  }
 
   qLog(Debug) << "Releasing ID" << id() << "(finished)";
 
@@ -96,4 +117,40 @@ void MessageReply<MessageType>::SetReply(const MessageType &message) {
 
 }
 
+template<typename MessageType>
+void MessageReply<MessageType>::SetPartialReply(const MessageType &message) {
+
+  Q_ASSERT(!finished_);
+
+  {
+    QMutexLocker l(&replies_mutex_);
+    partial_replies_ << message;
+    replies_condition_.wakeAll();
+  }
+
+  QTimer::singleShot(0, this, &_MessageReplyBase::PartialReplyArrived);
+
+}
+
+template<typename MessageType>
+bool MessageReply<MessageType>::WaitForNextReplies(QList<MessageType> *messages) {
+
+  QMutexLocker l(&replies_mutex_);
+
+  while (partial_replies_.isEmpty() && !finished_) {
+    replies_condition_.wait(&replies_mutex_);
+  }
+
+  *messages = partial_replies_;
+  partial_replies_.clear();
+
+  if (finished_ && success_ && !reply_taken_) {
+    *messages << reply_message_;
+    reply_taken_ = true;
+  }
+
+  return !messages->isEmpty();
+
+}
+
 #endif  // MESSAGEREPLY_H
@@ -0,0 +1,84 @@
+/* This file is part of Strawberry.
+   Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "sharedmemoryring.h"
+
+#include <cstring>
+
+#include <QtGlobal>
+#include <QSharedMemory>
+
+const qint64 SharedMemoryRing::kSegmentSize = 16 * 1024 * 1024;
+
+SharedMemoryRing::SharedMemoryRing(QSharedMemory *shared_memory, const int half)
+    : shared_memory_(shared_memory),
+      offset_(half * (kSegmentSize / 2)),
+      capacity_(static_cast<quint32>(kSegmentSize / 2 - static_cast<qint64>(sizeof(Header)))),
+      write_position_(0) {}
+
+void SharedMemoryRing::Initialize(QSharedMemory *shared_memory) {
+
+  shared_memory->lock();
+  memset(static_cast<char*>(shared_memory->data()), 0, sizeof(Header));
+  memset(static_cast<char*>(shared_memory->data()) + kSegmentSize / 2, 0, sizeof(Header));
+  shared_memory->unlock();
+
+}
+
+SharedMemoryRing::Header *SharedMemoryRing::header() const {
+  return reinterpret_cast<Header*>(static_cast<char*>(shared_memory_->data()) + offset_);
+}
+
+char *SharedMemoryRing::data() const {
+  return static_cast<char*>(shared_memory_->data()) + offset_ + sizeof(Header);
+}
+
+char *SharedMemoryRing::Reserve(const quint32 size, quint32 *position, quint32 *advance) const {
+
+  if (size > capacity_) return nullptr;
+
+  shared_memory_->lock();
+  const quint64 read_position = header()->read_position;
+  shared_memory_->unlock();
+
+  // Messages are never split, skip the end of the ring if the message doesn't fit there.
+  const quint32 write_offset = static_cast<quint32>(write_position_ % capacity_);
+  const quint32 padding = write_offset + size > capacity_ ? capacity_ - write_offset : 0;
+  const quint64 used = write_position_ - read_position;
+  if (used + padding + size > capacity_) return nullptr;
+
+  *position = padding > 0 ? 0 : write_offset;
+  *advance = padding + size;
+
+  return data() + *position;
+
+}
+
+void SharedMemoryRing::Commit(const quint32 advance) {
+  write_position_ += advance;
+}
+
+const char *SharedMemoryRing::Data(const quint32 position) const {
+  return data() + position;
+}
+
+void SharedMemoryRing::Release(const quint32 advance) {
+
+  shared_memory_->lock();
+  header()->read_position += advance;
+  shared_memory_->unlock();
+
+}
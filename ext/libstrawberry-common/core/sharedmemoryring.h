@@ -0,0 +1,60 @@
+/* This file is part of Strawberry.
+   Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SHAREDMEMORYRING_H
+#define SHAREDMEMORYRING_H
+
+#include <QtGlobal>
+
+class QSharedMemory;
+
+// A ring buffer in one half of a shared memory segment, written by one process and read by the other.
+// The writer tells the reader where a message is through the local socket, and messages are read in the order they were written.
+// Only the read position is stored in the segment, the writer keeps its own write position.
+class SharedMemoryRing {
+ public:
+  explicit SharedMemoryRing(QSharedMemory *shared_memory, const int half);
+
+  // Total size of a segment holding the rings for both directions.
+  static const qint64 kSegmentSize;
+
+  // Clears both rings in a newly created segment.
+  static void Initialize(QSharedMemory *shared_memory);
+
+  // Returns a pointer to size contiguous bytes, or nullptr if the ring is too full.
+  // Nothing is changed until Commit() is called with the returned advance.
+  char *Reserve(const quint32 size, quint32 *position, quint32 *advance) const;
+  void Commit(const quint32 advance);
+
+  const char *Data(const quint32 position) const;
+  // Frees the space of a message that has been read.
+  void Release(const quint32 advance);
+
+ private:
+  struct Header {
+    quint64 read_position;
+  };
+
+  Header *header() const;
+  char *data() const;
+
+  QSharedMemory *shared_memory_;
+  qint64 offset_;
+  quint32 capacity_;
+  quint64 write_position_;
+};
+
+#endif  // SHAREDMEMORYRING_H
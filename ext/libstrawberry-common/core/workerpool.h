@@ -29,7 +29,10 @@
 #include <QCoreApplication>
 #include <QThread>
 #include <QMutex>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <QLocalServer>
+#include <QSharedMemory>
 #include <QProcess>
 #include <QDir>
 #include <QFile>
@@ -41,6 +44,7 @@
 #include <QRandomGenerator>
 
 #include "core/logging.h"
+#include "core/sharedmemoryring.h"
 
 class QLocalSocket;
 
@@ -51,6 +55,14 @@ class _WorkerPoolBase : public QObject {
  public:
   explicit _WorkerPoolBase(QObject *parent = nullptr);
 
+  struct WorkerStatistics {
+    WorkerStatistics() : pending_requests(0), replies(0), average_latency(0), max_latency(0) {}
+    int pending_requests;
+    qint64 replies;
+    qint64 average_latency;
+    qint64 max_latency;
+  };
+
  signals:
   // Emitted when a worker failed to start.  This usually happens when the worker wasn't found, or couldn't be executed.
   void WorkerFailedToStart();
@@ -62,13 +74,17 @@ class _WorkerPoolBase : public QObject {
   virtual void ProcessReadyReadStandardError() {}
   virtual void ProcessError(QProcess::ProcessError) {}
   virtual void SendQueuedMessages() {}
+  virtual void StopIdleWorkers() {}
 };
 
 
 // Manages a pool of one or more external processes.
 // A local socket server is started for each process, and the address is passed to the process as argv[1].
 // The process is expected to connect back to the socket server, and when it does a HandlerType is created for it.
+// A shared memory segment is also created for each process, and its key is passed as argv[2].  Large messages go through it instead of the socket.
 // Instances of HandlerType are created in the WorkerPool's thread.
+// Requests go to the worker with the fewest pending requests, and each worker only gets a few at a time so that a slow request doesn't hold up the rest.
+// More workers are started when all of them are busy, up to the maximum worker count, and stopped again when they have been idle for a while.
 template<typename HandlerType>
 class WorkerPool : public _WorkerPoolBase {
  public:
@@ -85,6 +101,10 @@ class WorkerPool : public _WorkerPoolBase {
   // Sets the number of worker process to use.  Defaults to 1 <= (processors / 2) <= 2.
   void SetWorkerCount(const int count);
 
+  // Sets the number of worker processes that can be started when all workers are busy.  Defaults to worker count <= processors <= 4.
+  // The worker count is lowered if it is higher.
+  void SetMaxWorkerCount(const int count);
+
   // Sets the prefix to use for the local server (on unix this is a named pipe in /tmp).
   // Defaults to QApplication::applicationName().
   // A random number is appended to this name when creating each server.
@@ -98,6 +118,11 @@ class WorkerPool : public _WorkerPoolBase {
   // Can be called from any thread.
   ReplyType *SendMessageWithReply(MessageType *message);
 
+  // Returns the number of requests waiting for a worker, and the statistics of each worker as of the last request sent or answered.
+  // Can be called from any thread.
+  int QueuedRequests();
+  QList<WorkerStatistics> Statistics() const;
+
  protected:
   // These are all reimplemented slots, they are called on the WorkerPool's thread.
   void DoStart() override;
@@ -106,19 +131,33 @@ class WorkerPool : public _WorkerPoolBase {
   void ProcessReadyReadStandardError() override;
   void ProcessError(QProcess::ProcessError error) override;
   void SendQueuedMessages() override;
+  void StopIdleWorkers() override;
 
  private:
   struct Worker {
-    Worker() : local_server_(nullptr), local_socket_(nullptr), process_(nullptr), handler_(nullptr) {}
+    Worker() : local_server_(nullptr), local_socket_(nullptr), process_(nullptr), shared_memory_(nullptr), handler_(nullptr), last_request_time_(0) {}
 
     QLocalServer *local_server_;
     QLocalSocket *local_socket_;
     QProcess *process_;
+    QSharedMemory *shared_memory_;
     HandlerType *handler_;
+    qint64 last_request_time_;
   };
 
+  // Maximum number of requests sent to a worker before it has replied to them, the rest wait in the message queue.
+  static constexpr int kMaxPendingRequests = 4;
+  // Workers above the worker count are stopped after being idle for this long, in milliseconds.
+  static constexpr int kIdleWorkerTimeout = 30000;
+
   // Must only ever be called on my thread.
   void StartOneWorker(Worker *worker);
+  void StopOneWorker(Worker *worker);
+
+  // Starts another worker if all workers are connected and there are less than the maximum number.  Must be called from my thread.
+  void StartExtraWorker();
+
+  void UpdateStatistics();
 
   template<typename T>
   Worker *FindWorker(T Worker::*member, T value) {
@@ -142,8 +181,8 @@ class WorkerPool : public _WorkerPoolBase {
   // and sets the request's ID to the ID of the reply.  Can be called from any thread
   ReplyType *NewReply(MessageType *message);
 
-  // Returns the next handler, or nullptr if there isn't one.  Must be called from my thread.
-  HandlerType *NextHandler() const;
+  // Returns the connected worker with the fewest pending requests, or nullptr if all of them are busy.  Must be called from my thread.
+  Worker *NextWorker();
 
  private:
   QString local_server_name_;
@@ -151,21 +190,30 @@ class WorkerPool : public _WorkerPoolBase {
   QString executable_path_;
 
   int worker_count_;
-  mutable int next_worker_;
+  int max_worker_count_;
+  int next_worker_;
   QList<Worker> workers_;
 
+  QTimer *idle_workers_timer_;
+  QElapsedTimer clock_;
+
   QAtomicInt next_id_;
 
   QMutex message_queue_mutex_;
   QQueue<ReplyType *> message_queue_;
+
+  mutable QMutex statistics_mutex_;
+  QList<WorkerStatistics> statistics_;
 };
 
 
 template<typename HandlerType>
 WorkerPool<HandlerType>::WorkerPool(QObject *parent)
     : _WorkerPoolBase(parent),
-      worker_count_(1),
+      worker_count_(qBound(1, QThread::idealThreadCount() / 2, 2)),
+      max_worker_count_(qBound(worker_count_, QThread::idealThreadCount(), 4)),
       next_worker_(0),
+      idle_workers_timer_(new QTimer(this)),
       next_id_(0) {
 
   local_server_name_ = qApp->applicationName().toLower();
@@ -174,6 +222,11 @@ WorkerPool<HandlerType>::WorkerPool(QObject *parent)
     local_server_name_ = "workerpool";
   }
 
+  idle_workers_timer_->setInterval(kIdleWorkerTimeout);
+  QObject::connect(idle_workers_timer_, &QTimer::timeout, this, &WorkerPool::StopIdleWorkers);
+
+  clock_.start();
+
 }
 
 template<typename HandlerType>
@@ -210,7 +263,15 @@ WorkerPool<HandlerType>::~WorkerPool() {
 template<typename HandlerType>
 void WorkerPool<HandlerType>::SetWorkerCount(const int count) {
   Q_ASSERT(workers_.isEmpty());
-  worker_count_ = count;
+  worker_count_ = qMax(1, count);
+  max_worker_count_ = qMax(max_worker_count_, worker_count_);
+}
+
+template<typename HandlerType>
+void WorkerPool<HandlerType>::SetMaxWorkerCount(const int count) {
+  Q_ASSERT(workers_.isEmpty());
+  max_worker_count_ = qMax(1, count);
+  worker_count_ = qMin(worker_count_, max_worker_count_);
 }
 
 template<typename HandlerType>
@@ -282,6 +343,7 @@ void WorkerPool<HandlerType>::StartOneWorker(Worker *worker) {
   DeleteQObjectPointerLater(&worker->local_socket_);
   DeleteQObjectPointerLater(&worker->process_);
   DeleteQObjectPointerLater(&worker->handler_);
+  DeleteQObjectPointerLater(&worker->shared_memory_);
 
   worker->local_server_ = new QLocalServer(this);
   worker->process_ = new QProcess(this);
@@ -301,6 +363,20 @@ void WorkerPool<HandlerType>::StartOneWorker(Worker *worker) {
     }
   }
 
+  QStringList arguments = QStringList() << worker->local_server_->fullServerName();
+
+  // The shared memory is optional, the socket is used for everything if it can't be created.
+  worker->shared_memory_ = new QSharedMemory(this);
+  worker->shared_memory_->setKey(worker->local_server_->serverName() + "_shm");
+  if (worker->shared_memory_->create(SharedMemoryRing::kSegmentSize)) {
+    SharedMemoryRing::Initialize(worker->shared_memory_);
+    arguments << worker->shared_memory_->key();
+  }
+  else {
+    qLog(Warning) << "Could not create shared memory for worker" << worker << worker->shared_memory_->errorString();
+    DeleteQObjectPointerLater(&worker->shared_memory_);
+  }
+
   qLog(Debug) << "Starting worker" << worker << executable_path_ << worker->local_server_->fullServerName();
 
 #ifdef Q_OS_WIN32
@@ -309,7 +385,86 @@ void WorkerPool<HandlerType>::StartOneWorker(Worker *worker) {
   worker->process_->setProcessChannelMode(QProcess::ForwardedChannels);
 #endif
 
-  worker->process_->start(executable_path_, QStringList() << worker->local_server_->fullServerName());
+  worker->process_->start(executable_path_, arguments);
+}
+
+template<typename HandlerType>
+void WorkerPool<HandlerType>::StopOneWorker(Worker *worker) {
+
+  Q_ASSERT(QThread::currentThread() == thread());
+
+  qLog(Debug) << "Stopping idle worker" << worker;
+
+  // The worker exits when its socket is closed, so it is not an error when the process finishes.
+  if (worker->process_) {
+    QObject::disconnect(worker->process_, nullptr, this, nullptr);
+    QObject::connect(worker->process_, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), worker->process_, &QProcess::deleteLater);
+    worker->process_ = nullptr;
+  }
+  if (worker->local_socket_) {
+    worker->local_socket_->close();
+  }
+
+  DeleteQObjectPointerLater(&worker->local_server_);
+  DeleteQObjectPointerLater(&worker->local_socket_);
+  DeleteQObjectPointerLater(&worker->handler_);
+  DeleteQObjectPointerLater(&worker->shared_memory_);
+
+}
+
+template<typename HandlerType>
+void WorkerPool<HandlerType>::StartExtraWorker() {
+
+  Q_ASSERT(QThread::currentThread() == thread());
+
+  if (workers_.isEmpty() || workers_.count() >= max_worker_count_) return;
+
+  // Wait for the workers already started to connect first.
+  for (const Worker &worker : workers_) {
+    if (!worker.handler_) return;
+  }
+
+  qLog(Debug) << "All" << workers_.count() << "workers are busy, starting another one";
+
+  Worker worker;
+  StartOneWorker(&worker);
+  worker.last_request_time_ = clock_.elapsed();
+  workers_ << worker;
+
+  if (!idle_workers_timer_->isActive()) {
+    idle_workers_timer_->start();
+  }
+
+}
+
+template<typename HandlerType>
+void WorkerPool<HandlerType>::StopIdleWorkers() {
+
+  Q_ASSERT(QThread::currentThread() == thread());
+
+  {
+    QMutexLocker l(&message_queue_mutex_);
+    if (!message_queue_.isEmpty()) return;
+  }
+
+  // Extra workers are always at the end of the list.
+  while (workers_.count() > worker_count_) {
+    Worker &worker = workers_.last();
+    if ((worker.handler_ && worker.handler_->pending_replies_count() > 0) || clock_.elapsed() - worker.last_request_time_ < kIdleWorkerTimeout) {
+      break;
+    }
+    StopOneWorker(&worker);
+    workers_.removeLast();
+  }
+
+  next_worker_ = 0;
+
+  if (workers_.count() <= worker_count_) {
+    idle_workers_timer_->stop();
+  }
+
+  UpdateStatistics();
+
 }
 
 template<typename HandlerType>
@@ -335,6 +490,13 @@ void WorkerPool<HandlerType>::NewConnection() {
 
   // Create the handler.
   worker->handler_ = new HandlerType(worker->local_socket_, this);
+  if (worker->shared_memory_) {
+    worker->handler_->SetSharedMemory(worker->shared_memory_, false);
+  }
+
+  // Send the next request from the queue when the worker has answered one.
+  // This doesn't depend on the reply's signals, they are not delivered to callers blocking on a thread without an event loop.
+  QObject::connect(worker->handler_, &_MessageHandlerBase::RequestFinished, this, &WorkerPool::SendQueuedMessages, Qt::QueuedConnection);
 
   SendQueuedMessages();
 
@@ -401,7 +563,12 @@ WorkerPool<HandlerType>::NewReply(MessageType *message) {
   const int id = next_id_.fetchAndAddOrdered(1);
   message->set_id(id);
 
-  return new ReplyType(*message);
+  // The reply is finished on my thread, so it lives there too.  Its Finished() signal and deleteLater() are then handled by my event loop,
+  // also when the caller waits for it on a thread without one.
+  ReplyType *reply = new ReplyType(*message);
+  reply->moveToThread(thread());
+
+  return reply;
 
 }
 
@@ -425,40 +592,89 @@ WorkerPool<HandlerType>::SendMessageWithReply(MessageType *message) {
 }
 
 template<typename HandlerType>
-void WorkerPool<HandlerType>::SendQueuedMessages() {
+int WorkerPool<HandlerType>::QueuedRequests() {
 
   QMutexLocker l(&message_queue_mutex_);
+  return static_cast<int>(message_queue_.count());
 
-  while (!message_queue_.isEmpty()) {
-    ReplyType *reply = message_queue_.dequeue();
+}
 
-    // Find a worker for this message
-    HandlerType *handler = NextHandler();
-    if (!handler) {
-      // No available handlers - put the message on the front of the queue.
-      message_queue_.prepend(reply);
-      qLog(Debug) << "No available handlers to process request";
-      break;
-    }
+template<typename HandlerType>
+QList<_WorkerPoolBase::WorkerStatistics> WorkerPool<HandlerType>::Statistics() const {
 
-    handler->SendRequest(reply);
+  QMutexLocker l(&statistics_mutex_);
+  return statistics_;
+
+}
+
+template<typename HandlerType>
+void WorkerPool<HandlerType>::SendQueuedMessages() {
+
+  {
+    QMutexLocker l(&message_queue_mutex_);
+
+    while (!message_queue_.isEmpty()) {
+      // Find a worker for this message
+      Worker *worker = NextWorker();
+      if (!worker) {
+        // All workers are busy or not connected yet - leave the message in the queue, it is sent when a reply arrives.
+        StartExtraWorker();
+        break;
+      }
+
+      ReplyType *reply = message_queue_.dequeue();
+      worker->last_request_time_ = clock_.elapsed();
+      worker->handler_->SendRequest(reply);
+    }
   }
 
+  UpdateStatistics();
+
 }
 
 template<typename HandlerType>
-HandlerType *WorkerPool<HandlerType>::NextHandler() const {
+typename WorkerPool<HandlerType>::Worker *WorkerPool<HandlerType>::NextWorker() {
 
+  // Start after the last worker used, so that idle workers take turns.
+  Worker *next_worker = nullptr;
+  int next_worker_index = 0;
   for (int i = 0; i < workers_.count(); ++i) {
     const int worker_index = (next_worker_ + i) % workers_.count();
+    Worker *worker = &workers_[worker_index];
+    if (!worker->handler_ || worker->handler_->is_device_closed() || worker->handler_->pending_replies_count() >= kMaxPendingRequests) {
+      continue;
+    }
+    if (!next_worker || worker->handler_->pending_replies_count() < next_worker->handler_->pending_replies_count()) {
+      next_worker = worker;
+      next_worker_index = worker_index;
+    }
+  }
+
+  if (next_worker) {
+    next_worker_ = (next_worker_index + 1) % workers_.count();
+  }
 
-    if (workers_[worker_index].handler_ && !workers_[worker_index].handler_->is_device_closed()) {
-      next_worker_ = (worker_index + 1) % workers_.count();
-      return workers_[worker_index].handler_;
+  return next_worker;
+
+}
+
+template<typename HandlerType>
+void WorkerPool<HandlerType>::UpdateStatistics() {
+
+  QList<WorkerStatistics> statistics;
+  for (const Worker &worker : workers_) {
+    WorkerStatistics worker_statistics;
+    if (worker.handler_) {
+      worker_statistics.pending_requests = worker.handler_->pending_replies_count();
+      worker_statistics.replies = worker.handler_->replies_count();
+      worker_statistics.average_latency = worker.handler_->replies_count() > 0 ? worker.handler_->total_latency() / worker.handler_->replies_count() : 0;
+      worker_statistics.max_latency = worker.handler_->max_latency();
     }
+    statistics << worker_statistics;
   }
 
-  return nullptr;
+  QMutexLocker l(&statistics_mutex_);
+  statistics_ = statistics;
 
 }
 
@@ -0,0 +1,104 @@
+/* This file is part of Strawberry.
+   Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+
+   Strawberry is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Strawberry is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <string>
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QFileInfo>
+
+#include "tagreaderlocal.h"
+#if defined(USE_TAGLIB)
+#  include "tagreadertaglib.h"
+#elif defined(USE_TAGPARSER)
+#  include "tagreadertagparser.h"
+#endif
+
+// Formats that are well tested with both tag libraries.  Game music files are only read by TagReaderGME in the worker.
+const QStringList TagReaderLocal::kSupportedSuffixes = QStringList() << "mp3" << "flac" << "ogg" << "oga" << "opus" << "spx" << "m4a" << "m4b" << "mp4" << "wav" << "aif" << "aiff" << "wv" << "ape" << "mpc" << "wma" << "asf";
+
+TagReaderLocal::TagReaderLocal()
+#if defined(USE_TAGLIB)
+    : tag_reader_(new TagReaderTagLib) {}
+#elif defined(USE_TAGPARSER)
+    : tag_reader_(new TagReaderTagParser) {}
+#endif
+
+TagReaderLocal::~TagReaderLocal() {
+  delete tag_reader_;
+}
+
+bool TagReaderLocal::CanReadFile(const std::string &filename) const {
+
+  const QString suffix = QFileInfo(QString::fromUtf8(filename.data(), static_cast<qint64>(filename.size()))).suffix().toLower();
+  return kSupportedSuffixes.contains(suffix);
+
+}
+
+bool TagReaderLocal::CanHandle(const spb::tagreader::Message &message) const {
+
+  if (message.has_is_media_file_request()) {
+    return CanReadFile(message.is_media_file_request().filename());
+  }
+  if (message.has_read_file_request()) {
+    return CanReadFile(message.read_file_request().filename());
+  }
+  if (message.has_load_embedded_art_request()) {
+    return CanReadFile(message.load_embedded_art_request().filename());
+  }
+  if (message.has_read_files_request()) {
+    for (const std::string &filename : message.read_files_request().filenames()) {
+      if (!CanReadFile(filename)) return false;
+    }
+    return true;
+  }
+
+  return false;
+
+}
+
+void TagReaderLocal::HandleMessage(const spb::tagreader::Message &message, spb::tagreader::Message *reply) const {
+
+  reply->set_id(message.id());
+
+  if (message.has_is_media_file_request()) {
+    const QString filename = QString::fromUtf8(message.is_media_file_request().filename().data(), static_cast<qint64>(message.is_media_file_request().filename().size()));
+    reply->mutable_is_media_file_response()->set_success(tag_reader_->IsMediaFile(filename));
+  }
+  else if (message.has_read_file_request()) {
+    const QString filename = QString::fromUtf8(message.read_file_request().filename().data(), static_cast<qint64>(message.read_file_request().filename().size()));
+    tag_reader_->ReadFile(filename, reply->mutable_read_file_response()->mutable_metadata());
+  }
+  else if (message.has_read_files_request()) {
+    for (const std::string &filename_data : message.read_files_request().filenames()) {
+      const QString filename = QString::fromUtf8(filename_data.data(), static_cast<qint64>(filename_data.size()));
+      spb::tagreader::ReadFilesResponse_File *file = reply->mutable_read_files_response()->add_files();
+      file->set_filename(filename_data);
+      file->set_success(tag_reader_->ReadFile(filename, file->mutable_metadata()));
+    }
+    reply->mutable_read_files_response()->set_partial(false);
+  }
+  else if (message.has_load_embedded_art_request()) {
+    const QString filename = QString::fromUtf8(message.load_embedded_art_request().filename().data(), static_cast<qint64>(message.load_embedded_art_request().filename().size()));
+    const QByteArray data = tag_reader_->LoadEmbeddedArt(filename);
+    reply->mutable_load_embedded_art_response()->set_data(data.constData(), data.size());
+  }
+
+}
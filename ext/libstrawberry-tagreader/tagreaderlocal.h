@@ -0,0 +1,57 @@
+/* This file is part of Strawberry.
+   Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+
+   Strawberry is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Strawberry is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TAGREADERLOCAL_H
+#define TAGREADERLOCAL_H
+
+#include "config.h"
+
+#include <string>
+
+#include <QtGlobal>
+#include <QStringList>
+
+#include "tagreadermessages.pb.h"
+
+class TagReaderBase;
+
+/*
+ * Handles read requests in the calling process with TagReaderTagLib or TagReaderTagParser, without going through a worker process.
+ * Only common formats are read here, everything else, and all requests that write to files, must still be sent to a worker.
+ */
+class TagReaderLocal {
+ public:
+  explicit TagReaderLocal();
+  ~TagReaderLocal();
+
+  // Returns true if the request only reads files that can be read here.
+  bool CanHandle(const spb::tagreader::Message &message) const;
+
+  // Fills in reply for the request.  This can be called from several threads at the same time.
+  void HandleMessage(const spb::tagreader::Message &message, spb::tagreader::Message *reply) const;
+
+ private:
+  bool CanReadFile(const std::string &filename) const;
+
+  static const QStringList kSupportedSuffixes;
+
+  TagReaderBase *tag_reader_;
+
+  Q_DISABLE_COPY(TagReaderLocal)
+};
+
+#endif  // TAGREADERLOCAL_H
@@ -27,6 +27,7 @@
 #include <QString>
 #include <QStringList>
 #include <QLocalSocket>
+#include <QSharedMemory>
 
 #include "core/logging.h"
 #include "tagreaderworker.h"
@@ -36,7 +37,7 @@ int main(int argc, char **argv) {
   QCoreApplication a(argc, argv);
   QStringList args(a.arguments());
 
-  if (args.count() != 2) {
+  if (args.count() != 2 && args.count() != 3) {
     std::cerr << "This program is used internally by Strawberry to parse tags in music files\n"
                  "without exposing the whole application to crashes caused by malformed\n"
                  "files.  It is not meant to be run on its own.\n";
@@ -56,6 +57,18 @@ int main(int argc, char **argv) {
 
   TagReaderWorker worker(&socket);
 
+  // Large replies such as embedded covers go through shared memory when the parent process created it.
+  QSharedMemory shared_memory;
+  if (args.count() == 3) {
+    shared_memory.setKey(args[2]);
+    if (shared_memory.attach()) {
+      worker.SetSharedMemory(&shared_memory, true);
+    }
+    else {
+      qLog(Warning) << "Failed to attach to shared memory" << args[2] << shared_memory.errorString();
+    }
+  }
+
   return a.exec();
   
 }
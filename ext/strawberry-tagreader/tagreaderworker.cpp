@@ -27,11 +27,18 @@
 
 #include "tagreaderworker.h"
 
+const int TagReaderWorker::kReadFilesPartialReplySize = 8;
+
 TagReaderWorker::TagReaderWorker(QIODevice *socket, QObject *parent)
     : AbstractMessageHandler<spb::tagreader::Message>(socket, parent) {}
 
 void TagReaderWorker::MessageArrived(const spb::tagreader::Message &message) {
 
+  if (message.has_read_files_request()) {
+    HandleReadFilesRequest(message);
+    return;
+  }
+
   spb::tagreader::Message reply;
 
   bool success = HandleMessage(message, reply, &tag_reader_);
@@ -98,3 +105,42 @@ bool TagReaderWorker::HandleMessage(const spb::tagreader::Message &message, spb:
   return false;
 
 }
+
+void TagReaderWorker::HandleReadFilesRequest(const spb::tagreader::Message &message) {
+
+  const spb::tagreader::ReadFilesRequest &request = message.read_files_request();
+
+  spb::tagreader::Message reply;
+  for (int i = 0; i < request.filenames_size(); ++i) {
+    const std::string &filename_data = request.filenames(i);
+    const QString filename = QString::fromUtf8(filename_data.data(), static_cast<qint64>(filename_data.size()));
+
+    spb::tagreader::ReadFilesResponse_File *file = reply.mutable_read_files_response()->add_files();
+    file->set_filename(filename_data);
+    file->set_success(ReadFile(filename, file->mutable_metadata()));
+
+    // Send what we have so far, so the client can start using the files before the whole request is done.
+    if (reply.read_files_response().files_size() >= kReadFilesPartialReplySize && i < request.filenames_size() - 1) {
+      reply.mutable_read_files_response()->set_partial(true);
+      SendReply(message, &reply);
+      reply.Clear();
+    }
+  }
+
+  reply.mutable_read_files_response()->set_partial(false);
+  SendReply(message, &reply);
+
+}
+
+bool TagReaderWorker::ReadFile(const QString &filename, spb::tagreader::SongMetadata *metadata) {
+
+  bool success = tag_reader_.ReadFile(filename, metadata);
+#if defined(USE_TAGLIB)
+  if (!success) {
+    success = tag_reader_gme_.ReadFile(filename, metadata);
+  }
+#endif
+
+  return success;
+
+}
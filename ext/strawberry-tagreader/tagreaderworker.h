@@ -49,6 +49,12 @@ class TagReaderWorker : public AbstractMessageHandler<spb::tagreader::Message> {
   // Handle message using specific TagReaderBase implementation. Returns true on successful message handle.
   bool HandleMessage(const spb::tagreader::Message &message, spb::tagreader::Message &reply, TagReaderBase* reader);
 
+  // Reads the files of a ReadFilesRequest, sending the metadata back in partial replies of kReadFilesPartialReplySize files.
+  void HandleReadFilesRequest(const spb::tagreader::Message &message);
+  bool ReadFile(const QString &filename, spb::tagreader::SongMetadata *metadata);
+
+  static const int kReadFilesPartialReplySize;
+
 #if defined(USE_TAGLIB)
   TagReaderTagLib tag_reader_;
   TagReaderGME tag_reader_gme_;
@@ -24,6 +24,7 @@
 
 #include "analyzerbase.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <cmath>
 #include <algorithm>
@@ -109,14 +110,10 @@ void AnalyzerBase::paintEvent(QPaintEvent *e) {
 
   switch (engine_->state()) {
     case EngineBase::State::Playing: {
-      const EngineBase::Scope &thescope = engine_->scope(timeout_);
-      int i = 0;
-
-      // convert to mono here - our built in analyzers need mono, but the engines provide interleaved pcm
-      for (uint x = 0; static_cast<int>(x) < fht_->size(); ++x) {
-        lastscope_[x] = static_cast<float>(thescope[i] + thescope[i + 1]) / (2 * (1U << 15U));
-        i += 2;
-      }
+      // The engine provides the newest mono samples, already converted to floats.
+      const EngineBase::Scope &thescope = engine_->scope();
+      const size_t size = std::min(static_cast<size_t>(fht_->size()), thescope.size());
+      std::copy(thescope.end() - static_cast<std::ptrdiff_t>(size), thescope.end(), lastscope_.begin());
 
       is_playing_ = true;
       transform(lastscope_);
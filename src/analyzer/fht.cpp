@@ -28,11 +28,13 @@
 #include <QVector>
 #include <QtMath>
 
-FHT::FHT(uint n) : num_((n < 3) ? 0 : 1 << n), exp2_((n < 3) ? static_cast<int>(-1) : static_cast<int>(n)) {
+FHT::FHT(const uint n, const FHTKernels::Kernels &kernels) : num_((n < 3) ? 0 : 1 << n), exp2_((n < 3) ? static_cast<int>(-1) : static_cast<int>(n)), kernels_(&kernels) {
 
   if (n > 3) {
     buf_vector_.resize(num_);
     tab_vector_.resize(num_ * 2);
+    cos_vector_.resize(num_);
+    sin_vector_.resize(num_);
     makeCasTable();
   }
 
@@ -61,14 +63,23 @@ void FHT::makeCasTable(void) {
     if (sintab > tab_() + num_ * 2) sintab = tab_() + 1;
   }
 
+  // Same factors as _transform() picks from the table, stride is num_ / ndiv2.
+  for (int ndiv2 = 8; ndiv2 < num_; ndiv2 *= 2) {
+    const int stride = num_ / ndiv2;
+    for (int i = 0; i < ndiv2; ++i) {
+      cos_vector_[ndiv2 + i] = tab_vector_[stride * i];
+      sin_vector_[ndiv2 + i] = tab_vector_[stride * i + 1];
+    }
+  }
+
 }
 
 void FHT::scale(float *p, float d) const {
-  for (int i = 0; i < (num_ / 2); i++) *p++ *= d;
+  kernels_->scale(p, d, num_ / 2);
 }
 
 void FHT::ewma(float *d, float *s, float w) const {
-  for (int i = 0; i < (num_ / 2); i++, d++, s++) *d = *d * w + *s * (1 - w);
+  kernels_->ewma(d, s, w, num_ / 2);
 }
 
 void FHT::logSpectrum(float *out, float *p) {
@@ -102,7 +113,8 @@ void FHT::semiLogSpectrum(float *p) {
 
   power2(p);
   for (int i = 0; i < (num_ / 2); i++, p++) {
-    float e = 10.0F * static_cast<float>(log10(sqrt(*p / static_cast<float>(2))));
+    // 10 * log10(sqrt(p / 2))
+    float e = 5.0F * std::log10(*p * 0.5F);
     *p = e < 0 ? 0 : e;
   }
 
@@ -112,7 +124,7 @@ void FHT::spectrum(float *p) {
 
   power2(p);
   for (int i = 0; i < (num_ / 2); i++, p++) {
-    *p = static_cast<float>(sqrt(*p / 2));
+    *p = std::sqrt(*p * 0.5F);
   }
 
 }
@@ -128,15 +140,8 @@ void FHT::power2(float *p) {
 
   _transform(p, num_, 0);
 
-  *p = static_cast<float>(2 * pow(*p, 2));
-  p++;
-
-  float *q = p + num_ - 2;
-  for (int i = 1; i < (num_ / 2); i++) {
-    *p = static_cast<float>(pow(*p, 2) + pow(*q, 2));
-    p++;
-    q--;
-  }
+  *p = 2 * *p * *p;
+  kernels_->power2(p, num_ / 2);
 
 }
 
@@ -187,38 +192,26 @@ void FHT::_transform(float *p, int n, int k) {
     return;
   }
 
-  int i = 0, j = 0, ndiv2 = n / 2;
-  float a = 0.0, *t1 = nullptr, *t2 = nullptr, *t3 = nullptr, *t4 = nullptr, *ptab = nullptr, *pp = nullptr;
-
-  for (i = 0, t1 = buf_(), t2 = buf_() + ndiv2, pp = &p[k]; i < ndiv2; i++)
-    *t1++ = *pp++, *t2++ = *pp++;
+  const int ndiv2 = n / 2;
+  float *lo = buf_();
+  float *hi = buf_() + ndiv2;
 
+  kernels_->deinterleave(p + k, lo, hi, ndiv2);
   std::copy(buf_(), buf_() + n, p + k);
 
   _transform(p, ndiv2, k);
   _transform(p, ndiv2, k + ndiv2);
 
-  j = num_ / ndiv2 - 1;
-  t1 = buf_();
-  t2 = t1 + ndiv2;
-  t3 = p + k + ndiv2;
-  ptab = tab_();
-  pp = p + k;
-
-  a = *ptab++ * *t3++;
-  a += *ptab * *pp;
-  ptab += j;
+  const float *x = p + k;
+  const float *y = p + k + ndiv2;
+  const float *c = cos_vector_.constData() + ndiv2;
+  const float *s = sin_vector_.constData() + ndiv2;
 
-  *t1++ = *pp + a;
-  *t2++ = *pp++ - a;
+  const float a = c[0] * y[0] + s[0] * x[0];
+  lo[0] = x[0] + a;
+  hi[0] = x[0] - a;
 
-  for (i = 1, t4 = p + k + n; i < ndiv2; i++, ptab += j) {
-    a = *ptab++ * *t3++;
-    a += *ptab * *--t4;
-
-    *t1++ = *pp + a;
-    *t2++ = *pp++ - a;
-  }
+  kernels_->butterfly(x, y, c, s, lo, hi, ndiv2);
 
   std::copy(buf_(), buf_() + n, p + k);
 
@@ -25,6 +25,8 @@
 
 #include <QVector>
 
+#include "fhtkernels.h"
+
 /**
  * Implementation of the Hartley Transform after Bracewell's discrete
  * algorithm. The algorithm is subject to US patent No. 4,646,256 (1987)
@@ -36,11 +38,17 @@
 class FHT {
   const int num_;
   const int exp2_;
+  const FHTKernels::Kernels *kernels_;
 
   QVector<float> buf_vector_;
   QVector<float> tab_vector_;
   QVector<int> log_vector_;
 
+  // The cosine and sine factors for each recursion of _transform(), contiguous so the butterflies can be vectorized.
+  // The factors for a transform of 2n values start at index n.
+  QVector<float> cos_vector_;
+  QVector<float> sin_vector_;
+
   float *buf_();
   float *tab_();
   int *log_();
@@ -62,8 +70,9 @@ class FHT {
   * Prepare transform for data sets with @f$2^n@f$ numbers, whereby @f$n@f$
   * should be at least 3. Values of more than 3 need a trigonometry table.
   * @see makeCasTable()
+  * The kernels default to the fastest ones this CPU supports.
   */
-  explicit FHT(uint);
+  explicit FHT(const uint n, const FHTKernels::Kernels &kernels = FHTKernels::Best());
 
   ~FHT();
   int sizeExp() const;
@@ -0,0 +1,315 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <initializer_list>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define FHTKERNELS_SSE2
+#  include <emmintrin.h>
+#endif
+
+// AVX2 is built with a target attribute, so it doesn't need to be enabled for the whole build.
+#if defined(FHTKERNELS_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define FHTKERNELS_AVX2
+#  define FHTKERNELS_TARGET_AVX2 __attribute__((target("avx2")))
+#  include <immintrin.h>
+#endif
+
+#include "fhtkernels.h"
+
+namespace FHTKernels {
+
+namespace {
+
+void ButterflyScalarRange(const float *x, const float *y, const float *c, const float *s, float *lo, float *hi, int i, const int n) {
+
+  for (; i < n; ++i) {
+    const float a = c[i] * y[i] + s[i] * y[n - i];
+    lo[i] = x[i] + a;
+    hi[i] = x[i] - a;
+  }
+
+}
+
+void Power2ScalarRange(float *p, int i, const int n) {
+
+  // Keep the pointer walking down from the end, GCC 12 at -O1 drops the call to this when it indexes p[2n - i] directly.
+  const float *q = p + 2 * n - i;
+  for (; i < n; ++i, --q) {
+    p[i] = p[i] * p[i] + *q * *q;
+  }
+
+}
+
+void DeinterleaveScalar(const float *in, float *even, float *odd, const int n) {
+
+  for (int i = 0; i < n; ++i) {
+    even[i] = in[2 * i];
+    odd[i] = in[2 * i + 1];
+  }
+
+}
+
+void ButterflyScalar(const float *x, const float *y, const float *c, const float *s, float *lo, float *hi, const int n) {
+
+  ButterflyScalarRange(x, y, c, s, lo, hi, 1, n);
+
+}
+
+void Power2Scalar(float *p, const int n) {
+
+  Power2ScalarRange(p, 1, n);
+
+}
+
+void ScaleScalar(float *p, const float d, const int n) {
+
+  for (int i = 0; i < n; ++i) p[i] *= d;
+
+}
+
+void EwmaScalar(float *d, const float *s, const float w, const int n) {
+
+  for (int i = 0; i < n; ++i) d[i] = d[i] * w + s[i] * (1 - w);
+
+}
+
+const Kernels kScalarKernels = { InstructionSet::Scalar, DeinterleaveScalar, ButterflyScalar, Power2Scalar, ScaleScalar, EwmaScalar };
+
+#ifdef FHTKERNELS_SSE2
+
+inline __m128 Reverse128(const __m128 v) {
+  return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+void DeinterleaveSSE2(const float *in, float *even, float *odd, const int n) {
+
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128 a = _mm_loadu_ps(in + 2 * i);
+    const __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+    _mm_storeu_ps(even + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(odd + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  DeinterleaveScalar(in + 2 * i, even + i, odd + i, n - i);
+
+}
+
+void ButterflySSE2(const float *x, const float *y, const float *c, const float *s, float *lo, float *hi, const int n) {
+
+  int i = 1;
+  for (; i + 4 <= n; i += 4) {
+    // y[n - i - 3] to y[n - i], reversed.
+    const __m128 y_reversed = Reverse128(_mm_loadu_ps(y + n - i - 3));
+    const __m128 a = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(c + i), _mm_loadu_ps(y + i)), _mm_mul_ps(_mm_loadu_ps(s + i), y_reversed));
+    const __m128 xi = _mm_loadu_ps(x + i);
+    _mm_storeu_ps(lo + i, _mm_add_ps(xi, a));
+    _mm_storeu_ps(hi + i, _mm_sub_ps(xi, a));
+  }
+  ButterflyScalarRange(x, y, c, s, lo, hi, i, n);
+
+}
+
+void Power2SSE2(float *p, const int n) {
+
+  int i = 1;
+  for (; i + 4 <= n; i += 4) {
+    const __m128 a = _mm_loadu_ps(p + i);
+    const __m128 b = Reverse128(_mm_loadu_ps(p + 2 * n - i - 3));
+    _mm_storeu_ps(p + i, _mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b)));
+  }
+  Power2ScalarRange(p, i, n);
+
+}
+
+void ScaleSSE2(float *p, const float d, const int n) {
+
+  const __m128 dv = _mm_set1_ps(d);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(p + i, _mm_mul_ps(_mm_loadu_ps(p + i), dv));
+  }
+  ScaleScalar(p + i, d, n - i);
+
+}
+
+void EwmaSSE2(float *d, const float *s, const float w, const int n) {
+
+  const __m128 wv = _mm_set1_ps(w);
+  const __m128 rv = _mm_set1_ps(1 - w);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(d + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(d + i), wv), _mm_mul_ps(_mm_loadu_ps(s + i), rv)));
+  }
+  EwmaScalar(d + i, s + i, w, n - i);
+
+}
+
+const Kernels kSSE2Kernels = { InstructionSet::SSE2, DeinterleaveSSE2, ButterflySSE2, Power2SSE2, ScaleSSE2, EwmaSSE2 };
+
+#endif  // FHTKERNELS_SSE2
+
+#ifdef FHTKERNELS_AVX2
+
+// The remainders are done by code that isn't built for AVX, clear the upper halves of the registers first to avoid the transition penalty.
+FHTKERNELS_TARGET_AVX2 inline __m256 Reverse256(const __m256 v) {
+  return _mm256_permutevar8x32_ps(v, _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+FHTKERNELS_TARGET_AVX2 void DeinterleaveAVX2(const float *in, float *even, float *odd, const int n) {
+
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 a = _mm256_loadu_ps(in + 2 * i);
+    const __m256 b = _mm256_loadu_ps(in + 2 * i + 8);
+    // The shuffles work within each 128 bit lane, the permute puts the 64 bit halves back in order.
+    const __m256 e = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m256 o = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm256_storeu_ps(even + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(e), _MM_SHUFFLE(3, 1, 2, 0))));
+    _mm256_storeu_ps(odd + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(o), _MM_SHUFFLE(3, 1, 2, 0))));
+  }
+  _mm256_zeroupper();
+  DeinterleaveSSE2(in + 2 * i, even + i, odd + i, n - i);
+
+}
+
+FHTKERNELS_TARGET_AVX2 void ButterflyAVX2(const float *x, const float *y, const float *c, const float *s, float *lo, float *hi, const int n) {
+
+  int i = 1;
+  for (; i + 8 <= n; i += 8) {
+    // y[n - i - 7] to y[n - i], reversed.
+    const __m256 y_reversed = Reverse256(_mm256_loadu_ps(y + n - i - 7));
+    const __m256 a = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(c + i), _mm256_loadu_ps(y + i)), _mm256_mul_ps(_mm256_loadu_ps(s + i), y_reversed));
+    const __m256 xi = _mm256_loadu_ps(x + i);
+    _mm256_storeu_ps(lo + i, _mm256_add_ps(xi, a));
+    _mm256_storeu_ps(hi + i, _mm256_sub_ps(xi, a));
+  }
+  _mm256_zeroupper();
+  ButterflyScalarRange(x, y, c, s, lo, hi, i, n);
+
+}
+
+FHTKERNELS_TARGET_AVX2 void Power2AVX2(float *p, const int n) {
+
+  int i = 1;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 a = _mm256_loadu_ps(p + i);
+    const __m256 b = Reverse256(_mm256_loadu_ps(p + 2 * n - i - 7));
+    _mm256_storeu_ps(p + i, _mm256_add_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b)));
+  }
+  _mm256_zeroupper();
+  Power2ScalarRange(p, i, n);
+
+}
+
+FHTKERNELS_TARGET_AVX2 void ScaleAVX2(float *p, const float d, const int n) {
+
+  const __m256 dv = _mm256_set1_ps(d);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(p + i, _mm256_mul_ps(_mm256_loadu_ps(p + i), dv));
+  }
+  _mm256_zeroupper();
+  ScaleScalar(p + i, d, n - i);
+
+}
+
+FHTKERNELS_TARGET_AVX2 void EwmaAVX2(float *d, const float *s, const float w, const int n) {
+
+  const __m256 wv = _mm256_set1_ps(w);
+  const __m256 rv = _mm256_set1_ps(1 - w);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(d + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(d + i), wv), _mm256_mul_ps(_mm256_loadu_ps(s + i), rv)));
+  }
+  _mm256_zeroupper();
+  EwmaScalar(d + i, s + i, w, n - i);
+
+}
+
+const Kernels kAVX2Kernels = { InstructionSet::AVX2, DeinterleaveAVX2, ButterflyAVX2, Power2AVX2, ScaleAVX2, EwmaAVX2 };
+
+bool CPUSupportsAVX2() {
+
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+
+}
+
+#endif  // FHTKERNELS_AVX2
+
+}  // namespace
+
+const Kernels *Get(const InstructionSet instruction_set) {
+
+  switch (instruction_set) {
+    case InstructionSet::Scalar:
+      return &kScalarKernels;
+    case InstructionSet::SSE2:
+#ifdef FHTKERNELS_SSE2
+      return &kSSE2Kernels;
+#else
+      return nullptr;
+#endif
+    case InstructionSet::AVX2:
+#ifdef FHTKERNELS_AVX2
+      {
+        static const bool supported = CPUSupportsAVX2();
+        return supported ? &kAVX2Kernels : nullptr;
+      }
+#else
+      return nullptr;
+#endif
+  }
+
+  return nullptr;
+
+}
+
+const Kernels &Best() {
+
+  static const Kernels *best = []() {
+    for (const InstructionSet instruction_set : { InstructionSet::AVX2, InstructionSet::SSE2 }) {
+      if (const Kernels *kernels = Get(instruction_set)) return kernels;
+    }
+    return &kScalarKernels;
+  }();
+
+  return *best;
+
+}
+
+const char *Name(const InstructionSet instruction_set) {
+
+  switch (instruction_set) {
+    case InstructionSet::Scalar:
+      return "Scalar";
+    case InstructionSet::SSE2:
+      return "SSE2";
+    case InstructionSet::AVX2:
+      return "AVX2";
+  }
+
+  return "Unknown";
+
+}
+
+}  // namespace FHTKernels
@@ -0,0 +1,64 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FHTKERNELS_H
+#define FHTKERNELS_H
+
+#include "config.h"
+
+// The inner loops of FHT, with SSE2 and AVX2 versions picked at runtime.
+// All versions give the same results as the scalar ones, except for rounding.
+namespace FHTKernels {
+
+enum class InstructionSet {
+  Scalar,
+  SSE2,
+  AVX2
+};
+
+struct Kernels {
+  InstructionSet instruction_set;
+
+  // even[i] = in[2i] and odd[i] = in[2i + 1] for 0 <= i < n.
+  void (*deinterleave)(const float *in, float *even, float *odd, const int n);
+
+  // a = c[i] * y[i] + s[i] * y[n - i], lo[i] = x[i] + a and hi[i] = x[i] - a for 0 < i < n.
+  void (*butterfly)(const float *x, const float *y, const float *c, const float *s, float *lo, float *hi, const int n);
+
+  // p[i] = p[i]^2 + p[2n - i]^2 for 0 < i < n.
+  void (*power2)(float *p, const int n);
+
+  // p[i] *= d for 0 <= i < n.
+  void (*scale)(float *p, const float d, const int n);
+
+  // d[i] = d[i] * w + s[i] * (1 - w) for 0 <= i < n.
+  void (*ewma)(float *d, const float *s, const float w, const int n);
+};
+
+// The kernels for the best instruction set supported by this build and CPU.
+const Kernels &Best();
+
+// Returns nullptr if the instruction set is not supported by this build or CPU.
+const Kernels *Get(const InstructionSet instruction_set);
+
+const char *Name(const InstructionSet instruction_set);
+
+}  // namespace FHTKernels
+
+#endif  // FHTKERNELS_H
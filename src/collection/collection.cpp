@@ -28,6 +28,8 @@
 #include <QThread>
 #include <QList>
 #include <QSettings>
+#include <QUrl>
+#include <QByteArray>
 #include <QtConcurrentRun>
 
 #include "core/application.h"
@@ -42,8 +44,14 @@
 #include "collectionwatcher.h"
 #include "collectionbackend.h"
 #include "collectionmodel.h"
+#ifdef HAVE_EBUR128
+#  include "collectionloudnessanalyzer.h"
+#endif
 #include "scrobbler/lastfmimport.h"
 #include "settings/collectionsettingspage.h"
+#ifdef HAVE_MOODBAR
+#  include "moodbar/moodbarloader.h"
+#endif
 
 using std::make_shared;
 
@@ -60,8 +68,12 @@ SCollection::SCollection(Application *app, QObject *parent)
       watcher_(nullptr),
       watcher_thread_(nullptr),
       original_thread_(nullptr),
+#ifdef HAVE_EBUR128
+      loudness_analyzer_(nullptr),
+#endif
       save_playcounts_to_files_(false),
-      save_ratings_to_files_(false) {
+      save_ratings_to_files_(false),
+      song_ebur128_loudness_analysis_(false) {
 
   original_thread_ = thread();
 
@@ -121,6 +133,10 @@ void SCollection::Init() {
   QObject::connect(watcher_, &CollectionWatcher::SubdirsMTimeUpdated, &*backend_, &CollectionBackend::AddOrUpdateSubdirs);
   QObject::connect(watcher_, &CollectionWatcher::CompilationsNeedUpdating, &*backend_, &CollectionBackend::CompilationsNeedUpdating);
   QObject::connect(watcher_, &CollectionWatcher::UpdateLastSeen, &*backend_, &CollectionBackend::UpdateLastSeen);
+#ifdef HAVE_MOODBAR
+  // Moodbars made during the scan, the loader is only created once there is one.
+  QObject::connect(watcher_, &CollectionWatcher::MoodbarGenerated, this, [this](const QUrl &url, const QByteArray &data) { app_->moodbar_loader()->SaveMoodbar(url, data); });
+#endif
 
   QObject::connect(&*app_->lastfm_import(), &LastFMImport::UpdateLastPlayed, &*backend_, &CollectionBackend::UpdateLastPlayed);
   QObject::connect(&*app_->lastfm_import(), &LastFMImport::UpdatePlayCount, &*backend_, &CollectionBackend::UpdatePlayCount);
@@ -128,10 +144,35 @@ void SCollection::Init() {
   // This will start the watcher checking for updates
   backend_->LoadDirectoriesAsync();
 
+#ifdef HAVE_EBUR128
+  // Songs added before the loudness analysis was enabled, or when the program was closed during the analysis.
+  loudness_analyzer_ = new CollectionLoudnessAnalyzer(backend_, app_->task_manager(), this);
+  if (song_ebur128_loudness_analysis_) loudness_analyzer_->Start();
+#endif
+
 }
 
 void SCollection::Exit() {
 
+#ifdef HAVE_EBUR128
+  // The loudness analyzer saves the songs it analyzed through the backend, so let it stop before the backend exits.
+  if (loudness_analyzer_ && loudness_analyzer_->is_running()) {
+    QObject::connect(loudness_analyzer_, &CollectionLoudnessAnalyzer::Finished, this, &SCollection::ExitWatcherAndBackend);
+    loudness_analyzer_->Stop();
+    return;
+  }
+#endif
+
+  ExitWatcherAndBackend();
+
+}
+
+void SCollection::ExitWatcherAndBackend() {
+
+#ifdef HAVE_EBUR128
+  if (loudness_analyzer_) QObject::disconnect(loudness_analyzer_, &CollectionLoudnessAnalyzer::Finished, this, &SCollection::ExitWatcherAndBackend);
+#endif
+
   wait_for_exit_ << &*backend_ << watcher_;
 
   QObject::disconnect(&*backend_, nullptr, watcher_, nullptr);
@@ -183,8 +224,23 @@ void SCollection::ReloadSettings() {
   s.beginGroup(CollectionSettingsPage::kSettingsGroup);
   save_playcounts_to_files_ = s.value("save_playcounts", false).toBool();
   save_ratings_to_files_ = s.value("save_ratings", false).toBool();
+  const bool song_ebur128_loudness_analysis = s.value("song_ebur128_loudness_analysis", false).toBool();
   s.endGroup();
 
+#ifdef HAVE_EBUR128
+  // Only start or stop when the setting is changed, songs that could not be analyzed are not tried again on every apply.
+  if (loudness_analyzer_ && song_ebur128_loudness_analysis != song_ebur128_loudness_analysis_) {
+    if (song_ebur128_loudness_analysis) {
+      loudness_analyzer_->Start();
+    }
+    else {
+      loudness_analyzer_->Stop();
+    }
+  }
+#endif
+
+  song_ebur128_loudness_analysis_ = song_ebur128_loudness_analysis;
+
 }
 
 void SCollection::SyncPlaycountAndRatingToFilesAsync() {
@@ -38,6 +38,9 @@ class Thread;
 class CollectionBackend;
 class CollectionModel;
 class CollectionWatcher;
+#ifdef HAVE_EBUR128
+class CollectionLoudnessAnalyzer;
+#endif
 
 class SCollection : public QObject {
   Q_OBJECT
@@ -77,6 +80,7 @@ class SCollection : public QObject {
   void IncrementalScan();
 
  private slots:
+  void ExitWatcherAndBackend();
   void ExitReceived();
   void SongsPlaycountChanged(const SongList &songs, const bool save_tags = false);
   void SongsRatingChanged(const SongList &songs, const bool save_tags = false);
@@ -93,6 +97,9 @@ class SCollection : public QObject {
   CollectionWatcher *watcher_;
   Thread *watcher_thread_;
   QThread *original_thread_;
+#ifdef HAVE_EBUR128
+  CollectionLoudnessAnalyzer *loudness_analyzer_;
+#endif
 
   // DB schema versions which should trigger a full collection rescan (each of those with a short reason why).
   QHash<int, QString> full_rescan_revisions_;
@@ -101,6 +108,7 @@ class SCollection : public QObject {
 
   bool save_playcounts_to_files_;
   bool save_ratings_to_files_;
+  bool song_ebur128_loudness_analysis_;
 };
 
 #endif
@@ -57,6 +57,11 @@
 #include "collectionquery.h"
 #include "collectiontask.h"
 
+const int CollectionBackend::kBatchSize = 1000;
+const int CollectionBackend::kUrlBatchSize = 200;
+const int CollectionBackend::kAlbumIdBatchSize = 500;
+const int CollectionBackend::kSongIdBatchSize = 500;
+
 CollectionBackend::CollectionBackend(QObject *parent)
     : CollectionBackendInterface(parent),
       db_(nullptr),
@@ -157,7 +162,6 @@ void CollectionBackend::LoadDirectories() {
 
   CollectionDirectoryList dirs = GetAllDirectories();
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   for (const CollectionDirectory &dir : dirs) {
@@ -219,7 +223,6 @@ void CollectionBackend::ChangeDirPath(const int id, const QString &old_path, con
 
 CollectionDirectoryList CollectionBackend::GetAllDirectories() {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   CollectionDirectoryList ret;
@@ -244,7 +247,6 @@ CollectionDirectoryList CollectionBackend::GetAllDirectories() {
 
 CollectionSubdirectoryList CollectionBackend::SubdirsInDirectory(const int id) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db = db_->Connect();
   return SubdirsInDirectory(id, db);
 
@@ -253,7 +255,7 @@ CollectionSubdirectoryList CollectionBackend::SubdirsInDirectory(const int id) {
 CollectionSubdirectoryList CollectionBackend::SubdirsInDirectory(const int id, QSqlDatabase &db) {
 
   SqlQuery q(db);
-  q.prepare(QString("SELECT path, mtime FROM %1 WHERE directory_id = :dir").arg(subdirs_table_));
+  q.prepare(QString("SELECT path, mtime, inode, child_count, entries_hash FROM %1 WHERE directory_id = :dir").arg(subdirs_table_));
   q.BindValue(":dir", id);
   if (!q.Exec()) {
     db_->ReportErrors(q);
@@ -266,6 +268,9 @@ CollectionSubdirectoryList CollectionBackend::SubdirsInDirectory(const int id, Q
     subdir.directory_id = id;
     subdir.path = q.value(0).toString();
     subdir.mtime = q.value(1).toLongLong();
+    subdir.inode = q.value(2).toULongLong();
+    subdir.child_count = q.value(3).toULongLong();
+    subdir.entries_hash = q.value(4).toLongLong();
     subdirs << subdir;
   }
 
@@ -275,7 +280,6 @@ CollectionSubdirectoryList CollectionBackend::SubdirsInDirectory(const int id, Q
 
 void CollectionBackend::UpdateTotalSongCount() {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   SqlQuery q(db);
@@ -295,7 +299,6 @@ void CollectionBackend::UpdateTotalSongCount() {
 
 void CollectionBackend::UpdateTotalArtistCount() {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   SqlQuery q(db);
@@ -315,7 +318,6 @@ void CollectionBackend::UpdateTotalArtistCount() {
 
 void CollectionBackend::UpdateTotalAlbumCount() {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   SqlQuery q(db);
@@ -397,7 +399,6 @@ void CollectionBackend::RemoveDirectory(const CollectionDirectory &dir) {
 
 SongList CollectionBackend::FindSongsInDirectory(const int id) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   SqlQuery q(db);
@@ -420,7 +421,6 @@ SongList CollectionBackend::FindSongsInDirectory(const int id) {
 
 SongList CollectionBackend::SongsWithMissingFingerprint(const int id) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   SqlQuery q(db);
@@ -443,7 +443,6 @@ SongList CollectionBackend::SongsWithMissingFingerprint(const int id) {
 
 SongList CollectionBackend::SongsWithMissingLoudnessCharacteristics(const int id) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   SqlQuery q(db);
@@ -464,6 +463,45 @@ SongList CollectionBackend::SongsWithMissingLoudnessCharacteristics(const int id
 
 }
 
+SongList CollectionBackend::NextSongsWithMissingLoudnessCharacteristics(const int after_id, const int limit) {
+
+  QSqlDatabase db(db_->Connect());
+
+  SqlQuery q(db);
+  q.prepare(QString("SELECT ROWID, %1 FROM %2 WHERE ROWID > :after_id AND unavailable = 0 AND (ebur128_integrated_loudness_lufs IS NULL OR ebur128_loudness_range_lu IS NULL) ORDER BY ROWID LIMIT :limit").arg(Song::kColumnSpec, songs_table_));
+  q.BindValue(":after_id", after_id);
+  q.BindValue(":limit", limit);
+  if (!q.Exec()) {
+    db_->ReportErrors(q);
+    return SongList();
+  }
+
+  SongList ret;
+  while (q.next()) {
+    Song song(source_);
+    song.InitFromQuery(q, true);
+    ret << song;
+  }
+  return ret;
+
+}
+
+int CollectionBackend::CountSongsWithMissingLoudnessCharacteristics() {
+
+  QSqlDatabase db(db_->Connect());
+
+  SqlQuery q(db);
+  q.prepare(QString("SELECT COUNT(*) FROM %1 WHERE unavailable = 0 AND (ebur128_integrated_loudness_lufs IS NULL OR ebur128_loudness_range_lu IS NULL)").arg(songs_table_));
+  if (!q.Exec()) {
+    db_->ReportErrors(q);
+    return 0;
+  }
+  if (!q.next()) return 0;
+
+  return q.value(0).toInt();
+
+}
+
 void CollectionBackend::SongPathChanged(const Song &song, const QFileInfo &new_file, const std::optional<int> new_collection_directory_id) {
 
   // Take a song and update its path
@@ -515,8 +553,11 @@ void CollectionBackend::AddOrUpdateSubdirs(const CollectionSubdirectoryList &sub
 
       if (exists) {
         SqlQuery q(db);
-        q.prepare(QString("UPDATE %1 SET mtime = :mtime WHERE directory_id = :id AND path = :path").arg(subdirs_table_));
+        q.prepare(QString("UPDATE %1 SET mtime = :mtime, inode = :inode, child_count = :child_count, entries_hash = :entries_hash WHERE directory_id = :id AND path = :path").arg(subdirs_table_));
         q.BindValue(":mtime", subdir.mtime);
+        q.BindValue(":inode", static_cast<qint64>(subdir.inode));
+        q.BindValue(":child_count", static_cast<qint64>(subdir.child_count));
+        q.BindValue(":entries_hash", subdir.entries_hash);
         q.BindValue(":id", subdir.directory_id);
         q.BindValue(":path", subdir.path);
         if (!q.Exec()) {
@@ -526,10 +567,13 @@ void CollectionBackend::AddOrUpdateSubdirs(const CollectionSubdirectoryList &sub
       }
       else {
         SqlQuery q(db);
-        q.prepare(QString("INSERT INTO %1 (directory_id, path, mtime) VALUES (:id, :path, :mtime)").arg(subdirs_table_));
+        q.prepare(QString("INSERT INTO %1 (directory_id, path, mtime, inode, child_count, entries_hash) VALUES (:id, :path, :mtime, :inode, :child_count, :entries_hash)").arg(subdirs_table_));
         q.BindValue(":id", subdir.directory_id);
         q.BindValue(":path", subdir.path);
         q.BindValue(":mtime", subdir.mtime);
+        q.BindValue(":inode", static_cast<qint64>(subdir.inode));
+        q.BindValue(":child_count", static_cast<qint64>(subdir.child_count));
+        q.BindValue(":entries_hash", subdir.entries_hash);
         if (!q.Exec()) {
           db_->ReportErrors(q);
           return;
@@ -544,7 +588,6 @@ void CollectionBackend::AddOrUpdateSubdirs(const CollectionSubdirectoryList &sub
 
 SongList CollectionBackend::GetAllSongs() {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   SqlQuery q(db);
@@ -575,139 +618,146 @@ void CollectionBackend::AddOrUpdateSongs(const SongList &songs) {
 
   ScopedTransaction transaction(&db);
 
-  SongList added_songs;
-  SongList deleted_songs;
+  // Do a sanity check first - make sure the song's directory still exists
+  // This is to fix a possible race condition when a directory is removed while CollectionWatcher is scanning it.
+  QSet<int> directory_ids;
+  if (!dirs_table_.isEmpty()) {
+    SqlQuery q(db);
+    q.prepare(QString("SELECT ROWID FROM %1").arg(dirs_table_));
+    if (!q.Exec()) {
+      db_->ReportErrors(q);
+      return;
+    }
+    while (q.next()) {
+      directory_ids.insert(q.value(0).toInt());
+    }
+  }
 
+  // Get the previous song data for all songs that are updated.
+  QStringList update_ids;
+  QStringList update_song_ids;
   for (const Song &song : songs) {
-
-    // Do a sanity check first - make sure the song's directory still exists
-    // This is to fix a possible race condition when a directory is removed while CollectionWatcher is scanning it.
-    if (!dirs_table_.isEmpty()) {
-      SqlQuery check_dir(db);
-      check_dir.prepare(QString("SELECT ROWID FROM %1 WHERE ROWID = :id").arg(dirs_table_));
-      check_dir.BindValue(":id", song.directory_id());
-      if (!check_dir.Exec()) {
-        db_->ReportErrors(check_dir);
-        return;
-      }
-
-      if (!check_dir.next()) continue;
-
+    if (song.id() != -1) {
+      update_ids << QString::number(song.id());
+    }
+    else if (!song.song_id().isEmpty()) {
+      update_song_ids << song.song_id();
     }
+  }
 
-    if (song.id() != -1) {  // This song exists in the DB.
+  QMap<int, Song> old_songs_by_id;
+  for (qint64 i = 0; i < update_ids.count(); i += kBatchSize) {
+    const SongList old_songs = GetSongsById(update_ids.mid(i, kBatchSize), db);
+    for (const Song &old_song : old_songs) {
+      old_songs_by_id.insert(old_song.id(), old_song);
+    }
+  }
 
-      // Get the previous song data first
-      Song old_song(GetSongById(song.id()));
-      if (!old_song.is_valid()) continue;
+  QMap<QString, Song> old_songs_by_song_id;
+  for (qint64 i = 0; i < update_song_ids.count(); i += kBatchSize) {
+    const SongList old_songs = GetSongsBySongId(update_song_ids.mid(i, kBatchSize), db);
+    for (const Song &old_song : old_songs) {
+      old_songs_by_song_id.insert(old_song.song_id(), old_song);
+    }
+  }
 
-      // Update
-      {
-        SqlQuery q(db);
-        q.prepare(QString("UPDATE %1 SET %2 WHERE ROWID = :id").arg(songs_table_, Song::kUpdateSpec));
-        song.BindToQuery(&q);
-        q.BindValue(":id", song.id());
-        if (!q.Exec()) {
-          db_->ReportErrors(q);
-          return;
-        }
-      }
+  SqlQuery q_update(db);
+  q_update.prepare(QString("UPDATE %1 SET %2 WHERE ROWID = :id").arg(songs_table_, Song::kUpdateSpec));
+  SqlQuery q_update_fts(db);
+  q_update_fts.prepare(QString("UPDATE %1 SET %2 WHERE ROWID = :id").arg(fts_table_, Song::kFtsUpdateSpec));
+  SqlQuery q_insert(db);
+  q_insert.prepare(QString("INSERT INTO %1 (%2) VALUES (%3)").arg(songs_table_, Song::kColumnSpec, Song::kBindSpec));
+  SqlQuery q_insert_fts(db);
+  q_insert_fts.prepare(QString("INSERT INTO %1 (ROWID, %2) VALUES (:id, %3)").arg(fts_table_, Song::kFtsColumnSpec, Song::kFtsBindSpec));
 
-      {
-        SqlQuery q(db);
-        q.prepare(QString("UPDATE %1 SET %2 WHERE ROWID = :id").arg(fts_table_, Song::kFtsUpdateSpec));
-        song.BindToFtsQuery(&q);
-        q.BindValue(":id", song.id());
-        if (!q.Exec()) {
-          db_->ReportErrors(q);
-          return;
-        }
-      }
+  SongList added_songs;
+  SongList deleted_songs;
 
-      deleted_songs << old_song;
-      added_songs << song;
+  for (const Song &song : songs) {
 
-      continue;
+    if (!dirs_table_.isEmpty() && !directory_ids.contains(song.directory_id())) continue;
 
+    Song old_song;
+    Song new_song = song;
+    if (song.id() != -1) {  // This song exists in the DB.
+      old_song = old_songs_by_id.value(song.id());
+      if (!old_song.is_valid()) continue;
+    }
+    else if (!song.song_id().isEmpty() && old_songs_by_song_id.contains(song.song_id())) {  // Song has a unique id, and the song exists.
+      old_song = old_songs_by_song_id[song.song_id()];
+      new_song.set_id(old_song.id());
     }
-    else if (!song.song_id().isEmpty()) {  // Song has a unique id, check if the song exists.
 
-      // Get the previous song data first
-      Song old_song(GetSongBySongId(song.song_id()));
+    if (old_song.is_valid() && old_song.id() != -1) {
 
-      if (old_song.is_valid() && old_song.id() != -1) {
+      // Update
+      new_song.BindToQuery(&q_update);
+      q_update.BindValue(":id", new_song.id());
+      if (!q_update.Exec()) {
+        db_->ReportErrors(q_update);
+        return;
+      }
 
-        Song new_song = song;
-        new_song.set_id(old_song.id());
+      new_song.BindToFtsQuery(&q_update_fts);
+      q_update_fts.BindValue(":id", new_song.id());
+      if (!q_update_fts.Exec()) {
+        db_->ReportErrors(q_update_fts);
+        return;
+      }
 
-        // Update
-        {
-          SqlQuery q(db);
-          q.prepare(QString("UPDATE %1 SET %2 WHERE ROWID = :id").arg(songs_table_, Song::kUpdateSpec));
-          new_song.BindToQuery(&q);
-          q.BindValue(":id", new_song.id());
-          if (!q.Exec()) {
-            db_->ReportErrors(q);
-            return;
-          }
-        }
+      deleted_songs << old_song;
+      added_songs << new_song;
 
-        {
-          SqlQuery q(db);
-          q.prepare(QString("UPDATE %1 SET %2 WHERE ROWID = :id").arg(fts_table_, Song::kFtsUpdateSpec));
-          new_song.BindToFtsQuery(&q);
-          q.BindValue(":id", new_song.id());
-          if (!q.Exec()) {
-            db_->ReportErrors(q);
-            return;
-          }
-        }
+      // The same song might be updated again in this batch.
+      Song updated_song = new_song;
+      updated_song.set_valid(true);
+      old_songs_by_id[updated_song.id()] = updated_song;
+      if (!updated_song.song_id().isEmpty()) old_songs_by_song_id[updated_song.song_id()] = updated_song;
 
-        deleted_songs << old_song;
-        added_songs << new_song;
+      continue;
 
-        continue;
-      }
     }
 
     // Create new song
 
-    int id = -1;
-    {  // Insert the row and create a new ID
-      SqlQuery q(db);
-      q.prepare(QString("INSERT INTO %1 (%2) VALUES (%3)").arg(songs_table_, Song::kColumnSpec, Song::kBindSpec));
-      song.BindToQuery(&q);
-      if (!q.Exec()) {
-        db_->ReportErrors(q);
-        return;
-      }
-      // Get the new ID
-      id = q.lastInsertId().toInt();
+    // Insert the row and create a new ID
+    song.BindToQuery(&q_insert);
+    if (!q_insert.Exec()) {
+      db_->ReportErrors(q_insert);
+      return;
     }
+    // Get the new ID
+    const int id = q_insert.lastInsertId().toInt();
 
     if (id == -1) return;
 
-    {  // Add to the FTS index
-      SqlQuery q(db);
-      q.prepare(QString("INSERT INTO %1 (ROWID, %2) VALUES (:id, %3)").arg(fts_table_, Song::kFtsColumnSpec, Song::kFtsBindSpec));
-      q.BindValue(":id", id);
-      song.BindToFtsQuery(&q);
-      if (!q.Exec()) {
-        db_->ReportErrors(q);
-        return;
-      }
+    // Add to the FTS index
+    q_insert_fts.BindValue(":id", id);
+    song.BindToFtsQuery(&q_insert_fts);
+    if (!q_insert_fts.Exec()) {
+      db_->ReportErrors(q_insert_fts);
+      return;
     }
 
-    Song song_copy(song);
-    song_copy.set_id(id);
-    added_songs << song_copy;
+    new_song.set_id(id);
+    added_songs << new_song;
+
+    Song inserted_song = new_song;
+    inserted_song.set_valid(true);
+    old_songs_by_id[id] = inserted_song;
+    if (!inserted_song.song_id().isEmpty()) old_songs_by_song_id[inserted_song.song_id()] = inserted_song;
 
   }
 
   transaction.Commit();
 
-  if (!deleted_songs.isEmpty()) emit SongsDeleted(deleted_songs);
-  if (!added_songs.isEmpty()) emit SongsDiscovered(added_songs);
+  // Report the changes in batches, so large scans don't stall the models with one huge update.
+  for (qint64 i = 0; i < deleted_songs.count(); i += kBatchSize) {
+    emit SongsDeleted(deleted_songs.mid(i, kBatchSize));
+  }
+  for (qint64 i = 0; i < added_songs.count(); i += kBatchSize) {
+    emit SongsDiscovered(added_songs.mid(i, kBatchSize));
+  }
 
   UpdateTotalSongCountAsync();
   UpdateTotalArtistCountAsync();
@@ -739,6 +789,89 @@ void CollectionBackend::UpdateSongsBySongID(const SongMap &new_songs) {
     }
   }
 
+  if (!ReplaceSongsBySongID(db, old_songs, new_songs, added_songs, deleted_songs)) return;
+
+  transaction.Commit();
+
+  if (!deleted_songs.isEmpty()) emit SongsDeleted(deleted_songs);
+  if (!added_songs.isEmpty()) emit SongsDiscovered(added_songs);
+
+  UpdateTotalSongCountAsync();
+  UpdateTotalArtistCountAsync();
+  UpdateTotalAlbumCountAsync();
+
+}
+
+void CollectionBackend::UpdateSongsByAlbumIDAsync(const QStringList &album_ids, const SongMap &new_songs) {
+  QMetaObject::invokeMethod(this, "UpdateSongsByAlbumID", Qt::QueuedConnection, Q_ARG(QStringList, album_ids), Q_ARG(SongMap, new_songs));
+}
+
+void CollectionBackend::UpdateSongsByAlbumID(const QStringList &album_ids, const SongMap &new_songs) {
+
+  if (album_ids.isEmpty() && new_songs.isEmpty()) return;
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  CollectionTask task(task_manager_, tr("Updating %1 database.").arg(Song::TextForSource(source_)));
+  ScopedTransaction transaction(&db);
+
+  SongList added_songs;
+  SongList deleted_songs;
+
+  SongMap old_songs;
+  for (qint64 i = 0; i < album_ids.count(); i += kAlbumIdBatchSize) {
+    const QStringList batch_album_ids = album_ids.mid(i, kAlbumIdBatchSize);
+
+    QStringList placeholders;
+    placeholders.reserve(batch_album_ids.count());
+    for (int j = 0; j < batch_album_ids.count(); ++j) {
+      placeholders << QString(":album_id%1").arg(j);
+    }
+
+    SqlQuery q(db);
+    q.prepare(QString("SELECT ROWID, %1 FROM %2 WHERE album_id IN (%3)").arg(Song::kColumnSpec, songs_table_, placeholders.join(", ")));
+    for (int j = 0; j < batch_album_ids.count(); ++j) {
+      q.BindValue(QString(":album_id%1").arg(j), batch_album_ids[j]);
+    }
+    if (!q.Exec()) {
+      db_->ReportErrors(q);
+      return;
+    }
+    while (q.next()) {
+      Song song(source_);
+      song.InitFromQuery(q, true);
+      old_songs.insert(song.song_id(), song);
+    }
+  }
+
+  // Songs that moved here from an album that wasn't updated must be updated, not added a second time.
+  QStringList moved_song_ids;
+  for (SongMap::const_iterator it = new_songs.begin(); it != new_songs.end(); ++it) {
+    if (!old_songs.contains(it.key())) moved_song_ids << it.key();
+  }
+  for (qint64 i = 0; i < moved_song_ids.count(); i += kBatchSize) {
+    const SongList songs = GetSongsBySongId(moved_song_ids.mid(i, kBatchSize), db);
+    for (const Song &song : songs) {
+      old_songs.insert(song.song_id(), song);
+    }
+  }
+
+  if (!ReplaceSongsBySongID(db, old_songs, new_songs, added_songs, deleted_songs)) return;
+
+  transaction.Commit();
+
+  if (!deleted_songs.isEmpty()) emit SongsDeleted(deleted_songs);
+  if (!added_songs.isEmpty()) emit SongsDiscovered(added_songs);
+
+  UpdateTotalSongCountAsync();
+  UpdateTotalArtistCountAsync();
+  UpdateTotalAlbumCountAsync();
+
+}
+
+bool CollectionBackend::ReplaceSongsBySongID(QSqlDatabase &db, const SongMap &old_songs, const SongMap &new_songs, SongList &added_songs, SongList &deleted_songs) {
+
   // Add or update songs.
   QList new_songs_list = new_songs.values();
   for (const Song &new_song : new_songs_list) {
@@ -755,7 +888,7 @@ void CollectionBackend::UpdateSongsBySongID(const SongMap &new_songs) {
           q.BindValue(":id", old_song.id());
           if (!q.Exec()) {
             db_->ReportErrors(q);
-            return;
+            return false;
           }
         }
         {
@@ -765,7 +898,7 @@ void CollectionBackend::UpdateSongsBySongID(const SongMap &new_songs) {
           q.BindValue(":id", old_song.id());
           if (!q.Exec()) {
             db_->ReportErrors(q);
-            return;
+            return false;
           }
         }
 
@@ -785,13 +918,13 @@ void CollectionBackend::UpdateSongsBySongID(const SongMap &new_songs) {
         new_song.BindToQuery(&q);
         if (!q.Exec()) {
           db_->ReportErrors(q);
-          return;
+          return false;
         }
         // Get the new ID
         id = q.lastInsertId().toInt();
       }
 
-      if (id == -1) return;
+      if (id == -1) return false;
 
       {  // Add to the FTS index
         SqlQuery q(db);
@@ -800,7 +933,7 @@ void CollectionBackend::UpdateSongsBySongID(const SongMap &new_songs) {
         new_song.BindToFtsQuery(&q);
         if (!q.Exec()) {
           db_->ReportErrors(q);
-          return;
+          return false;
         }
       }
 
@@ -820,7 +953,7 @@ void CollectionBackend::UpdateSongsBySongID(const SongMap &new_songs) {
         q.BindValue(":id", old_song.id());
         if (!q.Exec()) {
           db_->ReportErrors(q);
-          return;
+          return false;
         }
       }
       {
@@ -829,21 +962,38 @@ void CollectionBackend::UpdateSongsBySongID(const SongMap &new_songs) {
         q.BindValue(":id", old_song.id());
         if (!q.Exec()) {
           db_->ReportErrors(q);
-          return;
+          return false;
         }
       }
       deleted_songs << old_song;
     }
   }
 
-  transaction.Commit();
+  return true;
 
-  if (!deleted_songs.isEmpty()) emit SongsDeleted(deleted_songs);
-  if (!added_songs.isEmpty()) emit SongsDiscovered(added_songs);
+}
 
-  UpdateTotalSongCountAsync();
-  UpdateTotalArtistCountAsync();
-  UpdateTotalAlbumCountAsync();
+CollectionBackend::AlbumSyncStates CollectionBackend::GetAlbumSyncStates() {
+
+  QMutexLocker l(db_->Mutex());
+  QSqlDatabase db(db_->Connect());
+
+  SqlQuery q(db);
+  q.prepare(QString("SELECT album_id, MAX(mtime), COUNT(*) FROM %1 WHERE album_id != '' AND unavailable = 0 GROUP BY album_id").arg(songs_table_));
+  if (!q.Exec()) {
+    db_->ReportErrors(q);
+    return AlbumSyncStates();
+  }
+
+  AlbumSyncStates states;
+  while (q.next()) {
+    AlbumSyncState state;
+    state.mtime = q.value(1).toLongLong();
+    state.song_count = q.value(2).toInt();
+    states.insert(q.value(0).toString(), state);
+  }
+
+  return states;
 
 }
 
@@ -935,7 +1085,6 @@ void CollectionBackend::MarkSongsUnavailable(const SongList &songs, const bool u
 
 QStringList CollectionBackend::GetAll(const QString &column, const CollectionFilterOptions &filter_options) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   CollectionQuery query(db, songs_table_, fts_table_, filter_options);
@@ -962,7 +1111,6 @@ QStringList CollectionBackend::GetAllArtists(const CollectionFilterOptions &opt)
 
 QStringList CollectionBackend::GetAllArtistsWithAlbums(const CollectionFilterOptions &opt) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   // Albums with 'albumartist' field set:
@@ -1011,7 +1159,6 @@ CollectionBackend::AlbumList CollectionBackend::GetAlbumsByArtist(const QString
 SongList CollectionBackend::GetArtistSongs(const QString &effective_albumartist, const CollectionFilterOptions &opt) {
 
   QSqlDatabase db(db_->Connect());
-  QMutexLocker l(db_->Mutex());
 
   CollectionQuery query(db, songs_table_, fts_table_, opt);
   query.AddCompilationRequirement(false);
@@ -1029,7 +1176,6 @@ SongList CollectionBackend::GetArtistSongs(const QString &effective_albumartist,
 SongList CollectionBackend::GetAlbumSongs(const QString &effective_albumartist, const QString &album, const CollectionFilterOptions &opt) {
 
   QSqlDatabase db(db_->Connect());
-  QMutexLocker l(db_->Mutex());
 
   CollectionQuery query(db, songs_table_, fts_table_, opt);
   query.AddCompilationRequirement(false);
@@ -1048,7 +1194,6 @@ SongList CollectionBackend::GetAlbumSongs(const QString &effective_albumartist,
 SongList CollectionBackend::GetSongsByAlbum(const QString &album, const CollectionFilterOptions &opt) {
 
   QSqlDatabase db(db_->Connect());
-  QMutexLocker l(db_->Mutex());
 
   CollectionQuery query(db, songs_table_, fts_table_, opt);
   query.AddCompilationRequirement(false);
@@ -1095,7 +1240,6 @@ bool CollectionBackend::ExecCollectionQuery(CollectionQuery *query, SongMap &son
 
 Song CollectionBackend::GetSongById(const int id) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
   return GetSongById(id, db);
 
@@ -1103,7 +1247,6 @@ Song CollectionBackend::GetSongById(const int id) {
 
 SongList CollectionBackend::GetSongsById(const QList<int> &ids) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   QStringList str_ids;
@@ -1118,7 +1261,6 @@ SongList CollectionBackend::GetSongsById(const QList<int> &ids) {
 
 SongList CollectionBackend::GetSongsById(const QStringList &ids) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   return GetSongsById(ids, db);
@@ -1127,7 +1269,6 @@ SongList CollectionBackend::GetSongsById(const QStringList &ids) {
 
 SongList CollectionBackend::GetSongsByForeignId(const QStringList &ids, const QString &table, const QString &column) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   QString in = ids.join(",");
@@ -1153,9 +1294,20 @@ SongList CollectionBackend::GetSongsByForeignId(const QStringList &ids, const QS
 
 Song CollectionBackend::GetSongById(const int id, QSqlDatabase &db) {
 
-  SongList list = GetSongsById(QStringList() << QString::number(id), db);
-  if (list.isEmpty()) return Song();
-  return list.first();
+  // Bind the ID instead of building an IN list, so every lookup shares the same cached statement.
+  SqlQuery q(db);
+  q.prepare(QString("SELECT ROWID, %1 FROM %2 WHERE ROWID = :id").arg(Song::kColumnSpec, songs_table_));
+  q.BindValue(":id", id);
+  if (!q.Exec()) {
+    db_->ReportErrors(q);
+    return Song();
+  }
+
+  if (!q.next()) return Song();
+
+  Song song(source_);
+  song.InitFromQuery(q, true);
+  return song;
 
 }
 
@@ -1182,7 +1334,6 @@ SongList CollectionBackend::GetSongsById(const QStringList &ids, QSqlDatabase &d
 
 Song CollectionBackend::GetSongByUrl(const QUrl &url, const qint64 beginning) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   SqlQuery q(db);
@@ -1210,9 +1361,48 @@ Song CollectionBackend::GetSongByUrl(const QUrl &url, const qint64 beginning) {
 
 }
 
+SongList CollectionBackend::GetSongsByUrls(const QList<QUrl> &urls) {
+
+  QSqlDatabase db(db_->Connect());
+
+  SongList songs;
+  for (qint64 i = 0; i < urls.count(); i += kUrlBatchSize) {
+    const QList<QUrl> batch_urls = urls.mid(i, kUrlBatchSize);
+
+    QStringList placeholders;
+    placeholders.reserve(batch_urls.count());
+    for (int j = 0; j < batch_urls.count(); ++j) {
+      placeholders << QString(":url%1_1, :url%1_2, :url%1_3, :url%1_4").arg(j);
+    }
+
+    SqlQuery q(db);
+    q.prepare(QString("SELECT ROWID, %1 FROM %2 WHERE url IN (%3) AND unavailable = 0").arg(Song::kColumnSpec, songs_table_, placeholders.join(", ")));
+    for (int j = 0; j < batch_urls.count(); ++j) {
+      const QUrl &url = batch_urls[j];
+      q.BindValue(QString(":url%1_1").arg(j), url);
+      q.BindValue(QString(":url%1_2").arg(j), url.toString());
+      q.BindValue(QString(":url%1_3").arg(j), url.toString(QUrl::FullyEncoded));
+      q.BindValue(QString(":url%1_4").arg(j), url.toEncoded());
+    }
+
+    if (!q.Exec()) {
+      db_->ReportErrors(q);
+      return SongList();
+    }
+
+    while (q.next()) {
+      Song song(source_);
+      song.InitFromQuery(q, true);
+      songs << song;
+    }
+  }
+
+  return songs;
+
+}
+
 SongList CollectionBackend::GetSongsByUrl(const QUrl &url, const bool unavailable) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   SqlQuery q(db);
@@ -1243,7 +1433,6 @@ SongList CollectionBackend::GetSongsByUrl(const QUrl &url, const bool unavailabl
 
 Song CollectionBackend::GetSongBySongId(const QString &song_id) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
   return GetSongBySongId(song_id, db);
 
@@ -1251,7 +1440,6 @@ Song CollectionBackend::GetSongBySongId(const QString &song_id) {
 
 SongList CollectionBackend::GetSongsBySongId(const QStringList &song_ids) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   return GetSongsBySongId(song_ids, db);
@@ -1268,25 +1456,31 @@ Song CollectionBackend::GetSongBySongId(const QString &song_id, QSqlDatabase &db
 
 SongList CollectionBackend::GetSongsBySongId(const QStringList &song_ids, QSqlDatabase &db) {
 
-  QStringList song_ids2;
-  song_ids2.reserve(song_ids.count());
-  for (const QString &song_id : song_ids) {
-    song_ids2 << "'" + song_id + "'";
-  }
-  QString in = song_ids2.join(",");
+  SongList ret;
+  for (qint64 i = 0; i < song_ids.count(); i += kSongIdBatchSize) {
+    const QStringList batch_song_ids = song_ids.mid(i, kSongIdBatchSize);
 
-  SqlQuery q(db);
-  q.prepare(QString("SELECT ROWID, %1 FROM %2 WHERE SONG_ID IN (%3)").arg(Song::kColumnSpec, songs_table_, in));
-  if (!q.Exec()) {
-    db_->ReportErrors(q);
-    return SongList();
-  }
+    QStringList placeholders;
+    placeholders.reserve(batch_song_ids.count());
+    for (int j = 0; j < batch_song_ids.count(); ++j) {
+      placeholders << QString(":song_id%1").arg(j);
+    }
 
-  SongList ret;
-  while (q.next()) {
-    Song song(source_);
-    song.InitFromQuery(q, true);
-    ret << song;
+    SqlQuery q(db);
+    q.prepare(QString("SELECT ROWID, %1 FROM %2 WHERE song_id IN (%3)").arg(Song::kColumnSpec, songs_table_, placeholders.join(", ")));
+    for (int j = 0; j < batch_song_ids.count(); ++j) {
+      q.BindValue(QString(":song_id%1").arg(j), batch_song_ids[j]);
+    }
+    if (!q.Exec()) {
+      db_->ReportErrors(q);
+      return SongList();
+    }
+
+    while (q.next()) {
+      Song song(source_);
+      song.InitFromQuery(q, true);
+      ret << song;
+    }
   }
 
   return ret;
@@ -1295,7 +1489,6 @@ SongList CollectionBackend::GetSongsBySongId(const QStringList &song_ids, QSqlDa
 
 SongList CollectionBackend::GetSongsByFingerprint(const QString &fingerprint) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   SqlQuery q(db);
@@ -1324,7 +1517,6 @@ CollectionBackend::AlbumList CollectionBackend::GetCompilationAlbums(const Colle
 
 SongList CollectionBackend::GetCompilationSongs(const QString &album, const CollectionFilterOptions &opt) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   CollectionQuery query(db, songs_table_, fts_table_, opt);
@@ -1461,7 +1653,6 @@ bool CollectionBackend::UpdateCompilations(const QSqlDatabase &db, SongList &del
 
 CollectionBackend::AlbumList CollectionBackend::GetAlbums(const QString &artist, const bool compilation_required, const CollectionFilterOptions &opt) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   CollectionQuery query(db, songs_table_, fts_table_, opt);
@@ -1548,7 +1739,6 @@ CollectionBackend::AlbumList CollectionBackend::GetAlbums(const QString &artist,
 
 CollectionBackend::Album CollectionBackend::GetAlbumArt(const QString &effective_albumartist, const QString &album) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   Album ret;
@@ -2003,7 +2193,6 @@ void CollectionBackend::DeleteAll() {
 
 SongList CollectionBackend::SmartPlaylistsFindSongs(const SmartPlaylistSearch &search) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   // Build the query
@@ -2037,7 +2226,6 @@ SongList CollectionBackend::SmartPlaylistsGetAllSongs() {
 
 SongList CollectionBackend::GetSongsBy(const QString &artist, const QString &album, const QString &title) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   SongList songs;
@@ -2183,6 +2371,35 @@ void CollectionBackend::UpdateLastSeen(const int directory_id, const int expire_
 
 }
 
+void CollectionBackend::UpdateLoudnessCharacteristics(const SongList &songs) {
+
+  if (songs.isEmpty()) return;
+
+  {
+    QMutexLocker l(db_->Mutex());
+    QSqlDatabase db(db_->Connect());
+    ScopedTransaction transaction(&db);
+
+    SqlQuery q(db);
+    q.prepare(QString("UPDATE %1 SET ebur128_integrated_loudness_lufs = :ebur128_integrated_loudness_lufs, ebur128_loudness_range_lu = :ebur128_loudness_range_lu WHERE ROWID = :id").arg(songs_table_));
+    for (const Song &song : songs) {
+      q.BindDoubleOrNullValue(":ebur128_integrated_loudness_lufs", song.ebur128_integrated_loudness_lufs());
+      q.BindDoubleOrNullValue(":ebur128_loudness_range_lu", song.ebur128_loudness_range_lu());
+      q.BindValue(":id", song.id());
+      if (!q.Exec()) {
+        db_->ReportErrors(q);
+        return;
+      }
+    }
+
+    transaction.Commit();
+  }
+
+  // The collection model already has these songs, this only updates the playlist items.
+  emit SongsDiscovered(songs);
+
+}
+
 void CollectionBackend::ExpireSongs(const int directory_id, const int expire_unavailable_songs_days) {
 
   SongList songs;
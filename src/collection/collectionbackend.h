@@ -31,6 +31,7 @@
 #include <QObject>
 #include <QFileInfo>
 #include <QList>
+#include <QHash>
 #include <QString>
 #include <QStringList>
 #include <QUrl>
@@ -130,6 +131,8 @@ class CollectionBackendInterface : public QObject {
   // Returns a section of a song with the given filename and beginning. If the section is not present in collection, returns invalid song.
   // Using default beginning value is suitable when searching for single-section songs.
   virtual Song GetSongByUrl(const QUrl &url, const qint64 beginning = 0) = 0;
+  // Returns all available sections of the songs with any of the given filenames, looked up in batches.
+  virtual SongList GetSongsByUrls(const QList<QUrl> &urls) = 0;
 
   virtual void AddDirectory(const QString &path) = 0;
   virtual void RemoveDirectory(const CollectionDirectory &dir) = 0;
@@ -144,6 +147,23 @@ class CollectionBackend : public CollectionBackendInterface {
 
   ~CollectionBackend();
 
+  // Number of songs per SongsDiscovered / SongsDeleted signal and per IN (...) lookup when adding or updating many songs.
+  static const int kBatchSize;
+  // Number of URLs per query in GetSongsByUrls(), each URL is bound in 4 encodings and SQLite allows 999 parameters.
+  static const int kUrlBatchSize;
+  // Number of album IDs per query in UpdateSongsByAlbumID().
+  static const int kAlbumIdBatchSize;
+  // Number of song IDs per query in GetSongsBySongId(), SQLite allows 999 parameters.
+  static const int kSongIdBatchSize;
+
+  // The newest mtime and the number of songs of an album, streaming services store the time the album last changed on the server as mtime.
+  struct AlbumSyncState {
+    AlbumSyncState() : mtime(0), song_count(0) {}
+    qint64 mtime;
+    int song_count;
+  };
+  using AlbumSyncStates = QHash<QString, AlbumSyncState>;
+
   void Init(SharedPtr<Database> db, SharedPtr<TaskManager> task_manager, const Song::Source source, const QString &songs_table, const QString &fts_table, const QString &dirs_table = QString(), const QString &subdirs_table = QString());
   void Close();
 
@@ -170,6 +190,9 @@ class CollectionBackend : public CollectionBackendInterface {
   SongList FindSongsInDirectory(const int id) override;
   SongList SongsWithMissingFingerprint(const int id) override;
   SongList SongsWithMissingLoudnessCharacteristics(const int id) override;
+  // Songs in all directories, ordered by ID and starting after the given ID, so they can be fetched in batches.
+  SongList NextSongsWithMissingLoudnessCharacteristics(const int after_id, const int limit);
+  int CountSongsWithMissingLoudnessCharacteristics();
   CollectionSubdirectoryList SubdirsInDirectory(const int id) override;
   CollectionDirectoryList GetAllDirectories() override;
   void ChangeDirPath(const int id, const QString &old_path, const QString &new_path) override;
@@ -203,6 +226,7 @@ class CollectionBackend : public CollectionBackendInterface {
 
   SongList GetSongsByUrl(const QUrl &url, const bool unavailable = false) override;
   Song GetSongByUrl(const QUrl &url, qint64 beginning = 0) override;
+  SongList GetSongsByUrls(const QList<QUrl> &urls) override;
 
   void AddDirectory(const QString &path) override;
   void RemoveDirectory(const CollectionDirectory &dir) override;
@@ -227,6 +251,10 @@ class CollectionBackend : public CollectionBackendInterface {
 
   void AddOrUpdateSongsAsync(const SongList &songs);
   void UpdateSongsBySongIDAsync(const SongMap &new_songs);
+  void UpdateSongsByAlbumIDAsync(const QStringList &album_ids, const SongMap &new_songs);
+
+  // Returns the sync state of every album ID in the collection, for syncing only the albums that changed.
+  AlbumSyncStates GetAlbumSyncStates();
 
   void UpdateSongRatingAsync(const int id, const float rating, const bool save_tags = false);
   void UpdateSongsRatingAsync(const QList<int> &ids, const float rating, const bool save_tags = false);
@@ -239,6 +267,8 @@ class CollectionBackend : public CollectionBackendInterface {
   void UpdateTotalAlbumCount();
   void AddOrUpdateSongs(const SongList &songs);
   void UpdateSongsBySongID(const SongMap &new_songs);
+  // Like UpdateSongsBySongID(), but only the songs in the given albums are added, updated or deleted.
+  void UpdateSongsByAlbumID(const QStringList &album_ids, const SongMap &new_songs);
   void UpdateMTimesOnly(const SongList &songs);
   void DeleteSongs(const SongList &songs);
   void MarkSongsUnavailable(const SongList &songs, const bool unavailable = true);
@@ -265,6 +295,7 @@ class CollectionBackend : public CollectionBackendInterface {
   void UpdateSongsRating(const QList<int> &id_list, const float rating, const bool save_tags = false);
 
   void UpdateLastSeen(const int directory_id, const int expire_unavailable_songs_days);
+  void UpdateLoudnessCharacteristics(const SongList &songs);
   void ExpireSongs(const int directory_id, const int expire_unavailable_songs_days);
 
  signals:
@@ -308,6 +339,8 @@ class CollectionBackend : public CollectionBackendInterface {
   Song GetSongBySongId(const QString &song_id, QSqlDatabase &db);
   SongList GetSongsBySongId(const QStringList &song_ids, QSqlDatabase &db);
 
+  bool ReplaceSongsBySongID(QSqlDatabase &db, const SongMap &old_songs, const SongMap &new_songs, SongList &added_songs, SongList &deleted_songs);
+
  private:
   SharedPtr<Database> db_;
   SharedPtr<TaskManager> task_manager_;
@@ -43,11 +43,17 @@ using CollectionDirectoryList = QList<CollectionDirectory>;
 Q_DECLARE_METATYPE(CollectionDirectoryList)
 
 struct CollectionSubdirectory {
-  CollectionSubdirectory() : directory_id(-1), mtime(0) {}
+  CollectionSubdirectory() : directory_id(-1), mtime(0), inode(0), child_count(0), entries_hash(0) {}
 
   int directory_id;
   QString path;
   qint64 mtime;
+
+  // Scan journal, recorded the last time the directory was listed.
+  // An inode of 0 means the directory has not been journaled yet.
+  quint64 inode;
+  quint64 child_count;
+  qint64 entries_hash;
 };
 Q_DECLARE_METATYPE(CollectionSubdirectory)
 
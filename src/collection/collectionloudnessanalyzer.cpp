@@ -0,0 +1,180 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <utility>
+#include <optional>
+
+#include <QtGlobal>
+#include <QObject>
+#include <QThread>
+#include <QThreadPool>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QList>
+#include <QtConcurrentRun>
+
+#include "core/logging.h"
+#include "core/song.h"
+#include "core/taskmanager.h"
+#include "utilities/threadutils.h"
+#include "engine/ebur128measures.h"
+#include "engine/ebur128analysis.h"
+#include "collectionbackend.h"
+#include "collectionloudnessanalyzer.h"
+
+const int CollectionLoudnessAnalyzer::kBatchSize = 50;
+
+CollectionLoudnessAnalyzer::CollectionLoudnessAnalyzer(SharedPtr<CollectionBackend> backend, SharedPtr<TaskManager> task_manager, QObject *parent)
+    : QObject(parent),
+      backend_(backend),
+      task_manager_(task_manager),
+      thread_pool_(new QThreadPool(this)),
+      stop_requested_(false),
+      restart_requested_(false) {
+
+  // Leave some of the cores for playback and the rest of the program.
+  // Run() takes one more thread, it only waits for the songs being analyzed.
+  thread_pool_->setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2) + 1);
+
+}
+
+CollectionLoudnessAnalyzer::~CollectionLoudnessAnalyzer() {
+
+  // The songs being analyzed are aborted, so this only waits for the pipelines to shut down.
+  stop_requested_ = true;
+  future_.waitForFinished();
+
+}
+
+void CollectionLoudnessAnalyzer::Start() {
+
+  if (is_running()) {
+    // Still stopping, start again once it has stopped.
+    if (stop_requested_) restart_requested_ = true;
+    return;
+  }
+
+  stop_requested_ = false;
+  restart_requested_ = false;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+  future_ = QtConcurrent::run(thread_pool_, &CollectionLoudnessAnalyzer::Run, this);
+#else
+  future_ = QtConcurrent::run(thread_pool_, this, &CollectionLoudnessAnalyzer::Run);
+#endif
+  QFutureWatcher<void> *watcher = new QFutureWatcher<void>();
+  QObject::connect(watcher, &QFutureWatcher<void>::finished, this, [this, watcher]() {
+    RunFinished();
+    watcher->deleteLater();
+  });
+  watcher->setFuture(future_);
+
+}
+
+void CollectionLoudnessAnalyzer::Stop() {
+
+  stop_requested_ = true;
+  restart_requested_ = false;
+
+}
+
+void CollectionLoudnessAnalyzer::RunFinished() {
+
+  if (restart_requested_) {
+    Start();
+    return;
+  }
+
+  emit Finished();
+
+}
+
+void CollectionLoudnessAnalyzer::Run() {
+
+  const int total = backend_->CountSongsWithMissingLoudnessCharacteristics() - static_cast<int>(failed_song_ids_.count());
+  if (total <= 0) return;
+
+  qLog(Debug) << "Analyzing loudness of" << total << "songs";
+
+  const int task_id = task_manager_->StartTask(tr("Analyzing loudness"));
+  task_manager_->SetTaskProgress(task_id, 0, total);
+
+  // Songs that could not be analyzed are still missing the loudness characteristics,
+  // so go through the songs by ID, to not select them again in this run.
+  int last_id = -1;
+  int done = 0;
+  while (!stop_requested_) {
+    SongList songs = backend_->NextSongsWithMissingLoudnessCharacteristics(last_id, kBatchSize);
+    if (songs.isEmpty()) break;
+    last_id = songs.last().id();
+
+    songs.erase(std::remove_if(songs.begin(), songs.end(), [this](const Song &song) { return failed_song_ids_.contains(song.id()); }), songs.end());
+
+    QList<QFuture<Song>> futures;
+    futures.reserve(songs.count());
+    for (const Song &song : std::as_const(songs)) {
+      futures << QtConcurrent::run(thread_pool_, &CollectionLoudnessAnalyzer::Analyze, song, &stop_requested_);
+    }
+
+    SongList analyzed_songs;
+    for (int i = 0; i < futures.count(); ++i) {
+      const Song song = futures[i].result();
+      if (song.is_valid()) {
+        analyzed_songs << song;
+      }
+      else if (!stop_requested_) {
+        failed_song_ids_.insert(songs[i].id());
+      }
+      task_manager_->SetTaskProgress(task_id, ++done, qMax(total, done));
+    }
+
+    backend_->UpdateLoudnessCharacteristics(analyzed_songs);
+  }
+
+  task_manager_->SetTaskFinished(task_id);
+
+  qLog(Debug) << "Finished analyzing loudness," << done << "songs processed";
+
+}
+
+Song CollectionLoudnessAnalyzer::Analyze(const Song &song, const std::atomic<bool> *stop_requested) {
+
+  // Skip the rest of the batch when stopping, the songs are analyzed in the next run.
+  if (*stop_requested) return Song();
+
+  // The pool threads are reused, so this only makes a difference the first time, but it's cheap.
+  Utilities::SetThreadIOPriority(Utilities::IoPriority::IOPRIO_CLASS_IDLE);
+
+  const std::optional<EBUR128Measures> measures = EBUR128Analysis::Compute(song, stop_requested);
+  if (*stop_requested) return Song();
+  if (!measures) {
+    qLog(Error) << "Could not analyze loudness of" << song.url();
+    return Song();
+  }
+
+  Song analyzed_song = song;
+  analyzed_song.set_ebur128_integrated_loudness_lufs(measures->loudness_lufs);
+  analyzed_song.set_ebur128_loudness_range_lu(measures->range_lu);
+
+  return analyzed_song;
+
+}
@@ -0,0 +1,76 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COLLECTIONLOUDNESSANALYZER_H
+#define COLLECTIONLOUDNESSANALYZER_H
+
+#include "config.h"
+
+#include <atomic>
+
+#include <QObject>
+#include <QFuture>
+#include <QSet>
+
+#include "core/shared_ptr.h"
+#include "core/song.h"
+
+class QThreadPool;
+class CollectionBackend;
+class TaskManager;
+
+// Runs the EBU R 128 analysis in the background for the collection songs that don't have loudness characteristics yet.
+// Results are saved in batches, so when the job is stopped or the program is closed, the next run picks up the remaining songs.
+// Songs that could not be analyzed are remembered, and not tried again until the program is restarted.
+class CollectionLoudnessAnalyzer : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit CollectionLoudnessAnalyzer(SharedPtr<CollectionBackend> backend, SharedPtr<TaskManager> task_manager, QObject *parent = nullptr);
+  ~CollectionLoudnessAnalyzer() override;
+
+  bool is_running() const { return future_.isRunning(); }
+
+ public slots:
+  void Start();
+  // Aborts the songs being analyzed and returns right away, Finished() is emitted when the analysis has stopped.
+  void Stop();
+
+ signals:
+  void Finished();
+
+ private:
+  void Run();
+  void RunFinished();
+  static Song Analyze(const Song &song, const std::atomic<bool> *stop_requested);
+
+ private:
+  static const int kBatchSize;
+
+  SharedPtr<CollectionBackend> backend_;
+  SharedPtr<TaskManager> task_manager_;
+  QThreadPool *thread_pool_;
+  QFuture<void> future_;
+  std::atomic<bool> stop_requested_;
+  bool restart_requested_;
+  // Only used by Run(), and there is only one run at a time.
+  QSet<int> failed_song_ids_;
+};
+
+#endif  // COLLECTIONLOUDNESSANALYZER_H
@@ -49,8 +49,8 @@
 #include <QChar>
 #include <QRegularExpression>
 #include <QPixmapCache>
-#include <QNetworkDiskCache>
 #include <QSettings>
+#include <QDir>
 #include <QStandardPaths>
 
 #include "core/scoped_ptr.h"
@@ -73,12 +73,14 @@
 #include "covermanager/albumcoverloaderoptions.h"
 #include "covermanager/albumcoverloaderresult.h"
 #include "covermanager/albumcoverloader.h"
+#include "covermanager/albumcoverthumbnailstore.h"
 #include "settings/collectionsettingspage.h"
 
 const int CollectionModel::kPrettyCoverSize = 32;
 const char *CollectionModel::kPixmapDiskCacheDir = "pixmapcache";
+const char *CollectionModel::kIconStoreName = "collection";
 
-QNetworkDiskCache *CollectionModel::sIconCache = nullptr;
+ScopedPtr<AlbumCoverThumbnailStore> CollectionModel::sIconStore;
 
 CollectionModel::CollectionModel(SharedPtr<CollectionBackend> backend, Application *app, QObject *parent)
     : SimpleTreeModel<CollectionItem>(new CollectionItem(this), parent),
@@ -114,9 +116,10 @@ CollectionModel::CollectionModel(SharedPtr<CollectionBackend> backend, Applicati
     no_cover_icon_ = nocover.pixmap(nocover_sizes.last()).scaled(kPrettyCoverSize, kPrettyCoverSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
   }
 
-  if (app_ && !sIconCache) {
-    sIconCache = new QNetworkDiskCache(this);
-    sIconCache->setCacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/" + kPixmapDiskCacheDir);
+  if (app_ && !sIconStore) {
+    sIconStore.reset(new AlbumCoverThumbnailStore(kIconStoreName, QSize(kPrettyCoverSize, kPrettyCoverSize)));
+    // Icons used to be stored as XPM in a QNetworkDiskCache, that cache is not used anymore.
+    QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/" + kPixmapDiskCacheDir).removeRecursively();
     QObject::connect(app_, &Application::ClearPixmapDiskCache, this, &CollectionModel::ClearDiskCache);
   }
 
@@ -173,16 +176,20 @@ void CollectionModel::ReloadSettings() {
 
   QPixmapCache::setCacheLimit(static_cast<int>(MaximumCacheSize(&s, CollectionSettingsPage::kSettingsCacheSize, CollectionSettingsPage::kSettingsCacheSizeUnit, CollectionSettingsPage::kSettingsCacheSizeDefault) / 1024));
 
-  if (sIconCache) {
-    sIconCache->setMaximumCacheSize(MaximumCacheSize(&s, CollectionSettingsPage::kSettingsDiskCacheSize, CollectionSettingsPage::kSettingsDiskCacheSizeUnit, CollectionSettingsPage::kSettingsDiskCacheSizeDefault));
-  }
+  const qint64 disk_cache_size = MaximumCacheSize(&s, CollectionSettingsPage::kSettingsDiskCacheSize, CollectionSettingsPage::kSettingsDiskCacheSizeUnit, CollectionSettingsPage::kSettingsDiskCacheSizeDefault);
 
   s.endGroup();
 
   cover_types_ = AlbumCoverLoaderOptions::LoadTypes();
 
-  if (!use_disk_cache_) {
-    ClearDiskCache();
+  if (sIconStore) {
+    if (use_disk_cache_) {
+      sIconStore->Open(disk_cache_size);
+    }
+    else {
+      ClearDiskCache();
+      sIconStore->Close();
+    }
   }
 
 }
@@ -562,7 +569,7 @@ void CollectionModel::SongsDeleted(const SongList &songs) {
       // Remove from pixmap cache
       const QString cache_key = AlbumIconPixmapCacheKey(ItemToIndex(node));
       QPixmapCache::remove(cache_key);
-      if (use_disk_cache_ && sIconCache) sIconCache->remove(AlbumIconPixmapDiskCacheKey(cache_key));
+      if (use_disk_cache_ && sIconStore) sIconStore->Remove(cache_key);
       if (pending_cache_keys_.contains(cache_key)) {
         pending_cache_keys_.remove(cache_key);
       }
@@ -617,12 +624,6 @@ QString CollectionModel::AlbumIconPixmapCacheKey(const QModelIndex &idx) const {
 
 }
 
-QUrl CollectionModel::AlbumIconPixmapDiskCacheKey(const QString &cache_key) const {
-
-  return QUrl(QUrl::toPercentEncoding(cache_key));
-
-}
-
 QVariant CollectionModel::AlbumIcon(const QModelIndex &idx) {
 
   CollectionItem *item = IndexToItem(idx);
@@ -636,15 +637,13 @@ QVariant CollectionModel::AlbumIcon(const QModelIndex &idx) {
     return cached_pixmap;
   }
 
-  // Try to load it from the disk cache
-  if (use_disk_cache_ && sIconCache) {
-    ScopedPtr<QIODevice> disk_cache_img(sIconCache->data(AlbumIconPixmapDiskCacheKey(cache_key)));
-    if (disk_cache_img) {
-      QImage cached_image;
-      if (cached_image.load(&*disk_cache_img, "XPM")) {
-        QPixmapCache::insert(cache_key, QPixmap::fromImage(cached_image));
-        return QPixmap::fromImage(cached_image);
-      }
+  // Try the thumbnail store, the image is read from the mapped file as is
+  if (use_disk_cache_ && sIconStore) {
+    const QImage cached_image = sIconStore->Image(cache_key);
+    if (!cached_image.isNull()) {
+      const QPixmap cached_image_pixmap = QPixmap::fromImage(cached_image);
+      QPixmapCache::insert(cache_key, cached_image_pixmap);
+      return cached_image_pixmap;
     }
   }
 
@@ -691,22 +690,9 @@ void CollectionModel::AlbumCoverLoaded(const quint64 id, const AlbumCoverLoaderR
     QPixmapCache::insert(cache_key, image_pixmap);
   }
 
-  // If we have a valid cover not already in the disk cache
-  if (use_disk_cache_ && sIconCache && result.success && !result.image_scaled.isNull()) {
-    const QUrl disk_cache_key = AlbumIconPixmapDiskCacheKey(cache_key);
-    ScopedPtr<QIODevice> disk_cache_img(sIconCache->data(disk_cache_key));
-    if (!disk_cache_img) {
-      QNetworkCacheMetaData disk_cache_metadata;
-      disk_cache_metadata.setSaveToDisk(true);
-      disk_cache_metadata.setUrl(disk_cache_key);
-      // Qt 6 now ignores any entry without headers, so add a fake header.
-      disk_cache_metadata.setRawHeaders(QNetworkCacheMetaData::RawHeaderList() << qMakePair(QByteArray(), QByteArray()));
-      QIODevice *device_iconcache = sIconCache->prepare(disk_cache_metadata);
-      if (device_iconcache) {
-        result.image_scaled.save(device_iconcache, "XPM");
-        sIconCache->insert(device_iconcache);
-      }
-    }
+  // If we have a valid cover not already in the thumbnail store
+  if (use_disk_cache_ && sIconStore && result.success && !result.image_scaled.isNull() && !sIconStore->Contains(cache_key)) {
+    sIconStore->Insert(cache_key, result.image_scaled);
   }
 
   const QModelIndex idx = ItemToIndex(item);
@@ -868,8 +854,6 @@ CollectionQueryOptions CollectionModel::PrepareQuery(CollectionItem *parent) {
 
 CollectionModel::QueryResult CollectionModel::RunQuery(const CollectionFilterOptions &filter_options, const CollectionQueryOptions &query_options) {
 
-  QMutexLocker l(backend_->db()->Mutex());
-
   QueryResult result;
   {
 
@@ -1965,7 +1949,7 @@ void CollectionModel::TotalAlbumCountUpdatedSlot(const int count) {
 }
 
 void CollectionModel::ClearDiskCache() {
-  if (sIconCache) sIconCache->clear();
+  if (sIconStore) sIconStore->Clear();
 }
 
 void CollectionModel::ExpandAll(CollectionItem *item) const {
@@ -43,14 +43,15 @@
 #include <QImage>
 #include <QIcon>
 #include <QPixmap>
-#include <QNetworkDiskCache>
 
+#include "core/scoped_ptr.h"
 #include "core/shared_ptr.h"
 #include "core/simpletreemodel.h"
 #include "core/song.h"
 #include "core/sqlrow.h"
 #include "covermanager/albumcoverloaderoptions.h"
 #include "covermanager/albumcoverloaderresult.h"
+#include "covermanager/albumcoverthumbnailstore.h"
 #include "collectionfilteroptions.h"
 #include "collectionqueryoptions.h"
 #include "collectionitem.h"
@@ -70,6 +71,7 @@ class CollectionModel : public SimpleTreeModel<CollectionItem> {
 
   static const int kPrettyCoverSize;
   static const char *kPixmapDiskCacheDir;
+  static const char *kIconStoreName;
 
   enum Role {
     Role_Type = Qt::UserRole + 1,
@@ -178,7 +180,7 @@ class CollectionModel : public SimpleTreeModel<CollectionItem> {
   static QString SortTextForYear(const int year);
   static QString SortTextForBitrate(const int bitrate);
 
-  quint64 icon_cache_disk_size() { return sIconCache->cacheSize(); }
+  quint64 icon_cache_disk_size() { return sIconStore ? sIconStore->used_size() : 0; }
 
   static bool IsArtistGroupBy(const GroupBy group_by) {
     return group_by == CollectionModel::GroupBy::Artist || group_by == CollectionModel::GroupBy::AlbumArtist;
@@ -267,7 +269,6 @@ class CollectionModel : public SimpleTreeModel<CollectionItem> {
   // Helpers
   static bool IsCompilationArtistNode(const CollectionItem *node) { return node == node->parent->compilation_artist_node_; }
   QString AlbumIconPixmapCacheKey(const QModelIndex &idx) const;
-  QUrl AlbumIconPixmapDiskCacheKey(const QString &cache_key) const;
   QVariant AlbumIcon(const QModelIndex &idx);
   QVariant data(const CollectionItem *item, const int role) const;
   bool CompareItems(const CollectionItem *a, const CollectionItem *b) const;
@@ -301,7 +302,7 @@ class CollectionModel : public SimpleTreeModel<CollectionItem> {
   // Used as a generic icon to show when no cover art is found, fixed to the same size as the artwork (32x32)
   QPixmap no_cover_icon_;
 
-  static QNetworkDiskCache *sIconCache;
+  static ScopedPtr<AlbumCoverThumbnailStore> sIconStore;
 
   int init_task_id_;
 
@@ -64,6 +64,14 @@ QVariant CollectionPlaylistItem::DatabaseValue(DatabaseColumn column) const {
 
 }
 
+Song CollectionPlaylistItem::DatabaseSongMetadata() const {
+
+  // Only the collection ID is saved, so all items share the same empty song.
+  static const Song song(Song::Source::Collection);
+  return song;
+
+}
+
 Song CollectionPlaylistItem::Metadata() const {
 
   if (HasTemporaryMetadata()) return temp_metadata_;
@@ -33,13 +33,14 @@
 #include <QSqlQuery>
 
 #include "core/song.h"
+#include "core/sqlquery.h"
 
 #include "collectionquery.h"
 #include "collectionfilteroptions.h"
 #include "utilities/searchparserutils.h"
 
 CollectionQuery::CollectionQuery(const QSqlDatabase &db, const QString &songs_table, const QString &fts_table, const CollectionFilterOptions &filter_options)
-    : QSqlQuery(db),
+    : SqlQuery(db),
       songs_table_(songs_table),
       fts_table_(fts_table),
       include_unavailable_(false),
@@ -272,7 +273,7 @@ bool CollectionQuery::Exec() {
   sql.replace("%fts_table_noprefix", fts_table_.section('.', -1, -1));
   sql.replace("%fts_table", fts_table_);
 
-  if (!QSqlQuery::prepare(sql)) return false;
+  if (!SqlQuery::prepare(sql)) return false;
 
   // Bind values
   for (const QVariant &value : bound_values_) {
@@ -31,9 +31,10 @@
 #include <QSqlDatabase>
 #include <QSqlQuery>
 
+#include "core/sqlquery.h"
 #include "collectionfilteroptions.h"
 
-class CollectionQuery : public QSqlQuery {
+class CollectionQuery : public SqlQuery {
  public:
   explicit CollectionQuery(const QSqlDatabase &db, const QString &songs_table, const QString &fts_table, const CollectionFilterOptions &filter_options = CollectionFilterOptions());
 
@@ -80,7 +81,6 @@ class CollectionQuery : public QSqlQuery {
  private:
   QString GetInnerQuery() const;
 
-  QSqlDatabase db_;
   QString songs_table_;
   QString fts_table_;
 
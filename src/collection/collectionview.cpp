@@ -43,6 +43,8 @@
 #include <QFontMetrics>
 #include <QMenu>
 #include <QAction>
+#include <QTimer>
+#include <QScrollBar>
 #include <QMessageBox>
 #include <QSettings>
 #include <QtEvents>
@@ -73,6 +75,8 @@
 
 using std::make_unique;
 
+const int CollectionView::kPrefetchDelayMsec = 50;
+
 CollectionView::CollectionView(QWidget *parent)
     : AutoExpandingTreeView(parent),
       app_(nullptr),
@@ -81,6 +85,7 @@ CollectionView::CollectionView(QWidget *parent)
       total_artist_count_(-1),
       total_album_count_(-1),
       nomusic_(":/pictures/nomusic.png"),
+      timer_prefetch_(new QTimer(this)),
       context_menu_(nullptr),
       action_load_(nullptr),
       action_add_to_playlist_(nullptr),
@@ -111,10 +116,43 @@ CollectionView::CollectionView(QWidget *parent)
 
   setStyleSheet("QTreeView::item{padding-top:1px;}");
 
+  timer_prefetch_->setSingleShot(true);
+  timer_prefetch_->setInterval(kPrefetchDelayMsec);
+  QObject::connect(timer_prefetch_, &QTimer::timeout, this, &CollectionView::PrefetchAlbumIcons);
+  QObject::connect(verticalScrollBar(), &QScrollBar::valueChanged, timer_prefetch_, QOverload<>::of(&QTimer::start));
+
 }
 
 CollectionView::~CollectionView() = default;
 
+void CollectionView::PrefetchAlbumIcons() {
+
+  if (!model()) return;
+
+  // Ask for the icons of the rows a page above and below the viewport, so their covers are loaded or loading by the time they scroll into view.
+  const QRect rect = viewport()->rect();
+  const QModelIndex first = indexAt(rect.topLeft());
+  if (!first.isValid()) return;
+  const QModelIndex last = indexAt(rect.bottomLeft());
+
+  const int page_rows = rect.height() / qMax(1, rowHeight(first));
+
+  QModelIndex idx = first;
+  for (int i = 0; i < page_rows; ++i) {
+    idx = indexAbove(idx);
+    if (!idx.isValid()) break;
+    idx.data(Qt::DecorationRole);
+  }
+
+  idx = last;
+  for (int i = 0; idx.isValid() && i < page_rows; ++i) {
+    idx = indexBelow(idx);
+    if (!idx.isValid()) break;
+    idx.data(Qt::DecorationRole);
+  }
+
+}
+
 void CollectionView::SaveFocus() {
 
   QModelIndex current = currentIndex();
@@ -36,6 +36,7 @@
 #include "widgets/autoexpandingtreeview.h"
 
 class QWidget;
+class QTimer;
 class QMenu;
 class QAction;
 class QContextMenuEvent;
@@ -54,6 +55,8 @@ class CollectionView : public AutoExpandingTreeView {
   explicit CollectionView(QWidget *parent = nullptr);
   ~CollectionView() override;
 
+  static const int kPrefetchDelayMsec;
+
   // Returns Songs currently selected in the collection view.
   // Please note that the selection is recursive meaning that if for example an album is selected this will return all of it's songs.
   SongList GetSelectedSongs() const;
@@ -111,6 +114,7 @@ class CollectionView : public AutoExpandingTreeView {
   void NoShowInVarious();
   void Delete();
   void DeleteFilesFinished(const SongList &songs_with_errors);
+  void PrefetchAlbumIcons();
 
  private:
   void RecheckIsEmpty();
@@ -128,6 +132,8 @@ class CollectionView : public AutoExpandingTreeView {
 
   QPixmap nomusic_;
 
+  QTimer *timer_prefetch_;
+
   QMenu *context_menu_;
   QModelIndex context_menu_index_;
   QAction *action_load_;
@@ -24,8 +24,17 @@
 #include <utility>
 #include <chrono>
 
+#include <QtGlobal>
+
+#ifdef Q_OS_UNIX
+#  include <sys/stat.h>
+#endif
+
 #include <QObject>
 #include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+#include <QFuture>
 #include <QIODevice>
 #include <QDir>
 #include <QDirIterator>
@@ -42,6 +51,9 @@
 #include <QStringList>
 #include <QUrl>
 #include <QImage>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QtEndian>
 #include <QSettings>
 
 #include "core/filesystemwatcherinterface.h"
@@ -56,12 +68,16 @@
 #include "playlistparsers/cueparser.h"
 #include "settings/collectionsettingspage.h"
 #include "engine/ebur128measures.h"
-#ifdef HAVE_SONGFINGERPRINTING
-#  include "engine/chromaprinter.h"
+#include "engine/audioanalyzerresult.h"
+#ifdef HAVE_GSTREAMER
+#  include "engine/audioanalyzer.h"
 #endif
 #ifdef HAVE_EBUR128
 #  include "engine/ebur128analysis.h"
 #endif
+#ifdef HAVE_MOODBAR
+#  include "settings/moodbarsettingspage.h"
+#endif
 
 // This is defined by one of the windows headers that is included by taglib.
 #ifdef RemoveDirectory
@@ -72,6 +88,8 @@ using namespace std::chrono_literals;
 
 QStringList CollectionWatcher::sValidImages = QStringList() << "jpg" << "png" << "gif" << "jpeg";
 QStringList CollectionWatcher::kIgnoredExtensions = QStringList() << "tmp" << "tar" << "gz" << "bz2" << "xz" << "tbz" << "tgz" << "z" << "zip" << "rar";
+const int CollectionWatcher::kMaxPrefetchedSubdirectories = 64;
+const int CollectionWatcher::kMaxPendingTagReads = 64;
 
 CollectionWatcher::CollectionWatcher(Song::Source source, QObject *parent)
     : QObject(parent),
@@ -84,10 +102,12 @@ CollectionWatcher::CollectionWatcher(Song::Source source, QObject *parent)
       monitor_(true),
       song_tracking_(false),
       song_ebur128_loudness_analysis_(false),
+      moodbar_(false),
       mark_songs_unavailable_(source_ == Song::Source::Collection),
       expire_unavailable_songs_days_(60),
       overwrite_playcount_(false),
       overwrite_rating_(false),
+      parallel_scan_(true),
       stop_requested_(false),
       abort_requested_(false),
       rescan_timer_(new QTimer(this)),
@@ -95,10 +115,16 @@ CollectionWatcher::CollectionWatcher(Song::Source source, QObject *parent)
       rescan_paused_(false),
       total_watches_(0),
       cue_parser_(new CueParser(backend_, this)),
+      scan_thread_pool_(new QThreadPool(this)),
+      analysis_thread_pool_(new QThreadPool(this)),
       last_scan_time_(0) {
 
   original_thread_ = thread();
 
+  // Listing directories is mostly waiting for the filesystem and the tagreader workers, so use at least a couple of threads.
+  scan_thread_pool_->setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+  analysis_thread_pool_->setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+
   rescan_timer_->setInterval(2s);
   rescan_timer_->setSingleShot(true);
 
@@ -168,7 +194,14 @@ void CollectionWatcher::ReloadSettings() {
   expire_unavailable_songs_days_ = s.value("expire_unavailable_songs", 60).toInt();
   overwrite_playcount_ = s.value("overwrite_playcount", false).toBool();
   overwrite_rating_ = s.value("overwrite_rating", false).toBool();
+  parallel_scan_ = s.value("parallel_scan", true).toBool();
+  s.endGroup();
+
+#ifdef HAVE_MOODBAR
+  s.beginGroup(MoodbarSettingsPage::kSettingsGroup);
+  moodbar_ = s.value("enabled", false).toBool();
   s.endGroup();
+#endif
 
   best_art_filters_.clear();
   for (const QString &filter : filters) {
@@ -233,6 +266,9 @@ CollectionWatcher::ScanTransaction::~ScanTransaction() {
     CommitNewOrUpdatedSongs();
   }
 
+  DiscardPrefetchedTags();
+  DiscardAnalyses();
+
   watcher_->task_manager_->SetTaskFinished(task_id_);
 
 }
@@ -359,6 +395,134 @@ bool CollectionWatcher::ScanTransaction::HasSongsWithMissingLoudnessCharacterist
 
 }
 
+bool CollectionWatcher::ScanTransaction::IsInMissingSubdir(const QString &path) const {
+
+  if (missing_subdirs_.isEmpty()) return false;
+
+  QString parent = path;
+  int pos = 0;
+  while ((pos = static_cast<int>(parent.lastIndexOf(QLatin1Char('/')))) > 0) {
+    parent.truncate(pos);
+    if (missing_subdirs_.contains(parent)) return true;
+  }
+
+  return false;
+
+}
+
+bool CollectionWatcher::ScanTransaction::TakeSubdirectoryListing(const QString &path, SubdirectoryListing *listing) {
+
+  if (!subdirectory_listings_.contains(path)) return false;
+
+  QFuture<SubdirectoryListing> future = subdirectory_listings_.take(path);
+  *listing = future.result();
+
+  return true;
+
+}
+
+void CollectionWatcher::ScanTransaction::PrefetchTags(const QStringList &files) {
+
+  for (const QString &file : files) {
+    if (!tag_read_replies_.contains(file) && !prefetched_tags_.contains(file) && !pending_tag_reads_.contains(file)) {
+      pending_tag_reads_ << file;
+    }
+  }
+
+  while (!pending_tag_reads_.isEmpty()) {
+    const int files_in_flight = static_cast<int>(tag_read_replies_.count() + prefetched_tags_.count());
+    if (files_in_flight >= kMaxPendingTagReads) break;
+    const QStringList batch = pending_tag_reads_.mid(0, qMin(TagReaderClient::kReadFilesBatchSize, kMaxPendingTagReads - files_in_flight));
+    pending_tag_reads_ = pending_tag_reads_.mid(batch.count());
+    TagReaderReply *reply = TagReaderClient::Instance()->ReadFiles(batch);
+    for (const QString &file : batch) {
+      tag_read_replies_.insert(file, reply);
+    }
+  }
+
+}
+
+bool CollectionWatcher::ScanTransaction::TakePrefetchedTags(const QString &file, Song *song) {
+
+  if (!prefetched_tags_.contains(file)) {
+    if (tag_read_replies_.contains(file)) {
+      ReceivePrefetchedTags(tag_read_replies_.value(file), file);
+    }
+    else if (pending_tag_reads_.removeAll(file) > 0) {
+      // Requested, but not sent to the workers yet.
+      TagReaderClient::Instance()->ReadFileBlocking(file, song);
+      return true;
+    }
+    else {
+      return false;
+    }
+  }
+
+  // Keep the workers busy
+  PrefetchTags(QStringList());
+
+  // The request was aborted.
+  if (!prefetched_tags_.contains(file)) return false;
+
+  song->InitFromProtobuf(prefetched_tags_.take(file));
+
+  return true;
+
+}
+
+void CollectionWatcher::ScanTransaction::ReceivePrefetchedTags(TagReaderReply *reply, const QString &file) {
+
+  QList<spb::tagreader::Message> messages;
+  bool finished = false;
+  while (!prefetched_tags_.contains(file)) {
+    if (!reply->WaitForNextReplies(&messages)) {
+      finished = true;
+      break;
+    }
+    for (const spb::tagreader::Message &message : std::as_const(messages)) {
+      for (const spb::tagreader::ReadFilesResponse_File &read_file : message.read_files_response().files()) {
+        const QString filename = QString::fromUtf8(read_file.filename().data(), static_cast<qint64>(read_file.filename().size()));
+        if (tag_read_replies_.value(filename) == reply) {
+          tag_read_replies_.remove(filename);
+          prefetched_tags_.insert(filename, read_file.metadata());
+        }
+      }
+    }
+  }
+
+  const QStringList remaining_files = tag_read_replies_.keys(reply);
+  if (finished) {
+    // The request was aborted, the remaining files are read by the caller when it needs them.
+    for (const QString &remaining_file : remaining_files) {
+      tag_read_replies_.remove(remaining_file);
+    }
+  }
+  if (finished || remaining_files.isEmpty()) {
+    reply->deleteLater();
+  }
+
+}
+
+void CollectionWatcher::ScanTransaction::DiscardPrefetchedTags() {
+
+  // Don't wait for tag reads that were never used, just clean them up when they finish.
+  pending_tag_reads_.clear();
+  prefetched_tags_.clear();
+  QSet<TagReaderReply*> replies;
+  for (TagReaderReply *reply : std::as_const(tag_read_replies_)) {
+    replies << reply;
+  }
+  for (TagReaderReply *reply : std::as_const(replies)) {
+    // Connect first, the reply might finish on the tagreader client's thread in between.  Calling deleteLater() twice is fine.
+    QObject::connect(reply, &TagReaderReply::Finished, reply, &TagReaderReply::deleteLater);
+    if (reply->is_finished()) {
+      reply->deleteLater();
+    }
+  }
+  tag_read_replies_.clear();
+
+}
+
 void CollectionWatcher::ScanTransaction::SetKnownSubdirs(const CollectionSubdirectoryList &subdirs) {
 
   known_subdirs_ = subdirs;
@@ -425,10 +589,15 @@ void CollectionWatcher::AddDirectory(const CollectionDirectory &dir, const Colle
     const quint64 files_count = FilesCountForSubdirs(&transaction, subdirs, subdir_files_count);
     transaction.SetKnownSubdirs(subdirs);
     transaction.AddToProgressMax(files_count);
-    for (const CollectionSubdirectory &subdir : subdirs) {
+    for (int i = 0; i < subdirs.count(); ++i) {
       if (stop_requested_ || abort_requested_) break;
 
-      if (scan_on_startup_) ScanSubdirectory(subdir.path, subdir, subdir_files_count[subdir.path], &transaction);
+      const CollectionSubdirectory &subdir = subdirs[i];
+
+      if (scan_on_startup_) {
+        PrefetchSubdirectories(subdirs.mid(i, kMaxPrefetchedSubdirectories), &transaction, false);
+        ScanSubdirectory(subdir.path, subdir, subdir_files_count[subdir.path], &transaction);
+      }
 
       if (monitor_) AddWatch(dir, subdir.path);
     }
@@ -443,94 +612,92 @@ void CollectionWatcher::AddDirectory(const CollectionDirectory &dir, const Colle
 
 void CollectionWatcher::ScanSubdirectory(const QString &path, const CollectionSubdirectory &subdir, const quint64 files_count, ScanTransaction *t, const bool force_noincremental) {
 
-  QFileInfo path_info(path);
+  // Reached again through its parent, for example when the parent is removed.
+  if (t->IsSubdirScanned(path)) {
+    t->AddToProgress(files_count);
+    return;
+  }
+  t->SetSubdirScanned(path);
+
+  const bool force_listing = SubdirectoryNeedsListing(path, t, force_noincremental);
+
+  SubdirectoryListing listing;
+  const bool prefetched = t->TakeSubdirectoryListing(path, &listing);
+  if (t->IsInMissingSubdir(path)) {
+    // Everything below a removed directory is gone as well, there is nothing to look at.
+    listing = SubdirectoryListing();
+    listing.listed = true;
+  }
+  else if (!prefetched || (force_listing && !listing.listed)) {
+    listing = ListSubdirectory(path, subdir, force_listing, false);
+  }
+
+  if (listing.listed && !listing.exists) {
+    t->SetSubdirMissing(path);
+  }
 
   // Do not scan symlinked dirs that are already in collection
-  if (path_info.isSymLink()) {
-    QString real_path = path_info.symLinkTarget();
+  if (listing.is_symlink) {
     for (const CollectionDirectory &dir : std::as_const(watched_dirs_)) {
-      if (real_path.startsWith(dir.path)) {
+      if (listing.symlink_target.startsWith(dir.path)) {
         return;
       }
     }
   }
 
-  bool songs_missing_fingerprint = false;
-  bool songs_missing_loudness_characteristics = false;
-#ifdef HAVE_SONGFINGERPRINTING
-  if (song_tracking_) {
-    songs_missing_fingerprint = t->HasSongsWithMissingFingerprint(path);
-  }
-#endif
-#ifdef HAVE_EBUR128
-  if (song_ebur128_loudness_analysis_) {
-    songs_missing_loudness_characteristics = t->HasSongsWithMissingLoudnessCharacteristics(path);
-  }
-#endif
-
-  if (!t->ignores_mtime() && !force_noincremental && t->is_incremental() && subdir.mtime == path_info.lastModified().toSecsSinceEpoch() && !songs_missing_fingerprint && !songs_missing_loudness_characteristics) {
-    // The directory hasn't changed since last time
+  if (!listing.listed) {
+    // The directory hasn't changed since last time, but the journal might have been filled in or its mtime touched.
+    if (subdir.directory_id != -1 && (listing.mtime != subdir.mtime || listing.inode != subdir.inode || listing.entries_hash != subdir.entries_hash)) {
+      CollectionSubdirectory journaled_subdir = subdir;
+      journaled_subdir.mtime = listing.mtime;
+      journaled_subdir.inode = listing.inode;
+      journaled_subdir.child_count = listing.child_count;
+      journaled_subdir.entries_hash = listing.entries_hash;
+      t->touched_subdirs << journaled_subdir;
+    }
     t->AddToProgress(files_count);
     return;
   }
 
-  QMap<QString, QStringList> album_art;
-  QStringList files_on_disk;
+  QMap<QString, QStringList> album_art = listing.album_art;
+  QStringList files_on_disk = listing.files_on_disk;
   CollectionSubdirectoryList my_new_subdirs;
 
   // If a directory is moved then only its parent gets a changed notification, so we need to look and see if any of our children don't exist anymore.
   // If one has been removed, "rescan" it to get the deleted songs
   CollectionSubdirectoryList previous_subdirs = t->GetImmediateSubdirs(path);
   for (const CollectionSubdirectory &prev_subdir : previous_subdirs) {
-    if (!QFile::exists(prev_subdir.path) && prev_subdir.path != path) {
+    if (prev_subdir.path != path && (!listing.exists || !QFile::exists(prev_subdir.path))) {
       ScanSubdirectory(prev_subdir.path, prev_subdir, 0, t, true);
     }
   }
 
-  // First we "quickly" get a list of the files in the directory that we think might be music.  While we're here, we also look for new subdirectories and possible album artwork.
-  QDirIterator it(path, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
-  while (it.hasNext()) {
-
-    if (stop_requested_ || abort_requested_) return;
-
-    QString child(it.next());
-    QFileInfo child_info(child);
-
-    if (child_info.isDir()) {
-      if (!t->HasSeenSubdir(child)) {
-        // We haven't seen this subdirectory before - add it to a list, and later we'll tell the backend about it and scan it.
-        CollectionSubdirectory new_subdir;
-        new_subdir.directory_id = -1;
-        new_subdir.path = child;
-        new_subdir.mtime = child_info.lastModified().toSecsSinceEpoch();
-        my_new_subdirs << new_subdir;
-      }
-      t->AddToProgress(1);
-    }
-    else {
-      QString ext_part(ExtensionPart(child));
-      QString dir_part(DirectoryPart(child));
-      if (kIgnoredExtensions.contains(child_info.suffix(), Qt::CaseInsensitive) || child_info.baseName() == "qt_temp") {
-        t->AddToProgress(1);
-      }
-      else if (sValidImages.contains(ext_part)) {
-        album_art[dir_part] << child;
-        t->AddToProgress(1);
-      }
-      else if (TagReaderClient::Instance()->IsMediaFileBlocking(child)) {
-        files_on_disk << child;
-      }
-      else {
-        t->AddToProgress(1);
-      }
+  for (const CollectionSubdirectory &child_subdir : std::as_const(listing.child_subdirs)) {
+    if (!t->HasSeenSubdir(child_subdir.path)) {
+      // We haven't seen this subdirectory before - add it to a list, and later we'll tell the backend about it and scan it.
+      my_new_subdirs << child_subdir;
     }
   }
+  t->AddToProgress(listing.files_skipped);
 
   if (stop_requested_ || abort_requested_) return;
 
   // Ask the database for a list of files in this directory
   SongList songs_in_db = t->FindSongsInSubdirectory(path);
 
+  if (parallel_scan_) {
+    // Send the tag reads we are likely to need to the workers up front, so they are read while we compare the rest.
+    QStringList files_to_read;
+    for (const QString &file : std::as_const(files_on_disk)) {
+      SongList matching_songs;
+      if (t->ignores_mtime() || !FindSongsByPath(songs_in_db, file, &matching_songs) || matching_songs.first().mtime() != QFileInfo(file).lastModified().toSecsSinceEpoch()) {
+        files_to_read << file;
+      }
+    }
+    t->PrefetchTags(files_to_read);
+    PrefetchAnalyses(files_to_read, t);
+  }
+
   QSet<QString> cues_processed;
 
   // Now compare the list from the database with the list of files on disk
@@ -606,22 +773,13 @@ void CollectionWatcher::ScanSubdirectory(const QString &path, const CollectionSu
       // The song's changed or missing fingerprint - create fingerprint and reread the metadata from file.
       if (t->ignores_mtime() || changed || missing_fingerprint || missing_loudness_characteristics) {
 
-        QString fingerprint;
-#ifdef HAVE_SONGFINGERPRINTING
-        if (song_tracking_) {
-          Chromaprinter chromaprinter(file);
-          fingerprint = chromaprinter.CreateFingerprint();
-          if (fingerprint.isEmpty()) {
-            fingerprint = "NONE";
-          }
-        }
-#endif
+        const AudioAnalyzerResult analysis = AnalyzeFile(file, t);
 
         if (new_cue.isEmpty() || new_cue_mtime == 0) {  // If no CUE or it's about to lose it.
-          UpdateNonCueAssociatedSong(file, fingerprint, matching_songs, art_automatic, cue_deleted, t);
+          UpdateNonCueAssociatedSong(file, analysis, matching_songs, art_automatic, cue_deleted, t);
         }
         else {  // If CUE associated.
-          UpdateCueAssociatedSongs(file, path, fingerprint, new_cue, art_automatic, matching_songs, t);
+          UpdateCueAssociatedSongs(file, path, analysis, new_cue, art_automatic, matching_songs, t);
         }
       }
 
@@ -632,16 +790,8 @@ void CollectionWatcher::ScanSubdirectory(const QString &path, const CollectionSu
 
     }
     else {  // Search the DB by fingerprint.
-      QString fingerprint;
-#ifdef HAVE_SONGFINGERPRINTING
-      if (song_tracking_) {
-        Chromaprinter chromaprinter(file);
-        fingerprint = chromaprinter.CreateFingerprint();
-        if (fingerprint.isEmpty()) {
-          fingerprint = "NONE";
-        }
-      }
-#endif
+      const AudioAnalyzerResult analysis = AnalyzeFile(file, t);
+      const QString &fingerprint = analysis.fingerprint;
       if (song_tracking_ && !fingerprint.isEmpty() && fingerprint != "NONE" && FindSongsByFingerprint(file, fingerprint, &matching_songs)) {
 
         // The song is in the database and still on disk.
@@ -680,16 +830,16 @@ void CollectionWatcher::ScanSubdirectory(const QString &path, const CollectionSu
         const QUrl art_automatic = ArtForSong(file, album_art);
 
         if (new_cue.isEmpty() || new_cue_mtime == 0) {  // If no CUE or it's about to lose it.
-          UpdateNonCueAssociatedSong(file, fingerprint, matching_songs, art_automatic, matching_songs_has_cue && new_cue_mtime == 0, t);
+          UpdateNonCueAssociatedSong(file, analysis, matching_songs, art_automatic, matching_songs_has_cue && new_cue_mtime == 0, t);
         }
         else {  // If CUE associated.
-          UpdateCueAssociatedSongs(file, path, fingerprint, new_cue, art_automatic, matching_songs, t);
+          UpdateCueAssociatedSongs(file, path, analysis, new_cue, art_automatic, matching_songs, t);
         }
 
       }
       else {  // The song is on disk but not in the DB
 
-        SongList songs = ScanNewFile(file, path, fingerprint, new_cue, &cues_processed);
+        SongList songs = ScanNewFile(file, path, analysis, new_cue, &cues_processed, t);
         if (songs.isEmpty()) {
           t->AddToProgress(1);
           continue;
@@ -722,8 +872,11 @@ void CollectionWatcher::ScanSubdirectory(const QString &path, const CollectionSu
   // Add this subdir to the new or touched list
   CollectionSubdirectory updated_subdir;
   updated_subdir.directory_id = t->dir();
-  updated_subdir.mtime = path_info.exists() ? path_info.lastModified().toSecsSinceEpoch() : 0;
+  updated_subdir.mtime = listing.exists ? listing.mtime : 0;
   updated_subdir.path = path;
+  updated_subdir.inode = listing.inode;
+  updated_subdir.child_count = listing.child_count;
+  updated_subdir.entries_hash = listing.entries_hash;
 
   if (subdir.directory_id == -1) {
     t->new_subdirs << updated_subdir;
@@ -736,7 +889,11 @@ void CollectionWatcher::ScanSubdirectory(const QString &path, const CollectionSu
     t->deleted_subdirs << updated_subdir;
   }
 
+  t->DiscardPrefetchedTags();
+  t->DiscardAnalyses();
+
   // Recurse into the new subdirs that we found
+  PrefetchSubdirectories(my_new_subdirs, t, true);
   for (const CollectionSubdirectory &my_new_subdir : my_new_subdirs) {
     if (stop_requested_ || abort_requested_) return;
     ScanSubdirectory(my_new_subdir.path, my_new_subdir, 0, t, true);
@@ -744,9 +901,241 @@ void CollectionWatcher::ScanSubdirectory(const QString &path, const CollectionSu
 
 }
 
+bool CollectionWatcher::SubdirectoryNeedsListing(const QString &path, ScanTransaction *t, const bool force_noincremental) {
+
+  if (t->ignores_mtime() || force_noincremental || !t->is_incremental()) return true;
+
+#ifdef HAVE_SONGFINGERPRINTING
+  if (song_tracking_ && t->HasSongsWithMissingFingerprint(path)) {
+    return true;
+  }
+#endif
+#ifdef HAVE_EBUR128
+  if (song_ebur128_loudness_analysis_ && t->HasSongsWithMissingLoudnessCharacteristics(path)) {
+    return true;
+  }
+#endif
+
+  Q_UNUSED(path);
+
+  return false;
+
+}
+
+CollectionWatcher::SubdirectoryListing CollectionWatcher::ListSubdirectory(const QString &path, const CollectionSubdirectory &known_subdir, const bool force_listing, const bool pipelined) {
+
+  SubdirectoryListing listing;
+
+  StatSubdirectory(path, &listing);
+  listing.child_count = known_subdir.child_count;
+  listing.entries_hash = known_subdir.entries_hash;
+
+  // A directory that was replaced by another one with the same mtime (restored from a backup, moved back) gets a new inode.
+  const bool mtime_unchanged = !force_listing && known_subdir.mtime == listing.mtime && (known_subdir.inode == 0 || known_subdir.inode == listing.inode);
+  if (mtime_unchanged && known_subdir.entries_hash != 0) {
+    return listing;
+  }
+
+  // Read the directory entries and hash them, the hash is compared with the journal to find out if anything in the directory really changed.
+  QStringList children;
+  QList<QFileInfo> children_info;
+  QStringList journal_entries;
+  QDirIterator it(path, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+  while (it.hasNext()) {
+    if (stop_requested_ || abort_requested_) return listing;
+    const QString child = it.next();
+    // Uses the file type from the directory entry where the platform has it, so only files are stat'ed.
+    const QFileInfo child_info = it.fileInfo();
+    if (child_info.isDir()) {
+      // The mtime of subdirectories is journaled separately, so changes inside them should not make this directory dirty.
+      journal_entries << child_info.fileName() + QDir::separator();
+    }
+    else {
+      journal_entries << QString("%1:%2:%3").arg(child_info.fileName()).arg(child_info.lastModified().toSecsSinceEpoch()).arg(child_info.size());
+    }
+    children << child;
+    children_info << child_info;
+  }
+  journal_entries.sort();
+
+  listing.child_count = children.count();
+  listing.entries_hash = qFromBigEndian<qint64>(QCryptographicHash::hash(journal_entries.join(QLatin1Char('\n')).toUtf8(), QCryptographicHash::Sha1).constData());
+  // 0 is reserved for directories that are not journaled yet.
+  if (listing.entries_hash == 0) listing.entries_hash = 1;
+
+  // The mtime changed but the entries are the same, or the journal was just filled in for an unchanged directory.
+  if (mtime_unchanged || (!force_listing && listing.exists && known_subdir.entries_hash != 0 && known_subdir.inode == listing.inode && known_subdir.child_count == listing.child_count && known_subdir.entries_hash == listing.entries_hash)) {
+    return listing;
+  }
+
+  listing.listed = true;
+
+  // First we "quickly" get a list of the files in the directory that we think might be music.  While we're here, we also look for new subdirectories and possible album artwork.
+  QStringList media_candidates;
+  for (int i = 0; i < children.count(); ++i) {
+
+    if (stop_requested_ || abort_requested_) return listing;
+
+    const QString &child = children[i];
+    const QFileInfo &child_info = children_info[i];
+
+    if (child_info.isDir()) {
+      CollectionSubdirectory child_subdir;
+      child_subdir.directory_id = -1;
+      child_subdir.path = child;
+      child_subdir.mtime = child_info.lastModified().toSecsSinceEpoch();
+      listing.child_subdirs << child_subdir;
+      ++listing.files_skipped;
+    }
+    else {
+      QString ext_part(ExtensionPart(child));
+      QString dir_part(DirectoryPart(child));
+      if (kIgnoredExtensions.contains(child_info.suffix(), Qt::CaseInsensitive) || child_info.baseName() == "qt_temp") {
+        ++listing.files_skipped;
+      }
+      else if (sValidImages.contains(ext_part)) {
+        listing.album_art[dir_part] << child;
+        ++listing.files_skipped;
+      }
+      else if (pipelined) {
+        media_candidates << child;
+      }
+      else if (TagReaderClient::Instance()->IsMediaFileBlocking(child)) {
+        listing.files_on_disk << child;
+      }
+      else {
+        ++listing.files_skipped;
+      }
+    }
+  }
+
+  if (media_candidates.isEmpty()) return listing;
+
+  // Send all requests before waiting for any of them, so every tagreader worker has something to do.
+  QList<TagReaderReply*> replies;
+  replies.reserve(media_candidates.count());
+  for (const QString &file : std::as_const(media_candidates)) {
+    replies << TagReaderClient::Instance()->IsMediaFile(file);
+  }
+
+  for (int i = 0; i < replies.count(); ++i) {
+    TagReaderReply *reply = replies[i];
+    if (reply->WaitForFinished() && reply->message().is_media_file_response().success()) {
+      listing.files_on_disk << media_candidates[i];
+    }
+    else {
+      ++listing.files_skipped;
+    }
+    // The tagreader client might still be finishing the reply on its own thread, which is also where the reply lives and is deleted.
+    reply->deleteLater();
+  }
+
+  return listing;
+
+}
+
+void CollectionWatcher::PrefetchSubdirectories(const CollectionSubdirectoryList &subdirs, ScanTransaction *t, const bool force_noincremental) {
+
+  if (!parallel_scan_) return;
+
+  for (const CollectionSubdirectory &subdir : subdirs) {
+    if (stop_requested_ || abort_requested_) break;
+    if (t->HasSubdirectoryListing(subdir.path) || t->IsSubdirScanned(subdir.path) || t->IsInMissingSubdir(subdir.path)) continue;
+    const bool force_listing = SubdirectoryNeedsListing(subdir.path, t, force_noincremental);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    t->AddSubdirectoryListing(subdir.path, QtConcurrent::run(scan_thread_pool_, &CollectionWatcher::ListSubdirectory, this, subdir.path, subdir, force_listing, true));
+#else
+    t->AddSubdirectoryListing(subdir.path, QtConcurrent::run(scan_thread_pool_, this, &CollectionWatcher::ListSubdirectory, subdir.path, subdir, force_listing, true));
+#endif
+  }
+
+}
+
+void CollectionWatcher::ReadFileForScan(const QString &file, Song *song, ScanTransaction *t) {
+
+  if (!t->TakePrefetchedTags(file, song)) {
+    TagReaderClient::Instance()->ReadFileBlocking(file, song);
+  }
+
+}
+
+AudioAnalyzerResult::Analyses CollectionWatcher::FileAnalyses(const QString &file) const {
+
+  AudioAnalyzerResult::Analyses analyses = AudioAnalyzerResult::Analysis::None;
+
+#ifdef HAVE_SONGFINGERPRINTING
+  if (song_tracking_) {
+    analyses |= AudioAnalyzerResult::Analysis::Fingerprint;
+  }
+#endif
+
+#ifdef HAVE_EBUR128
+  // The sections of a file with a CUE sheet are analyzed separately.
+  if (song_ebur128_loudness_analysis_ && GetMtimeForCue(CueParser::FindCueFilename(file)) == 0) {
+    analyses |= AudioAnalyzerResult::Analysis::Loudness;
+    // The whole file is decoded anyway, so the moodbar comes almost for free.
+    if (moodbar_) {
+      analyses |= AudioAnalyzerResult::Analysis::Moodbar;
+    }
+  }
+#else
+  Q_UNUSED(file);
+#endif
+
+  return analyses;
+
+}
+
+AudioAnalyzerResult CollectionWatcher::AnalyzeFileBlocking(const QString &file, const AudioAnalyzerResult::Analyses analyses) {
+
+#ifdef HAVE_GSTREAMER
+  AudioAnalyzer analyzer(file, analyses);
+  return analyzer.Analyze();
+#else
+  Q_UNUSED(file);
+  Q_UNUSED(analyses);
+  return AudioAnalyzerResult();
+#endif
+
+}
+
+void CollectionWatcher::PrefetchAnalyses(const QStringList &files, ScanTransaction *t) {
+
+  if (!parallel_scan_) return;
+
+  for (const QString &file : files) {
+    if (t->HasAnalysis(file)) continue;
+    const AudioAnalyzerResult::Analyses analyses = FileAnalyses(file);
+    if (!analyses) continue;
+    t->AddAnalysis(file, QtConcurrent::run(analysis_thread_pool_, &CollectionWatcher::AnalyzeFileBlocking, file, analyses));
+  }
+
+}
+
+AudioAnalyzerResult CollectionWatcher::AnalyzeFile(const QString &file, ScanTransaction *t) {
+
+  AudioAnalyzerResult analysis;
+  if (!t->TakeAnalysis(file, &analysis)) {
+    analysis = AnalyzeFileBlocking(file, FileAnalyses(file));
+  }
+
+#ifdef HAVE_SONGFINGERPRINTING
+  if (song_tracking_ && analysis.fingerprint.isEmpty()) {
+    analysis.fingerprint = "NONE";
+  }
+#endif
+
+  if (!analysis.moodbar.isEmpty()) {
+    emit MoodbarGenerated(QUrl::fromLocalFile(file), analysis.moodbar);
+  }
+
+  return analysis;
+
+}
+
 void CollectionWatcher::UpdateCueAssociatedSongs(const QString &file,
                                                  const QString &path,
-                                                 const QString &fingerprint,
+                                                 const AudioAnalyzerResult &analysis,
                                                  const QString &matching_cue,
                                                  const QUrl &art_automatic,
                                                  const SongList &old_cue_songs,
@@ -772,8 +1161,8 @@ void CollectionWatcher::UpdateCueAssociatedSongs(const QString &file,
   for (Song new_cue_song : songs) {
     new_cue_song.set_source(source_);
     new_cue_song.set_directory_id(t->dir());
-    PerformEBUR128Analysis(new_cue_song);
-    new_cue_song.set_fingerprint(fingerprint);
+    PerformEBUR128Analysis(new_cue_song, analysis);
+    new_cue_song.set_fingerprint(analysis.fingerprint);
 
     if (sections_map.contains(new_cue_song.beginning_nanosec())) {  // Changed section
       const Song matching_cue_song = sections_map[new_cue_song.beginning_nanosec()];
@@ -797,7 +1186,7 @@ void CollectionWatcher::UpdateCueAssociatedSongs(const QString &file,
 }
 
 void CollectionWatcher::UpdateNonCueAssociatedSong(const QString &file,
-                                                   const QString &fingerprint,
+                                                   const AudioAnalyzerResult &analysis,
                                                    const SongList &matching_songs,
                                                    const QUrl &art_automatic,
                                                    const bool cue_deleted,
@@ -814,13 +1203,13 @@ void CollectionWatcher::UpdateNonCueAssociatedSong(const QString &file,
   }
 
   Song song_on_disk(source_);
-  TagReaderClient::Instance()->ReadFileBlocking(file, &song_on_disk);
+  ReadFileForScan(file, &song_on_disk, t);
   if (song_on_disk.is_valid()) {
     song_on_disk.set_source(source_);
     song_on_disk.set_directory_id(t->dir());
     song_on_disk.set_id(matching_song.id());
-    PerformEBUR128Analysis(song_on_disk);
-    song_on_disk.set_fingerprint(fingerprint);
+    PerformEBUR128Analysis(song_on_disk, analysis);
+    song_on_disk.set_fingerprint(analysis.fingerprint);
     song_on_disk.set_art_automatic(art_automatic);
     song_on_disk.MergeUserSetData(matching_song, !overwrite_playcount_, !overwrite_rating_);
     AddChangedSong(file, matching_song, song_on_disk, t);
@@ -828,7 +1217,7 @@ void CollectionWatcher::UpdateNonCueAssociatedSong(const QString &file,
 
 }
 
-SongList CollectionWatcher::ScanNewFile(const QString &file, const QString &path, const QString &fingerprint, const QString &matching_cue, QSet<QString> *cues_processed) {
+SongList CollectionWatcher::ScanNewFile(const QString &file, const QString &path, const AudioAnalyzerResult &analysis, const QString &matching_cue, QSet<QString> *cues_processed, ScanTransaction *t) {
 
   SongList songs;
 
@@ -855,8 +1244,8 @@ SongList CollectionWatcher::ScanNewFile(const QString &file, const QString &path
     songs.reserve(cue_congs.count());
     for (Song &cue_song : cue_congs) {
       cue_song.set_source(source_);
-      PerformEBUR128Analysis(cue_song);
-      cue_song.set_fingerprint(fingerprint);
+      PerformEBUR128Analysis(cue_song, analysis);
+      cue_song.set_fingerprint(analysis.fingerprint);
       if (cue_song.url().toLocalFile().normalized(QString::NormalizationForm_D) == file_nfd) {
         songs << cue_song;
       }
@@ -867,11 +1256,11 @@ SongList CollectionWatcher::ScanNewFile(const QString &file, const QString &path
   }
   else {  // It's a normal media file
     Song song(source_);
-    TagReaderClient::Instance()->ReadFileBlocking(file, &song);
+    ReadFileForScan(file, &song, t);
     if (song.is_valid()) {
       song.set_source(source_);
-      PerformEBUR128Analysis(song);
-      song.set_fingerprint(fingerprint);
+      PerformEBUR128Analysis(song, analysis);
+      song.set_fingerprint(analysis.fingerprint);
       songs << song;
     }
   }
@@ -948,12 +1337,13 @@ void CollectionWatcher::AddChangedSong(const QString &file, const Song &matching
 
 }
 
-void CollectionWatcher::PerformEBUR128Analysis(Song &song) const {
+void CollectionWatcher::PerformEBUR128Analysis(Song &song, const AudioAnalyzerResult &analysis) const {
 
   if (!song_ebur128_loudness_analysis_) return;
 
 #ifdef HAVE_EBUR128
-  std::optional<EBUR128Measures> loudness_characteristics = EBUR128Analysis::Compute(song);
+  // The analysis of the file covers the song only when the song is the whole file.
+  std::optional<EBUR128Measures> loudness_characteristics = analysis.analyses.testFlag(AudioAnalyzerResult::Analysis::Loudness) && !song.has_cue() ? analysis.loudness : EBUR128Analysis::Compute(song);
   if (loudness_characteristics) {
     song.set_ebur128_integrated_loudness_lufs(loudness_characteristics->loudness_lufs);
     song.set_ebur128_loudness_range_lu(loudness_characteristics->range_lu);
@@ -978,6 +1368,35 @@ quint64 CollectionWatcher::GetMtimeForCue(const QString &cue_path) {
   return cue_last_modified.isValid() ? cue_last_modified.toSecsSinceEpoch() : 0;
 }
 
+void CollectionWatcher::StatSubdirectory(const QString &path, SubdirectoryListing *listing) {
+
+#ifdef Q_OS_UNIX
+  // One lstat() gives the existence, mtime and inode of a plain directory, only symlinks need a second stat() to follow them.
+  const QByteArray encoded_path = QFile::encodeName(path);
+  struct stat s {};
+  if (lstat(encoded_path.constData(), &s) != 0) return;
+  if (S_ISLNK(s.st_mode)) {
+    listing->is_symlink = true;
+    listing->symlink_target = QFileInfo(path).symLinkTarget();
+    if (stat(encoded_path.constData(), &s) != 0) return;
+  }
+  listing->exists = true;
+  listing->mtime = static_cast<qint64>(s.st_mtime);
+  listing->inode = static_cast<quint64>(s.st_ino);
+#else
+  const QFileInfo path_info(path);
+  listing->exists = path_info.exists();
+  listing->is_symlink = path_info.isSymLink();
+  if (listing->is_symlink) {
+    listing->symlink_target = path_info.symLinkTarget();
+  }
+  if (listing->exists) {
+    listing->mtime = path_info.lastModified().toSecsSinceEpoch();
+  }
+#endif
+
+}
+
 void CollectionWatcher::AddWatch(const CollectionDirectory &dir, const QString &path) {
 
   if (!QFile::exists(path)) return;
@@ -1088,13 +1507,20 @@ void CollectionWatcher::RescanPathsNow() {
       transaction.AddToProgressMax(files_count);
     }
 
+    CollectionSubdirectoryList subdirs;
     for (const QString &path : rescan_queue_[dir]) {
-      if (stop_requested_ || abort_requested_) break;
       CollectionSubdirectory subdir;
       subdir.directory_id = dir;
       subdir.mtime = 0;
       subdir.path = path;
-      ScanSubdirectory(path, subdir, subdir_files_count[path], &transaction);
+      subdirs << subdir;
+    }
+
+    for (int i = 0; i < subdirs.count(); ++i) {
+      if (stop_requested_ || abort_requested_) break;
+      const CollectionSubdirectory &subdir = subdirs[i];
+      PrefetchSubdirectories(subdirs.mid(i, kMaxPrefetchedSubdirectories), &transaction, false);
+      ScanSubdirectory(subdir.path, subdir, subdir_files_count[subdir.path], &transaction);
     }
   }
 
@@ -1231,8 +1657,10 @@ void CollectionWatcher::PerformScan(const bool incremental, const bool ignore_mt
     quint64 files_count = FilesCountForSubdirs(&transaction, subdirs, subdir_files_count);
     transaction.AddToProgressMax(files_count);
 
-    for (const CollectionSubdirectory &subdir : subdirs) {
+    for (int i = 0; i < subdirs.count(); ++i) {
       if (stop_requested_ || abort_requested_) break;
+      const CollectionSubdirectory &subdir = subdirs[i];
+      PrefetchSubdirectories(subdirs.mid(i, kMaxPrefetchedSubdirectories), &transaction, false);
       ScanSubdirectory(subdir.path, subdir, subdir_files_count[subdir.path], &transaction);
     }
 
@@ -1285,7 +1713,8 @@ quint64 CollectionWatcher::FilesCountForSubdirs(ScanTransaction *t, const Collec
   quint64 i = 0;
   for (const CollectionSubdirectory &subdir : subdirs) {
     if (stop_requested_ || abort_requested_) break;
-    const quint64 files_count = FilesCountForPath(t, subdir.path);
+    // Use the journal for incremental scans instead of listing every directory just to show the progress.
+    const quint64 files_count = t->is_incremental() && !t->ignores_mtime() && subdir.entries_hash != 0 ? subdir.child_count : FilesCountForPath(t, subdir.path);
     subdir_files_count[subdir.path] = files_count;
     i += files_count;
   }
@@ -24,8 +24,11 @@
 
 #include "config.h"
 
+#include <atomic>
+
 #include <QtGlobal>
 #include <QObject>
+#include <QFuture>
 #include <QHash>
 #include <QMap>
 #include <QMultiMap>
@@ -33,12 +36,17 @@
 #include <QString>
 #include <QStringList>
 #include <QUrl>
+#include <QByteArray>
 
 #include "collectiondirectory.h"
+#include "prefetchedanalyses.h"
 #include "core/shared_ptr.h"
 #include "core/song.h"
+#include "core/tagreaderclient.h"
+#include "engine/audioanalyzerresult.h"
 
 class QThread;
+class QThreadPool;
 class QTimer;
 
 class CollectionBackend;
@@ -81,6 +89,7 @@ class CollectionWatcher : public QObject {
   void SubdirsMTimeUpdated(const CollectionSubdirectoryList &subdirs);
   void CompilationsNeedUpdating();
   void UpdateLastSeen(const int directory_id, const int expire_unavailable_songs_days);
+  void MoodbarGenerated(const QUrl &url, const QByteArray &data);
   void ExitFinished();
 
   void ScanStarted(const int task_id);
@@ -91,6 +100,28 @@ class CollectionWatcher : public QObject {
   void SetRescanPaused(bool pause);
 
  private:
+  // The result of listing the contents of a single subdirectory.
+  // In parallel scan mode these are produced on the scan thread pool ahead of ScanSubdirectory(), which only consumes them.
+  struct SubdirectoryListing {
+    SubdirectoryListing() : listed(false), exists(false), is_symlink(false), mtime(0), inode(0), child_count(0), entries_hash(0), files_skipped(0) {}
+
+    // False if the directory is unchanged since the last scan and wasn't listed.
+    bool listed;
+    bool exists;
+    bool is_symlink;
+    QString symlink_target;
+    qint64 mtime;
+    // Scan journal for the directory, see CollectionSubdirectory.
+    quint64 inode;
+    quint64 child_count;
+    qint64 entries_hash;
+    CollectionSubdirectoryList child_subdirs;
+    QMap<QString, QStringList> album_art;
+    QStringList files_on_disk;
+    // Number of directory entries that were not media files, used for the progress.
+    quint64 files_skipped;
+  };
+
   // This class encapsulates a full or partial scan of a directory.
   // Each directory has one or more subdirectories, and any number of subdirectories can be scanned during one transaction.
   // ScanSubdirectory() adds its results to the members of this transaction class,
@@ -116,6 +147,30 @@ class CollectionWatcher : public QObject {
     // Emits the signals for new & deleted songs etc and clears the lists. This causes the new stuff to be updated on UI.
     void CommitNewOrUpdatedSongs();
 
+    // Subdirectory listings started on the scan thread pool ahead of the scan.
+    bool HasSubdirectoryListing(const QString &path) const { return subdirectory_listings_.contains(path); }
+    void AddSubdirectoryListing(const QString &path, const QFuture<SubdirectoryListing> &future) { subdirectory_listings_.insert(path, future); }
+    bool TakeSubdirectoryListing(const QString &path, SubdirectoryListing *listing);
+
+    // Subdirectories already scanned in this transaction, and removed ones whose known subdirectories don't need to be looked at.
+    bool IsSubdirScanned(const QString &path) const { return scanned_subdirs_.contains(path); }
+    void SetSubdirScanned(const QString &path) { scanned_subdirs_.insert(path); }
+    bool IsInMissingSubdir(const QString &path) const;
+    void SetSubdirMissing(const QString &path) { missing_subdirs_.insert(path); }
+
+    // Keeps up to kMaxPendingTagReads files in flight to the tagreader workers for the given files, in batched requests.
+    void PrefetchTags(const QStringList &files);
+    // Returns false if the file was not prefetched, the caller should then read the file itself.
+    bool TakePrefetchedTags(const QString &file, Song *song);
+    void DiscardPrefetchedTags();
+
+    // Audio analyses started on the analysis thread pool ahead of the scan.
+    bool HasAnalysis(const QString &file) const { return analyses_.Contains(file); }
+    void AddAnalysis(const QString &file, const QFuture<AudioAnalyzerResult> &future) { analyses_.Add(file, future); }
+    // Returns false if the file was not prefetched or its analysis was canceled, the caller should then analyze the file itself.
+    bool TakeAnalysis(const QString &file, AudioAnalyzerResult *analysis) { return analyses_.Take(file, analysis); }
+    void DiscardAnalyses() { analyses_.Discard(); }
+
     int dir() const { return dir_; }
     bool is_incremental() const { return incremental_; }
     bool ignores_mtime() const { return ignores_mtime_; }
@@ -164,6 +219,19 @@ class CollectionWatcher : public QObject {
 
     CollectionSubdirectoryList known_subdirs_;
     bool known_subdirs_dirty_;
+
+    QHash<QString, QFuture<SubdirectoryListing>> subdirectory_listings_;
+    QSet<QString> scanned_subdirs_;
+    QSet<QString> missing_subdirs_;
+
+    // Waits for the partial replies of the batch until the file has arrived.
+    void ReceivePrefetchedTags(TagReaderReply *reply, const QString &file);
+
+    QStringList pending_tag_reads_;
+    QHash<QString, TagReaderReply*> tag_read_replies_;
+    QHash<QString, spb::tagreader::SongMetadata> prefetched_tags_;
+
+    PrefetchedAnalyses analyses_;
   };
 
  private slots:
@@ -189,19 +257,39 @@ class CollectionWatcher : public QObject {
   void AddWatch(const CollectionDirectory &dir, const QString &path);
   void RemoveWatch(const CollectionDirectory &dir, const CollectionSubdirectory &subdir);
   static quint64 GetMtimeForCue(const QString &cue_path);
+  // Fills in exists, symlink, mtime and inode of the listing with as few stat calls as possible.
+  static void StatSubdirectory(const QString &path, SubdirectoryListing *listing);
   void PerformScan(const bool incremental, const bool ignore_mtimes);
 
+  // Returns true if the subdirectory must be listed even if its mtime is unchanged.
+  bool SubdirectoryNeedsListing(const QString &path, ScanTransaction *t, const bool force_noincremental);
+  // Lists the subdirectory unless it is unchanged.  Called directly or on the scan thread pool in parallel scan mode.
+  SubdirectoryListing ListSubdirectory(const QString &path, const CollectionSubdirectory &known_subdir, const bool force_listing, const bool pipelined);
+  // Starts listing the given subdirectories on the scan thread pool.  Does nothing unless parallel scan is enabled.
+  void PrefetchSubdirectories(const CollectionSubdirectoryList &subdirs, ScanTransaction *t, const bool force_noincremental);
+
+  void ReadFileForScan(const QString &file, Song *song, ScanTransaction *t);
+
+  // The analyses a file needs, the fingerprint and the loudness and moodbar of files without CUE sheet are done in one decode.
+  AudioAnalyzerResult::Analyses FileAnalyses(const QString &file) const;
+  static AudioAnalyzerResult AnalyzeFileBlocking(const QString &file, const AudioAnalyzerResult::Analyses analyses);
+  // Starts analyzing the given files on the analysis thread pool.  Does nothing unless parallel scan is enabled.
+  void PrefetchAnalyses(const QStringList &files, ScanTransaction *t);
+  // Returns the prefetched analysis of the file, or analyzes it now.
+  AudioAnalyzerResult AnalyzeFile(const QString &file, ScanTransaction *t);
+
   // Updates the sections of a cue associated and altered (according to mtime) media file during a scan.
-  void UpdateCueAssociatedSongs(const QString &file, const QString &path, const QString &fingerprint, const QString &matching_cue, const QUrl &art_automatic, const SongList &old_cue_songs, ScanTransaction *t);
+  void UpdateCueAssociatedSongs(const QString &file, const QString &path, const AudioAnalyzerResult &analysis, const QString &matching_cue, const QUrl &art_automatic, const SongList &old_cue_songs, ScanTransaction *t);
   // Updates a single non-cue associated and altered (according to mtime) song during a scan.
-  void UpdateNonCueAssociatedSong(const QString &file, const QString &fingerprint, const SongList &matching_songs, const QUrl &art_automatic, const bool cue_deleted, ScanTransaction *t);
+  void UpdateNonCueAssociatedSong(const QString &file, const AudioAnalyzerResult &analysis, const SongList &matching_songs, const QUrl &art_automatic, const bool cue_deleted, ScanTransaction *t);
   // Scans a single media file that's present on the disk but not yet in the collection.
   // It may result in a multiple files added to the collection when the media file has many sections (like a CUE related media file).
-  SongList ScanNewFile(const QString &file, const QString &path, const QString &fingerprint, const QString &matching_cue, QSet<QString> *cues_processed);
+  SongList ScanNewFile(const QString &file, const QString &path, const AudioAnalyzerResult &analysis, const QString &matching_cue, QSet<QString> *cues_processed, ScanTransaction *t);
 
   static void AddChangedSong(const QString &file, const Song &matching_song, const Song &new_song, ScanTransaction *t);
 
-  void PerformEBUR128Analysis(Song &song) const;
+  // Uses the loudness from the analysis of the file if it has one, otherwise analyzes the song's section of the file.
+  void PerformEBUR128Analysis(Song &song, const AudioAnalyzerResult &analysis) const;
 
   quint64 FilesCountForPath(ScanTransaction *t, const QString &path);
   quint64 FilesCountForSubdirs(ScanTransaction *t, const CollectionSubdirectoryList &subdirs, QMap<QString, quint64> &subdir_files_count);
@@ -226,13 +314,16 @@ class CollectionWatcher : public QObject {
   bool monitor_;
   bool song_tracking_;
   bool song_ebur128_loudness_analysis_;
+  bool moodbar_;
   bool mark_songs_unavailable_;
   int expire_unavailable_songs_days_;
   bool overwrite_playcount_;
   bool overwrite_rating_;
+  bool parallel_scan_;
 
-  bool stop_requested_;
-  bool abort_requested_;
+  // Read by the scan pool threads while Stop() and Abort() are called from other threads.
+  std::atomic<bool> stop_requested_;
+  std::atomic<bool> abort_requested_;
 
   QMap<int, CollectionDirectory> watched_dirs_;
   QTimer *rescan_timer_;
@@ -244,8 +335,14 @@ class CollectionWatcher : public QObject {
 
   CueParser *cue_parser_;
 
+  QThreadPool *scan_thread_pool_;
+  // Decoding is CPU bound, so analyses get their own pool with fewer threads.
+  QThreadPool *analysis_thread_pool_;
+
   static QStringList sValidImages;
   static QStringList kIgnoredExtensions;
+  static const int kMaxPrefetchedSubdirectories;
+  static const int kMaxPendingTagReads;
 
   qint64 last_scan_time_;
 
@@ -0,0 +1,58 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <QFuture>
+#include <QString>
+
+#include "prefetchedanalyses.h"
+#include "engine/audioanalyzerresult.h"
+
+PrefetchedAnalyses::~PrefetchedAnalyses() {
+
+  Discard();
+
+}
+
+bool PrefetchedAnalyses::Take(const QString &file, AudioAnalyzerResult *analysis) {
+
+  if (!futures_.contains(file)) return false;
+
+  QFuture<AudioAnalyzerResult> future = futures_.take(file);
+  future.waitForFinished();
+
+  // A canceled analysis has no result, even if it was already running.
+  if (future.isCanceled() || future.resultCount() == 0) return false;
+
+  *analysis = future.result();
+
+  return true;
+
+}
+
+void PrefetchedAnalyses::Discard() {
+
+  // Clearing the thread pool would also drop analyses that others still wait for.
+  for (QHash<QString, QFuture<AudioAnalyzerResult>>::iterator it = futures_.begin(); it != futures_.end(); ++it) {
+    it.value().cancel();
+  }
+  futures_.clear();
+
+}
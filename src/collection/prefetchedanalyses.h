@@ -0,0 +1,55 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PREFETCHEDANALYSES_H
+#define PREFETCHEDANALYSES_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QFuture>
+#include <QHash>
+#include <QString>
+
+#include "engine/audioanalyzerresult.h"
+
+// Audio analyses started on a thread pool ahead of a collection scan.
+// The thread pool can be shared, discarding only cancels the analyses added here.
+class PrefetchedAnalyses {
+ public:
+  PrefetchedAnalyses() = default;
+  ~PrefetchedAnalyses();
+
+  bool Contains(const QString &file) const { return futures_.contains(file); }
+  void Add(const QString &file, const QFuture<AudioAnalyzerResult> &future) { futures_.insert(file, future); }
+
+  // Waits for the analysis of the file.
+  // Returns false if the file was not prefetched or its analysis was canceled, the caller should then analyze the file itself.
+  bool Take(const QString &file, AudioAnalyzerResult *analysis);
+
+  // Analyses that haven't started yet are skipped, the running ones finish in the background.
+  void Discard();
+
+ private:
+  QHash<QString, QFuture<AudioAnalyzerResult>> futures_;
+
+  Q_DISABLE_COPY(PrefetchedAnalyses)
+};
+
+#endif  // PREFETCHEDANALYSES_H
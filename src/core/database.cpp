@@ -48,9 +48,12 @@
 #include "scopedtransaction.h"
 
 const char *Database::kDatabaseFilename = "strawberry.db";
-const int Database::kSchemaVersion = 18;
+const int Database::kSchemaVersion = 20;
 const int Database::kMinSupportedSchemaVersion = 10;
 const char *Database::kMagicAllSongsTables = "%allsongstables";
+const char *Database::kMagicAllSubdirectoriesTables = "%allsubdirectoriestables";
+const qint64 Database::kMmapSize = 256 * 1024 * 1024;
+const int Database::kCacheSize = 16 * 1024;
 
 int Database::sNextConnectionId = 1;
 QMutex Database::sNextConnectionIdMutex;
@@ -142,6 +145,8 @@ QSqlDatabase Database::Connect() {
     return db;
   }
 
+  SetConnectionOptions(db, injected_database_name_ == ":memory:");
+
   if (db.tables().count() == 0) {
     // Set up initial schema
     qLog(Info) << "Creating initial database schema";
@@ -200,6 +205,7 @@ void Database::Close() {
 
   // Try to find an existing connection for this thread
   if (QSqlDatabase::connectionNames().contains(connection_id)) {
+    SqlQuery::ClearCache(connection_id);
     {
       QSqlDatabase db = QSqlDatabase::database(connection_id);
       if (db.isOpen()) {
@@ -212,6 +218,29 @@ void Database::Close() {
 
 }
 
+void Database::SetConnectionOptions(QSqlDatabase &db, const bool in_memory) {
+
+  QStringList pragmas;
+  // WAL lets readers on other connections work while a write transaction is open.  It is a property of the database file, so it's kept once set.
+  if (!in_memory) {
+    pragmas << "PRAGMA journal_mode = WAL"
+            << "PRAGMA synchronous = NORMAL"
+            << QString("PRAGMA mmap_size = %1").arg(kMmapSize);
+  }
+  // Negative cache size is in KiB.
+  pragmas << QString("PRAGMA cache_size = -%1").arg(kCacheSize)
+          << "PRAGMA temp_store = MEMORY";
+
+  for (const QString &pragma : pragmas) {
+    SqlQuery q(db);
+    q.prepare(pragma);
+    if (!q.Exec()) {
+      qLog(Warning) << "Failed to set" << pragma << q.lastError().text();
+    }
+  }
+
+}
+
 int Database::SchemaVersion(QSqlDatabase *db) {
 
   // Get the database's schema version
@@ -257,6 +286,7 @@ void Database::RecreateAttachedDb(const QString &database_name) {
   QMutexLocker l(&mutex_);
   {
     QSqlDatabase db(Connect());
+    SqlQuery::ClearCache(db.connectionName());
 
     SqlQuery q(db);
     q.prepare("DETACH DATABASE :alias");
@@ -303,6 +333,7 @@ void Database::DetachDatabase(const QString &database_name) {
   QMutexLocker l(&mutex_);
   {
     QSqlDatabase db(Connect());
+    SqlQuery::ClearCache(db.connectionName());
 
     SqlQuery q(db);
     q.prepare("DETACH DATABASE :alias");
@@ -388,19 +419,20 @@ void Database::ExecSchemaCommands(QSqlDatabase &db, const QString &schema, int s
   // If no outer transaction is provided the song tables need to be queried before beginning an inner transaction!
   // Otherwise DROP TABLE commands on song tables may fail due to database locks.
   const QStringList song_tables(SongsTables(db, schema_version));
+  const QStringList subdirectories_tables(SubdirectoriesTables(db));
 
   if (!in_transaction) {
     ScopedTransaction inner_transaction(&db);
-    ExecSongTablesCommands(db, song_tables, commands);
+    ExecSongTablesCommands(db, song_tables, subdirectories_tables, commands);
     inner_transaction.Commit();
   }
   else {
-    ExecSongTablesCommands(db, song_tables, commands);
+    ExecSongTablesCommands(db, song_tables, subdirectories_tables, commands);
   }
 
 }
 
-void Database::ExecSongTablesCommands(QSqlDatabase &db, const QStringList &song_tables, const QStringList &commands) {
+void Database::ExecSongTablesCommands(QSqlDatabase &db, const QStringList &song_tables, const QStringList &subdirectories_tables, const QStringList &commands) {
 
   for (const QString &command : commands) {
     // There are now lots of "songs" tables that need to have the same schema: songs and device_*_songs.
@@ -423,6 +455,20 @@ void Database::ExecSongTablesCommands(QSqlDatabase &db, const QStringList &song_
         }
       }
     }
+    else if (command.contains(kMagicAllSubdirectoriesTables)) {
+      // Same for the subdirectories tables of the collection and the devices.
+      for (const QString &table : subdirectories_tables) {
+        qLog(Info) << "Updating" << table << "for" << kMagicAllSubdirectoriesTables;
+        QString new_command(command);
+        new_command.replace(kMagicAllSubdirectoriesTables, table);
+        SqlQuery query(db);
+        query.prepare(new_command);
+        if (!query.Exec()) {
+          ReportErrors(query);
+          qFatal("Unable to update music collection database");
+        }
+      }
+    }
     else {
       SqlQuery query(db);
       query.prepare(command);
@@ -468,6 +514,17 @@ QStringList Database::SongsTables(QSqlDatabase &db, const int schema_version) {
 
 }
 
+QStringList Database::SubdirectoriesTables(QSqlDatabase &db) {
+
+  QStringList ret;
+  for (const QString &table : db.tables()) {
+    if (table == "subdirectories" || table.endsWith("_subdirectories")) ret << table;
+  }
+
+  return ret;
+
+}
+
 void Database::ReportErrors(const SqlQuery &query) {
 
   const QSqlError sql_error = query.lastError();
@@ -64,12 +64,17 @@ class Database : public QObject {
   static const int kMinSupportedSchemaVersion;
   static const char *kDatabaseFilename;
   static const char *kMagicAllSongsTables;
+  static const char *kMagicAllSubdirectoriesTables;
+  static const qint64 kMmapSize;
+  static const int kCacheSize;
 
   void ExitAsync();
   QSqlDatabase Connect();
   void Close();
   void ReportErrors(const SqlQuery &query);
 
+  // Serializes writes to the database.  The database is in WAL mode, so reads don't block or get blocked by writes and don't need to lock this.
+  // Each thread has its own connection, so reads from different threads run concurrently.
 #if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
   QRecursiveMutex *Mutex() { return &mutex_; }
 #else
@@ -98,15 +103,17 @@ class Database : public QObject {
   void DoBackup();
 
  private:
+  static void SetConnectionOptions(QSqlDatabase &db, const bool in_memory);
   static int SchemaVersion(QSqlDatabase *db);
   void UpdateMainSchema(QSqlDatabase *db);
 
   void ExecSchemaCommandsFromFile(QSqlDatabase &db, const QString &filename, int schema_version, bool in_transaction = false);
-  void ExecSongTablesCommands(QSqlDatabase &db, const QStringList &song_tables, const QStringList &commands);
+  void ExecSongTablesCommands(QSqlDatabase &db, const QStringList &song_tables, const QStringList &subdirectories_tables, const QStringList &commands);
 
   void UpdateDatabaseSchema(int version, QSqlDatabase &db);
   void UrlEncodeFilenameColumn(const QString &table, QSqlDatabase &db);
   QStringList SongsTables(QSqlDatabase &db, const int schema_version);
+  static QStringList SubdirectoriesTables(QSqlDatabase &db);
   bool IntegrityCheck(const QSqlDatabase &db);
   void BackupFile(const QString &filename);
   static bool OpenDatabase(const QString &filename, sqlite3 **connection);
@@ -151,7 +158,9 @@ class MemoryDatabase : public Database {
       : Database(app, parent, ":memory:") {}
   ~MemoryDatabase() override {
     // Make sure Qt doesn't reuse the same database
-    QSqlDatabase::removeDatabase(Connect().connectionName());
+    const QString connection_name = Connect().connectionName();
+    SqlQuery::ClearCache(connection_name);
+    QSqlDatabase::removeDatabase(connection_name);
   }
 };
 
@@ -0,0 +1,197 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QThreadPool>
+#include <QFuture>
+#include <QMutex>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QtConcurrentRun>
+
+#include "filestatuscache.h"
+
+const qint64 FileStatusCache::kMaxAge = 60000;
+const int FileStatusCache::kMaxThreads = 8;
+const int FileStatusCache::kMinFilesForListing = 4;
+const int FileStatusCache::kMaxEntries = 100000;
+
+QMutex FileStatusCache::sInstanceMutex;
+FileStatusCache *FileStatusCache::sInstance = nullptr;
+
+FileStatusCache::FileStatusCache(const qint64 max_age, const int max_entries)
+    : max_age_(max_age),
+      max_entries_(max_entries),
+      thread_pool_(new QThreadPool) {
+
+  thread_pool_->setMaxThreadCount(kMaxThreads);
+
+}
+
+FileStatusCache::~FileStatusCache() {
+
+  delete thread_pool_;
+
+}
+
+FileStatusCache *FileStatusCache::Instance() {
+
+  QMutexLocker l(&sInstanceMutex);
+  if (!sInstance) {
+    sInstance = new FileStatusCache;
+  }
+
+  return sInstance;
+
+}
+
+bool FileStatusCache::Exists(const QString &filename, const bool refresh) {
+
+  return Exists(QStringList() << filename, refresh).value(filename, false);
+
+}
+
+QHash<QString, bool> FileStatusCache::Exists(const QStringList &filenames, const bool refresh) {
+
+  QHash<QString, bool> results;
+  results.reserve(filenames.count());
+
+  // Group the files that are not cached by directory.
+  QHash<QString, QStringList> directories;
+  QSet<QString> requested_filenames;
+  {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QMutexLocker l(&mutex_);
+    for (const QString &filename : filenames) {
+      if (results.contains(filename) || requested_filenames.contains(filename)) continue;
+      const QHash<QString, Status>::const_iterator it = refresh ? statuses_.constEnd() : statuses_.constFind(filename);
+      if (it != statuses_.constEnd() && now - it.value().checked < max_age_) {
+        results.insert(filename, it.value().exists);
+      }
+      else {
+        directories[QFileInfo(filename).path()] << filename;
+        requested_filenames.insert(filename);
+      }
+    }
+  }
+
+  if (directories.isEmpty()) return results;
+
+  QList<QFuture<QHash<QString, bool>>> futures;
+  futures.reserve(directories.count());
+  for (QHash<QString, QStringList>::const_iterator it = directories.constBegin(); it != directories.constEnd(); ++it) {
+    futures << QtConcurrent::run(thread_pool_, &FileStatusCache::CheckDirectory, it.key(), it.value());
+  }
+
+  QHash<QString, bool> checked_results;
+  checked_results.reserve(requested_filenames.count());
+  for (QFuture<QHash<QString, bool>> &future : futures) {
+    const QHash<QString, bool> directory_results = future.result();
+    for (QHash<QString, bool>::const_iterator it = directory_results.constBegin(); it != directory_results.constEnd(); ++it) {
+      checked_results.insert(it.key(), it.value());
+    }
+  }
+
+  {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QMutexLocker l(&mutex_);
+    // Drop the old entries when there are too many, so the cache doesn't keep growing.
+    if (statuses_.count() > max_entries_) {
+      for (QHash<QString, Status>::iterator it = statuses_.begin(); it != statuses_.end();) {
+        if (now - it.value().checked >= max_age_) {
+          it = statuses_.erase(it);
+        }
+        else {
+          ++it;
+        }
+      }
+    }
+    for (QHash<QString, bool>::const_iterator it = checked_results.constBegin(); it != checked_results.constEnd(); ++it) {
+      Status status;
+      status.exists = it.value();
+      status.checked = now;
+      statuses_.insert(it.key(), status);
+      results.insert(it.key(), it.value());
+    }
+  }
+
+  return results;
+
+}
+
+QHash<QString, bool> FileStatusCache::CheckDirectory(const QString &path, const QStringList &filenames) {
+
+  QHash<QString, bool> results;
+  results.reserve(filenames.count());
+
+  if (filenames.count() < kMinFilesForListing) {
+    for (const QString &filename : filenames) {
+      results.insert(filename, QFile::exists(filename));
+    }
+    return results;
+  }
+
+  QDir dir(path);
+  if (!dir.exists()) {
+    for (const QString &filename : filenames) {
+      results.insert(filename, false);
+    }
+    return results;
+  }
+
+  // Without QDir::System, broken symlinks are not listed, QFile::exists() doesn't count them either.
+  const QStringList entries = dir.entryList(QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+  const QSet<QString> entry_set(entries.begin(), entries.end());
+#else
+  const QSet<QString> entry_set = entries.toSet();
+#endif
+
+  for (const QString &filename : filenames) {
+    // Names that are not listed are checked again, the URL might not have the same case or normalization as the file system.
+    const bool exists = entry_set.contains(QFileInfo(filename).fileName()) || QFile::exists(filename);
+    results.insert(filename, exists);
+  }
+
+  return results;
+
+}
+
+void FileStatusCache::Clear() {
+
+  QMutexLocker l(&mutex_);
+  statuses_.clear();
+
+}
+
+int FileStatusCache::count() {
+
+  QMutexLocker l(&mutex_);
+  return static_cast<int>(statuses_.count());
+
+}
@@ -0,0 +1,83 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FILESTATUSCACHE_H
+#define FILESTATUSCACHE_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QMutex>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+class QThreadPool;
+
+// Checks if local files exist, for all playlists.
+// Files in the same directory are checked by listing the directory once instead of a stat for each file,
+// and the directories are checked in parallel, with a limited number of threads so a slow network share doesn't take all threads.
+// Results are cached for a while, so playlists with the same songs don't check them again.
+// Thread safe, but blocking, so don't call it from the GUI thread.
+class FileStatusCache {
+
+ public:
+  // Use the instance, a cache of its own is only for tests.
+  explicit FileStatusCache(const qint64 max_age = kMaxAge, const int max_entries = kMaxEntries);
+  ~FileStatusCache();
+
+  static FileStatusCache *Instance();
+
+  static const qint64 kMaxAge;
+  static const int kMinFilesForListing;
+  static const int kMaxEntries;
+
+  // Returns whether each of the files exists, by filename.
+  // With refresh, the files are checked again even if they were checked recently, use it when the user asked for the check.
+  QHash<QString, bool> Exists(const QStringList &filenames, const bool refresh = false);
+  bool Exists(const QString &filename, const bool refresh = false);
+
+  void Clear();
+  int count();
+
+ private:
+
+  struct Status {
+    Status() : exists(false), checked(0) {}
+    bool exists;
+    qint64 checked;
+  };
+
+  static QHash<QString, bool> CheckDirectory(const QString &path, const QStringList &filenames);
+
+  static const int kMaxThreads;
+
+  static QMutex sInstanceMutex;
+  static FileStatusCache *sInstance;
+
+  const qint64 max_age_;
+  const int max_entries_;
+  QThreadPool *thread_pool_;
+  QMutex mutex_;
+  QHash<QString, Status> statuses_;
+
+  Q_DISABLE_COPY(FileStatusCache)
+};
+
+#endif  // FILESTATUSCACHE_H
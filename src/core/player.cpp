@@ -345,6 +345,7 @@ void Player::HandleLoadResult(const UrlHandler::LoadResult &result) {
         engine_->Play(result.media_url_, result.stream_url_, stream_change_type_, song.has_cue(), song.beginning_nanosec(), song.end_nanosec(), play_offset_nanosec_, song.ebur128_integrated_loudness_lufs());
         current_item_ = item;
         play_offset_nanosec_ = 0;
+        PrefetchNext();
       }
       else if (is_next && !item->Metadata().is_module_music()) {
         qLog(Debug) << "Preloading next song" << next_item->Metadata().title() << result.stream_url_;
@@ -738,6 +739,23 @@ void Player::PlayAt(const int index, const quint64 offset_nanosec, EngineBase::T
   else {
     qLog(Debug) << "Playing song" << current_item_->Metadata().title() << url << "position" << offset_nanosec;
     engine_->Play(current_item_->Url(), url, change, current_item_->Metadata().has_cue(), current_item_->effective_beginning_nanosec(), current_item_->effective_end_nanosec(), offset_nanosec, current_item_->effective_ebur128_integrated_loudness_lufs());
+    PrefetchNext();
+  }
+
+}
+
+void Player::PrefetchNext() {
+
+  Playlist *active_playlist = app_->playlist_manager()->active();
+  const int next_row = active_playlist->next_row();
+  if (next_row == -1) return;
+
+  PlaylistItemPtr next_item = active_playlist->item_at(next_row);
+  if (!next_item) return;
+
+  const QUrl url = next_item->StreamUrl();
+  if (url_handlers_.contains(url.scheme()) && !loading_async_.contains(url)) {
+    url_handlers_[url.scheme()]->Prefetch(url);
   }
 
 }
@@ -931,6 +949,16 @@ void Player::ValidSongRequested(const QUrl &url) {
 
 void Player::InvalidSongRequested(const QUrl &url) {
 
+  // The URL handler might want to resolve the stream URL again, like when it came from a cache.
+  if (current_item_) {
+    const QUrl media_url = current_item_->Metadata().url();
+    if (url != media_url && url_handlers_.contains(media_url.scheme()) && !loading_async_.contains(media_url) && url_handlers_[media_url.scheme()]->LoadFailed(media_url, url)) {
+      qLog(Debug) << "Loading" << media_url << "again after" << url << "failed to play";
+      HandleLoadResult(url_handlers_[media_url.scheme()]->StartLoading(media_url));
+      return;
+    }
+  }
+
   if (greyout_) emit SongChangeRequestProcessed(url, false);
 
   if (!continue_on_error_) {
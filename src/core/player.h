@@ -215,6 +215,9 @@ class Player : public PlayerInterface {
 
   void UnPause();
 
+  // Lets the URL handler of the next song resolve its stream URL while the current song plays.
+  void PrefetchNext();
+
  private:
   Application *app_;
   SharedPtr<EngineBase> engine_;
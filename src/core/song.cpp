@@ -830,6 +830,12 @@ bool Song::IsAllMetadataEqual(const Song &other) const {
 
 }
 
+bool Song::IsSameData(const Song &other) const {
+
+  return d == other.d;
+
+}
+
 bool Song::IsOnSameAlbum(const Song &other) const {
 
   if (is_compilation() != other.is_compilation()) return false;
@@ -379,6 +379,8 @@ class Song {
   bool IsEBUR128Equal(const Song &other) const;
   bool IsArtEqual(const Song &other) const;
   bool IsAllMetadataEqual(const Song &other) const;
+  // True if both are copies of the same song that neither was changed since.
+  bool IsSameData(const Song &other) const;
 
   bool IsOnSameAlbum(const Song &other) const;
   bool IsSimilar(const Song &other) const;
@@ -22,6 +22,7 @@
 #include "config.h"
 
 #include <algorithm>
+#include <utility>
 
 #ifdef HAVE_GSTREAMER
 #  include <gst/gst.h>
@@ -35,9 +36,12 @@
 #include <QDirIterator>
 #include <QFile>
 #include <QFileInfo>
+#include <QList>
+#include <QHash>
 #include <QSet>
 #include <QTimer>
 #include <QString>
+#include <QStringList>
 #include <QUrl>
 #include <QEventLoop>
 
@@ -64,6 +68,7 @@
 
 QSet<QString> SongLoader::sRawUriSchemes;
 const int SongLoader::kDefaultTimeout = 5000;
+const int SongLoader::kMetadataBatchSize = 256;
 
 SongLoader::SongLoader(SharedPtr<CollectionBackendInterface> collection_backend, const SharedPtr<Player> player, QObject *parent)
     : QObject(parent),
@@ -171,8 +176,8 @@ SongLoader::Result SongLoader::LoadLocalPartial(const QString &filename) {
     return Result::Success;
   }
 
-  // Assume it's just a normal file
-  if (TagReaderClient::Instance()->IsMediaFileBlocking(filename) || Song::kAcceptedExtensions.contains(fileinfo.suffix(), Qt::CaseInsensitive)) {
+  // Assume it's just a normal file, only ask the tagreader when the extension isn't known.
+  if (Song::kAcceptedExtensions.contains(fileinfo.suffix(), Qt::CaseInsensitive) || TagReaderClient::Instance()->IsMediaFileBlocking(filename)) {
     Song song(Song::Source::LocalFile);
     song.InitFromFilePartial(filename, fileinfo);
     if (song.is_valid()) {
@@ -316,7 +321,7 @@ SongLoader::Result SongLoader::LoadLocalAsync(const QString &filename) {
   }
 
   // Assume it's just a normal file
-  if (TagReaderClient::Instance()->IsMediaFileBlocking(filename) || Song::kAcceptedExtensions.contains(fileinfo.suffix(), Qt::CaseInsensitive)) {
+  if (Song::kAcceptedExtensions.contains(fileinfo.suffix(), Qt::CaseInsensitive) || TagReaderClient::Instance()->IsMediaFileBlocking(filename)) {
     Song song(Song::Source::LocalFile);
     song.InitFromFilePartial(filename, fileinfo);
     if (song.is_valid()) {
@@ -332,10 +337,68 @@ SongLoader::Result SongLoader::LoadLocalAsync(const QString &filename) {
 
 void SongLoader::LoadMetadataBlocking() {
 
+  QList<int> song_indexes;
+  QList<QUrl> urls;
   for (int i = 0; i < songs_.size(); i++) {
-    EffectiveSongLoad(&songs_[i]);
+    const Song &song = songs_[i];
+    if (!song.url().isLocalFile()) continue;
+    if (song.init_from_file() && song.filetype() != Song::FileType::Unknown) continue;
+    song_indexes << i;
+    urls << song.url();
+  }
+
+  if (song_indexes.isEmpty()) return;
+
+  // Look up all the songs in the collection at once.
+  QHash<QUrl, Song> collection_songs;
+  const SongList songs_found = collection_backend_->GetSongsByUrls(urls);
+  for (const Song &song : songs_found) {
+    if (song.beginning_nanosec() == 0 && song.is_valid()) {
+      collection_songs.insert(song.url(), song);
+    }
+  }
+
+  SongList collection_songs_loaded;
+  QList<int> tagreader_indexes;
+  for (const int i : std::as_const(song_indexes)) {
+    QHash<QUrl, Song>::const_iterator it = collection_songs.constFind(songs_[i].url());
+    if (it == collection_songs.constEnd()) {
+      tagreader_indexes << i;
+    }
+    else {
+      songs_[i] = it.value();
+      collection_songs_loaded << it.value();
+    }
   }
 
+  if (!collection_songs_loaded.isEmpty()) {
+    emit MetadataLoaded(collection_songs_loaded);
+  }
+
+  // The rest are read by the tagreader, in batches so the songs can be updated while the others are read.
+  for (qint64 i = 0; i < tagreader_indexes.count(); i += kMetadataBatchSize) {
+    const QList<int> batch_indexes = tagreader_indexes.mid(i, kMetadataBatchSize);
+    QStringList filenames;
+    SongList songs;
+    filenames.reserve(batch_indexes.count());
+    songs.reserve(batch_indexes.count());
+    for (const int song_index : batch_indexes) {
+      filenames << songs_[song_index].url().toLocalFile();
+      songs << songs_[song_index];
+    }
+    TagReaderClient::Instance()->ReadFilesBlocking(filenames, &songs);
+    for (int j = 0; j < batch_indexes.count(); ++j) {
+      songs_[batch_indexes[j]] = songs[j];
+    }
+    emit MetadataLoaded(songs);
+  }
+
+}
+
+void SongLoader::LoadFirstSongMetadataBlocking() {
+
+  if (!songs_.isEmpty()) EffectiveSongLoad(&songs_.first());
+
 }
 
 void SongLoader::EffectiveSongLoad(Song *song) {
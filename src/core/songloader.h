@@ -69,6 +69,8 @@ class SongLoader : public QObject {
   };
 
   static const int kDefaultTimeout;
+  // Number of files read from the tagreader before the songs are passed on with MetadataLoaded().
+  static const int kMetadataBatchSize;
 
   const QUrl &url() const { return url_; }
   const SongList &songs() const { return songs_; }
@@ -82,8 +84,11 @@ class SongLoader : public QObject {
   // This method is blocking, do not call it from the UI thread.
   SongLoader::Result LoadFilenamesBlocking();
   // Completely load songs previously loaded with LoadFilenamesBlocking().
+  // The songs in the collection are loaded first all at once, then the files are read in batches, MetadataLoaded() is emitted for each of these.
   // When finished, the Song objects in songs() contain metadata now. This method is blocking, do not call it from the UI thread.
   void LoadMetadataBlocking();
+  // Completely load only the first song, so it can start playing. This method is blocking, do not call it from the UI thread.
+  void LoadFirstSongMetadataBlocking();
   Result LoadAudioCD();
 
   QStringList errors() { return errors_; }
@@ -92,6 +97,7 @@ class SongLoader : public QObject {
   void AudioCDTracksLoadFinished();
   void LoadAudioCDFinished(const bool success);
   void LoadRemoteFinished();
+  void MetadataLoaded(const SongList &songs);
 
  private slots:
   void ScheduleTimeout();
@@ -19,13 +19,128 @@
 
 #include "config.h"
 
+#include <utility>
+#include <atomic>
+
 #include <QMap>
+#include <QCache>
+#include <QThreadStorage>
 #include <QVariant>
 #include <QString>
 #include <QUrl>
+#include <QSqlDatabase>
+#include <QSqlError>
 
+#include "shared_ptr.h"
 #include "sqlquery.h"
 
+// clazy:excludeall=non-pod-global-static
+
+const int SqlQuery::kMaxCachedQueries = 64;
+
+namespace {
+
+using QueryCache = QCache<QString, QSqlQuery>;
+
+// Connections are per thread, so each thread keeps the statements of its own connections, keyed by connection name and then by SQL.
+QThreadStorage<QMap<QString, SharedPtr<QueryCache>>> sQueryCaches;
+std::atomic<quint64> sCacheHits(0);
+std::atomic<quint64> sCacheMisses(0);
+
+QueryCache *CacheForConnection(const QString &connection_name, const bool create) {
+
+  QMap<QString, SharedPtr<QueryCache>> &caches = sQueryCaches.localData();
+  if (caches.contains(connection_name)) {
+    return caches[connection_name].get();
+  }
+  if (!create) return nullptr;
+
+  SharedPtr<QueryCache> cache = std::make_shared<QueryCache>(SqlQuery::kMaxCachedQueries);
+  caches.insert(connection_name, cache);
+  return cache.get();
+
+}
+
+}  // namespace
+
+SqlQuery::SqlQuery(const QSqlDatabase &db) : QSqlQuery(db), db_(db), connection_name_(db.connectionName()) {}
+
+SqlQuery::~SqlQuery() {
+
+  ReleaseCachedQuery();
+
+}
+
+bool SqlQuery::prepare(const QString &query) {
+
+  if (ReleaseCachedQuery()) {
+    // The statement was handed back to the cache, start over with a new one.
+    QSqlQuery::operator=(QSqlQuery(db_));
+  }
+
+  QueryCache *cache = CacheForConnection(connection_name_, true);
+  // Take the statement out of the cache while it's in use, a nested query with the same SQL then gets its own.
+  QSqlQuery *cached_query = cache->take(query);
+  // The connection might have been removed and opened again by another thread since, then the statement belongs to the old driver.
+  if (cached_query && cached_query->driver() != db_.driver()) {
+    delete cached_query;
+    cached_query = nullptr;
+  }
+  if (cached_query) {
+    QSqlQuery::operator=(std::move(*cached_query));
+    delete cached_query;
+    ++sCacheHits;
+    prepared_query_ = query;
+    return true;
+  }
+
+  ++sCacheMisses;
+  if (!QSqlQuery::prepare(query)) return false;
+  prepared_query_ = query;
+  return true;
+
+}
+
+bool SqlQuery::ReleaseCachedQuery() {
+
+  if (prepared_query_.isEmpty()) return false;
+
+  const QString query = prepared_query_;
+  prepared_query_.clear();
+
+  // Don't keep statements that were replaced with exec(QString) or failed.
+  if (lastQuery() != query || lastError().isValid()) return false;
+
+  QueryCache *cache = CacheForConnection(connection_name_, false);
+  if (!cache || cache->contains(query)) return false;
+
+  // Reset the statement so it doesn't hold on to a read transaction while it's cached.
+  finish();
+  cache->insert(query, new QSqlQuery(std::move(*static_cast<QSqlQuery*>(this))));
+
+  return true;
+
+}
+
+void SqlQuery::ClearCache(const QString &connection_name) {
+
+  if (!sQueryCaches.hasLocalData()) return;
+  sQueryCaches.localData().remove(connection_name);
+
+}
+
+quint64 SqlQuery::cache_hits() {
+
+  return sCacheHits.load();
+
+}
+
+quint64 SqlQuery::cache_misses() {
+
+  return sCacheMisses.load();
+
+}
+
 void SqlQuery::BindValue(const QString &placeholder, const QVariant &value) {
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
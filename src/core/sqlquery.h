@@ -33,7 +33,13 @@
 class SqlQuery : public QSqlQuery {
 
  public:
-  explicit SqlQuery(const QSqlDatabase &db) : QSqlQuery(db) {}
+  explicit SqlQuery(const QSqlDatabase &db);
+  ~SqlQuery();
+
+  static const int kMaxCachedQueries;
+
+  // Prepares the query, reusing the compiled statement from an earlier query with the same SQL on this connection when there is one.
+  bool prepare(const QString &query);
 
   void BindValue(const QString &placeholder, const QVariant &value);
   void BindStringValue(const QString &placeholder, const QString &value);
@@ -49,7 +55,17 @@ class SqlQuery : public QSqlQuery {
   bool Exec();
   QString LastQuery() const;
 
+  // Drops the cached statements of a connection, must be called from the connection's thread before it's closed.
+  static void ClearCache(const QString &connection_name);
+  static quint64 cache_hits();
+  static quint64 cache_misses();
+
  private:
+  bool ReleaseCachedQuery();
+
+  QSqlDatabase db_;
+  QString connection_name_;
+  QString prepared_query_;
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
   QMap<QString, QVariant> bound_values_;
 #endif
@@ -22,25 +22,39 @@
 #include "config.h"
 
 #include <string>
+#include <utility>
 
 #include <QtGlobal>
 #include <QObject>
 #include <QThread>
 #include <QByteArray>
+#include <QList>
 #include <QString>
+#include <QStringList>
 #include <QImage>
 #include <QSettings>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 
 #include "core/logging.h"
 #include "core/workerpool.h"
+#include "settings/collectionsettingspage.h"
+#include "tagreaderlocal.h"
 
 #include "song.h"
 #include "tagreaderclient.h"
 
 const char *TagReaderClient::kWorkerExecutableName = "strawberry-tagreader";
+const int TagReaderClient::kReadFilesBatchSize = 16;
+const char *TagReaderClient::kSettingsInProcess = "in_process_tag_reading";
+const char *TagReaderClient::kSettingsMaxWorkers = "tagreader_max_workers";
 TagReaderClient *TagReaderClient::sInstance = nullptr;
 
-TagReaderClient::TagReaderClient(QObject *parent) : QObject(parent), worker_pool_(new WorkerPool<HandlerType>(this)) {
+TagReaderClient::TagReaderClient(QObject *parent)
+    : QObject(parent),
+      worker_pool_(new WorkerPool<HandlerType>(this)),
+      local_reader_(nullptr),
+      local_thread_pool_(new QThreadPool(this)) {
 
   sInstance = this;
   original_thread_ = thread();
@@ -50,7 +64,35 @@ TagReaderClient::TagReaderClient(QObject *parent) : QObject(parent), worker_pool
 
 }
 
-void TagReaderClient::Start() { worker_pool_->Start(); }
+TagReaderClient::~TagReaderClient() {
+
+  local_thread_pool_->waitForDone();
+  delete local_reader_;
+
+}
+
+void TagReaderClient::Start() {
+
+  QSettings s;
+  s.beginGroup(CollectionSettingsPage::kSettingsGroup);
+  const bool in_process = s.value(kSettingsInProcess, false).toBool();
+  const int max_workers = s.value(kSettingsMaxWorkers, 0).toInt();
+  s.endGroup();
+
+  if (in_process) {
+    qLog(Info) << "Reading tags of common formats in process";
+    local_reader_ = new TagReaderLocal;
+    local_thread_pool_->setMaxThreadCount(QThread::idealThreadCount());
+  }
+
+  // Zero leaves it to the worker pool, based on the number of processors.
+  if (max_workers > 0) {
+    worker_pool_->SetMaxWorkerCount(max_workers);
+  }
+
+  worker_pool_->Start();
+
+}
 
 void TagReaderClient::ExitAsync() {
   QMetaObject::invokeMethod(this, &TagReaderClient::Exit, Qt::QueuedConnection);
@@ -64,6 +106,37 @@ void TagReaderClient::Exit() {
 
 }
 
+QList<_WorkerPoolBase::WorkerStatistics> TagReaderClient::WorkerStatistics() const {
+  return worker_pool_->Statistics();
+}
+
+TagReaderReply *TagReaderClient::SendMessageWithReply(spb::tagreader::Message *message) {
+
+  if (!local_reader_ || !local_reader_->CanHandle(*message)) {
+    return worker_pool_->SendMessageWithReply(message);
+  }
+
+  // Like the worker pool's replies, the reply lives on this thread, which has an event loop, instead of the caller's.
+  ReplyType *reply = new ReplyType(*message);
+  reply->moveToThread(thread());
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+  (void)QtConcurrent::run(local_thread_pool_, &TagReaderClient::HandleMessageLocal, this, reply);
+#else
+  (void)QtConcurrent::run(local_thread_pool_, this, &TagReaderClient::HandleMessageLocal, reply);
+#endif
+
+  return reply;
+
+}
+
+void TagReaderClient::HandleMessageLocal(ReplyType *reply) {
+
+  spb::tagreader::Message message;
+  local_reader_->HandleMessage(reply->request_message(), &message);
+  reply->SetReply(message);
+
+}
+
 void TagReaderClient::WorkerFailedToStart() {
   qLog(Error) << "The" << kWorkerExecutableName << "executable was not found in the current directory or on the PATH.  Strawberry will not be able to read music file tags without it.";
 }
@@ -76,7 +149,7 @@ TagReaderReply *TagReaderClient::IsMediaFile(const QString &filename) {
   const QByteArray filename_data = filename.toUtf8();
   request->set_filename(filename_data.constData(), filename_data.length());
 
-  return worker_pool_->SendMessageWithReply(&message);
+  return SendMessageWithReply(&message);
 
 }
 
@@ -88,7 +161,21 @@ TagReaderReply *TagReaderClient::ReadFile(const QString &filename) {
   const QByteArray filename_data = filename.toUtf8();
   request->set_filename(filename_data.constData(), filename_data.length());
 
-  return worker_pool_->SendMessageWithReply(&message);
+  return SendMessageWithReply(&message);
+
+}
+
+TagReaderReply *TagReaderClient::ReadFiles(const QStringList &filenames) {
+
+  spb::tagreader::Message message;
+  spb::tagreader::ReadFilesRequest *request = message.mutable_read_files_request();
+
+  for (const QString &filename : filenames) {
+    const QByteArray filename_data = filename.toUtf8();
+    request->add_filenames(filename_data.constData(), filename_data.length());
+  }
+
+  return SendMessageWithReply(&message);
 
 }
 
@@ -118,7 +205,7 @@ TagReaderReply *TagReaderClient::SaveFile(const QString &filename, const Song &m
   }
   metadata.ToProtobuf(request->mutable_metadata());
 
-  ReplyType *reply = worker_pool_->SendMessageWithReply(&message);
+  ReplyType *reply = SendMessageWithReply(&message);
 
   return reply;
 
@@ -132,7 +219,7 @@ TagReaderReply *TagReaderClient::LoadEmbeddedArt(const QString &filename) {
   const QByteArray filename_data = filename.toUtf8();
   request->set_filename(filename_data.constData(), filename_data.length());
 
-  return worker_pool_->SendMessageWithReply(&message);
+  return SendMessageWithReply(&message);
 
 }
 
@@ -155,7 +242,7 @@ TagReaderReply *TagReaderClient::SaveEmbeddedArt(const QString &filename, const
     request->set_cover_mime_type(cover_mime_type.constData(), cover_mime_type.length());
   }
 
-  return worker_pool_->SendMessageWithReply(&message);
+  return SendMessageWithReply(&message);
 
 }
 
@@ -168,7 +255,7 @@ TagReaderReply *TagReaderClient::UpdateSongPlaycount(const Song &metadata) {
   request->set_filename(filename_data.constData(), filename_data.length());
   metadata.ToProtobuf(request->mutable_metadata());
 
-  return worker_pool_->SendMessageWithReply(&message);
+  return SendMessageWithReply(&message);
 
 }
 
@@ -190,7 +277,7 @@ TagReaderReply *TagReaderClient::UpdateSongRating(const Song &metadata) {
   request->set_filename(filename_data.constData(), filename_data.length());
   metadata.ToProtobuf(request->mutable_metadata());
 
-  return worker_pool_->SendMessageWithReply(&message);
+  return SendMessageWithReply(&message);
 
 }
 
@@ -231,6 +318,38 @@ void TagReaderClient::ReadFileBlocking(const QString &filename, Song *song) {
 
 }
 
+void TagReaderClient::ReadFilesBlocking(const QStringList &filenames, SongList *songs) {
+
+  Q_ASSERT(QThread::currentThread() != thread());
+  Q_ASSERT(filenames.count() == songs->count());
+
+  // Split the files over several requests so all workers are used.
+  QList<TagReaderReply*> replies;
+  for (int i = 0; i < filenames.count(); i += kReadFilesBatchSize) {
+    replies << ReadFiles(filenames.mid(i, kReadFilesBatchSize));
+  }
+
+  // The worker answers with the files in the same order as they were requested.
+  // Songs of files that could not be read are left as they are.
+  for (int i = 0; i < replies.count(); ++i) {
+    TagReaderReply *reply = replies[i];
+    int song_index = i * kReadFilesBatchSize;
+    QList<spb::tagreader::Message> messages;
+    while (reply->WaitForNextReplies(&messages)) {
+      for (const spb::tagreader::Message &message : std::as_const(messages)) {
+        for (const spb::tagreader::ReadFilesResponse_File &file : message.read_files_response().files()) {
+          if (song_index < songs->count() && file.success()) {
+            (*songs)[song_index].InitFromProtobuf(file.metadata());
+          }
+          ++song_index;
+        }
+      }
+    }
+    reply->deleteLater();
+  }
+
+}
+
 bool TagReaderClient::SaveFileBlocking(const QString &filename, const Song &metadata, const SaveTypes save_types, const SaveCoverOptions &save_cover_options) {
 
   Q_ASSERT(QThread::currentThread() != thread());
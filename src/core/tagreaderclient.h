@@ -27,6 +27,7 @@
 #include <QObject>
 #include <QList>
 #include <QString>
+#include <QStringList>
 #include <QImage>
 
 #include "core/messagehandler.h"
@@ -36,20 +37,43 @@
 #include "tagreadermessages.pb.h"
 
 class QThread;
+class QThreadPool;
+class QIODevice;
 class Song;
+class TagReaderLocal;
 template<typename HandlerType> class WorkerPool;
 
+// Client side of the tagreader protocol, ReadFilesRequest is answered with several partial replies.
+class TagReaderMessageHandler : public AbstractMessageHandler<spb::tagreader::Message> {
+ public:
+  explicit TagReaderMessageHandler(QIODevice *device, QObject *parent) : AbstractMessageHandler<spb::tagreader::Message>(device, parent) {}
+
+ protected:
+  bool IsPartialReply(const spb::tagreader::Message &message) const override {
+    return message.has_read_files_response() && message.read_files_response().partial();
+  }
+};
+
 class TagReaderClient : public QObject {
   Q_OBJECT
 
  public:
   explicit TagReaderClient(QObject *parent = nullptr);
+  ~TagReaderClient() override;
 
-  using HandlerType = AbstractMessageHandler<spb::tagreader::Message>;
+  using HandlerType = TagReaderMessageHandler;
   using ReplyType = HandlerType::ReplyType;
 
   static const char *kWorkerExecutableName;
 
+  // Maximum number of files sent to a worker in one ReadFilesRequest.
+  static const int kReadFilesBatchSize;
+
+  static const char *kSettingsInProcess;
+  static const char *kSettingsMaxWorkers;
+
+  // Reads the in-process and worker count settings and starts the workers.  With in-process tag reading, files in common formats are read on a thread pool in this process,
+  // and only other files and requests that write to files are sent to the workers.
   void Start();
   void ExitAsync();
 
@@ -74,6 +98,8 @@ class TagReaderClient : public QObject {
 
   ReplyType *IsMediaFile(const QString &filename);
   ReplyType *ReadFile(const QString &filename);
+  // Reads all the files in one request, the metadata is streamed back in partial replies.
+  ReplyType *ReadFiles(const QStringList &filenames);
   ReplyType *SaveFile(const QString &filename, const Song &metadata, const SaveTypes types = SaveType::Tags, const SaveCoverOptions &save_cover_options = SaveCoverOptions());
   ReplyType *LoadEmbeddedArt(const QString &filename);
   ReplyType *SaveEmbeddedArt(const QString &filename, const SaveCoverOptions &save_cover_options);
@@ -83,6 +109,8 @@ class TagReaderClient : public QObject {
   // Convenience functions that call the above functions and wait for a response.
   // These block the calling thread with a semaphore, and must NOT be called from the TagReaderClient's thread.
   void ReadFileBlocking(const QString &filename, Song *song);
+  // songs must have one song for each filename, the songs are initialized from the files in place.  Songs of files that could not be read are not changed.
+  void ReadFilesBlocking(const QStringList &filenames, SongList *songs);
   bool SaveFileBlocking(const QString &filename, const Song &metadata,  const SaveTypes types = SaveType::Tags, const SaveCoverOptions &save_cover_options = SaveCoverOptions());
   bool IsMediaFileBlocking(const QString &filename);
   QByteArray LoadEmbeddedArtBlocking(const QString &filename);
@@ -91,6 +119,9 @@ class TagReaderClient : public QObject {
   bool UpdateSongPlaycountBlocking(const Song &metadata);
   bool UpdateSongRatingBlocking(const Song &metadata);
 
+  // Pending requests and reply latency of each worker, for diagnostics.
+  QList<_WorkerPoolBase::WorkerStatistics> WorkerStatistics() const;
+
   // TODO: Make this not a singleton
   static TagReaderClient *Instance() { return sInstance; }
 
@@ -106,9 +137,15 @@ class TagReaderClient : public QObject {
   void UpdateSongsRating(const SongList &songs);
 
  private:
+  // Handles the request in this process if possible, otherwise sends it to a worker.
+  ReplyType *SendMessageWithReply(spb::tagreader::Message *message);
+  void HandleMessageLocal(ReplyType *reply);
+
   static TagReaderClient *sInstance;
 
   WorkerPool<HandlerType> *worker_pool_;
+  TagReaderLocal *local_reader_;
+  QThreadPool *local_thread_pool_;
   QList<spb::tagreader::Message> message_queue_;
   QThread *original_thread_;
 };
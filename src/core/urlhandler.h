@@ -90,6 +90,13 @@ class UrlHandler : public QObject {
   // Called by the Player when a song starts loading - gives the handler a chance to do something clever to get a playable track.
   virtual LoadResult StartLoading(const QUrl &url) { return LoadResult(url); }
 
+  // Called by the Player for the next song while the current one plays, so the handler can get ready to load it without waiting.
+  virtual void Prefetch(const QUrl &url) { Q_UNUSED(url); }
+
+  // Called by the Player when the stream URL from StartLoading() could not be played.
+  // Returns true if the handler wants the song loaded again, like when the stream URL came from a cache and might be stale.
+  virtual bool LoadFailed(const QUrl &media_url, const QUrl &stream_url) { Q_UNUSED(media_url); Q_UNUSED(stream_url); return false; }
+
  signals:
   void AsyncLoadComplete(const UrlHandler::LoadResult &result);
 
@@ -92,11 +92,14 @@
 #include "coversearchstatistics.h"
 #include "coversearchstatisticsdialog.h"
 #include "albumcoverimageresult.h"
+#include "albumcoverthumbnailstore.h"
 
 #include "ui_albumcovermanager.h"
 
 const char *AlbumCoverManager::kSettingsGroup = "CoverManager";
 constexpr int AlbumCoverManager::kThumbnailSize = 120;
+const char *AlbumCoverManager::kThumbnailStoreName = "albumcovermanager";
+constexpr qint64 AlbumCoverManager::kThumbnailStoreSize = 64 * 1024 * 1024;
 
 AlbumCoverManager::AlbumCoverManager(Application *app, SharedPtr<CollectionBackend> collection_backend, QMainWindow *mainwindow, QWidget *parent)
     : QMainWindow(parent),
@@ -120,6 +123,7 @@ AlbumCoverManager::AlbumCoverManager(Application *app, SharedPtr<CollectionBacke
       progress_bar_(new QProgressBar(this)),
       abort_progress_(new QPushButton(this)),
       jobs_(0),
+      thumbnail_store_(new AlbumCoverThumbnailStore(kThumbnailStoreName, QSize(kThumbnailSize, kThumbnailSize) * devicePixelRatioF())),
       all_artists_(nullptr) {
 
   ui_->setupUi(this);
@@ -421,7 +425,7 @@ void AlbumCoverManager::ArtistChanged(QListWidgetItem *current) {
     album_item->setData(Role_ArtManual, album_info.art_manual);
     album_item->setData(Role_ArtUnset, album_info.art_unset);
 
-    if (album_info.art_embedded || !album_info.art_automatic.isEmpty() || !album_info.art_manual.isEmpty()) {
+    if ((album_info.art_embedded || !album_info.art_automatic.isEmpty() || !album_info.art_manual.isEmpty()) && !LoadAlbumCoverFromThumbnailStore(album_item)) {
       LoadAlbumCoverAsync(album_item);
     }
 
@@ -442,6 +446,9 @@ void AlbumCoverManager::AlbumCoverLoaded(const quint64 id, const AlbumCoverLoade
   }
   else {
     album_item->setIcon(QPixmap::fromImage(result.image_scaled));
+    if (thumbnail_store_->is_open()) {
+      thumbnail_store_->Insert(AlbumItemThumbnailKey(album_item), result.image_scaled);
+    }
   }
 
   UpdateFilter();
@@ -1083,3 +1090,31 @@ void AlbumCoverManager::LoadAlbumCoverAsync(AlbumItem *album_item) {
   cover_loading_tasks_.insert(cover_load_id, album_item);
 
 }
+
+bool AlbumCoverManager::LoadAlbumCoverFromThumbnailStore(AlbumItem *album_item) {
+
+  if (!thumbnail_store_->is_open() && !thumbnail_store_->Open(kThumbnailStoreSize)) return false;
+
+  QImage image = thumbnail_store_->Image(AlbumItemThumbnailKey(album_item));
+  if (image.isNull()) return false;
+
+  // Copies the image out of the mapped file.
+  QPixmap pixmap = QPixmap::fromImage(image);
+  pixmap.setDevicePixelRatio(devicePixelRatioF());
+  album_item->setIcon(pixmap);
+
+  return true;
+
+}
+
+QString AlbumCoverManager::AlbumItemThumbnailKey(AlbumItem *album_item) {
+
+  // Includes the cover locations so a changed cover gets a new thumbnail.
+  return album_item->data(Role_AlbumArtist).toString() + QLatin1Char('\0') +
+         album_item->data(Role_Album).toString() + QLatin1Char('\0') +
+         QString::number(album_item->data(Role_ArtEmbedded).toBool()) +
+         QString::number(album_item->data(Role_ArtUnset).toBool()) + QLatin1Char('\0') +
+         album_item->data(Role_ArtAutomatic).toUrl().toString() + QLatin1Char('\0') +
+         album_item->data(Role_ArtManual).toUrl().toString();
+
+}
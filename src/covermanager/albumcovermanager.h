@@ -36,6 +36,7 @@
 #include <QImage>
 #include <QIcon>
 
+#include "core/scoped_ptr.h"
 #include "core/shared_ptr.h"
 #include "core/song.h"
 #include "core/tagreaderclient.h"
@@ -61,6 +62,7 @@ class AlbumCoverExport;
 class AlbumCoverExporter;
 class AlbumCoverFetcher;
 class AlbumCoverSearcher;
+class AlbumCoverThumbnailStore;
 
 class Ui_CoverManager;
 
@@ -135,6 +137,7 @@ class AlbumCoverManager : public QMainWindow {
 
   Song AlbumItemAsSong(QListWidgetItem *list_widget_item) { return AlbumItemAsSong(static_cast<AlbumItem*>(list_widget_item)); }
   static Song AlbumItemAsSong(AlbumItem *album_item);
+  static QString AlbumItemThumbnailKey(AlbumItem *album_item);
 
   void UpdateStatusText();
   bool ShouldHide(const AlbumItem &album_item, const QString &filter, const HideCovers hide_covers) const;
@@ -148,6 +151,7 @@ class AlbumCoverManager : public QMainWindow {
   bool ItemHasCover(const AlbumItem &album_item) const;
 
   void LoadAlbumCoverAsync(AlbumItem *album_item);
+  bool LoadAlbumCoverFromThumbnailStore(AlbumItem *album_item);
 
  signals:
   void Error(const QString &error);
@@ -187,6 +191,8 @@ class AlbumCoverManager : public QMainWindow {
  private:
   static const char *kSettingsGroup;
   static const int kThumbnailSize;
+  static const char *kThumbnailStoreName;
+  static const qint64 kThumbnailStoreSize;
 
   Ui_CoverManager *ui_;
   QMainWindow *mainwindow_;
@@ -222,6 +228,8 @@ class AlbumCoverManager : public QMainWindow {
 
   QMultiMap<AlbumItem*, QUrl> cover_save_tasks_;
 
+  ScopedPtr<AlbumCoverThumbnailStore> thumbnail_store_;
+
   QListWidgetItem *all_artists_;
 
   AlbumCoverLoaderOptions::Types cover_types_;
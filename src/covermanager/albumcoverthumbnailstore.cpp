@@ -0,0 +1,336 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include <QtGlobal>
+#include <QtEndian>
+#include <QDir>
+#include <QFileInfo>
+#include <QFile>
+#include <QByteArray>
+#include <QString>
+#include <QSize>
+#include <QImage>
+#include <QPainter>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+
+#include "core/logging.h"
+#include "albumcoverthumbnailstore.h"
+
+const char *AlbumCoverThumbnailStore::kThumbnailsDir = "thumbnails";
+
+namespace {
+constexpr char kMagic[4] = { 'S', 'B', 'A', 'T' };
+constexpr quint32 kVersion = 1;
+constexpr qint64 kTilesAlignment = 64;
+// The file grows by this much when it's out of tiles.
+constexpr qint64 kGrowSize = 4 * 1024 * 1024;
+}  // namespace
+
+struct AlbumCoverThumbnailStore::Header {
+  char magic[4];
+  quint32 version;
+  quint32 tile_width;
+  quint32 tile_height;
+  quint32 capacity;
+  // Slot the next new thumbnail goes into.
+  quint32 next;
+  quint64 reserved;
+};
+
+struct AlbumCoverThumbnailStore::Slot {
+  quint64 key_hash;
+  quint32 used;
+  quint32 reserved;
+};
+
+AlbumCoverThumbnailStore::AlbumCoverThumbnailStore(const QString &name, const QSize &tile_size)
+    : filename_(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/" + kThumbnailsDir + "/" + QString("%1-%2x%3.atlas").arg(name).arg(tile_size.width()).arg(tile_size.height())),
+      tile_size_(tile_size),
+      data_(nullptr),
+      capacity_(0),
+      tile_count_(0),
+      tiles_offset_(0) {}
+
+AlbumCoverThumbnailStore::~AlbumCoverThumbnailStore() {
+
+  Close();
+
+}
+
+qint64 AlbumCoverThumbnailStore::TileBytes() const {
+
+  return static_cast<qint64>(tile_size_.width()) * tile_size_.height() * 4;
+
+}
+
+qint64 AlbumCoverThumbnailStore::TilesOffset(const int capacity) const {
+
+  const qint64 slots_end = static_cast<qint64>(sizeof(Header)) + static_cast<qint64>(sizeof(Slot)) * capacity;
+  return (slots_end + kTilesAlignment - 1) / kTilesAlignment * kTilesAlignment;
+
+}
+
+AlbumCoverThumbnailStore::Header *AlbumCoverThumbnailStore::header() const {
+
+  return reinterpret_cast<Header*>(data_);
+
+}
+
+AlbumCoverThumbnailStore::Slot *AlbumCoverThumbnailStore::slot(const int i) const {
+
+  return reinterpret_cast<Slot*>(data_ + sizeof(Header)) + i;
+
+}
+
+uchar *AlbumCoverThumbnailStore::tile(const int i) const {
+
+  return data_ + tiles_offset_ + TileBytes() * i;
+
+}
+
+qint64 AlbumCoverThumbnailStore::used_size() const {
+
+  return (TileBytes() + static_cast<qint64>(sizeof(Slot))) * count();
+
+}
+
+quint64 AlbumCoverThumbnailStore::KeyHash(const QString &key) {
+
+  // qHash() is seeded per process, the hash has to be the same in the next run.
+  const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5);
+  return qFromLittleEndian<quint64>(hash.constData());
+
+}
+
+bool AlbumCoverThumbnailStore::Open(const qint64 max_size) {
+
+  if (tile_size_.isEmpty()) return false;
+
+  const int capacity = static_cast<int>(std::clamp(max_size / (TileBytes() + static_cast<qint64>(sizeof(Slot))), static_cast<qint64>(1), static_cast<qint64>(std::numeric_limits<int>::max())));
+  if (is_open() && capacity == capacity_) return true;
+
+  Close();
+
+  if (!QDir().mkpath(QFileInfo(filename_).path())) {
+    qLog(Error) << "Could not create directory for" << filename_;
+    return false;
+  }
+
+  file_.setFileName(filename_);
+  if (!file_.open(QIODevice::ReadWrite)) {
+    qLog(Error) << "Could not open" << filename_ << file_.errorString();
+    return false;
+  }
+
+  capacity_ = capacity;
+  tiles_offset_ = TilesOffset(capacity);
+
+  const qint64 file_size = file_.size();
+  if (file_size >= tiles_offset_ && (file_size - tiles_offset_) % TileBytes() == 0 && (file_size - tiles_offset_) / TileBytes() <= capacity) {
+    tile_count_ = static_cast<int>((file_size - tiles_offset_) / TileBytes());
+    if (Map()) {
+      const Header *h = header();
+      if (memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 || h->version != kVersion || h->tile_width != static_cast<quint32>(tile_size_.width()) || h->tile_height != static_cast<quint32>(tile_size_.height()) || h->capacity != static_cast<quint32>(capacity) || h->next >= static_cast<quint32>(capacity) || h->next > static_cast<quint32>(tile_count_)) {
+        file_.unmap(data_);
+        data_ = nullptr;
+      }
+    }
+  }
+
+  if (!data_ && !Create(capacity)) {
+    Close();
+    return false;
+  }
+
+  index_.reserve(tile_count_);
+  for (int i = 0; i < tile_count_; ++i) {
+    if (slot(i)->used) {
+      index_.insert(slot(i)->key_hash, i);
+    }
+  }
+
+  return true;
+
+}
+
+bool AlbumCoverThumbnailStore::Create(const int capacity) {
+
+  // Truncate first, so the header and slots are zero filled. There are no tiles until the first thumbnail is added.
+  if (!file_.resize(0) || !file_.resize(TilesOffset(capacity))) {
+    qLog(Error) << "Could not resize" << filename_ << file_.errorString();
+    return false;
+  }
+
+  tile_count_ = 0;
+  if (!Map()) return false;
+
+  Header *h = header();
+  memcpy(h->magic, kMagic, sizeof(kMagic));
+  h->version = kVersion;
+  h->tile_width = static_cast<quint32>(tile_size_.width());
+  h->tile_height = static_cast<quint32>(tile_size_.height());
+  h->capacity = static_cast<quint32>(capacity);
+  h->next = 0;
+
+  return true;
+
+}
+
+bool AlbumCoverThumbnailStore::Map() {
+
+  data_ = file_.map(0, file_.size());
+  if (!data_) {
+    qLog(Error) << "Could not map" << filename_ << file_.errorString();
+    return false;
+  }
+
+  return true;
+
+}
+
+bool AlbumCoverThumbnailStore::Grow() {
+
+  const int grow_tiles = static_cast<int>(qMax(static_cast<qint64>(1), kGrowSize / TileBytes()));
+  const int tile_count = static_cast<int>(qMin(static_cast<qint64>(capacity_), static_cast<qint64>(tile_count_) + grow_tiles));
+
+  // The file can't be resized while it's mapped on all platforms.
+  file_.unmap(data_);
+  data_ = nullptr;
+  if (!file_.resize(tiles_offset_ + TileBytes() * tile_count)) {
+    qLog(Error) << "Could not resize" << filename_ << file_.errorString();
+    Close();
+    return false;
+  }
+  tile_count_ = tile_count;
+
+  if (!Map()) {
+    Close();
+    return false;
+  }
+
+  return true;
+
+}
+
+void AlbumCoverThumbnailStore::Close() {
+
+  index_.clear();
+  if (data_) {
+    file_.unmap(data_);
+    data_ = nullptr;
+  }
+  if (file_.isOpen()) file_.close();
+  capacity_ = 0;
+  tile_count_ = 0;
+  tiles_offset_ = 0;
+
+}
+
+bool AlbumCoverThumbnailStore::Contains(const QString &key) const {
+
+  return is_open() && index_.contains(KeyHash(key));
+
+}
+
+QImage AlbumCoverThumbnailStore::Image(const QString &key) const {
+
+  if (!is_open()) return QImage();
+
+  const QHash<quint64, int>::const_iterator it = index_.constFind(KeyHash(key));
+  if (it == index_.constEnd()) return QImage();
+
+  const uchar *bits = tile(it.value());
+  return QImage(bits, tile_size_.width(), tile_size_.height(), tile_size_.width() * 4, QImage::Format_ARGB32_Premultiplied);
+
+}
+
+void AlbumCoverThumbnailStore::Insert(const QString &key, const QImage &image) {
+
+  if (!is_open() || image.isNull()) return;
+
+  QImage tile_image;
+  if (image.size() == tile_size_) {
+    tile_image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+  }
+  else {
+    tile_image = QImage(tile_size_, QImage::Format_ARGB32_Premultiplied);
+    tile_image.fill(Qt::transparent);
+    const QImage scaled_image = image.scaled(tile_size_, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    QPainter p(&tile_image);
+    p.drawImage((tile_size_.width() - scaled_image.width()) / 2, (tile_size_.height() - scaled_image.height()) / 2, scaled_image);
+    p.end();
+  }
+
+  const quint64 key_hash = KeyHash(key);
+  int i = index_.value(key_hash, -1);
+  if (i == -1) {
+    // The slots are filled in order, so the file only has to grow when the next slot is past the last tile.
+    if (static_cast<int>(header()->next) >= tile_count_ && !Grow()) return;
+    Header *h = header();
+    i = static_cast<int>(h->next);
+    h->next = static_cast<quint32>((i + 1) % capacity_);
+    if (slot(i)->used) {
+      index_.remove(slot(i)->key_hash);
+    }
+  }
+
+  // Mark the slot unused while the tile is written, so a crash doesn't leave a half written thumbnail behind.
+  Slot *s = slot(i);
+  s->used = 0;
+  uchar *bits = tile(i);
+  const qint64 line_bytes = static_cast<qint64>(tile_size_.width()) * 4;
+  for (int y = 0; y < tile_size_.height(); ++y) {
+    memcpy(bits + line_bytes * y, tile_image.constScanLine(y), static_cast<size_t>(line_bytes));
+  }
+  s->key_hash = key_hash;
+  s->used = 1;
+
+  index_.insert(key_hash, i);
+
+}
+
+void AlbumCoverThumbnailStore::Remove(const QString &key) {
+
+  if (!is_open()) return;
+
+  const quint64 key_hash = KeyHash(key);
+  const int i = index_.value(key_hash, -1);
+  if (i == -1) return;
+
+  index_.remove(key_hash);
+  slot(i)->used = 0;
+
+}
+
+void AlbumCoverThumbnailStore::Clear() {
+
+  if (!is_open()) return;
+
+  memset(data_ + sizeof(Header), 0, sizeof(Slot) * static_cast<size_t>(capacity_));
+  header()->next = 0;
+  index_.clear();
+
+}
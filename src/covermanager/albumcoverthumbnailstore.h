@@ -0,0 +1,96 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ALBUMCOVERTHUMBNAILSTORE_H
+#define ALBUMCOVERTHUMBNAILSTORE_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QHash>
+#include <QString>
+#include <QSize>
+#include <QImage>
+#include <QFile>
+
+// Stores album cover thumbnails as fixed size premultiplied ARGB32 tiles in a memory mapped file.
+// Thumbnails are read straight from the mapped file, so there is nothing to decode.
+// The file grows in chunks as thumbnails are added, when it's full, the oldest thumbnail is replaced.
+// Not thread safe, use it from one thread only.
+class AlbumCoverThumbnailStore {
+
+ public:
+  explicit AlbumCoverThumbnailStore(const QString &name, const QSize &tile_size);
+  ~AlbumCoverThumbnailStore();
+
+  static const char *kThumbnailsDir;
+
+  QSize tile_size() const { return tile_size_; }
+  bool is_open() const { return data_ != nullptr; }
+  int capacity() const { return capacity_; }
+  int count() const { return static_cast<int>(index_.count()); }
+  // Bytes taken by the stored thumbnails, the file can be up to one chunk larger.
+  qint64 used_size() const;
+  // Number of thumbnails the file has room for now.
+  int tile_count() const { return tile_count_; }
+
+  // Opens the store, recreating it if it was made with another tile size or capacity.
+  // The capacity is the number of thumbnails that fit in max_size bytes.
+  bool Open(const qint64 max_size);
+  void Close();
+
+  bool Contains(const QString &key) const;
+
+  // The image refers to the mapped file, it's only valid until the next Insert(), which can also grow the file, or until the store is closed.
+  QImage Image(const QString &key) const;
+
+  // Images not the size of a tile are scaled and centered.
+  void Insert(const QString &key, const QImage &image);
+  void Remove(const QString &key);
+  void Clear();
+
+ private:
+  struct Header;
+  struct Slot;
+
+  static quint64 KeyHash(const QString &key);
+  qint64 TileBytes() const;
+  qint64 TilesOffset(const int capacity) const;
+  Header *header() const;
+  Slot *slot(const int i) const;
+  uchar *tile(const int i) const;
+  bool Create(const int capacity);
+  bool Map();
+  bool Grow();
+
+  QString filename_;
+  QSize tile_size_;
+  QFile file_;
+  uchar *data_;
+  int capacity_;
+  int tile_count_;
+  qint64 tiles_offset_;
+
+  // Key hash -> slot
+  QHash<quint64, int> index_;
+
+  Q_DISABLE_COPY(AlbumCoverThumbnailStore)
+};
+
+#endif  // ALBUMCOVERTHUMBNAILSTORE_H
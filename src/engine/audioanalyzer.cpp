@@ -0,0 +1,421 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+
+#include <glib.h>
+#include <glib-object.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+
+#include <QtGlobal>
+#include <QCoreApplication>
+#include <QThread>
+#include <QByteArray>
+#include <QString>
+#include <QElapsedTimer>
+
+#include "core/logging.h"
+#include "core/signalchecker.h"
+#include "audioanalyzer.h"
+
+#ifdef HAVE_EBUR128
+#  include "ebur128analysis.h"
+#endif
+
+#ifdef HAVE_MOODBAR
+#  include "moodbar/moodbarbuilder.h"
+#  include "ext/gstmoodbar/gstfastspectrum.h"
+#endif
+
+#ifndef u_int32_t
+using u_int32_t = unsigned int;
+#endif
+
+namespace {
+
+#ifdef HAVE_SONGFINGERPRINTING
+// Chromaprint expects mono 16-bit ints at a sample rate of 11025Hz, and only needs the first 30 seconds.
+constexpr int kFingerprintRate = 11025;
+constexpr int kFingerprintChannels = 1;
+constexpr int kFingerprintLengthSecs = 30;
+#endif
+
+#ifdef HAVE_MOODBAR
+// The same as MoodbarPipeline, so the data is identical to a moodbar generated on demand.
+constexpr int kMoodbarBands = 128;
+constexpr int kMoodbarWidth = 1000;
+#endif
+
+constexpr int kFingerprintTimeoutSecs = 10;
+constexpr int kTimeoutSecs = 60;
+
+}  // namespace
+
+AudioAnalyzer::AudioAnalyzer(const QString &filename, const Analyses analyses)
+    : filename_(filename),
+      analyses_(analyses & AvailableAnalyses()),
+#ifdef HAVE_SONGFINGERPRINTING
+      chromaprint_(nullptr),
+      fingerprint_samples_(0),
+#endif
+#ifdef HAVE_EBUR128
+      loudness_error_(false),
+#endif
+      tee_(nullptr) {}
+
+AudioAnalyzer::~AudioAnalyzer() {
+
+#ifdef HAVE_SONGFINGERPRINTING
+  if (chromaprint_) {
+    chromaprint_free(chromaprint_);
+  }
+#endif
+
+}
+
+AudioAnalyzer::Analyses AudioAnalyzer::AvailableAnalyses() {
+
+  Analyses analyses = Analysis::None;
+#ifdef HAVE_SONGFINGERPRINTING
+  analyses |= Analysis::Fingerprint;
+#endif
+#ifdef HAVE_EBUR128
+  analyses |= Analysis::Loudness;
+#endif
+#ifdef HAVE_MOODBAR
+  analyses |= Analysis::Moodbar;
+#endif
+
+  return analyses;
+
+}
+
+GstElement *AudioAnalyzer::CreateElement(const QString &factory_name, GstElement *bin) {
+
+  GstElement *ret = gst_element_factory_make(factory_name.toLatin1().constData(), nullptr);
+
+  if (ret && bin) gst_bin_add(GST_BIN(bin), ret);
+
+  if (!ret) {
+    qLog(Warning) << "Couldn't create the gstreamer element" << factory_name;
+  }
+
+  return ret;
+
+}
+
+GstElement *AudioAnalyzer::CreateBranch(GstElement *pipeline, GstElement *tee) {
+
+  GstElement *queue = CreateElement("queue", pipeline);
+  GstElement *convert = CreateElement("audioconvert", pipeline);
+  if (!queue || !convert) return nullptr;
+
+  // Each branch runs in its own streaming thread, don't let a slow branch hold up the others too soon.
+  g_object_set(G_OBJECT(queue), "max-size-time", 10 * GST_SECOND, nullptr);
+  g_object_set(G_OBJECT(queue), "max-size-buffers", 0, nullptr);
+  g_object_set(G_OBJECT(queue), "max-size-bytes", 0, nullptr);
+
+  if (!gst_element_link_many(tee, queue, convert, nullptr)) {
+    qLog(Error) << "Failed to link analysis branch";
+    return nullptr;
+  }
+
+  return convert;
+
+}
+
+AudioAnalyzer::Result AudioAnalyzer::Analyze() {
+
+  Q_ASSERT(QThread::currentThread() != qApp->thread());
+
+  Result result;
+  if (!analyses_) return result;
+
+  GstElement *pipeline = gst_pipeline_new("analysis-pipeline");
+  if (!pipeline) return result;
+
+  GstElement *src = CreateElement("filesrc", pipeline);
+  GstElement *decode = CreateElement("decodebin", pipeline);
+  tee_ = CreateElement("tee", pipeline);
+
+  if (!src || !decode || !tee_) {
+    gst_object_unref(pipeline);
+    return result;
+  }
+
+  gst_element_link_many(src, decode, nullptr);
+
+  bool success = true;
+
+#ifdef HAVE_SONGFINGERPRINTING
+  GstAppSinkCallbacks fingerprint_callbacks;
+  memset(&fingerprint_callbacks, 0, sizeof(fingerprint_callbacks));
+  if (success && analyses_.testFlag(Analysis::Fingerprint)) {
+    GstElement *convert = CreateBranch(pipeline, tee_);
+    GstElement *resample = CreateElement("audioresample", pipeline);
+    GstElement *sink = CreateElement("appsink", pipeline);
+    if (convert && resample && sink) {
+      gst_element_link_many(convert, resample, nullptr);
+      GstCaps *caps = gst_caps_new_simple("audio/x-raw", "format", G_TYPE_STRING, "S16LE", "channels", G_TYPE_INT, kFingerprintChannels, "rate", G_TYPE_INT, kFingerprintRate, nullptr);
+      gst_element_link_filtered(resample, sink, caps);
+      gst_caps_unref(caps);
+      fingerprint_callbacks.new_sample = NewFingerprintBufferCallback;
+      gst_app_sink_set_callbacks(reinterpret_cast<GstAppSink*>(sink), &fingerprint_callbacks, this, nullptr);
+      g_object_set(G_OBJECT(sink), "sync", FALSE, nullptr);
+      chromaprint_ = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+      chromaprint_start(chromaprint_, kFingerprintRate, kFingerprintChannels);
+    }
+    else {
+      success = false;
+    }
+  }
+#endif
+
+#ifdef HAVE_EBUR128
+  GstAppSinkCallbacks loudness_callbacks;
+  memset(&loudness_callbacks, 0, sizeof(loudness_callbacks));
+  if (success && analyses_.testFlag(Analysis::Loudness)) {
+    GstElement *convert = CreateBranch(pipeline, tee_);
+    GstElement *sink = CreateElement("appsink", pipeline);
+    if (convert && sink) {
+      GstCaps *caps = EBUR128Accumulator::Caps();
+      gst_element_link_filtered(convert, sink, caps);
+      gst_caps_unref(caps);
+      loudness_callbacks.new_sample = NewLoudnessBufferCallback;
+      gst_app_sink_set_callbacks(reinterpret_cast<GstAppSink*>(sink), &loudness_callbacks, this, nullptr);
+      g_object_set(G_OBJECT(sink), "buffer-list", FALSE, nullptr);
+      g_object_set(G_OBJECT(sink), "sync", FALSE, nullptr);
+      g_object_set(G_OBJECT(sink), "max-buffers", 1, nullptr);
+      loudness_.reset(new EBUR128Accumulator);
+    }
+    else {
+      success = false;
+    }
+  }
+#endif
+
+#ifdef HAVE_MOODBAR
+  if (success && analyses_.testFlag(Analysis::Moodbar)) {
+    GstElement *convert = CreateBranch(pipeline, tee_);
+    GstElement *spectrum = CreateElement("fastspectrum", pipeline);
+    GstElement *sink = CreateElement("fakesink", pipeline);
+    if (convert && spectrum && sink && gst_element_link_many(convert, spectrum, sink, nullptr)) {
+      moodbar_builder_.reset(new MoodbarBuilder);
+      g_object_set(spectrum, "bands", kMoodbarBands, nullptr);
+      GstFastSpectrum *fast_spectrum = reinterpret_cast<GstFastSpectrum*>(spectrum);
+      fast_spectrum->output_callback = [this](double *magnitudes, int size) { moodbar_builder_->AddFrame(magnitudes, size); };
+    }
+    else {
+      success = false;
+    }
+  }
+#endif
+
+  if (!success) {
+    gst_object_unref(pipeline);
+    return result;
+  }
+
+  // Set the filename
+  g_object_set(src, "location", filename_.toUtf8().constData(), nullptr);
+
+  // Connect signals
+  GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline));
+  CHECKED_GCONNECT(decode, "pad-added", &NewPadCallback, this);
+
+  // The fingerprint alone only needs the start of the file, the other analyses need all of it.
+  const bool fingerprint_only = analyses_ == Analyses(Analysis::Fingerprint);
+  const int timeout_secs = fingerprint_only ? kFingerprintTimeoutSecs : kTimeoutSecs;
+#ifdef HAVE_SONGFINGERPRINTING
+  if (fingerprint_only) {
+    gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    // wait for state change before seeking
+    gst_element_get_state(pipeline, nullptr, nullptr, timeout_secs * GST_SECOND);
+    gst_element_seek(pipeline, 1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH, GST_SEEK_TYPE_SET, 0 * GST_SECOND, GST_SEEK_TYPE_SET, kFingerprintLengthSecs * GST_SECOND);
+  }
+#endif
+
+  QElapsedTimer time;
+  time.start();
+
+  // Start playing
+  gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+  // Wait until EOS or error
+  bool had_error = false;
+  GstMessage *msg = gst_bus_timed_pop_filtered(bus, timeout_secs * GST_SECOND, static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+  if (msg) {
+    if (msg->type == GST_MESSAGE_ERROR) {
+      had_error = true;
+      // Report error
+      GError *error = nullptr;
+      gchar *debugs = nullptr;
+      gst_message_parse_error(msg, &error, &debugs);
+      if (error) {
+        QString message = QString::fromLocal8Bit(error->message);
+        g_error_free(error);
+        qLog(Debug) << "Error processing" << filename_ << ":" << message;
+      }
+      if (debugs) free(debugs);
+    }
+    gst_message_unref(msg);
+  }
+  else {
+    had_error = true;
+    qLog(Debug) << "Timeout processing" << filename_;
+  }
+
+  // Stop the streaming threads before reading the results.
+  gst_element_set_state(pipeline, GST_STATE_NULL);
+
+  const qint64 decode_time = time.restart();
+
+  result.analyses = analyses_;
+
+#ifdef HAVE_SONGFINGERPRINTING
+  if (chromaprint_) {
+    chromaprint_finish(chromaprint_);
+    u_int32_t *fprint = nullptr;
+    int size = 0;
+    int ret = chromaprint_get_raw_fingerprint(chromaprint_, &fprint, &size);
+    if (ret == 1) {
+      char *encoded = nullptr;
+      int encoded_size = 0;
+      ret = chromaprint_encode_fingerprint(fprint, size, CHROMAPRINT_ALGORITHM_DEFAULT, &encoded, &encoded_size, 1);
+      if (ret == 1) {
+        result.fingerprint = QString::fromLatin1(encoded, encoded_size);
+        chromaprint_dealloc(encoded);
+      }
+      chromaprint_dealloc(fprint);
+    }
+  }
+#endif
+
+#ifdef HAVE_EBUR128
+  if (loudness_ && !had_error && !loudness_error_) {
+    result.loudness = loudness_->Finish();
+  }
+#endif
+
+#ifdef HAVE_MOODBAR
+  if (moodbar_builder_ && !had_error) {
+    result.moodbar = moodbar_builder_->Finish(kMoodbarWidth);
+  }
+#endif
+
+  const qint64 analysis_time = time.elapsed();
+
+  qLog(Debug) << "Analyzed" << filename_ << "Decode time:" << decode_time << "Analysis time:" << analysis_time;
+
+  // Cleanup
+  gst_object_unref(bus);
+  gst_object_unref(pipeline);
+  tee_ = nullptr;
+
+  return result;
+
+}
+
+void AudioAnalyzer::NewPadCallback(GstElement*, GstPad *pad, gpointer data) {
+
+  AudioAnalyzer *me = reinterpret_cast<AudioAnalyzer*>(data);
+
+  // The tee takes one stream, don't let a cover art stream replace the audio.
+  int rate = 0;
+  GstCaps *caps = gst_pad_get_current_caps(pad);
+  if (caps) {
+    GstStructure *structure = gst_caps_get_structure(caps, 0);
+    const bool is_audio = structure && g_str_has_prefix(gst_structure_get_name(structure), "audio/");
+    if (is_audio) {
+      gst_structure_get_int(structure, "rate", &rate);
+    }
+    gst_caps_unref(caps);
+    if (!is_audio) return;
+  }
+
+  GstPad *const teepad = gst_element_get_static_pad(me->tee_, "sink");
+
+  if (GST_PAD_IS_LINKED(teepad)) {
+    qLog(Warning) << "teepad is already linked, unlinking old pad";
+    gst_pad_unlink(teepad, GST_PAD_PEER(teepad));
+  }
+
+  gst_pad_link(pad, teepad);
+  gst_object_unref(teepad);
+
+#ifdef HAVE_MOODBAR
+  if (me->moodbar_builder_) {
+    me->moodbar_builder_->Init(kMoodbarBands, rate);
+  }
+#else
+  Q_UNUSED(rate);
+#endif
+
+}
+
+#ifdef HAVE_SONGFINGERPRINTING
+GstFlowReturn AudioAnalyzer::NewFingerprintBufferCallback(GstAppSink *app_sink, gpointer self) {
+
+  AudioAnalyzer *me = reinterpret_cast<AudioAnalyzer*>(self);
+
+  GstSample *sample = gst_app_sink_pull_sample(app_sink);
+  if (!sample) return GST_FLOW_ERROR;
+
+  // Keep pulling samples after the first 30 seconds, returning EOS here would stop the other branches.
+  constexpr qint64 max_samples = static_cast<qint64>(kFingerprintRate) * kFingerprintChannels * kFingerprintLengthSecs;
+  GstBuffer *buffer = gst_sample_get_buffer(sample);
+  if (buffer && me->fingerprint_samples_ < max_samples) {
+    GstMapInfo map;
+    if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+      const qint64 samples = qMin(static_cast<qint64>(map.size / sizeof(int16_t)), max_samples - me->fingerprint_samples_);
+      chromaprint_feed(me->chromaprint_, reinterpret_cast<int16_t*>(map.data), static_cast<int>(samples));
+      me->fingerprint_samples_ += samples;
+      gst_buffer_unmap(buffer, &map);
+    }
+  }
+  gst_sample_unref(sample);
+
+  return GST_FLOW_OK;
+
+}
+#endif
+
+#ifdef HAVE_EBUR128
+GstFlowReturn AudioAnalyzer::NewLoudnessBufferCallback(GstAppSink *app_sink, gpointer self) {
+
+  AudioAnalyzer *me = reinterpret_cast<AudioAnalyzer*>(self);
+
+  GstSample *sample = gst_app_sink_pull_sample(app_sink);
+  if (!sample) return GST_FLOW_ERROR;
+
+  if (!me->loudness_->AddSample(sample)) {
+    me->loudness_error_ = true;
+  }
+  gst_sample_unref(sample);
+
+  // Don't fail the whole pipeline, the other analyses can still finish.
+  return GST_FLOW_OK;
+
+}
+#endif
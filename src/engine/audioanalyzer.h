@@ -0,0 +1,98 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AUDIOANALYZER_H
+#define AUDIOANALYZER_H
+
+#include "config.h"
+
+#include <glib.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#ifdef HAVE_SONGFINGERPRINTING
+#  include <chromaprint.h>
+#endif
+
+#include <QtGlobal>
+#include <QString>
+
+#include "core/scoped_ptr.h"
+#include "audioanalyzerresult.h"
+
+#ifdef HAVE_EBUR128
+class EBUR128Accumulator;
+#endif
+#ifdef HAVE_MOODBAR
+class MoodbarBuilder;
+#endif
+
+class AudioAnalyzer {
+  // Decodes a file once and passes the PCM data to each of the requested analyses through a tee,
+  // instead of decoding the file again for the fingerprint, the loudness and the moodbar.
+  // You should create one AudioAnalyzer for each file you want to analyze.
+
+ public:
+  using Analysis = AudioAnalyzerResult::Analysis;
+  using Analyses = AudioAnalyzerResult::Analyses;
+  using Result = AudioAnalyzerResult;
+
+  explicit AudioAnalyzer(const QString &filename, const Analyses analyses);
+  ~AudioAnalyzer();
+
+  // Returns the analyses that can be run in this build.
+  static Analyses AvailableAnalyses();
+
+  // This method is blocking, so you want to call it in another thread.
+  Result Analyze();
+
+ private:
+  static GstElement *CreateElement(const QString &factory_name, GstElement *bin);
+  // Adds queue ! audioconvert to the tee and returns the audioconvert.
+  static GstElement *CreateBranch(GstElement *pipeline, GstElement *tee);
+
+  static void NewPadCallback(GstElement*, GstPad *pad, gpointer data);
+#ifdef HAVE_SONGFINGERPRINTING
+  static GstFlowReturn NewFingerprintBufferCallback(GstAppSink *app_sink, gpointer self);
+#endif
+#ifdef HAVE_EBUR128
+  static GstFlowReturn NewLoudnessBufferCallback(GstAppSink *app_sink, gpointer self);
+#endif
+
+ private:
+  QString filename_;
+  Analyses analyses_;
+
+#ifdef HAVE_SONGFINGERPRINTING
+  ChromaprintContext *chromaprint_;
+  qint64 fingerprint_samples_;
+#endif
+#ifdef HAVE_EBUR128
+  ScopedPtr<EBUR128Accumulator> loudness_;
+  bool loudness_error_;
+#endif
+#ifdef HAVE_MOODBAR
+  ScopedPtr<MoodbarBuilder> moodbar_builder_;
+#endif
+
+  GstElement *tee_;
+
+  Q_DISABLE_COPY(AudioAnalyzer)
+};
+
+#endif  // AUDIOANALYZER_H
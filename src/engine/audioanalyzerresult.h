@@ -0,0 +1,57 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AUDIOANALYZERRESULT_H
+#define AUDIOANALYZERRESULT_H
+
+#include "config.h"
+
+#include <optional>
+
+#include <QtGlobal>
+#include <QFlags>
+#include <QByteArray>
+#include <QString>
+
+#include "ebur128measures.h"
+
+class AudioAnalyzerResult {
+ public:
+  enum class Analysis {
+    None = 0x0,
+    Fingerprint = 0x1,
+    Loudness = 0x2,
+    Moodbar = 0x4
+  };
+  Q_DECLARE_FLAGS(Analyses, Analysis)
+
+  AudioAnalyzerResult() : analyses(Analysis::None) {}
+
+  // The analyses that were run, the others were not requested or are not available in this build.
+  Analyses analyses;
+
+  // Empty if no fingerprint could be created.
+  QString fingerprint;
+  std::optional<EBUR128Measures> loudness;
+  QByteArray moodbar;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(AudioAnalyzerResult::Analyses)
+
+#endif  // AUDIOANALYZERRESULT_H
@@ -19,6 +19,7 @@
 
 #include "config.h"
 
+#include <atomic>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
@@ -48,6 +49,7 @@
 using std::unique_ptr;
 
 static const int kTimeoutSecs = 60;
+static const int kAbortPollMsecs = 200;
 
 namespace {
 
@@ -190,21 +192,6 @@ class EBUR128State {
   unique_ptr<ebur128_state, ebur128_state_deleter> st;
 };
 
-class EBUR128AnalysisImpl {
-  EBUR128AnalysisImpl() = default;
-
- public:
-  static std::optional<EBUR128Measures> Compute(const Song &song);
-
- private:
-  GstElement *convert_element_ = nullptr;
-
-  std::optional<EBUR128State> state;
-
-  static void NewPadCallback(GstElement *elt, GstPad *pad, gpointer data);
-  static GstFlowReturn NewBufferCallback(GstAppSink *app_sink, gpointer self);
-};
-
 FrameFormat::FrameFormat(GstCaps *caps) : channels(0), channel_mask(0), samplerate(0) {
 
   GstStructure *structure = gst_caps_get_structure(caps, 0);
@@ -326,6 +313,78 @@ std::optional<EBUR128Measures> EBUR128State::Finalize(EBUR128State&& state)  {
 
 }
 
+}  // namespace
+
+struct EBUR128Accumulator::Private {
+  std::optional<EBUR128State> state;
+};
+
+EBUR128Accumulator::EBUR128Accumulator() : d_(new Private) {}
+
+EBUR128Accumulator::~EBUR128Accumulator() = default;
+
+GstCaps *EBUR128Accumulator::Caps() {
+
+  GstStaticCaps static_caps = GST_STATIC_CAPS(
+    "audio/x-raw,"
+    "format = (string) { S16LE, S32LE, F32LE, F64LE },"
+    "layout = (string) interleaved");
+
+  return gst_static_caps_get(&static_caps);
+
+}
+
+bool EBUR128Accumulator::AddSample(GstSample *sample) {
+
+  const FrameFormat dsc(gst_sample_get_caps(sample));
+  if (!d_->state) {
+    d_->state.emplace(dsc);
+  }
+  else if (d_->state->dsc != dsc) {
+    return false;
+  }
+
+  GstBuffer *buffer = gst_sample_get_buffer(sample);
+  if (buffer) {
+    GstMapInfo map;
+    if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+      d_->state->AddFrames(reinterpret_cast<const char*>(map.data), static_cast<qint64>(map.size));
+      gst_buffer_unmap(buffer, &map);
+    }
+  }
+
+  return true;
+
+}
+
+std::optional<EBUR128Measures> EBUR128Accumulator::Finish() {
+
+  if (!d_->state) return std::nullopt;
+
+  std::optional<EBUR128Measures> result = EBUR128State::Finalize(std::move(d_->state.value()));
+  d_->state.reset();
+
+  return result;
+
+}
+
+namespace {
+
+class EBUR128AnalysisImpl {
+  EBUR128AnalysisImpl() = default;
+
+ public:
+  static std::optional<EBUR128Measures> Compute(const Song &song, const std::atomic<bool> *abort);
+
+ private:
+  GstElement *convert_element_ = nullptr;
+
+  EBUR128Accumulator accumulator_;
+
+  static void NewPadCallback(GstElement *elt, GstPad *pad, gpointer data);
+  static GstFlowReturn NewBufferCallback(GstAppSink *app_sink, gpointer self);
+};
+
 void EBUR128AnalysisImpl::NewPadCallback(GstElement *elt, GstPad *pad, gpointer data) {
 
   Q_UNUSED(elt);
@@ -350,23 +409,10 @@ GstFlowReturn EBUR128AnalysisImpl::NewBufferCallback(GstAppSink *app_sink, gpoin
   unique_ptr<GstSample, GstSampleDeleter> sample(gst_app_sink_pull_sample(app_sink));
   if (!sample) return GST_FLOW_ERROR;
 
-  const FrameFormat dsc(gst_sample_get_caps(&*sample));
-  if (!me->state) {
-    me->state.emplace(dsc);
-  }
-  else if (me->state->dsc != dsc) {
+  if (!me->accumulator_.AddSample(&*sample)) {
     return GST_FLOW_ERROR;
   }
 
-  GstBuffer *buffer = gst_sample_get_buffer(&*sample);
-  if (buffer) {
-    GstMapInfo map;
-    if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
-      me->state->AddFrames(reinterpret_cast<const char*>(map.data), static_cast<qint64>(map.size));
-      gst_buffer_unmap(buffer, &map);
-    }
-  }
-
   return GST_FLOW_OK;
 
 }
@@ -385,7 +431,7 @@ GstElement *CreateElement(const QString &factory_name, GstElement *bin) {
 
 }
 
-std::optional<EBUR128Measures> EBUR128AnalysisImpl::Compute(const Song &song) {
+std::optional<EBUR128Measures> EBUR128AnalysisImpl::Compute(const Song &song, const std::atomic<bool> *abort) {
 
   EBUR128AnalysisImpl impl;
 
@@ -410,12 +456,7 @@ std::optional<EBUR128Measures> EBUR128AnalysisImpl::Compute(const Song &song) {
   // Connect the elements
   gst_element_link_many(src, decode, nullptr);
 
-  GstStaticCaps static_caps = GST_STATIC_CAPS(
-    "audio/x-raw,"
-    "format = (string) { S16LE, S32LE, F32LE, F64LE },"
-    "layout = (string) interleaved");
-
-  GstCaps *caps = gst_static_caps_get(&static_caps);
+  GstCaps *caps = EBUR128Accumulator::Caps();
   // Place a queue before the sink. It really does matter for performance.
   gst_element_link_filtered(convert, queue, caps);
   gst_element_link_many(queue, sink, nullptr);
@@ -459,9 +500,17 @@ std::optional<EBUR128Measures> EBUR128AnalysisImpl::Compute(const Song &song) {
   // Start playing
   gst_element_set_state(pipeline, GST_STATE_PLAYING);
 
-  // Wait until EOS or error
+  // Wait until EOS or error, in short steps so the analysis can be aborted.
   bool hadError = false;
-  GstMessage *msg = gst_bus_timed_pop_filtered(bus, kTimeoutSecs * GST_SECOND, static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+  GstMessage *msg = nullptr;
+  for (int waited = 0; !msg && waited < kTimeoutSecs * 1000; waited += kAbortPollMsecs) {
+    if (abort && *abort) {
+      qLog(Debug) << "Aborted analyzing" << song.url();
+      hadError = true;
+      break;
+    }
+    msg = gst_bus_timed_pop_filtered(bus, kAbortPollMsecs * GST_MSECOND, static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+  }
   if (msg) {
     if (msg->type == GST_MESSAGE_ERROR) {
       hadError = true;
@@ -482,9 +531,9 @@ std::optional<EBUR128Measures> EBUR128AnalysisImpl::Compute(const Song &song) {
   const qint64 decode_time = time.restart();
 
   std::optional<EBUR128Measures> result;
-  if (!hadError && impl.state) {
+  if (!hadError) {
     // Generate loudness characteristics from sampled data.
-    result = EBUR128State::Finalize(std::move(impl.state.value()));
+    result = impl.accumulator_.Finish();
 
     const qint64 finalize_time = time.elapsed();
 
@@ -503,10 +552,10 @@ std::optional<EBUR128Measures> EBUR128AnalysisImpl::Compute(const Song &song) {
 
 }  // namespace
 
-std::optional<EBUR128Measures> EBUR128Analysis::Compute(const Song &song) {
+std::optional<EBUR128Measures> EBUR128Analysis::Compute(const Song &song, const std::atomic<bool> *abort) {
 
   Q_ASSERT(QThread::currentThread() != qApp->thread());
 
-  return EBUR128AnalysisImpl::Compute(song);
+  return EBUR128AnalysisImpl::Compute(song, abort);
 
 }
@@ -22,8 +22,12 @@
 
 #include "config.h"
 
+#include <atomic>
 #include <optional>
 
+#include <gst/gst.h>
+
+#include "core/scoped_ptr.h"
 #include "core/song.h"
 #include "ebur128measures.h"
 
@@ -35,7 +39,32 @@ class EBUR128Analysis {
   // Returns `std::nullopt` if the analysis fails.
   //
   // This method is blocking, so you want to call it in another thread.
-  static std::optional<EBUR128Measures> Compute(const Song &song);
+  // Returns `std::nullopt` early when abort is set while the song is decoded.
+  static std::optional<EBUR128Measures> Compute(const Song &song, const std::atomic<bool> *abort = nullptr);
+};
+
+// Performs an EBU R 128 analysis on samples from a pipeline set up by the caller,
+// so the same decoded audio can be used for other analyses too.
+class EBUR128Accumulator {
+ public:
+  EBUR128Accumulator();
+  ~EBUR128Accumulator();
+
+  // The caps the samples passed to AddSample() must have.
+  // The caller owns the returned caps.
+  static GstCaps *Caps();
+
+  // Returns false if the sample format changed since the first sample.
+  bool AddSample(GstSample *sample);
+
+  // Returns `std::nullopt` if no samples were added.
+  std::optional<EBUR128Measures> Finish();
+
+ private:
+  struct Private;
+  ScopedPtr<Private> d_;
+
+  Q_DISABLE_COPY(EBUR128Accumulator)
 };
 
 #endif  // EBUR128ANALYSIS_H
@@ -94,7 +94,8 @@ class EngineBase : public QObject {
   };
   using OutputDetailsList = QList<OutputDetails>;
 
-  using Scope = std::vector<int16_t>;
+  // Mono samples in the range -1.0..1.0, newest last.
+  using Scope = std::vector<float>;
 
   static Type TypeFromName(const QString &name);
   static QString Name(const Type type);
@@ -115,7 +116,7 @@ class EngineBase : public QObject {
   virtual qint64 position_nanosec() const = 0;
   virtual qint64 length_nanosec() const = 0;
 
-  virtual const Scope &scope(const int chunk_length) { Q_UNUSED(chunk_length); return scope_; }
+  virtual const Scope &scope() { return scope_; }
 
   // Sets new values for the beginning and end markers of the currently playing song.
   // This doesn't change the state of engine or the stream's current position.
@@ -151,7 +152,7 @@ class EngineBase : public QObject {
   bool crossfade_same_album() const { return crossfade_same_album_; }
   bool IsEqualizerEnabled() { return equalizer_enabled_; }
 
-  static const int kScopeSize = 1024;
+  static const int kScopeSize = 512;
 
   QVariant device() { return device_; }
 
@@ -23,7 +23,9 @@
 #include "config.h"
 
 #include <cmath>
+#include <cstdint>
 #include <algorithm>
+#include <atomic>
 #include <optional>
 #include <memory>
 
@@ -45,7 +47,6 @@
 #include <QUrl>
 #include <QTimeLine>
 #include <QEasingCurve>
-#include <QMetaObject>
 #include <QTimerEvent>
 
 #include "core/shared_ptr.h"
@@ -77,6 +78,7 @@ const int GstEngine::kDiscoveryTimeoutS = 10;
 const qint64 GstEngine::kTimerIntervalNanosec = 1000 * kNsecPerMsec;  // 1s
 const qint64 GstEngine::kPreloadGapNanosec = 8000 * kNsecPerMsec;     // 8s
 const qint64 GstEngine::kSeekDelayNanosec = 100 * kNsecPerMsec;       // 100msec
+const int GstEngine::kScopeChannels = 2;  // Scope buffers are assumed to be interleaved stereo
 
 GstEngine::GstEngine(SharedPtr<TaskManager> task_manager, QObject *parent)
     : EngineBase(parent),
@@ -84,7 +86,6 @@ GstEngine::GstEngine(SharedPtr<TaskManager> task_manager, QObject *parent)
       gst_startup_(nullptr),
       discoverer_(nullptr),
       buffering_task_id_(-1),
-      latest_buffer_(nullptr),
       stereo_balancer_enabled_(false),
       stereo_balance_(0.0F),
       equalizer_enabled_(false),
@@ -95,9 +96,7 @@ GstEngine::GstEngine(SharedPtr<TaskManager> task_manager, QObject *parent)
       timer_id_(-1),
       is_fading_out_to_pause_(false),
       has_faded_out_(false),
-      scope_chunk_(0),
-      have_new_buffer_(false),
-      scope_chunks_(0),
+      scope_pipeline_id_(-1),
       discovery_finished_cb_id_(-1),
       discovery_discovered_cb_id_(-1) {
 
@@ -114,11 +113,6 @@ GstEngine::~GstEngine() {
   EnsureInitialized();
   current_pipeline_.reset();
 
-  if (latest_buffer_) {
-    gst_buffer_unref(latest_buffer_);
-    latest_buffer_ = nullptr;
-  }
-
   if (discoverer_) {
 
     if (discovery_discovered_cb_id_ != -1) {
@@ -207,6 +201,7 @@ bool GstEngine::Load(const QUrl &media_url, const QUrl &stream_url, const Engine
 
   BufferingFinished();
   current_pipeline_ = pipeline;
+  scope_pipeline_id_.store(current_pipeline_->id(), std::memory_order_relaxed);
 
   SetVolume(volume_);
   SetStereoBalance(stereo_balance_);
@@ -378,26 +373,10 @@ qint64 GstEngine::length_nanosec() const {
 
 }
 
-const EngineBase::Scope &GstEngine::scope(const int chunk_length) {
-
-  // The new buffer could have a different size
-  if (have_new_buffer_) {
-    if (latest_buffer_) {
-      scope_chunks_ = ceil((static_cast<double>(GST_BUFFER_DURATION(latest_buffer_) / static_cast<double>(chunk_length * kNsecPerMsec))));
-    }
-
-    // if the buffer is shorter than the chunk length
-    if (scope_chunks_ <= 0) {
-      scope_chunks_ = 1;
-    }
-
-    scope_chunk_ = 0;
-    have_new_buffer_ = false;
-  }
+const EngineBase::Scope &GstEngine::scope() {
 
-  if (latest_buffer_) {
-    UpdateScope(chunk_length);
-  }
+  // Keep the previous scope if there is no new data.
+  scope_buffer_.ReadLatest(scope_.data(), static_cast<int>(scope_.size()));
 
   return scope_;
 
@@ -464,12 +443,25 @@ void GstEngine::ReloadSettings() {
 
 void GstEngine::ConsumeBuffer(GstBuffer *buffer, const int pipeline_id, const QString &format) {
 
-  // Schedule this to run in the GUI thread.  The buffer gets added to the queue and unreffed by UpdateScope.
-  if (!QMetaObject::invokeMethod(this, "AddBufferToScope", Q_ARG(GstBuffer*, buffer), Q_ARG(int, pipeline_id), Q_ARG(QString, format))) {
-    qLog(Warning) << "Failed to invoke AddBufferToScope on GstEngine";
-    gst_buffer_unref(buffer);
+  // This runs in the streaming thread, the samples are written to the ring buffer and read by scope() in the GUI thread.
+  // The pipeline has converted the supported formats to S16LE.
+  if (pipeline_id == scope_pipeline_id_.load(std::memory_order_relaxed) &&
+      (format.startsWith("S16LE") ||
+       format.startsWith("U16LE") ||
+       format.startsWith("S24LE") ||
+       format.startsWith("S24_32LE") ||
+       format.startsWith("S32LE") ||
+       format.startsWith("F32LE"))
+  ) {
+    GstMapInfo map;
+    if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+      scope_buffer_.Write(reinterpret_cast<const int16_t*>(map.data), static_cast<qint64>(map.size / (sizeof(int16_t) * kScopeChannels)), kScopeChannels);
+      gst_buffer_unmap(buffer, &map);
+    }
   }
 
+  gst_buffer_unref(buffer);
+
 }
 
 void GstEngine::SetStereoBalancerEnabled(const bool enabled) {
@@ -589,23 +581,6 @@ void GstEngine::NewMetaData(const int pipeline_id, const EngineMetadata &engine_
 
 }
 
-void GstEngine::AddBufferToScope(GstBuffer *buf, const int pipeline_id, const QString &format) {
-
-  if (!current_pipeline_ || current_pipeline_->id() != pipeline_id) {
-    gst_buffer_unref(buf);
-    return;
-  }
-
-  if (latest_buffer_) {
-    gst_buffer_unref(latest_buffer_);
-  }
-
-  buffer_format_ = format;
-  latest_buffer_ = buf;
-  have_new_buffer_ = true;
-
-}
-
 void GstEngine::FadeoutFinished() {
 
   fadeout_pipeline_.reset();
@@ -654,6 +629,7 @@ void GstEngine::PlayDone(const GstStateChangeReturn ret, const quint64 offset_na
     if (!redirect_url.isEmpty() && redirect_url != current_pipeline_->gst_url()) {
       qLog(Info) << "Redirecting to" << redirect_url;
       current_pipeline_ = CreatePipeline(current_pipeline_->media_url(), current_pipeline_->stream_url(), redirect_url, end_nanosec_, current_pipeline_->ebur128_loudness_normalizing_gain_db());
+      if (current_pipeline_) scope_pipeline_id_.store(current_pipeline_->id(), std::memory_order_relaxed);
       Play(offset_nanosec);
       return;
     }
@@ -836,66 +812,6 @@ SharedPtr<GstEnginePipeline> GstEngine::CreatePipeline(const QUrl &media_url, co
 
 }
 
-void GstEngine::UpdateScope(const int chunk_length) {
-
-  using sample_type = EngineBase::Scope::value_type;
-
-  // Prevent dbz or invalid chunk size
-  if (!GST_CLOCK_TIME_IS_VALID(GST_BUFFER_DURATION(latest_buffer_))) return;
-  if (GST_BUFFER_DURATION(latest_buffer_) == 0) return;
-
-  GstMapInfo map;
-  gst_buffer_map(latest_buffer_, &map, GST_MAP_READ);
-
-  // Determine where to split the buffer
-  int chunk_density = static_cast<int>((map.size * kNsecPerMsec) / GST_BUFFER_DURATION(latest_buffer_));
-
-  int chunk_size = chunk_length * chunk_density;
-
-  // In case a buffer doesn't arrive in time
-  if (scope_chunk_ >= scope_chunks_) {
-    scope_chunk_ = 0;
-    gst_buffer_unmap(latest_buffer_, &map);
-    return;
-  }
-
-  const sample_type *source = reinterpret_cast<sample_type*>(map.data);
-  sample_type *dest = scope_.data();
-  source += (chunk_size / sizeof(sample_type)) * scope_chunk_;
-
-  size_t bytes = 0;
-
-  // Make sure we don't go beyond the end of the buffer
-  if (scope_chunk_ == scope_chunks_ - 1) {
-    bytes = qMin(static_cast<EngineBase::Scope::size_type>(map.size - (chunk_size * scope_chunk_)), scope_.size() * sizeof(sample_type));
-  }
-  else {
-    bytes = qMin(static_cast<EngineBase::Scope::size_type>(chunk_size), scope_.size() * sizeof(sample_type));
-  }
-
-  scope_chunk_++;
-
-  if (buffer_format_.startsWith("S16LE") ||
-      buffer_format_.startsWith("U16LE") ||
-      buffer_format_.startsWith("S24LE") ||
-      buffer_format_.startsWith("S24_32LE") ||
-      buffer_format_.startsWith("S32LE") ||
-      buffer_format_.startsWith("F32LE")
-  ) {
-    memcpy(dest, source, bytes);
-  }
-  else {
-    memset(dest, 0, bytes);
-  }
-
-  gst_buffer_unmap(latest_buffer_, &map);
-
-  if (scope_chunk_ == scope_chunks_) {
-    gst_buffer_unref(latest_buffer_);
-    latest_buffer_ = nullptr;
-    buffer_format_.clear();
-  }
-
 }
 
 void GstEngine::StreamDiscovered(GstDiscoverer*, GstDiscovererInfo *info, GError*, gpointer self) {
@@ -26,6 +26,7 @@
 #include "config.h"
 
 #include <optional>
+#include <atomic>
 
 #include <gst/gst.h>
 #include <gst/pbutils/pbutils.h>
@@ -42,6 +43,7 @@
 #include "enginebase.h"
 #include "gststartup.h"
 #include "gstbufferconsumer.h"
+#include "scoperingbuffer.h"
 
 class QTimer;
 class QTimerEvent;
@@ -74,7 +76,7 @@ class GstEngine : public EngineBase, public GstBufferConsumer {
  public:
   qint64 position_nanosec() const override;
   qint64 length_nanosec() const override;
-  const EngineBase::Scope &scope(const int chunk_length) override;
+  const EngineBase::Scope &scope() override;
 
   OutputDetailsList GetOutputsList() const override;
   bool ValidOutput(const QString &output) override;
@@ -112,7 +114,6 @@ class GstEngine : public EngineBase, public GstBufferConsumer {
   void EndOfStreamReached(const int pipeline_id, const bool has_next_track);
   void HandlePipelineError(const int pipeline_id, const int domain, const int error_code, const QString &message, const QString &debugstr);
   void NewMetaData(const int pipeline_id, const EngineMetadata &engine_metadata);
-  void AddBufferToScope(GstBuffer *buf, const int pipeline_id, const QString &format);
   void FadeoutFinished();
   void FadeoutPauseFinished();
   void SeekNow();
@@ -134,8 +135,6 @@ class GstEngine : public EngineBase, public GstBufferConsumer {
   SharedPtr<GstEnginePipeline> CreatePipeline();
   SharedPtr<GstEnginePipeline> CreatePipeline(const QUrl &media_url, const QUrl &stream_url, const QByteArray &gst_url, const qint64 end_nanosec, const double ebur128_loudness_normalizing_gain_db);
 
-  void UpdateScope(int chunk_length);
-
   static void StreamDiscovered(GstDiscoverer*, GstDiscovererInfo *info, GError*, gpointer self);
   static void StreamDiscoveryFinished(GstDiscoverer*, gpointer);
   static QString GSTdiscovererErrorMessage(GstDiscovererResult result);
@@ -156,6 +155,7 @@ class GstEngine : public EngineBase, public GstBufferConsumer {
   static const qint64 kTimerIntervalNanosec;
   static const qint64 kPreloadGapNanosec;
   static const qint64 kSeekDelayNanosec;
+  static const int kScopeChannels;
 
   SharedPtr<TaskManager> task_manager_;
   GstStartup *gst_startup_;
@@ -169,8 +169,6 @@ class GstEngine : public EngineBase, public GstBufferConsumer {
 
   QList<GstBufferConsumer*> buffer_consumers_;
 
-  GstBuffer *latest_buffer_;
-
   bool stereo_balancer_enabled_;
   float stereo_balance_;
 
@@ -188,10 +186,10 @@ class GstEngine : public EngineBase, public GstBufferConsumer {
   bool is_fading_out_to_pause_;
   bool has_faded_out_;
 
-  int scope_chunk_;
-  bool have_new_buffer_;
-  int scope_chunks_;
-  QString buffer_format_;
+  // Written in the streaming thread, read in scope().
+  ScopeRingBuffer scope_buffer_;
+  // Only buffers from this pipeline are added to the scope.
+  std::atomic<int> scope_pipeline_id_;
 
   int discovery_finished_cb_id_;
   int discovery_discovered_cb_id_;
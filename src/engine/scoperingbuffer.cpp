@@ -0,0 +1,84 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+
+#include <QtGlobal>
+
+#include "scoperingbuffer.h"
+
+static_assert((ScopeRingBuffer::kCapacity & (ScopeRingBuffer::kCapacity - 1)) == 0, "The capacity must be a power of two");
+
+ScopeRingBuffer::ScopeRingBuffer() : write_pos_(0) {
+
+  for (std::atomic<float> &sample : samples_) {
+    sample.store(0.0F, std::memory_order_relaxed);
+  }
+
+}
+
+void ScopeRingBuffer::Write(const int16_t *samples, const qint64 frames, const int channels) {
+
+  if (!samples || frames <= 0 || channels <= 0) return;
+
+  const float scale = 1.0F / (static_cast<float>(channels) * 32768.0F);
+
+  quint64 pos = write_pos_.load(std::memory_order_relaxed);
+  qint64 frame = 0;
+  while (frame < frames) {
+    const qint64 end = std::min(frames, frame + kMaxWriteFrames);
+    // Pairs with the fence in ReadLatest(): a reader that sees one of the samples below also sees the position published before them.
+    std::atomic_thread_fence(std::memory_order_release);
+    for (; frame < end; ++frame) {
+      const int16_t *s = samples + (frame * channels);
+      int sum = 0;
+      for (int channel = 0; channel < channels; ++channel) {
+        sum += s[channel];
+      }
+      samples_[pos & (kCapacity - 1)].store(static_cast<float>(sum) * scale, std::memory_order_relaxed);
+      ++pos;
+    }
+    write_pos_.store(pos, std::memory_order_release);
+  }
+
+}
+
+bool ScopeRingBuffer::ReadLatest(float *dest, const int frames) const {
+
+  if (!dest || frames <= 0 || frames > kCapacity - kMaxWriteFrames) return false;
+
+  const quint64 end = write_pos_.load(std::memory_order_acquire);
+  if (end < static_cast<quint64>(frames)) return false;
+
+  const quint64 start = end - frames;
+  for (int i = 0; i < frames; ++i) {
+    dest[i] = samples_[(start + i) & (kCapacity - 1)].load(std::memory_order_relaxed);
+  }
+
+  // The writer can be up to kMaxWriteFrames ahead of what it published, check that it didn't reach the frames we copied.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const quint64 new_end = write_pos_.load(std::memory_order_relaxed);
+
+  return !IsOverwritten(start, new_end);
+
+}
@@ -0,0 +1,61 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SCOPERINGBUFFER_H
+#define SCOPERINGBUFFER_H
+
+#include "config.h"
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+
+#include <QtGlobal>
+
+// Lock-free ring of mono float samples for the analyzer.
+// One thread writes (the GStreamer streaming thread), and one thread reads the newest samples (the GUI thread).
+// Old samples are overwritten instead of blocking the writer, a read that raced with the writer is detected and discarded.
+class ScopeRingBuffer {
+
+ public:
+  explicit ScopeRingBuffer();
+
+  static const int kCapacity = 16384;
+
+  // Writer: downmixes the interleaved samples to mono and converts them to -1.0..1.0.
+  void Write(const int16_t *samples, const qint64 frames, const int channels);
+
+  // Reader: copies the newest frames to dest, returns false if there is not enough data yet, or it was overwritten while reading.
+  bool ReadLatest(float *dest, const int frames) const;
+
+  // The writer publishes every kMaxWriteFrames, so the reader knows how far ahead it can be.
+  static const int kMaxWriteFrames = kCapacity / 4;
+
+  // Whether the frames from start might have been overwritten, when the writer has published up to write_pos.
+  static bool IsOverwritten(const quint64 start, const quint64 write_pos) { return write_pos + kMaxWriteFrames > start + kCapacity; }
+
+ private:
+
+  std::array<std::atomic<float>, kCapacity> samples_;
+  std::atomic<quint64> write_pos_;
+
+  Q_DISABLE_COPY(ScopeRingBuffer)
+};
+
+#endif  // SCOPERINGBUFFER_H
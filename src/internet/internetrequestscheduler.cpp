@@ -0,0 +1,208 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <algorithm>
+
+#include <QtGlobal>
+#include <QObject>
+#include <QTimer>
+#include <QByteArray>
+#include <QString>
+#include <QUrl>
+#include <QDateTime>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+
+#include "core/logging.h"
+#include "internetrequestscheduler.h"
+
+const int InternetRequestScheduler::kMinRequests = 1;
+const int InternetRequestScheduler::kMaxRequests = 16;
+const int InternetRequestScheduler::kInitialRequests = 4;
+const int InternetRequestScheduler::kInteractiveRequests = 1;
+const int InternetRequestScheduler::kMaxRetries = 3;
+const qint64 InternetRequestScheduler::kLatencyTolerance = 200;
+const qint64 InternetRequestScheduler::kMinDecreaseInterval = 100;
+const qint64 InternetRequestScheduler::kDefaultRetryAfter = 1000;
+const qint64 InternetRequestScheduler::kMaxRetryAfter = 120000;
+
+InternetRequestScheduler::Host::Host()
+    : limit(kInitialRequests),
+      active(0),
+      active_interactive(0),
+      min_latency(-1),
+      last_decrease(-1),
+      paused_until(-1) {}
+
+InternetRequestScheduler::InternetRequestScheduler(QObject *parent) : QObject(parent) {
+
+  clock_.start();
+
+}
+
+QString InternetRequestScheduler::HostKey(const QUrl &url) {
+
+  return url.host().toLower();
+
+}
+
+bool InternetRequestScheduler::CanStart(const QUrl &url, const Priority priority) const {
+
+  const QString host_key = HostKey(url);
+  if (!hosts_.contains(host_key)) return true;
+
+  const Host &host = hosts_[host_key];
+  if (host.paused_until > Now()) return false;
+
+  const int limit = static_cast<int>(host.limit);
+  switch (priority) {
+    case Priority::Interactive:
+      // Always let one interactive request through, even when background requests have used up the limit.
+      return host.active < limit || host.active_interactive == 0;
+    case Priority::Background:
+      return host.active < std::max(kMinRequests, limit - kInteractiveRequests);
+  }
+
+  return false;
+
+}
+
+int InternetRequestScheduler::MaxRequests(const QUrl &url) const {
+
+  const QString host_key = HostKey(url);
+  if (!hosts_.contains(host_key)) return kInitialRequests;
+  return static_cast<int>(hosts_[host_key].limit);
+
+}
+
+int InternetRequestScheduler::ActiveRequests(const QUrl &url) const {
+
+  const QString host_key = HostKey(url);
+  if (!hosts_.contains(host_key)) return 0;
+  return hosts_[host_key].active;
+
+}
+
+void InternetRequestScheduler::AddReply(QNetworkReply *reply, const Priority priority) {
+
+  const QString host_key = HostKey(reply->url());
+  Host &host = hosts_[host_key];
+  ++host.active;
+  if (priority == Priority::Interactive) ++host.active_interactive;
+
+  const qint64 started = Now();
+  QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, host_key, priority, started]() { ReplyFinished(reply, host_key, priority, started); });
+
+}
+
+bool InternetRequestScheduler::RetryLater(QNetworkReply *reply) {
+
+  const int http_status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  return http_status == 429 || http_status == 503;
+
+}
+
+void InternetRequestScheduler::ReplyFinished(QNetworkReply *reply, const QString &host_key, const Priority priority, const qint64 started) {
+
+  QObject::disconnect(reply, nullptr, this, nullptr);
+
+  Host &host = hosts_[host_key];
+  // Background requests leave room for interactive ones, so the limit counts as used when they have filled their share.
+  const bool limit_reached = host.active >= std::max(kMinRequests, static_cast<int>(host.limit) - kInteractiveRequests);
+  --host.active;
+  if (priority == Priority::Interactive) --host.active_interactive;
+
+  const qint64 latency = Now() - started;
+  const int http_status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+  if (RetryLater(reply)) {
+    qint64 retry_after = kDefaultRetryAfter;
+    if (reply->hasRawHeader("Retry-After")) {
+      retry_after = ParseRetryAfter(reply->rawHeader("Retry-After"));
+    }
+    qLog(Debug) << "Backing off from" << host_key << "for" << retry_after << "ms after HTTP status" << http_status;
+    Decrease(host);
+    Pause(host, retry_after);
+  }
+  else if (reply->error() == QNetworkReply::OperationCanceledError) {
+    // Aborted by us, this doesn't tell anything about the server.
+  }
+  else if (reply->error() != QNetworkReply::NoError && reply->error() < 200) {
+    // Network error, like a timeout or a connection that was reset.
+    Decrease(host);
+  }
+  else if (http_status >= 200 && http_status < 400) {
+    if (host.min_latency < 0 || latency < host.min_latency) host.min_latency = latency;
+    if (latency > host.min_latency * 2 + kLatencyTolerance) {
+      // The server, or the connection to it is queueing requests.
+      Decrease(host);
+    }
+    // Only grow when the limit is used, otherwise the reply says nothing about how much more the server can take.
+    else if (limit_reached) {
+      Increase(host);
+    }
+  }
+
+  emit Available();
+
+}
+
+void InternetRequestScheduler::Increase(Host &host) {
+
+  host.limit = std::min(static_cast<double>(kMaxRequests), host.limit + 1.0 / host.limit);
+
+}
+
+void InternetRequestScheduler::Decrease(Host &host) {
+
+  // Replies that were sent before the last decrease are likely to be slow too, only count them once per round trip.
+  const qint64 now = Now();
+  if (host.last_decrease >= 0 && now - host.last_decrease < std::max(host.min_latency, kMinDecreaseInterval)) return;
+
+  host.limit = std::max(static_cast<double>(kMinRequests), host.limit / 2.0);
+  host.last_decrease = now;
+
+}
+
+void InternetRequestScheduler::Pause(Host &host, const qint64 msec) {
+
+  const qint64 msec_clamped = std::clamp(msec, static_cast<qint64>(0), kMaxRetryAfter);
+  const qint64 paused_until = Now() + msec_clamped;
+  if (paused_until <= host.paused_until) return;
+
+  host.paused_until = paused_until;
+  QTimer::singleShot(static_cast<int>(msec_clamped), this, [this]() { emit Available(); });
+
+}
+
+qint64 InternetRequestScheduler::ParseRetryAfter(const QByteArray &value) {
+
+  // Either a number of seconds or an HTTP date.
+  bool ok = false;
+  const qint64 seconds = value.trimmed().toLongLong(&ok);
+  if (ok) return seconds * 1000;
+
+  const QDateTime date = QDateTime::fromString(QString::fromLatin1(value.trimmed()).replace(QLatin1String("GMT"), QLatin1String("+0000")), Qt::RFC2822Date);
+  if (date.isValid()) return QDateTime::currentDateTimeUtc().msecsTo(date);
+
+  return kDefaultRetryAfter;
+
+}
@@ -0,0 +1,106 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef INTERNETREQUESTSCHEDULER_H
+#define INTERNETREQUESTSCHEDULER_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QObject>
+#include <QHash>
+#include <QByteArray>
+#include <QString>
+#include <QElapsedTimer>
+
+class QUrl;
+class QNetworkReply;
+
+// Decides how many requests an internet service can have running against each host.
+// The limit grows by about one request per round trip while replies come back fast,
+// and is halved when they slow down, fail, or the server asks us to back off with 429 or 503.
+// Background requests leave room for interactive ones, so a search isn't stuck behind a collection sync.
+class InternetRequestScheduler : public QObject {
+  Q_OBJECT
+
+ public:
+  explicit InternetRequestScheduler(QObject *parent = nullptr);
+
+  enum class Priority {
+    Interactive,
+    Background
+  };
+
+  static const int kMinRequests;
+  static const int kMaxRequests;
+  static const int kInitialRequests;
+  static const int kInteractiveRequests;
+  static const int kMaxRetries;
+
+  // Returns true if a request with this priority can be sent to the host of the URL now.
+  bool CanStart(const QUrl &url, const Priority priority) const;
+
+  // Tracks a request that was sent until the reply has finished.
+  void AddReply(QNetworkReply *reply, const Priority priority);
+
+  int MaxRequests(const QUrl &url) const;
+  int ActiveRequests(const QUrl &url) const;
+
+  // Returns true if the server asked us to back off instead of answering the request.
+  // The request should be queued again, CanStart() holds it back until the host is no longer paused.
+  static bool RetryLater(QNetworkReply *reply);
+
+ protected:
+  // Milliseconds since the scheduler was created, tests replace it to control time.
+  virtual qint64 Now() const { return clock_.elapsed(); }
+
+ signals:
+  // A request finished or a host stopped backing off, queued requests can be tried again.
+  void Available();
+
+ private:
+  struct Host {
+    Host();
+    double limit;
+    int active;
+    int active_interactive;
+    qint64 min_latency;
+    qint64 last_decrease;
+    qint64 paused_until;
+  };
+
+  static QString HostKey(const QUrl &url);
+  static qint64 ParseRetryAfter(const QByteArray &value);
+
+  void ReplyFinished(QNetworkReply *reply, const QString &host_key, const Priority priority, const qint64 started);
+  void Increase(Host &host);
+  void Decrease(Host &host);
+  void Pause(Host &host, const qint64 msec);
+
+ private:
+  static const qint64 kLatencyTolerance;
+  static const qint64 kMinDecreaseInterval;
+  static const qint64 kDefaultRetryAfter;
+  static const qint64 kMaxRetryAfter;
+
+  QElapsedTimer clock_;
+  QHash<QString, Host> hosts_;
+};
+
+#endif  // INTERNETREQUESTSCHEDULER_H
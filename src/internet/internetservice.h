@@ -25,6 +25,7 @@
 #include <QMetaType>
 #include <QMap>
 #include <QString>
+#include <QStringList>
 #include <QUrl>
 #include <QIcon>
 
@@ -37,6 +38,7 @@ class QSortFilterProxyModel;
 class Application;
 class CollectionBackend;
 class CollectionModel;
+class InternetRequestScheduler;
 
 class InternetService : public QObject {
   Q_OBJECT
@@ -73,6 +75,8 @@ class InternetService : public QObject {
   virtual QSortFilterProxyModel *albums_collection_sort_model() { return nullptr; }
   virtual QSortFilterProxyModel *songs_collection_sort_model() { return nullptr; }
 
+  InternetRequestScheduler *request_scheduler() const { return request_scheduler_; }
+
  public slots:
   virtual void ShowConfig() {}
   virtual void GetArtists() {}
@@ -112,6 +116,8 @@ class InternetService : public QObject {
   void AlbumsUpdateProgress(const int max);
 
   void SongsResults(const SongMap &songs, const QString &error);
+  // Only the songs in these albums were fetched, songs in other albums are unchanged.
+  void SongsAlbumsResults(const QStringList &album_ids, const SongMap &songs, const QString &error);
   void SongsUpdateStatus(const QString &text);
   void SongsProgressSetMaximum(const int max);
   void SongsUpdateProgress(const int max);
@@ -142,6 +148,7 @@ class InternetService : public QObject {
   QString url_scheme_;
   QString settings_group_;
   SettingsDialog::Page settings_page_;
+  InternetRequestScheduler *request_scheduler_;
 };
 
 using InternetServicePtr = SharedPtr<InternetService>;
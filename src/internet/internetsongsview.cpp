@@ -67,6 +67,7 @@ InternetSongsView::InternetSongsView(Application *app, InternetServicePtr servic
   QObject::connect(ui_->close, &QPushButton::clicked, this, &InternetSongsView::AbortGetSongs);
   QObject::connect(ui_->abort, &QPushButton::clicked, this, &InternetSongsView::AbortGetSongs);
   QObject::connect(&*service_, &InternetService::SongsResults, this, &InternetSongsView::SongsFinished);
+  QObject::connect(&*service_, &InternetService::SongsAlbumsResults, this, &InternetSongsView::SongsAlbumsFinished);
   QObject::connect(&*service_, &InternetService::SongsUpdateStatus, ui_->status, &QLabel::setText);
   QObject::connect(&*service_, &InternetService::SongsProgressSetMaximum, ui_->progressbar, &QProgressBar::setMaximum);
   QObject::connect(&*service_, &InternetService::SongsUpdateProgress, ui_->progressbar, &QProgressBar::setValue);
@@ -136,3 +137,16 @@ void InternetSongsView::SongsFinished(const SongMap &songs, const QString &error
   }
 
 }
+
+void InternetSongsView::SongsAlbumsFinished(const QStringList &album_ids, const SongMap &songs, const QString &error) {
+
+  if (album_ids.isEmpty() && songs.isEmpty() && !error.isEmpty()) {
+    SongsFinished(songs, error);
+  }
+  else {
+    ui_->stacked->setCurrentWidget(ui_->internetcollection_page);
+    ui_->status->clear();
+    service_->songs_collection_backend()->UpdateSongsByAlbumIDAsync(album_ids, songs);
+  }
+
+}
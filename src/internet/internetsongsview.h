@@ -26,6 +26,7 @@
 #include <QWidget>
 #include <QMap>
 #include <QString>
+#include <QStringList>
 
 #include "core/shared_ptr.h"
 #include "core/song.h"
@@ -57,6 +58,7 @@ class InternetSongsView : public QWidget {
   void GetSongs();
   void AbortGetSongs();
   void SongsFinished(const SongMap &songs, const QString &error);
+  void SongsAlbumsFinished(const QStringList &album_ids, const SongMap &songs, const QString &error);
 
  private:
   Application *app_;
@@ -0,0 +1,301 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <QtGlobal>
+#include <QObject>
+#include <QStandardPaths>
+#include <QFile>
+#include <QIODevice>
+#include <QTimer>
+#include <QDateTime>
+#include <QList>
+#include <QPair>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QUrlQuery>
+#include <QJsonDocument>
+#include <QJsonValue>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include "core/logging.h"
+#include "core/song.h"
+#include "utilities/timeconstants.h"
+#include "internetstreamurlcache.h"
+
+using namespace std::chrono_literals;
+
+const qint64 InternetStreamUrlCache::kDefaultLifetime = 1800;
+const qint64 InternetStreamUrlCache::kMaxLifetime = 86400;
+const qint64 InternetStreamUrlCache::kExpiryMargin = 300;
+
+InternetStreamUrlCache::Entry::Entry()
+    : filetype(Song::FileType::Stream),
+      samplerate(-1),
+      bit_depth(-1),
+      length_nanosec(-1),
+      expires(0) {}
+
+InternetStreamUrlCache::InternetStreamUrlCache(const QString &filename, QObject *parent)
+    : QObject(parent),
+      timer_flush_(new QTimer(this)),
+      dirty_(false) {
+
+  if (!filename.isEmpty()) {
+    filename_ = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/" + filename;
+    ReadCache();
+  }
+
+  timer_flush_->setSingleShot(true);
+  timer_flush_->setInterval(5min);
+  QObject::connect(timer_flush_, &QTimer::timeout, this, &InternetStreamUrlCache::WriteCache);
+
+}
+
+InternetStreamUrlCache::~InternetStreamUrlCache() {
+
+  if (dirty_) WriteCache();
+
+}
+
+bool InternetStreamUrlCache::Get(const QUrl &media_url, Entry &entry) {
+
+  QHash<QUrl, Entry>::iterator it = entries_.find(media_url);
+  if (it == entries_.end() || it.value().variant != variant_) return false;
+
+  if (!IsUsable(it.value(), QDateTime::currentSecsSinceEpoch())) {
+    entries_.erase(it);
+    return false;
+  }
+
+  entry = it.value();
+  return true;
+
+}
+
+bool InternetStreamUrlCache::Contains(const QUrl &media_url) {
+
+  Entry entry;
+  return Get(media_url, entry);
+
+}
+
+void InternetStreamUrlCache::Insert(const QUrl &media_url, const QUrl &stream_url, const Song::FileType filetype, const int samplerate, const int bit_depth, const qint64 length_nanosec) {
+
+  RemoveUnusable();
+
+  const qint64 now = QDateTime::currentSecsSinceEpoch();
+  qint64 expires = ExpiryFromUrl(stream_url);
+  if (expires < 0) expires = now + kDefaultLifetime;
+  if (expires <= now) return;
+
+  Entry entry;
+  entry.stream_url = stream_url;
+  entry.filetype = filetype;
+  entry.samplerate = samplerate;
+  entry.bit_depth = bit_depth;
+  entry.length_nanosec = length_nanosec;
+  entry.expires = std::min(expires, now + kMaxLifetime);
+  entry.variant = variant_;
+  entries_.insert(media_url, entry);
+
+  ScheduleWrite();
+
+}
+
+void InternetStreamUrlCache::Remove(const QUrl &media_url) {
+
+  if (entries_.remove(media_url) > 0) ScheduleWrite();
+
+}
+
+void InternetStreamUrlCache::Clear() {
+
+  if (entries_.isEmpty()) return;
+
+  entries_.clear();
+  ScheduleWrite();
+
+}
+
+bool InternetStreamUrlCache::IsUsable(const Entry &entry, const qint64 now) {
+
+  // GStreamer requests the URL again when seeking, so it has to stay valid until the song has played.
+  const qint64 length = entry.length_nanosec > 0 ? entry.length_nanosec / kNsecPerSec : kExpiryMargin;
+  return entry.expires - now >= length + kExpiryMargin;
+
+}
+
+void InternetStreamUrlCache::RemoveUnusable() {
+
+  const qint64 now = QDateTime::currentSecsSinceEpoch();
+  for (QHash<QUrl, Entry>::iterator it = entries_.begin(); it != entries_.end();) {
+    if (IsUsable(it.value(), now)) {
+      ++it;
+    }
+    else {
+      it = entries_.erase(it);
+    }
+  }
+
+}
+
+void InternetStreamUrlCache::ScheduleWrite() {
+
+  if (filename_.isEmpty()) return;
+
+  dirty_ = true;
+  if (!timer_flush_->isActive()) timer_flush_->start();
+
+}
+
+qint64 InternetStreamUrlCache::ExpiryFromUrl(const QUrl &url) {
+
+  const QList<QPair<QString, QString>> query_items = QUrlQuery(url).queryItems(QUrl::FullyDecoded);
+  for (const QPair<QString, QString> &query_item : query_items) {
+    const QString key = query_item.first.toLower();
+    if (key == "etsp" || key == "expires" || key == "exp") {
+      const qint64 expires = ParseTimestamp(query_item.second);
+      if (expires > 0) return expires;
+    }
+    // CDN tokens, either with an "exp=<time>" field or starting with the time, like "<time>~<hash>".
+    else if (key == "token" || key == "hdnts" || key == "__token__") {
+      const QStringList fields = query_item.second.split('~');
+      for (int i = 0; i < fields.count(); ++i) {
+        qint64 expires = -1;
+        if (fields[i].startsWith("exp=")) expires = ParseTimestamp(fields[i].mid(4));
+        else if (i == 0) expires = ParseTimestamp(fields[i]);
+        if (expires > 0) return expires;
+      }
+    }
+  }
+
+  return -1;
+
+}
+
+qint64 InternetStreamUrlCache::ParseTimestamp(const QString &value) {
+
+  bool ok = false;
+  qint64 timestamp = value.toLongLong(&ok);
+  if (!ok) return -1;
+
+  // Some services use milliseconds.
+  if (timestamp > 100000000000LL) timestamp /= 1000;
+
+  // Anything smaller is a duration or a sequence number, not a time.
+  if (timestamp < 1000000000LL) return -1;
+
+  return timestamp;
+
+}
+
+void InternetStreamUrlCache::ReadCache() {
+
+  QFile file(filename_);
+  if (!file.open(QIODevice::ReadOnly)) return;
+  const QByteArray data = file.readAll();
+  file.close();
+
+  if (data.isEmpty()) return;
+
+  QJsonParseError error;
+  const QJsonDocument json_doc = QJsonDocument::fromJson(data, &error);
+  if (error.error != QJsonParseError::NoError || !json_doc.isObject()) {
+    qLog(Error) << "Stream URL cache" << filename_ << "is not a JSON object.";
+    return;
+  }
+  const QJsonObject json_obj_cache = json_doc.object();
+  const QJsonValue json_entries = json_obj_cache["entries"];
+  if (!json_entries.isArray()) {
+    qLog(Error) << "Stream URL cache" << filename_ << "is missing JSON entries.";
+    return;
+  }
+
+  const qint64 now = QDateTime::currentSecsSinceEpoch();
+  const QJsonArray json_array = json_entries.toArray();
+  for (const QJsonValue &value : json_array) {
+    if (!value.isObject()) continue;
+    const QJsonObject json_obj = value.toObject();
+    const QUrl media_url(json_obj["media_url"].toString());
+    Entry entry;
+    entry.stream_url = QUrl(json_obj["stream_url"].toString());
+    entry.filetype = static_cast<Song::FileType>(json_obj["filetype"].toInt());
+    entry.samplerate = json_obj["samplerate"].toInt(-1);
+    entry.bit_depth = json_obj["bit_depth"].toInt(-1);
+    entry.length_nanosec = json_obj["length_nanosec"].toVariant().toLongLong();
+    entry.expires = json_obj["expires"].toVariant().toLongLong();
+    entry.variant = json_obj["variant"].toString();
+    if (!media_url.isValid() || !entry.stream_url.isValid() || !IsUsable(entry, now)) continue;
+    entries_.insert(media_url, entry);
+  }
+
+  qLog(Debug) << "Loaded" << entries_.count() << "stream URLs from" << filename_;
+
+}
+
+void InternetStreamUrlCache::WriteCache() {
+
+  if (filename_.isEmpty()) return;
+
+  dirty_ = false;
+
+  const qint64 now = QDateTime::currentSecsSinceEpoch();
+  QJsonArray json_array;
+  for (QHash<QUrl, Entry>::const_iterator it = entries_.constBegin(); it != entries_.constEnd(); ++it) {
+    const Entry &entry = it.value();
+    if (!IsUsable(entry, now)) continue;
+    QJsonObject json_obj;
+    json_obj.insert("media_url", it.key().toString());
+    json_obj.insert("stream_url", entry.stream_url.toString());
+    json_obj.insert("filetype", static_cast<int>(entry.filetype));
+    json_obj.insert("samplerate", entry.samplerate);
+    json_obj.insert("bit_depth", entry.bit_depth);
+    json_obj.insert("length_nanosec", QJsonValue::fromVariant(entry.length_nanosec));
+    json_obj.insert("expires", QJsonValue::fromVariant(entry.expires));
+    json_obj.insert("variant", entry.variant);
+    json_array.append(json_obj);
+  }
+
+  if (json_array.isEmpty()) {
+    QFile file(filename_);
+    if (file.exists()) file.remove();
+    return;
+  }
+
+  QJsonObject json_obj;
+  json_obj.insert("entries", json_array);
+
+  QFile file(filename_);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qLog(Error) << "Unable to open stream URL cache file" << filename_;
+    return;
+  }
+  file.setPermissions(QFile::ReadOwner | QFile::WriteOwner);
+  file.write(QJsonDocument(json_obj).toJson(QJsonDocument::Compact));
+  file.close();
+
+}
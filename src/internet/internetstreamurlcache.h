@@ -0,0 +1,97 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef INTERNETSTREAMURLCACHE_H
+#define INTERNETSTREAMURLCACHE_H
+
+#include "config.h"
+
+#include <QtGlobal>
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <QUrl>
+
+#include "core/song.h"
+
+class QTimer;
+
+// Remembers the stream URLs a streaming service resolved for its songs until they expire,
+// so playing, skipping to or preloading a song doesn't have to wait for the service API.
+// The expiry is read from the URL when the service signs it with one, otherwise a default lifetime is used.
+// The stream URLs work for anyone who has them until they expire, so the cache file is only readable by the user.
+class InternetStreamUrlCache : public QObject {
+  Q_OBJECT
+
+ public:
+  // The cache is saved to filename in the cache directory, or kept in memory only if filename is empty.
+  explicit InternetStreamUrlCache(const QString &filename, QObject *parent = nullptr);
+  ~InternetStreamUrlCache() override;
+
+  static const qint64 kDefaultLifetime;
+  static const qint64 kMaxLifetime;
+  static const qint64 kExpiryMargin;
+
+  struct Entry {
+    Entry();
+    QUrl stream_url;
+    Song::FileType filetype;
+    int samplerate;
+    int bit_depth;
+    qint64 length_nanosec;
+    qint64 expires;
+    QString variant;
+  };
+
+  // Entries resolved with other settings, like a different stream quality, are ignored.
+  void set_variant(const QString &variant) { variant_ = variant; }
+
+  // Returns true if there is a stream URL for the song that is still valid long enough to play the whole song.
+  // An entry that isn't anymore is removed.
+  bool Get(const QUrl &media_url, Entry &entry);
+  bool Contains(const QUrl &media_url);
+
+  void Insert(const QUrl &media_url, const QUrl &stream_url, const Song::FileType filetype = Song::FileType::Stream, const int samplerate = -1, const int bit_depth = -1, const qint64 length_nanosec = -1);
+  void Remove(const QUrl &media_url);
+  void Clear();
+
+  int Count() const { return static_cast<int>(entries_.count()); }
+
+  // Returns the time in seconds since epoch the URL expires, from the signature parameters in the query, or -1.
+  static qint64 ExpiryFromUrl(const QUrl &url);
+
+ public slots:
+  void WriteCache();
+
+ private:
+  void ReadCache();
+  void ScheduleWrite();
+  static bool IsUsable(const Entry &entry, const qint64 now);
+  void RemoveUnusable();
+  static qint64 ParseTimestamp(const QString &value);
+
+ private:
+  QTimer *timer_flush_;
+  QString filename_;
+  QString variant_;
+  QHash<QUrl, Entry> entries_;
+  bool dirty_;
+};
+
+#endif  // INTERNETSTREAMURLCACHE_H
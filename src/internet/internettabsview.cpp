@@ -143,6 +143,7 @@ InternetTabsView::InternetTabsView(Application *app, InternetServicePtr service,
     QObject::connect(ui_->songs_collection->button_close(), &QPushButton::clicked, this, &InternetTabsView::AbortGetSongs);
     QObject::connect(ui_->songs_collection->button_abort(), &QPushButton::clicked, this, &InternetTabsView::AbortGetSongs);
     QObject::connect(&*service_, &InternetService::SongsResults, this, &InternetTabsView::SongsFinished);
+    QObject::connect(&*service_, &InternetService::SongsAlbumsResults, this, &InternetTabsView::SongsAlbumsFinished);
     QObject::connect(&*service_, &InternetService::SongsUpdateStatus, ui_->songs_collection->status(), &QLabel::setText);
     QObject::connect(&*service_, &InternetService::SongsProgressSetMaximum, ui_->songs_collection->progressbar(), &QProgressBar::setMaximum);
     QObject::connect(&*service_, &InternetService::SongsUpdateProgress, ui_->songs_collection->progressbar(), &QProgressBar::setValue);
@@ -357,6 +358,19 @@ void InternetTabsView::SongsFinished(const SongMap &songs, const QString &error)
 
 }
 
+void InternetTabsView::SongsAlbumsFinished(const QStringList &album_ids, const SongMap &songs, const QString &error) {
+
+  if (album_ids.isEmpty() && songs.isEmpty() && !error.isEmpty()) {
+    SongsFinished(songs, error);
+  }
+  else {
+    ui_->songs_collection->stacked()->setCurrentWidget(ui_->songs_collection->internetcollection_page());
+    ui_->songs_collection->status()->clear();
+    service_->songs_collection_backend()->UpdateSongsByAlbumIDAsync(album_ids, songs);
+  }
+
+}
+
 void InternetTabsView::OpenSettingsDialog() {
   app_->OpenSettingsDialogAtPage(service_->settings_page());
 }
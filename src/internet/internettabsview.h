@@ -26,6 +26,7 @@
 #include <QWidget>
 #include <QMap>
 #include <QString>
+#include <QStringList>
 
 #include "core/shared_ptr.h"
 #include "settings/settingsdialog.h"
@@ -68,6 +69,7 @@ class InternetTabsView : public QWidget {
   void ArtistsFinished(const SongMap &songs, const QString &error);
   void AlbumsFinished(const SongMap &songs, const QString &error);
   void SongsFinished(const SongMap &songs, const QString &error);
+  void SongsAlbumsFinished(const QStringList &album_ids, const SongMap &songs, const QString &error);
 
  private:
   Application *app_;
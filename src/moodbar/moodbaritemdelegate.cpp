@@ -30,6 +30,8 @@
 #include <QPixmap>
 #include <QPainter>
 #include <QRect>
+#include <QTimer>
+#include <QScrollBar>
 
 #include "core/application.h"
 #include "playlist/playlist.h"
@@ -43,15 +45,22 @@
 
 #include "settings/moodbarsettingspage.h"
 
-MoodbarItemDelegate::Data::Data() : state_(State::None) {}
+MoodbarItemDelegate::Data::Data() : state_(State::None), load_claimed_(false) {}
 
 MoodbarItemDelegate::MoodbarItemDelegate(Application *app, PlaylistView *view, QObject *parent)
     : QItemDelegate(parent),
       app_(app),
       view_(view),
+      timer_cancel_requests_(new QTimer(this)),
       enabled_(false),
       style_(MoodbarRenderer::MoodbarStyle::Normal) {
 
+  // Moodbars for rows that were scrolled past are not generated, unless they are already being generated.
+  timer_cancel_requests_->setSingleShot(true);
+  timer_cancel_requests_->setInterval(250);
+  QObject::connect(timer_cancel_requests_, &QTimer::timeout, this, &MoodbarItemDelegate::CancelInvisibleRequests);
+  QObject::connect(view_->verticalScrollBar(), &QScrollBar::valueChanged, timer_cancel_requests_, QOverload<>::of(&QTimer::start));
+
   QObject::connect(app_, &Application::SettingsChanged, this, &MoodbarItemDelegate::ReloadSettings);
   ReloadSettings();
 
@@ -113,8 +122,17 @@ QPixmap MoodbarItemDelegate::PixmapForIndex(const QModelIndex &idx, const QSize
   data->desired_size_ = size;
 
   switch (data->state_) {
-    case Data::State::CannotLoad:
     case Data::State::LoadingData:
+      // The claim was given up while the row was hidden, the request might be gone, so load it again.
+      if (!data->load_claimed_) {
+        StartLoadingData(url, has_cue, data);
+        return data->pixmap_;
+      }
+      // The row is being painted, so it's visible, generate it before the rows that were scrolled past.
+      app_->moodbar_loader()->Prioritize(url);
+      return data->pixmap_;
+
+    case Data::State::CannotLoad:
     case Data::State::LoadingColors:
     case Data::State::LoadingImage:
       return data->pixmap_;
@@ -141,6 +159,7 @@ QPixmap MoodbarItemDelegate::PixmapForIndex(const QModelIndex &idx, const QSize
 void MoodbarItemDelegate::StartLoadingData(const QUrl &url, const bool has_cue, Data *data) {
 
   data->state_ = Data::State::LoadingData;
+  data->load_claimed_ = false;
 
   // Load a mood file for this song and generate some colors from it
   QByteArray bytes;
@@ -157,6 +176,7 @@ void MoodbarItemDelegate::StartLoadingData(const QUrl &url, const bool has_cue,
 
     case MoodbarLoader::Result::WillLoadAsync:
       // Maybe in a little while.
+      data->load_claimed_ = true;
       QObject::connect(pipeline, &MoodbarPipeline::Finished, this, [this, url, pipeline]() { DataLoaded(url, pipeline); });
       break;
   }
@@ -174,6 +194,28 @@ bool MoodbarItemDelegate::RemoveFromCacheIfIndexesInvalid(const QUrl &url, Data
 
 }
 
+bool MoodbarItemDelegate::IsVisible(const Data *data) const {
+
+  const QRect viewport_rect = view_->viewport()->rect();
+  return std::any_of(data->indexes_.begin(), data->indexes_.end(), [this, viewport_rect](const QPersistentModelIndex &idx) { return idx.isValid() && idx.model() == view_->model() && view_->visualRect(idx).intersects(viewport_rect); });
+
+}
+
+void MoodbarItemDelegate::CancelInvisibleRequests() {
+
+  for (const QUrl &url : data_.keys()) {
+    Data *data = data_[url];
+    if (data->state_ != Data::State::LoadingData || !data->load_claimed_ || IsVisible(data)) continue;
+    // Each Load() is only cancelled once, even if the request keeps running for someone else.
+    data->load_claimed_ = false;
+    if (app_->moodbar_loader()->Cancel(url)) {
+      // It's loaded again if the row is painted later.
+      data->state_ = Data::State::None;
+    }
+  }
+
+}
+
 void MoodbarItemDelegate::ReloadAllColors() {
 
   for (const QUrl &url : data_.keys()) {
@@ -192,6 +234,9 @@ void MoodbarItemDelegate::DataLoaded(const QUrl &url, MoodbarPipeline *pipeline)
 
   Data *data = data_[url];
 
+  // The request was cancelled.
+  if (data->state_ != Data::State::LoadingData) return;
+
   if (RemoveFromCacheIfIndexesInvalid(url, data)) {
     return;
   }
@@ -33,6 +33,7 @@
 #include <QStyleOption>
 
 class QPainter;
+class QTimer;
 class QModelIndex;
 class QPersistentModelIndex;
 class Application;
@@ -54,6 +55,8 @@ class MoodbarItemDelegate : public QItemDelegate {
   void ColorsLoaded(const QUrl &url, const ColorVector &colors);
   void ImageLoaded(const QUrl &url, const QImage &image);
 
+  void CancelInvisibleRequests();
+
  private:
   struct Data {
     Data();
@@ -70,6 +73,8 @@ class MoodbarItemDelegate : public QItemDelegate {
     QSet<QPersistentModelIndex> indexes_;
 
     State state_;
+    // True while the moodbar loader counts this delegate as waiting for the data.
+    bool load_claimed_;
     ColorVector colors_;
     QSize desired_size_;
     QPixmap pixmap_;
@@ -82,6 +87,7 @@ class MoodbarItemDelegate : public QItemDelegate {
   void StartLoadingImage(const QUrl &url, Data *data);
 
   bool RemoveFromCacheIfIndexesInvalid(const QUrl &url, Data *data);
+  bool IsVisible(const Data *data) const;
 
   void ReloadAllColors();
 
@@ -89,6 +95,7 @@ class MoodbarItemDelegate : public QItemDelegate {
   Application *app_;
   PlaylistView *view_;
   QCache<QUrl, Data> data_;
+  QTimer *timer_cancel_requests_;
 
   bool enabled_;
   MoodbarRenderer::MoodbarStyle style_;
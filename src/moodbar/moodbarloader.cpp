@@ -19,6 +19,8 @@
 
 #include <memory>
 #include <chrono>
+#include <algorithm>
+#include <utility>
 
 #include <QtGlobal>
 #include <QObject>
@@ -36,10 +38,16 @@
 #include <QString>
 #include <QUrl>
 #include <QSettings>
+#include <QtConcurrentRun>
+#include <QFuture>
+#include <QFutureWatcher>
 
 #include "core/logging.h"
 #include "core/scoped_ptr.h"
+#include "core/shared_ptr.h"
 #include "core/application.h"
+#include "core/taskmanager.h"
+#include "collection/collectionbackend.h"
 
 #include "moodbarpipeline.h"
 
@@ -53,11 +61,22 @@ using namespace std::chrono_literals;
 
 MoodbarLoader::MoodbarLoader(Application *app, QObject *parent)
     : QObject(parent),
+      app_(app),
       cache_(new QNetworkDiskCache(this)),
-      thread_(new QThread(this)),
+      next_thread_(0),
       kMaxActiveRequests(qMax(1, QThread::idealThreadCount() / 2)),
+      kMaxActiveCollectionRequests(qMax(1, kMaxActiveRequests / 2)),
+      collection_songs_loading_(false),
+      collection_task_id_(-1),
+      collection_requests_total_(0),
+      collection_requests_done_(0),
       save_(false) {
 
+  // The pipelines are spread over the threads, so a slow file doesn't hold up the others.
+  for (int i = 0; i < kMaxActiveRequests; ++i) {
+    threads_ << new QThread(this);
+  }
+
   cache_->setCacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/moodbar");
   cache_->setMaximumCacheSize(60 * 1024 * 1024);  // 60MB - enough for 20,000 moodbars
 
@@ -67,8 +86,14 @@ MoodbarLoader::MoodbarLoader(Application *app, QObject *parent)
 }
 
 MoodbarLoader::~MoodbarLoader() {
-  thread_->quit();
-  thread_->wait(1000);
+
+  for (QThread *thread : std::as_const(threads_)) {
+    thread->quit();
+  }
+  for (QThread *thread : std::as_const(threads_)) {
+    thread->wait(1000);
+  }
+
 }
 
 void MoodbarLoader::ReloadSettings() {
@@ -98,6 +123,17 @@ QUrl MoodbarLoader::CacheUrlEntry(const QString &filename) {
 
 }
 
+bool MoodbarLoader::MoodbarExists(const QString &filename) const {
+
+  const QStringList mood_filenames = MoodFilenames(filename);
+  if (std::any_of(mood_filenames.begin(), mood_filenames.end(), [](const QString &mood_filename) { return QFile::exists(mood_filename); })) {
+    return true;
+  }
+
+  return cache_->metaData(CacheUrlEntry(filename)).isValid();
+
+}
+
 MoodbarLoader::Result MoodbarLoader::Load(const QUrl &url, const bool has_cue, QByteArray *data, MoodbarPipeline **async_pipeline) {
 
   if (!url.isLocalFile() || has_cue) {
@@ -106,6 +142,8 @@ MoodbarLoader::Result MoodbarLoader::Load(const QUrl &url, const bool has_cue, Q
 
   // Are we in the middle of loading this moodbar already?
   if (requests_.contains(url)) {
+    ++request_users_[url];
+    Prioritize(url);
     *async_pipeline = requests_[url];
     return Result::WillLoadAsync;
   }
@@ -142,20 +180,96 @@ MoodbarLoader::Result MoodbarLoader::Load(const QUrl &url, const bool has_cue, Q
     }
   }
 
-  if (!thread_->isRunning()) thread_->start(QThread::IdlePriority);
-
   // There was no existing file, analyze the audio file and create one.
+  MoodbarPipeline *pipeline = CreatePipeline(url);
+  request_users_[url] = 1;
+  queued_requests_.prepend(url);
+
+  MaybeTakeNextRequest();
+
+  *async_pipeline = pipeline;
+  return Result::WillLoadAsync;
+
+}
+
+MoodbarPipeline *MoodbarLoader::CreatePipeline(const QUrl &url) {
+
+  QThread *thread = threads_[next_thread_];
+  next_thread_ = (next_thread_ + 1) % threads_.count();
+  if (!thread->isRunning()) thread->start(QThread::IdlePriority);
+
   MoodbarPipeline *pipeline = new MoodbarPipeline(url);
-  pipeline->moveToThread(thread_);
+  pipeline->moveToThread(thread);
   QObject::connect(pipeline, &MoodbarPipeline::Finished, this, [this, pipeline, url]() { RequestFinished(pipeline, url); });
 
   requests_[url] = pipeline;
-  queued_requests_ << url;
 
-  MaybeTakeNextRequest();
+  return pipeline;
 
-  *async_pipeline = pipeline;
-  return Result::WillLoadAsync;
+}
+
+void MoodbarLoader::Prioritize(const QUrl &url) {
+
+  const int i = static_cast<int>(queued_requests_.indexOf(url));
+  if (i > 0) {
+    queued_requests_.move(i, 0);
+  }
+
+}
+
+bool MoodbarLoader::Cancel(const QUrl &url) {
+
+  Q_ASSERT(QThread::currentThread() == qApp->thread());
+
+  // Callers that already gave up their claim, or never had one, don't count.
+  QHash<QUrl, int>::iterator it = request_users_.find(url);
+  if (it == request_users_.end() || it.value() <= 0) return false;
+
+  if (--it.value() > 0 || !queued_requests_.contains(url)) return false;
+
+  queued_requests_.removeOne(url);
+  request_users_.remove(url);
+
+  // The pipeline was never started, it's deleted in its own thread.
+  MoodbarPipeline *pipeline = requests_.take(url);
+  pipeline->deleteLater();
+
+  return true;
+
+}
+
+void MoodbarLoader::GenerateCollectionMoodbars() {
+
+  if (collection_songs_loading_ || collection_task_id_ != -1) return;
+
+  collection_songs_loading_ = true;
+  collection_task_id_ = app_->task_manager()->StartTask(tr("Generating moodbars"));
+
+  SharedPtr<CollectionBackend> collection_backend = app_->collection_backend();
+  QFuture<SongList> future = QtConcurrent::run([collection_backend]() { return collection_backend->GetAllSongs(); });
+  QFutureWatcher<SongList> *watcher = new QFutureWatcher<SongList>();
+  QObject::connect(watcher, &QFutureWatcher<SongList>::finished, this, [this, watcher]() {
+    CollectionSongsLoaded(watcher->result());
+    watcher->deleteLater();
+  });
+  watcher->setFuture(future);
+
+}
+
+void MoodbarLoader::CollectionSongsLoaded(const SongList &songs) {
+
+  collection_songs_loading_ = false;
+
+  for (const Song &song : songs) {
+    if (song.url().isLocalFile() && !song.has_cue()) {
+      collection_requests_ << song.url();
+    }
+  }
+  collection_requests_total_ += static_cast<int>(collection_requests_.count());
+
+  qLog(Info) << "Generating missing moodbars for" << collection_requests_.count() << "songs";
+
+  MaybeTakeNextRequest();
 
 }
 
@@ -163,71 +277,116 @@ void MoodbarLoader::MaybeTakeNextRequest() {
 
   Q_ASSERT(QThread::currentThread() == qApp->thread());
 
-  if (active_requests_.count() >= kMaxActiveRequests || queued_requests_.isEmpty()) {
-    return;
+  while (active_requests_.count() < kMaxActiveRequests && !queued_requests_.isEmpty()) {
+    const QUrl url = queued_requests_.takeFirst();
+    active_requests_ << url;
+    StartRequest(url);
   }
 
-  const QUrl url = queued_requests_.takeFirst();
-  active_requests_ << url;
+  // Collection requests only use the pipelines that are left, and are checked for existing moodbars when they are taken.
+  while (active_collection_requests_.count() < kMaxActiveCollectionRequests && active_requests_.count() + active_collection_requests_.count() < kMaxActiveRequests && !collection_requests_.isEmpty()) {
+    const QUrl url = collection_requests_.takeFirst();
+    if (requests_.contains(url) || MoodbarExists(url.toLocalFile())) {
+      ++collection_requests_done_;
+      continue;
+    }
+    CreatePipeline(url);
+    active_collection_requests_ << url;
+    StartRequest(url);
+  }
+
+  UpdateCollectionTask();
+
+}
+
+void MoodbarLoader::StartRequest(const QUrl &url) {
 
   qLog(Info) << "Creating moodbar data for" << url.toLocalFile();
   QMetaObject::invokeMethod(requests_[url], &MoodbarPipeline::Start, Qt::QueuedConnection);
 
 }
 
-void MoodbarLoader::RequestFinished(MoodbarPipeline *request, const QUrl &url) {
+void MoodbarLoader::UpdateCollectionTask() {
 
-  Q_ASSERT(QThread::currentThread() == qApp->thread());
+  if (collection_songs_loading_ || collection_task_id_ == -1) return;
 
-  if (request->success()) {
-
-    const QString filename = url.toLocalFile();
+  if (collection_requests_.isEmpty() && active_collection_requests_.isEmpty() && collection_requests_done_ >= collection_requests_total_) {
+    app_->task_manager()->SetTaskFinished(collection_task_id_);
+    collection_task_id_ = -1;
+    collection_requests_total_ = 0;
+    collection_requests_done_ = 0;
+  }
+  else {
+    app_->task_manager()->SetTaskProgress(collection_task_id_, collection_requests_done_, collection_requests_total_);
+  }
 
-    qLog(Info) << "Moodbar data generated successfully for" << filename;
+}
 
-    // Save the data in the cache
-    QNetworkCacheMetaData disk_cache_metadata;
-    disk_cache_metadata.setSaveToDisk(true);
-    disk_cache_metadata.setUrl(CacheUrlEntry(filename));
-    // Qt 6 now ignores any entry without headers, so add a fake header.
-    disk_cache_metadata.setRawHeaders(QNetworkCacheMetaData::RawHeaderList() << qMakePair(QByteArray(), QByteArray()));
+void MoodbarLoader::RequestFinished(MoodbarPipeline *request, const QUrl &url) {
 
-    QIODevice *device_cache_file = cache_->prepare(disk_cache_metadata);
-    if (device_cache_file) {
-      const qint64 data_written = device_cache_file->write(request->data());
-      if (data_written > 0) {
-        cache_->insert(device_cache_file);
-      }
-    }
+  Q_ASSERT(QThread::currentThread() == qApp->thread());
 
-    // Save the data alongside the original as well if we're configured to.
-    if (save_) {
-      QList<QString> mood_filenames = MoodFilenames(url.toLocalFile());
-      const QString mood_filename(mood_filenames[0]);
-      QFile mood_file(mood_filename);
-      if (mood_file.open(QIODevice::WriteOnly)) {
-        if (mood_file.write(request->data()) <= 0) {
-          qLog(Error) << "Error writing to mood file" << mood_filename << mood_file.errorString();
-        }
-        mood_file.close();
-#ifdef Q_OS_WIN32
-        if (!SetFileAttributes(reinterpret_cast<LPCTSTR>(mood_filename.utf16()), FILE_ATTRIBUTE_HIDDEN)) {
-          qLog(Warning) << "Error setting hidden attribute for file" << mood_filename;
-        }
-#endif
-      }
-      else {
-        qLog(Error) << "Error opening mood file" << mood_filename << "for writing:" << mood_file.errorString();
-      }
-    }
+  if (request->success()) {
+    qLog(Info) << "Moodbar data generated successfully for" << url.toLocalFile();
+    SaveMoodbar(url, request->data());
   }
 
   // Remove the request from the active list and delete it
   requests_.remove(url);
+  request_users_.remove(url);
   active_requests_.remove(url);
+  if (active_collection_requests_.remove(url)) {
+    ++collection_requests_done_;
+  }
 
   QTimer::singleShot(1s, request, &MoodbarLoader::deleteLater);
 
   MaybeTakeNextRequest();
 
 }
+
+void MoodbarLoader::SaveMoodbar(const QUrl &url, const QByteArray &data) {
+
+  Q_ASSERT(QThread::currentThread() == qApp->thread());
+
+  if (data.isEmpty()) return;
+
+  const QString filename = url.toLocalFile();
+
+  // Save the data in the cache
+  QNetworkCacheMetaData disk_cache_metadata;
+  disk_cache_metadata.setSaveToDisk(true);
+  disk_cache_metadata.setUrl(CacheUrlEntry(filename));
+  // Qt 6 now ignores any entry without headers, so add a fake header.
+  disk_cache_metadata.setRawHeaders(QNetworkCacheMetaData::RawHeaderList() << qMakePair(QByteArray(), QByteArray()));
+
+  QIODevice *device_cache_file = cache_->prepare(disk_cache_metadata);
+  if (device_cache_file) {
+    const qint64 data_written = device_cache_file->write(data);
+    if (data_written > 0) {
+      cache_->insert(device_cache_file);
+    }
+  }
+
+  // Save the data alongside the original as well if we're configured to.
+  if (save_) {
+    QList<QString> mood_filenames = MoodFilenames(filename);
+    const QString mood_filename(mood_filenames[0]);
+    QFile mood_file(mood_filename);
+    if (mood_file.open(QIODevice::WriteOnly)) {
+      if (mood_file.write(data) <= 0) {
+        qLog(Error) << "Error writing to mood file" << mood_filename << mood_file.errorString();
+      }
+      mood_file.close();
+#ifdef Q_OS_WIN32
+      if (!SetFileAttributes(reinterpret_cast<LPCTSTR>(mood_filename.utf16()), FILE_ATTRIBUTE_HIDDEN)) {
+        qLog(Warning) << "Error setting hidden attribute for file" << mood_filename;
+      }
+#endif
+    }
+    else {
+      qLog(Error) << "Error opening mood file" << mood_filename << "for writing:" << mood_file.errorString();
+    }
+  }
+
+}
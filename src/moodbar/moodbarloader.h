@@ -21,11 +21,14 @@
 #include <QObject>
 #include <QList>
 #include <QMap>
+#include <QHash>
 #include <QSet>
 #include <QString>
 #include <QStringList>
 #include <QUrl>
 
+#include "core/song.h"
+
 class QThread;
 class QByteArray;
 class QNetworkDiskCache;
@@ -52,28 +55,62 @@ class MoodbarLoader : public QObject {
     WillLoadAsync
   };
 
+  // New requests are put in front of the queue, the most recently requested moodbar is usually the one the user is looking at.
   Result Load(const QUrl &url, const bool has_cue, QByteArray *data, MoodbarPipeline **async_pipeline);
 
+  // Moves a queued request to the front of the queue.
+  void Prioritize(const QUrl &url);
+
+  // Tells the loader that one of the callers of Load() doesn't need the moodbar anymore.
+  // The request is cancelled when nobody needs it and it hasn't started yet, returns true if it was.
+  bool Cancel(const QUrl &url);
+
+ public slots:
+  // Saves moodbar data generated elsewhere, like during a collection scan.
+  void SaveMoodbar(const QUrl &url, const QByteArray &data);
+
+  // Generates the missing moodbars for all songs in the collection, straight into the cache.
+  // These run after the other requests, with fewer pipelines at a time.
+  void GenerateCollectionMoodbars();
+
  private slots:
   void ReloadSettings();
 
   void RequestFinished(MoodbarPipeline *request, const QUrl &url);
   void MaybeTakeNextRequest();
+  void CollectionSongsLoaded(const SongList &songs);
 
  private:
   static QStringList MoodFilenames(const QString &song_filename);
   static QUrl CacheUrlEntry(const QString &filename);
 
+  bool MoodbarExists(const QString &filename) const;
+  MoodbarPipeline *CreatePipeline(const QUrl &url);
+  void StartRequest(const QUrl &url);
+  void UpdateCollectionTask();
+
  private:
+  Application *app_;
   QNetworkDiskCache *cache_;
-  QThread *thread_;
+  QList<QThread*> threads_;
+  int next_thread_;
 
   const int kMaxActiveRequests;
+  const int kMaxActiveCollectionRequests;
 
   QMap<QUrl, MoodbarPipeline*> requests_;
+  // Number of callers of Load() waiting for each request.
+  QHash<QUrl, int> request_users_;
   QList<QUrl> queued_requests_;
   QSet<QUrl> active_requests_;
 
+  QList<QUrl> collection_requests_;
+  QSet<QUrl> active_collection_requests_;
+  bool collection_songs_loading_;
+  int collection_task_id_;
+  int collection_requests_total_;
+  int collection_requests_done_;
+
   bool save_;
 };
 
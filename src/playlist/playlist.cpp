@@ -29,6 +29,9 @@
 #include <unordered_map>
 #include <random>
 #include <chrono>
+#include <limits>
+#include <optional>
+#include <vector>
 
 #include <QObject>
 #include <QCoreApplication>
@@ -57,6 +60,8 @@
 #include <QFlags>
 #include <QSettings>
 #include <QTimer>
+#include <QCollator>
+#include <QCollatorSortKey>
 
 #include "core/shared_ptr.h"
 #include "core/application.h"
@@ -64,6 +69,7 @@
 #include "core/mimedata.h"
 #include "core/tagreaderclient.h"
 #include "core/song.h"
+#include "core/filestatuscache.h"
 #include "utilities/timeconstants.h"
 #include "collection/collection.h"
 #include "collection/collectionbackend.h"
@@ -111,6 +117,11 @@ const char *Playlist::kSettingsGroup = "Playlist";
 const int Playlist::kUndoStackSize = 20;
 const int Playlist::kUndoItemLimit = 500;
 
+const int Playlist::kRestoreFirstPageSize = 100;
+const int Playlist::kRestorePageSize = 5000;
+
+const int Playlist::kFileStatusBatchSize = 1000;
+
 const qint64 Playlist::kMinScrobblePointNsecs = 31LL * kNsecPerSec;
 const qint64 Playlist::kMaxScrobblePointNsecs = 240LL * kNsecPerSec;
 
@@ -133,6 +144,13 @@ Playlist::Playlist(SharedPtr<PlaylistBackend> backend, SharedPtr<TaskManager> ta
       undo_stack_(new QUndoStack(this)),
       special_type_(special_type),
       cancel_restore_(false),
+      restoring_(false),
+      restore_deferred_(false),
+      restore_paused_(false),
+      save_after_restore_(false),
+      restore_row_(0),
+      restore_position_(0),
+      restore_row_id_(-1),
       scrobbled_(false),
       scrobble_point_(-1),
       editing_(-1),
@@ -933,6 +951,15 @@ void Playlist::MoveItemsWithoutUndo(const QList<int> &source_rows, int pos) {
     items_.insert(i, moved_items[i - start]);
   }
 
+  if (restoring_) {
+    int restore_row = restore_row_;
+    for (const int source_row : source_rows) {
+      if (source_row < restore_row_) --restore_row;
+    }
+    if (start < restore_row) restore_row += static_cast<int>(moved_items.count());
+    restore_row_ = restore_row;
+  }
+
   // Update persistent indexes
   for (const QModelIndex &pidx : persistentIndexList()) {
     const int dest_offset = static_cast<int>(source_rows.indexOf(pidx.row()));
@@ -986,6 +1013,13 @@ void Playlist::MoveItemsWithoutUndo(int start, const QList<int> &dest_rows) {
     offset++;
   }
 
+  if (restoring_) {
+    restore_row_ -= qBound(0, restore_row_ - start, static_cast<int>(dest_rows.count()));
+    for (const int dest_row : dest_rows) {
+      if (dest_row < restore_row_) ++restore_row_;
+    }
+  }
+
   // Update persistent indexes
   for (const QModelIndex &pidx : persistentIndexList()) {
     if (pidx.row() >= start && pidx.row() < start + dest_rows.count()) {
@@ -1119,6 +1153,11 @@ void Playlist::InsertItemsWithoutUndo(const PlaylistItemPtrList &items, const in
     queue_->InsertFirst(indexes);
   }
 
+  // Rows the user inserted before the next restored page push it down, rows inserted at its position stay after it.
+  if (restoring_ && !is_loading_ && start < restore_row_) {
+    restore_row_ += static_cast<int>(items.count());
+  }
+
   ScheduleSave();
 
   if (auto_sort_) {
@@ -1191,53 +1230,69 @@ void Playlist::UpdateItems(SongList songs) {
 
   qLog(Debug) << "Updating playlist with new tracks' info";
 
-  // We first convert our songs list into a linked list (a 'real' list), because removals are faster with QLinkedList.
-  // Next, we walk through the list of playlist's items then the list of songs
-  // we want to update: if an item corresponds to the song (we rely on URL for this), we update the item with the new metadata,
-  // then we remove song from our list because we will not need to check it again.
+  // We first index the songs we want to update by URL, keeping their order for songs with the same URL.
+  // Next, we walk through the list of playlist's items once: if an item corresponds to a song (we rely on URL for this), we update the item with the new metadata,
+  // then we take the song from the index because we will not need to check it again.
   // And we also update undo actions.
 
-  for (int i = 0; i < items_.size(); i++) {
-    // Update current items list
-    QMutableListIterator<Song> it(songs);
-    while (it.hasNext()) {
-      const Song &song = it.next();
-      const PlaylistItemPtr &item = items_[i];
-      if (item->Metadata().url() == song.url() && (item->Metadata().filetype() == Song::FileType::Unknown || item->Metadata().filetype() == Song::FileType::Stream || item->Metadata().filetype() == Song::FileType::CDDA || !item->Metadata().init_from_file())) {
-        PlaylistItemPtr new_item;
-        if (song.url().isLocalFile()) {
-          if (song.is_collection_song()) {
-            new_item = make_shared<CollectionPlaylistItem>(song);
-            if (collection_items_by_id_.contains(song.id(), item)) collection_items_by_id_.remove(song.id(), item);
-            collection_items_by_id_.insert(song.id(), new_item);
-          }
-          else {
-            new_item = make_shared<SongPlaylistItem>(song);
-          }
-        }
-        else {
-          if (song.is_radio()) {
-            new_item = make_shared<RadioPlaylistItem>(song);
-          }
-          else {
-            new_item = make_shared<InternetPlaylistItem>(song);
-          }
-        }
-        items_[i] = new_item;
-        emit dataChanged(index(i, 0), index(i, ColumnCount - 1));
-        // Also update undo actions
-        for (int y = 0; y < undo_stack_->count(); y++) {
-          QUndoCommand *undo_action = const_cast<QUndoCommand*>(undo_stack_->command(i));
-          PlaylistUndoCommands::InsertItems *undo_action_insert = dynamic_cast<PlaylistUndoCommands::InsertItems*>(undo_action);
-          if (undo_action_insert) {
-            bool found_and_updated = undo_action_insert->UpdateItem(new_item);
-            if (found_and_updated) break;
-          }
-        }
-        it.remove();
-        break;
+  QHash<QUrl, QList<int>> songs_by_url;
+  songs_by_url.reserve(songs.count());
+  for (int i = 0; i < songs.count(); ++i) {
+    songs_by_url[songs[i].url()] << i;
+  }
+
+  // The replaced items are kept until the undo actions are updated, they are looked up by address.
+  PlaylistItemPtrList replaced_items;
+  QHash<const PlaylistItem*, PlaylistItemPtr> updated_items;
+  QList<int> updated_rows;
+  for (int i = 0; i < items_.size() && !songs_by_url.isEmpty(); i++) {
+    const PlaylistItemPtr &item = items_[i];
+    const Song metadata = item->Metadata();
+    if (!(metadata.filetype() == Song::FileType::Unknown || metadata.filetype() == Song::FileType::Stream || metadata.filetype() == Song::FileType::CDDA || !metadata.init_from_file())) continue;
+    QHash<QUrl, QList<int>>::iterator it = songs_by_url.find(metadata.url());
+    if (it == songs_by_url.end()) continue;
+    const Song &song = songs[it.value().takeFirst()];
+    if (it.value().isEmpty()) songs_by_url.erase(it);
+    PlaylistItemPtr new_item;
+    if (song.url().isLocalFile()) {
+      if (song.is_collection_song()) {
+        new_item = make_shared<CollectionPlaylistItem>(song);
+        if (collection_items_by_id_.contains(song.id(), item)) collection_items_by_id_.remove(song.id(), item);
+        collection_items_by_id_.insert(song.id(), new_item);
+      }
+      else {
+        new_item = make_shared<SongPlaylistItem>(song);
+      }
+    }
+    else {
+      if (song.is_radio()) {
+        new_item = make_shared<RadioPlaylistItem>(song);
+      }
+      else {
+        new_item = make_shared<InternetPlaylistItem>(song);
       }
     }
+    replaced_items << item;
+    updated_items.insert(&*item, new_item);
+    items_[i] = new_item;
+    updated_rows << i;
+  }
+
+  // Also update undo actions
+  for (int i = 0; i < undo_stack_->count() && !updated_items.isEmpty(); i++) {
+    QUndoCommand *undo_action = const_cast<QUndoCommand*>(undo_stack_->command(i));
+    PlaylistUndoCommands::InsertItems *undo_action_insert = dynamic_cast<PlaylistUndoCommands::InsertItems*>(undo_action);
+    if (undo_action_insert) {
+      undo_action_insert->UpdateItems(&updated_items);
+    }
+  }
+
+  // One signal for each range of updated rows.
+  for (int i = 0; i < updated_rows.count();) {
+    int j = i;
+    while (j + 1 < updated_rows.count() && updated_rows[j + 1] == updated_rows[j] + 1) ++j;
+    emit dataChanged(index(updated_rows[i], 0), index(updated_rows[j], ColumnCount - 1));
+    i = j + 1;
   }
 
   emit PlaylistChanged();
@@ -1291,24 +1346,47 @@ bool Playlist::CompareItems(const int column, const Qt::SortOrder order, Playlis
   PlaylistItemPtr a = order == Qt::AscendingOrder ? _a : _b;
   PlaylistItemPtr b = order == Qt::AscendingOrder ? _b : _a;
 
-#define cmp(field) return a->Metadata().field() < b->Metadata().field()
-#define strcmp(field) return QString::localeAwareCompare(a->Metadata().field().toLower(), b->Metadata().field().toLower()) < 0;
+  const Song song_a = a->Metadata();
+  const Song song_b = b->Metadata();
+
+  const std::optional<QString> text_a = SortText(column, a, song_a);
+  if (text_a) {
+    return QString::localeAwareCompare(*text_a, *SortText(column, b, song_b)) < 0;
+  }
+
+  return CompareSongs(column, song_a, song_b);
+
+}
+
+std::optional<QString> Playlist::SortText(const int column, PlaylistItemPtr item, const Song &song) {
+
+  switch (column) {
+    case Column_Title:        return song.title_sortable().toLower();
+    case Column_Artist:       return song.artist_sortable().toLower();
+    case Column_Album:        return song.album_sortable().toLower();
+    case Column_Genre:        return song.genre().toLower();
+    case Column_AlbumArtist:  return song.playlist_albumartist_sortable().toLower();
+    case Column_Composer:     return song.composer().toLower();
+    case Column_Performer:    return song.performer().toLower();
+    case Column_Grouping:     return song.grouping().toLower();
+    case Column_Comment:      return song.comment().toLower();
+    case Column_Filename:     return item->Url().path().toLower();
+    default:                  return std::nullopt;
+  }
+
+}
+
+bool Playlist::CompareSongs(const int column, const Song &a, const Song &b) {
+
+#define cmp(field) return a.field() < b.field()
 
   switch (column) {
 
-    case Column_Title:        strcmp(title_sortable);
-    case Column_Artist:       strcmp(artist_sortable);
-    case Column_Album:        strcmp(album_sortable);
     case Column_Length:       cmp(length_nanosec);
     case Column_Track:        cmp(track);
     case Column_Disc:         cmp(disc);
     case Column_Year:         cmp(year);
     case Column_OriginalYear: cmp(originalyear);
-    case Column_Genre:        strcmp(genre);
-    case Column_AlbumArtist:  strcmp(playlist_albumartist_sortable);
-    case Column_Composer:     strcmp(composer);
-    case Column_Performer:    strcmp(performer);
-    case Column_Grouping:     strcmp(grouping);
 
     case Column_PlayCount:    cmp(playcount);
     case Column_SkipCount:    cmp(skipcount);
@@ -1317,15 +1395,12 @@ bool Playlist::CompareItems(const int column, const Qt::SortOrder order, Playlis
     case Column_Bitrate:      cmp(bitrate);
     case Column_Samplerate:   cmp(samplerate);
     case Column_Bitdepth:     cmp(bitdepth);
-    case Column_Filename:
-      return (QString::localeAwareCompare(a->Url().path().toLower(), b->Url().path().toLower()) < 0);
     case Column_BaseFilename: cmp(basefilename);
     case Column_Filesize:     cmp(filesize);
     case Column_Filetype:     cmp(filetype);
     case Column_DateModified: cmp(mtime);
     case Column_DateCreated:  cmp(ctime);
 
-    case Column_Comment:      strcmp(comment);
     case Column_Source:       cmp(source);
 
     case Column_Rating:       cmp(rating);
@@ -1339,12 +1414,61 @@ bool Playlist::CompareItems(const int column, const Qt::SortOrder order, Playlis
   }
 
 #undef cmp
-#undef strcmp
 
   return false;
 
 }
 
+void Playlist::SortItemRange(PlaylistItemPtrList::iterator begin, PlaylistItemPtrList::iterator end, const int column, const Qt::SortOrder order) {
+
+  // The metadata and the collation keys are taken once for each item, instead of in every comparison.
+  struct SortEntry {
+    PlaylistItemPtr item;
+    Song song;
+    std::optional<QCollatorSortKey> key;
+    qint64 path_depth;
+  };
+
+  QCollator collator;
+
+  std::vector<SortEntry> entries;
+  entries.reserve(static_cast<size_t>(std::distance(begin, end)));
+  for (PlaylistItemPtrList::iterator it = begin; it != end; ++it) {
+    SortEntry entry { *it, (*it)->Metadata(), std::nullopt, 0 };
+    const std::optional<QString> text = SortText(column, entry.item, entry.song);
+    if (text) entry.key = collator.sortKey(*text);
+    if (column == Column_Filename) entry.path_depth = entry.item->Url().path().count('/');
+    entries.push_back(entry);
+  }
+
+  std::stable_sort(entries.begin(), entries.end(), [column, order](const SortEntry &_a, const SortEntry &_b) {
+    const SortEntry &a = order == Qt::AscendingOrder ? _a : _b;
+    const SortEntry &b = order == Qt::AscendingOrder ? _b : _a;
+    switch (column) {
+      case Column_Album: {
+        // When sorting by album, also take into account discs and tracks.
+        const int result = a.key->compare(*b.key);
+        if (result != 0) return result < 0;
+        if (a.song.disc() != b.song.disc()) return a.song.disc() < b.song.disc();
+        return a.song.track() < b.song.track();
+      }
+      case Column_Filename:
+        // When sorting by full paths we also expect a hierarchical order. This returns a breath-first ordering of paths.
+        if (a.path_depth != b.path_depth) return a.path_depth < b.path_depth;
+        return a.key->compare(*b.key) < 0;
+      default:
+        if (a.key) return a.key->compare(*b.key) < 0;
+        return CompareSongs(column, a.song, b.song);
+    }
+  });
+
+  PlaylistItemPtrList::iterator it = begin;
+  for (const SortEntry &entry : entries) {
+    *it++ = entry.item;
+  }
+
+}
+
 bool Playlist::ComparePathDepths(const Qt::SortOrder order, PlaylistItemPtr _a, PlaylistItemPtr _b) {
 
   PlaylistItemPtr a = order == Qt::AscendingOrder ? _a : _b;
@@ -1434,20 +1558,7 @@ void Playlist::sort(int column, Qt::SortOrder order) {
   if (dynamic_playlist_ && current_item_index_.isValid())
     begin += current_item_index_.row() + 1;
 
-  if (column == Column_Album) {
-    // When sorting by album, also take into account discs and tracks.
-    std::stable_sort(begin, new_items.end(), std::bind(&Playlist::CompareItems, Column_Track, order, std::placeholders::_1, std::placeholders::_2));
-    std::stable_sort(begin, new_items.end(), std::bind(&Playlist::CompareItems, Column_Disc, order, std::placeholders::_1, std::placeholders::_2));
-    std::stable_sort(begin, new_items.end(), std::bind(&Playlist::CompareItems, Column_Album, order, std::placeholders::_1, std::placeholders::_2));
-  }
-  else if (column == Column_Filename) {
-    // When sorting by full paths we also expect a hierarchical order. This returns a breath-first ordering of paths.
-    std::stable_sort(begin, new_items.end(), std::bind(&Playlist::CompareItems, Column_Filename, order, std::placeholders::_1, std::placeholders::_2));
-    std::stable_sort(begin, new_items.end(), std::bind(&Playlist::ComparePathDepths, order, std::placeholders::_1, std::placeholders::_2));
-  }
-  else {
-    std::stable_sort(begin, new_items.end(), std::bind(&Playlist::CompareItems, column, order, std::placeholders::_1, std::placeholders::_2));
-  }
+  SortItemRange(begin, new_items.end(), column, order);
 
   undo_stack_->push(new PlaylistUndoCommands::SortItems(this, column, order, new_items));
 
@@ -1462,6 +1573,9 @@ void Playlist::ReOrderWithoutUndo(const PlaylistItemPtrList &new_items) {
   PlaylistItemPtrList old_items = items_;
   items_ = new_items;
 
+  // The rest of the rows are added after the reordered ones.
+  if (restoring_) restore_row_ = static_cast<int>(items_.count());
+
   QHash<const PlaylistItem*, int> new_rows;
   for (int i = 0; i < new_items.length(); ++i) {
     new_rows[&*new_items[i]] = i;
@@ -1513,6 +1627,12 @@ void Playlist::ScheduleSave() {
 
   if (!backend_ || is_loading_) return;
 
+  // Saving before all rows are loaded would remove the rest of the rows.
+  if (restoring_) {
+    save_after_restore_ = true;
+    return;
+  }
+
   timer_save_->start();
 
 }
@@ -1521,6 +1641,11 @@ void Playlist::Save() {
 
   if (!backend_ || is_loading_) return;
 
+  if (restoring_) {
+    save_after_restore_ = true;
+    return;
+  }
+
   backend_->SavePlaylistAsync(id_, items_, last_played_row(), dynamic_playlist_);
 
 }
@@ -1529,43 +1654,94 @@ void Playlist::Restore() {
 
   if (!backend_) return;
 
+  StartRestore();
+
+  // The first page is small, so the first rows are shown right away.
+  RestorePage(std::numeric_limits<qint64>::min(), -1, kRestoreFirstPageSize);
+
+}
+
+void Playlist::StartRestore() {
+
   items_.clear();
   virtual_items_.clear();
   collection_items_by_id_.clear();
 
   cancel_restore_ = false;
+  restoring_ = true;
+  restore_paused_ = false;
+  restore_row_ = 0;
+  restore_cue_items_.clear();
+
+}
+
+void Playlist::RestorePage(const qint64 after_position, const qint64 after_row_id, const int limit) {
+
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-  QFuture<PlaylistItemPtrList> future = QtConcurrent::run(&PlaylistBackend::GetPlaylistItems, backend_, id_);
+  QFuture<PlaylistBackend::PlaylistItemsPage> future = QtConcurrent::run(&PlaylistBackend::GetPlaylistItemsPage, backend_, id_, after_position, after_row_id, limit);
 #else
-  QFuture<PlaylistItemPtrList> future = QtConcurrent::run(&*backend_, &PlaylistBackend::GetPlaylistItems, id_);
+  QFuture<PlaylistBackend::PlaylistItemsPage> future = QtConcurrent::run(&*backend_, &PlaylistBackend::GetPlaylistItemsPage, id_, after_position, after_row_id, limit);
 #endif
-  QFutureWatcher<PlaylistItemPtrList> *watcher = new QFutureWatcher<PlaylistItemPtrList>();
-  QObject::connect(watcher, &QFutureWatcher<PlaylistItemPtrList>::finished, this, &Playlist::ItemsLoaded);
+  QFutureWatcher<PlaylistBackend::PlaylistItemsPage> *watcher = new QFutureWatcher<PlaylistBackend::PlaylistItemsPage>();
+  QObject::connect(watcher, &QFutureWatcher<PlaylistBackend::PlaylistItemsPage>::finished, this, [this, watcher]() {
+    ItemsPageLoaded(watcher->result());
+    watcher->deleteLater();
+  });
   watcher->setFuture(future);
 
 }
 
-void Playlist::ItemsLoaded() {
+void Playlist::SetRestoreDeferred(const bool deferred) {
+
+  restore_deferred_ = deferred;
+
+  if (!restore_deferred_ && restore_paused_) {
+    restore_paused_ = false;
+    RestorePage(restore_position_, restore_row_id_, kRestorePageSize);
+  }
+
+}
+
+void Playlist::ItemsPageLoaded(const PlaylistBackend::PlaylistItemsPage &page) {
 
-  QFutureWatcher<PlaylistItemPtrList> *watcher = static_cast<QFutureWatcher<PlaylistItemPtrList>*>(sender());
-  PlaylistItemPtrList items = watcher->result();
-  watcher->deleteLater();
+  if (cancel_restore_) {
+    FinishRestore();
+    emit PlaylistLoaded();
+    return;
+  }
 
-  if (cancel_restore_) return;
+  PlaylistItemPtrList items;
+  items.reserve(page.items.count());
+  for (PlaylistItemPtr item : page.items) {
+    // Backend returns empty elements for collection items which it couldn't match (because they got deleted); we don't need those
+    if (item->IsLocalCollectionItem() && item->Metadata().url().isEmpty()) continue;
+    if (item->source() == Song::Source::LocalFile && item->Metadata().has_cue()) {
+      restore_cue_items_ << item;
+    }
+    items << item;
+  }
 
-  // Backend returns empty elements for collection items which it couldn't match (because they got deleted); we don't need those
-  QMutableListIterator<PlaylistItemPtr> it(items);
-  while (it.hasNext()) {
-    PlaylistItemPtr item = it.next();
+  // Restored rows are not added to the undo stack, the user didn't add them.
+  if (!items.isEmpty()) {
+    is_loading_ = true;
+    InsertItemsWithoutUndo(items, std::min(restore_row_, static_cast<int>(items_.count())));
+    is_loading_ = false;
+    restore_row_ += static_cast<int>(items.count());
+  }
 
-    if (item->IsLocalCollectionItem() && item->Metadata().url().isEmpty()) {
-      it.remove();
+  if (!page.last_page) {
+    restore_position_ = page.last_position;
+    restore_row_id_ = page.last_row_id;
+    if (restore_deferred_) {
+      restore_paused_ = true;
     }
+    else {
+      RestorePage(restore_position_, restore_row_id_, kRestorePageSize);
+    }
+    return;
   }
 
-  is_loading_ = true;
-  InsertItems(items, 0);
-  is_loading_ = false;
+  FinishRestore();
 
   PlaylistBackend::Playlist p = backend_->GetPlaylist(id_);
 
@@ -1590,6 +1766,9 @@ void Playlist::ItemsLoaded() {
 
   emit RestoreFinished();
 
+  // The CUE sheets are read in the background, the rows are updated when they are done.
+  RestoreCueItems();
+
   QSettings s;
   s.beginGroup(kSettingsGroup);
   bool greyout = s.value("greyout_songs_startup", true).toBool();
@@ -1608,6 +1787,69 @@ void Playlist::ItemsLoaded() {
 
 }
 
+void Playlist::FinishRestore() {
+
+  restoring_ = false;
+  restore_deferred_ = false;
+  restore_paused_ = false;
+
+  if (save_after_restore_) {
+    save_after_restore_ = false;
+    ScheduleSave();
+  }
+
+}
+
+void Playlist::RestoreCueItems() {
+
+  if (restore_cue_items_.isEmpty()) return;
+
+  const PlaylistItemPtrList items = restore_cue_items_;
+  restore_cue_items_.clear();
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+  QFuture<PlaylistItemPtrList> future = QtConcurrent::run(&PlaylistBackend::RestoreCueItems, backend_, items);
+#else
+  QFuture<PlaylistItemPtrList> future = QtConcurrent::run(&*backend_, &PlaylistBackend::RestoreCueItems, items);
+#endif
+  QFutureWatcher<PlaylistItemPtrList> *watcher = new QFutureWatcher<PlaylistItemPtrList>();
+  QObject::connect(watcher, &QFutureWatcher<PlaylistItemPtrList>::finished, this, [this, watcher, items]() {
+    CueItemsRestored(items, watcher->result());
+    watcher->deleteLater();
+  });
+  watcher->setFuture(future);
+
+}
+
+void Playlist::CueItemsRestored(const PlaylistItemPtrList &items, const PlaylistItemPtrList &cue_items) {
+
+  // The rows might have moved since the items were loaded.
+  QHash<const PlaylistItem*, int> rows;
+  rows.reserve(items_.count());
+  for (int row = 0; row < items_.count(); ++row) {
+    rows.insert(&*items_[row], row);
+  }
+
+  QList<int> reload_rows;
+  for (int i = 0; i < items.count() && i < cue_items.count(); ++i) {
+    if (cue_items[i] == items[i]) continue;
+    const int row = rows.value(&*items[i], -1);
+    if (row == -1) continue;
+    if (cue_items[i]) {
+      items_[row] = cue_items[i];
+      emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+    }
+    else {
+      reload_rows << row;
+    }
+  }
+
+  if (!reload_rows.isEmpty()) {
+    ReloadItems(reload_rows);
+  }
+
+}
+
 static bool DescendingIntLessThan(int a, int b) { return a > b; }
 
 void Playlist::RemoveItemsWithoutUndo(const QList<int> &indicesIn) {
@@ -1705,6 +1947,11 @@ PlaylistItemPtrList Playlist::RemoveItemsWithoutUndo(const int row, const int co
 
   endRemoveRows();
 
+  if (restoring_) {
+    if (row + count <= restore_row_) restore_row_ -= count;
+    else if (row < restore_row_) restore_row_ = row;
+  }
+
   QList<int>::iterator it = virtual_items_.begin();
   while (it != virtual_items_.end()) {
     if (*it >= items_.count()) {
@@ -1812,6 +2059,10 @@ void Playlist::Clear() {
 
   // If loading songs from session restore async, don't insert them
   cancel_restore_ = true;
+  if (restore_paused_) {
+    FinishRestore();
+    emit PlaylistLoaded();
+  }
 
   const int count = static_cast<int>(items_.count());
 
@@ -2147,47 +2398,102 @@ void Playlist::InformOfCurrentSongChange(const AutoScroll autoscroll, const bool
 
 void Playlist::InvalidateDeletedSongs() {
 
-  QList<int> invalidated_rows;
+  // The files are checked in batches, so the rows are updated while the rest of the files are checked.
+  for (int first_row = 0; first_row < items_.count(); first_row += kFileStatusBatchSize) {
+    const int last_row = std::min(first_row + kFileStatusBatchSize, static_cast<int>(items_.count()));
 
-  for (int row = 0; row < items_.count(); ++row) {
-    PlaylistItemPtr item = items_[row];
-    Song song = item->Metadata();
+    QStringList filenames;
+    for (int row = first_row; row < last_row; ++row) {
+      const QUrl url = items_[row]->Metadata().url();
+      if (url.isLocalFile()) filenames << url.toLocalFile();
+    }
+    if (filenames.isEmpty()) continue;
 
-    if (song.url().isLocalFile()) {
-      bool exists = QFile::exists(song.url().toLocalFile());
+    const QHash<QString, bool> files_exist = FileStatusCache::Instance()->Exists(filenames);
+
+    QList<int> invalidated_rows;
+    for (int row = first_row; row < last_row && row < items_.count(); ++row) {
+      PlaylistItemPtr item = items_[row];
+      Song song = item->Metadata();
 
-      if (!exists && !item->HasForegroundColor(kInvalidSongPriority)) {
-        // gray out the song if it's not there
-        item->SetForegroundColor(kInvalidSongPriority, kInvalidSongColor);
-        invalidated_rows.append(row);  // clazy:exclude=reserve-candidates
+      if (song.url().isLocalFile()) {
+        bool exists = files_exist.value(song.url().toLocalFile(), true);
+
+        if (!exists && !item->HasForegroundColor(kInvalidSongPriority)) {
+          // gray out the song if it's not there
+          item->SetForegroundColor(kInvalidSongPriority, kInvalidSongColor);
+          invalidated_rows.append(row);  // clazy:exclude=reserve-candidates
+        }
+        else if (exists && item->HasForegroundColor(kInvalidSongPriority)) {
+          item->RemoveForegroundColor(kInvalidSongPriority);
+          invalidated_rows.append(row);  // clazy:exclude=reserve-candidates
+        }
       }
-      else if (exists && item->HasForegroundColor(kInvalidSongPriority)) {
-        item->RemoveForegroundColor(kInvalidSongPriority);
-        invalidated_rows.append(row);  // clazy:exclude=reserve-candidates
+    }
+
+    if (!invalidated_rows.isEmpty()) {
+      if (QThread::currentThread() == thread()) {
+        ReloadItems(invalidated_rows);
+      }
+      else {
+        ReloadItemsBlocking(invalidated_rows);
       }
     }
   }
 
-  if (!invalidated_rows.isEmpty()) {
-    if (QThread::currentThread() == thread()) {
-      ReloadItems(invalidated_rows);
-    }
-    else {
-      ReloadItemsBlocking(invalidated_rows);
+}
+
+PlaylistItemPtrList Playlist::DeletedSongItems(const PlaylistItemPtrList &items) {
+
+  QStringList filenames;
+  for (PlaylistItemPtr item : items) {  // clazy:exclude=range-loop-reference
+    const QUrl url = item->Metadata().url();
+    if (url.isLocalFile()) filenames << url.toLocalFile();
+  }
+
+  // The user asked for this, so don't trust what the periodic check found a while ago.
+  const QHash<QString, bool> files_exist = FileStatusCache::Instance()->Exists(filenames, true);
+
+  PlaylistItemPtrList deleted_items;
+  for (PlaylistItemPtr item : items) {  // clazy:exclude=range-loop-reference
+    const QUrl url = item->Metadata().url();
+    if (url.isLocalFile() && !files_exist.value(url.toLocalFile(), true)) {
+      deleted_items << item;
     }
   }
 
+  return deleted_items;
+
 }
 
 void Playlist::RemoveDeletedSongs() {
 
-  QList<int> rows_to_remove;
+  // Checking the files can take a while on a network share, so it's done on another thread.
+  const PlaylistItemPtrList items = items_;
+  QFuture<PlaylistItemPtrList> future = QtConcurrent::run(&Playlist::DeletedSongItems, items);
+  QFutureWatcher<PlaylistItemPtrList> *watcher = new QFutureWatcher<PlaylistItemPtrList>();
+  QObject::connect(watcher, &QFutureWatcher<PlaylistItemPtrList>::finished, this, [this, watcher]() {
+    RemoveDeletedSongItems(watcher->result());
+    watcher->deleteLater();
+  });
+  watcher->setFuture(future);
 
-  for (int row = 0; row < items_.count(); ++row) {
-    PlaylistItemPtr item = items_[row];
-    Song song = item->Metadata();
+}
+
+void Playlist::RemoveDeletedSongItems(const PlaylistItemPtrList &deleted_items) {
 
-    if (song.url().isLocalFile() && !QFile::exists(song.url().toLocalFile())) {
+  if (deleted_items.isEmpty()) return;
+
+  // The rows might have moved while the files were checked.
+  QSet<const PlaylistItem*> items;
+  items.reserve(deleted_items.count());
+  for (PlaylistItemPtr item : deleted_items) {  // clazy:exclude=range-loop-reference
+    items.insert(&*item);
+  }
+
+  QList<int> rows_to_remove;
+  for (int row = 0; row < items_.count(); ++row) {
+    if (items.contains(&*items_[row])) {
       rows_to_remove.append(row);  // clazy:exclude=reserve-candidates
     }
   }
@@ -2249,18 +2555,8 @@ void Playlist::RemoveDuplicateSongs() {
 
 void Playlist::RemoveUnavailableSongs() {
 
-  QList<int> rows_to_remove;
-  for (int row = 0; row < items_.count(); ++row) {
-    PlaylistItemPtr item = items_[row];
-    const Song &song = item->Metadata();
-
-    // Check only local files
-    if (song.url().isLocalFile() && !QFile::exists(song.url().toLocalFile())) {
-      rows_to_remove.append(row);  // clazy:exclude=reserve-candidates
-    }
-  }
-
-  removeRows(rows_to_remove);
+  // Check only local files
+  RemoveDeletedSongs();
 
 }
 
@@ -24,6 +24,8 @@
 
 #include "config.h"
 
+#include <optional>
+
 #include <QtGlobal>
 #include <QObject>
 #include <QAbstractItemModel>
@@ -46,6 +48,7 @@
 #include "core/tagreaderclient.h"
 #include "covermanager/albumcoverloaderresult.h"
 #include "playlistitem.h"
+#include "playlistbackend.h"
 #include "playlistsequence.h"
 #include "smartplaylists/playlistgenerator_fwd.h"
 #include <internet/internetservice.h>
@@ -55,7 +58,6 @@ class QUndoStack;
 class QTimer;
 
 class CollectionBackend;
-class PlaylistBackend;
 class PlaylistFilter;
 class Queue;
 class TaskManager;
@@ -166,6 +168,11 @@ class Playlist : public QAbstractListModel {
   static const int kUndoStackSize;
   static const int kUndoItemLimit;
 
+  static const int kRestoreFirstPageSize;
+  static const int kRestorePageSize;
+
+  static const int kFileStatusBatchSize;
+
   static const qint64 kMinScrobblePointNsecs;
   static const qint64 kMaxScrobblePointNsecs;
 
@@ -181,6 +188,10 @@ class Playlist : public QAbstractListModel {
   void Restore();
   void ScheduleSaveAsync();
 
+  // A deferred restore stops after the first page, until it's no longer deferred.
+  bool restore_deferred() const { return restoring_ && restore_deferred_; }
+  void SetRestoreDeferred(const bool deferred);
+
   // Accessors
   PlaylistFilter *filter() const;
   Queue *queue() const { return queue_; }
@@ -343,6 +354,11 @@ class Playlist : public QAbstractListModel {
   // Signals that the queue has changed, meaning that the remaining queued items should update their position.
   void QueueChanged();
 
+ protected:
+  // The steps of Restore(), so the paging can be tested without a backend.
+  void StartRestore();
+  void ItemsPageLoaded(const PlaylistBackend::PlaylistItemsPage &page);
+
  private:
   void SetCurrentIsPaused(const bool paused);
   int NextVirtualIndex(int i, const bool ignore_repeat_track) const;
@@ -362,10 +378,24 @@ class Playlist : public QAbstractListModel {
 
   void RemoveItemsNotInQueue();
 
+  // Items with local files that don't exist anymore, the files are checked again even if they were checked recently.
+  // Blocking, it's run on another thread.
+  static PlaylistItemPtrList DeletedSongItems(const PlaylistItemPtrList &items);
+  void RemoveDeletedSongItems(const PlaylistItemPtrList &deleted_items);
+
+  static std::optional<QString> SortText(const int column, PlaylistItemPtr item, const Song &song);
+  static bool CompareSongs(const int column, const Song &a, const Song &b);
+  static void SortItemRange(PlaylistItemPtrList::iterator begin, PlaylistItemPtrList::iterator end, const int column, const Qt::SortOrder order);
+
   // Removes rows with given indices from this playlist.
   bool removeRows(QList<int> &rows);
 
   void TurnOnDynamicPlaylist(PlaylistGeneratorPtr gen);
+
+  void RestorePage(const qint64 after_position, const qint64 after_row_id, const int limit);
+  void FinishRestore();
+  void RestoreCueItems();
+  void CueItemsRestored(const PlaylistItemPtrList &items, const PlaylistItemPtrList &cue_items);
   void InsertDynamicItems(const int count);
 
  private slots:
@@ -375,7 +405,6 @@ class Playlist : public QAbstractListModel {
   void QueueLayoutChanged();
   void SongSaveComplete(TagReaderReply *reply, const QPersistentModelIndex &idx, const Song &old_metadata);
   void ItemReloadComplete(const QPersistentModelIndex &idx, const Song &old_metadata, const bool metadata_edit);
-  void ItemsLoaded();
   void SongInsertVetoListenerDestroyed();
   void ScheduleSave();
   void Save();
@@ -427,6 +456,17 @@ class Playlist : public QAbstractListModel {
   // Cancel async restore if songs are already replaced
   bool cancel_restore_;
 
+  // The rows are restored in pages, the next page starts after the last restored row.
+  bool restoring_;
+  bool restore_deferred_;
+  bool restore_paused_;
+  bool save_after_restore_;
+  // Where the next page goes, moved along when the user inserts, removes or moves rows before it.
+  int restore_row_;
+  qint64 restore_position_;
+  qint64 restore_row_id_;
+  PlaylistItemPtrList restore_cue_items_;
+
   bool scrobbled_;
   qint64 scrobble_point_;
 
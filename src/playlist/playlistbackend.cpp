@@ -22,6 +22,7 @@
 #include "config.h"
 
 #include <memory>
+#include <algorithm>
 
 #include <QObject>
 #include <QApplication>
@@ -32,6 +33,8 @@
 #include <QFile>
 #include <QByteArray>
 #include <QList>
+#include <QVector>
+#include <QHash>
 #include <QString>
 #include <QStringList>
 #include <QUrl>
@@ -55,12 +58,25 @@
 using std::make_shared;
 
 const int PlaylistBackend::kSongTableJoins = 2;
+const qint64 PlaylistBackend::kPositionStep = 1024;
 
 PlaylistBackend::PlaylistBackend(Application *app, QObject *parent)
     : QObject(parent),
       app_(app),
       db_(app_->database()),
-      original_thread_(nullptr) {
+      original_thread_(nullptr),
+      saves_(0) {
+
+  original_thread_ = thread();
+
+}
+
+PlaylistBackend::PlaylistBackend(SharedPtr<Database> database, QObject *parent)
+    : QObject(parent),
+      app_(nullptr),
+      db_(database),
+      original_thread_(nullptr),
+      saves_(0) {
 
   original_thread_ = thread();
 
@@ -102,7 +118,6 @@ PlaylistBackend::PlaylistList PlaylistBackend::GetAllFavoritePlaylists() {
 
 PlaylistBackend::PlaylistList PlaylistBackend::GetPlaylists(const GetPlaylistsFlags flags) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   PlaylistList ret;
@@ -146,7 +161,6 @@ PlaylistBackend::PlaylistList PlaylistBackend::GetPlaylists(const GetPlaylistsFl
 
 PlaylistBackend::Playlist PlaylistBackend::GetPlaylist(const int id) {
 
-  QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
   SqlQuery q(db);
@@ -175,31 +189,62 @@ PlaylistBackend::Playlist PlaylistBackend::GetPlaylist(const int id) {
 
 }
 
-PlaylistItemPtrList PlaylistBackend::GetPlaylistItems(const int playlist) {
+PlaylistBackend::PlaylistItemsPage PlaylistBackend::GetPlaylistItemsPage(const int playlist, const qint64 after_position, const qint64 after_row_id, const int limit) {
 
-  PlaylistItemPtrList playlistitems;
+  // Remember the rows as loaded, so the first save only writes what changed.
+  if (after_row_id == -1) {
+    QMutexLocker l(&saved_items_mutex_);
+    LoadingItems loading_items;
+    loading_items.saves = saves_;
+    loading_items_.insert(playlist, loading_items);
+  }
+
+  PlaylistItemsPage page;
+  page.last_position = after_position;
+  page.last_row_id = after_row_id;
+
+  SavedItemList saved_items;
+  bool all_items_restored = true;
 
   {
 
-    QMutexLocker l(db_->Mutex());
     QSqlDatabase db(db_->Connect());
 
-    QString query = "SELECT songs.ROWID, " + Song::JoinSpec("songs") + ", p.ROWID, " + Song::JoinSpec("p") + ", p.type FROM playlist_items AS p LEFT JOIN songs ON p.collection_id = songs.ROWID WHERE p.playlist = :playlist";
+    QString query = "SELECT songs.ROWID, " + Song::JoinSpec("songs") + ", p.ROWID, " + Song::JoinSpec("p") + ", p.type, p.position FROM playlist_items AS p LEFT JOIN songs ON p.collection_id = songs.ROWID WHERE p.playlist = :playlist AND (p.position > :after_position OR (p.position = :after_position AND p.ROWID > :after_row_id)) ORDER BY p.position, p.ROWID LIMIT :limit";
     SqlQuery q(db);
     // Forward iterations only may be faster
     q.setForwardOnly(true);
     q.prepare(query);
     q.BindValue(":playlist", playlist);
+    q.BindValue(":after_position", after_position);
+    q.BindValue(":after_row_id", after_row_id);
+    q.BindValue(":limit", limit);
     if (!q.Exec()) {
       db_->ReportErrors(q);
-      return PlaylistItemPtrList();
+      QMutexLocker l(&saved_items_mutex_);
+      loading_items_.remove(playlist);
+      return page;
     }
 
-    // it's probable that we'll have a few songs associated with the same CUE, so we're caching results of parsing CUEs
-    SharedPtr<NewSongFromQueryState> state_ptr = make_shared<NewSongFromQueryState>();
+    const int rowid_column = static_cast<int>(Song::kColumns.count() + 1) * (kSongTableJoins - 1);
+    const int position_column = static_cast<int>(Song::kColumns.count() + 1) * kSongTableJoins + 1;
+    int count = 0;
     while (q.next()) {
-      playlistitems << NewPlaylistItemFromQuery(SqlRow(q), state_ptr);
+      SqlRow row(q);
+      SavedItem saved_item;
+      PlaylistItemPtr item = NewPlaylistItemFromQuery(row, nullptr, &saved_item);
+      if (saved_item.item) {
+        saved_items << saved_item;
+      }
+      else {
+        all_items_restored = false;
+      }
+      page.items << item;
+      page.last_position = row.value(position_column).toLongLong();
+      page.last_row_id = row.value(rowid_column).toLongLong();
+      ++count;
     }
+    page.last_page = count < limit;
 
   }
 
@@ -207,7 +252,36 @@ PlaylistItemPtrList PlaylistBackend::GetPlaylistItems(const int playlist) {
     Close();
   }
 
-  return playlistitems;
+  // Rows that couldn't be restored are only removed by a full rewrite, and a save while loading makes the rows outdated.
+  QMutexLocker l(&saved_items_mutex_);
+  if (loading_items_.contains(playlist)) {
+    LoadingItems &loading_items = loading_items_[playlist];
+    loading_items.saved_items << saved_items;
+    loading_items.all_items_restored = loading_items.all_items_restored && all_items_restored;
+    if (page.last_page) {
+      const LoadingItems loaded_items = loading_items_.take(playlist);
+      if (loaded_items.all_items_restored && saves_ == loaded_items.saves && !saved_items_.contains(playlist)) {
+        saved_items_.insert(playlist, loaded_items.saved_items);
+      }
+    }
+  }
+
+  return page;
+
+}
+
+PlaylistItemPtrList PlaylistBackend::RestoreCueItems(const PlaylistItemPtrList &items) {
+
+  // it's probable that we'll have a few songs associated with the same CUE, so we're caching results of parsing CUEs
+  SharedPtr<NewSongFromQueryState> state_ptr = make_shared<NewSongFromQueryState>();
+
+  PlaylistItemPtrList cue_items;
+  cue_items.reserve(items.count());
+  for (PlaylistItemPtr item : items) {
+    cue_items << CueItem(item, state_ptr);
+  }
+
+  return cue_items;
 
 }
 
@@ -216,10 +290,9 @@ SongList PlaylistBackend::GetPlaylistSongs(const int playlist) {
   SongList songs;
 
   {
-    QMutexLocker l(db_->Mutex());
     QSqlDatabase db(db_->Connect());
 
-    QString query = "SELECT songs.ROWID, " + Song::JoinSpec("songs") + ", p.ROWID, " + Song::JoinSpec("p") + ", p.type FROM playlist_items AS p LEFT JOIN songs ON p.collection_id = songs.ROWID WHERE p.playlist = :playlist";
+    QString query = "SELECT songs.ROWID, " + Song::JoinSpec("songs") + ", p.ROWID, " + Song::JoinSpec("p") + ", p.type FROM playlist_items AS p LEFT JOIN songs ON p.collection_id = songs.ROWID WHERE p.playlist = :playlist ORDER BY p.position, p.ROWID";
     SqlQuery q(db);
     // Forward iterations only may be faster
     q.setForwardOnly(true);
@@ -246,7 +319,7 @@ SongList PlaylistBackend::GetPlaylistSongs(const int playlist) {
 
 }
 
-PlaylistItemPtr PlaylistBackend::NewPlaylistItemFromQuery(const SqlRow &row, SharedPtr<NewSongFromQueryState> state) {
+PlaylistItemPtr PlaylistBackend::NewPlaylistItemFromQuery(const SqlRow &row, SharedPtr<NewSongFromQueryState> state, SavedItem *saved_item) {
 
   // The song tables get joined first, plus one each for the song ROWIDs
   const int playlist_row = static_cast<int>(Song::kColumns.count() + 1) * kSongTableJoins;
@@ -254,7 +327,13 @@ PlaylistItemPtr PlaylistBackend::NewPlaylistItemFromQuery(const SqlRow &row, Sha
   PlaylistItemPtr item(PlaylistItem::NewFromSource(static_cast<Song::Source>(row.value(playlist_row).toInt())));
   if (item) {
     item->InitFromQuery(row);
-    return RestoreCueData(item, state);
+    // Taken before the CUE data is restored, if that changes the item it's saved again.
+    if (saved_item) {
+      const int rowid_column = static_cast<int>(Song::kColumns.count() + 1) * (kSongTableJoins - 1);
+      *saved_item = MakeSavedItem(item, row.value(rowid_column).toLongLong(), row.value(playlist_row + 1).toLongLong());
+    }
+    // Without a state, the CUE data is restored later by the caller.
+    return state ? RestoreCueData(item, state) : item;
   }
   else {
     return item;
@@ -272,10 +351,22 @@ Song PlaylistBackend::NewSongFromQuery(const SqlRow &row, SharedPtr<NewSongFromQ
 
 PlaylistItemPtr PlaylistBackend::RestoreCueData(PlaylistItemPtr item, SharedPtr<NewSongFromQueryState> state) {
 
+  PlaylistItemPtr cue_item = CueItem(item, state);
+  if (!cue_item) {
+    item->Reload();
+    return item;
+  }
+
+  return cue_item;
+
+}
+
+PlaylistItemPtr PlaylistBackend::CueItem(PlaylistItemPtr item, SharedPtr<NewSongFromQueryState> state) {
+
   // We need collection to run a CueParser; also, this method applies only to file-type PlaylistItems
-  if (item->source() != Song::Source::LocalFile) return item;
+  if (!item || item->source() != Song::Source::LocalFile) return item;
 
-  CueParser cue_parser(app_->collection_backend());
+  CueParser cue_parser(app_ ? app_->collection_backend() : nullptr);
 
   Song song = item->Metadata();
   // We're only interested in .cue songs here
@@ -284,8 +375,7 @@ PlaylistItemPtr PlaylistBackend::RestoreCueData(PlaylistItemPtr item, SharedPtr<
   QString cue_path = song.cue_path();
   // If .cue was deleted - reload the song
   if (!QFile::exists(cue_path)) {
-    item->Reload();
-    return item;
+    return PlaylistItemPtr();
   }
 
   SongList song_list;
@@ -313,9 +403,7 @@ PlaylistItemPtr PlaylistBackend::RestoreCueData(PlaylistItemPtr item, SharedPtr<
   }
 
   // There's no such section in the related .cue -> reload the song
-  item->Reload();
-
-  return item;
+  return PlaylistItemPtr();
 
 }
 
@@ -332,30 +420,28 @@ void PlaylistBackend::SavePlaylist(int playlist, const PlaylistItemPtrList &item
 
   qLog(Debug) << "Saving playlist" << playlist;
 
-  ScopedTransaction transaction(&db);
-
-  // Clear the existing items in the playlist
+  // Take out the rows from the last save, if this save fails the next one rewrites the playlist.
+  bool have_old_saved_items = false;
+  SavedItemList old_saved_items;
   {
-    SqlQuery q(db);
-    q.prepare("DELETE FROM playlist_items WHERE playlist = :playlist");
-    q.BindValue(":playlist", playlist);
-    if (!q.Exec()) {
-      db_->ReportErrors(q);
-      return;
+    QMutexLocker saved_items_locker(&saved_items_mutex_);
+    ++saves_;
+    if (saved_items_.contains(playlist)) {
+      old_saved_items = saved_items_.take(playlist);
+      have_old_saved_items = true;
     }
   }
 
-  // Save the new ones
-  for (PlaylistItemPtr item : items) {  // clazy:exclude=range-loop-reference
-    SqlQuery q(db);
-    q.prepare("INSERT INTO playlist_items (playlist, type, collection_id, " + Song::kColumnSpec + ") VALUES (:playlist, :type, :collection_id, " + Song::kBindSpec + ")");
-    q.BindValue(":playlist", playlist);
-    item->BindToQuery(&q);
+  ScopedTransaction transaction(&db);
 
-    if (!q.Exec()) {
-      db_->ReportErrors(q);
-      return;
-    }
+  SavedItemList saved_items;
+  QList<int> old_indexes;
+  QList<qint64> positions;
+  if (have_old_saved_items && PlanPlaylistUpdate(items, old_saved_items, &old_indexes, &positions)) {
+    if (!UpdatePlaylistItems(db, playlist, items, old_saved_items, old_indexes, positions, &saved_items)) return;
+  }
+  else {
+    if (!RewritePlaylistItems(db, playlist, items, &saved_items)) return;
   }
 
   // Update the last played track number
@@ -382,6 +468,245 @@ void PlaylistBackend::SavePlaylist(int playlist, const PlaylistItemPtrList &item
 
   transaction.Commit();
 
+  QMutexLocker saved_items_locker(&saved_items_mutex_);
+  saved_items_.insert(playlist, saved_items);
+
+}
+
+PlaylistBackend::SavedItem PlaylistBackend::MakeSavedItem(PlaylistItemPtr item, const qint64 row_id, const qint64 position) {
+
+  SavedItem saved_item;
+  saved_item.item = item;
+  saved_item.row_id = row_id;
+  saved_item.position = position;
+  saved_item.type = item->source();
+  saved_item.collection_id = item->DatabaseCollectionId();
+  saved_item.metadata = item->DatabaseMetadata();
+
+  return saved_item;
+
+}
+
+bool PlaylistBackend::IsSavedItemEqual(const SavedItem &saved_item1, const SavedItem &saved_item2) {
+
+  // Changing the metadata of an item detaches its song from the saved copy, so comparing the data pointers is enough.
+  return saved_item1.type == saved_item2.type &&
+         saved_item1.collection_id == saved_item2.collection_id &&
+         saved_item1.metadata.IsSameData(saved_item2.metadata);
+
+}
+
+// Works out which rows to delete, insert, move or update to get from the saved rows to the items.
+// Returns false if rewriting the whole playlist is cheaper, or if there's no room left between positions.
+
+bool PlaylistBackend::PlanPlaylistUpdate(const PlaylistItemPtrList &items, const SavedItemList &old_saved_items, QList<int> *old_indexes, QList<qint64> *positions) {
+
+  QHash<const PlaylistItem*, int> old_index_by_item;
+  old_index_by_item.reserve(old_saved_items.count());
+  for (int i = 0; i < old_saved_items.count(); ++i) {
+    old_index_by_item.insert(old_saved_items[i].item.get(), i);
+  }
+
+  // Map each item to its saved row, an item that is in the playlist twice only keeps the row once.
+  old_indexes->clear();
+  old_indexes->reserve(items.count());
+  for (const PlaylistItemPtr &item : items) {
+    QHash<const PlaylistItem*, int>::iterator it = old_index_by_item.find(item.get());
+    if (it == old_index_by_item.end()) {
+      old_indexes->append(-1);
+    }
+    else {
+      old_indexes->append(it.value());
+      old_index_by_item.erase(it);
+    }
+  }
+  const int removed = static_cast<int>(old_index_by_item.count());
+
+  // The longest run of saved rows still in the same order stays where it is, the other rows are moved.
+  // Patience sorting: tails[l] is the index into items of the smallest tail of an increasing run of length l + 1.
+  QList<int> tails;
+  QVector<int> previous(items.count(), -1);
+  for (int i = 0; i < items.count(); ++i) {
+    const int old_index = old_indexes->value(i, -1);
+    if (old_index == -1) continue;
+    const QList<int>::const_iterator it = std::lower_bound(tails.constBegin(), tails.constEnd(), old_index, [old_indexes](const int tail, const int value) { return old_indexes->at(tail) < value; });
+    const int length = static_cast<int>(it - tails.constBegin());
+    if (length > 0) previous[i] = tails[length - 1];
+    if (length == tails.count()) {
+      tails << i;
+    }
+    else {
+      tails[length] = i;
+    }
+  }
+  QVector<bool> anchored(items.count(), false);
+  for (int i = tails.isEmpty() ? -1 : tails.last(); i != -1; i = previous[i]) {
+    anchored[i] = true;
+  }
+
+  int changes = removed;
+  for (int i = 0; i < items.count(); ++i) {
+    const int old_index = old_indexes->at(i);
+    if (!anchored[i]) {
+      ++changes;
+      continue;
+    }
+    const SavedItem &old_saved_item = old_saved_items[old_index];
+    if (!IsSavedItemEqual(old_saved_item, MakeSavedItem(items[i], old_saved_item.row_id, old_saved_item.position))) ++changes;
+  }
+  if (changes > items.count() / 2) return false;
+
+  // Spread the rows that are moved or inserted evenly between the positions of the anchored rows around them.
+  positions->clear();
+  positions->reserve(items.count());
+  int i = 0;
+  qint64 lower = 0;
+  bool have_lower = false;
+  while (i < items.count()) {
+    if (anchored[i]) {
+      lower = old_saved_items[old_indexes->at(i)].position;
+      have_lower = true;
+      positions->append(lower);
+      ++i;
+      continue;
+    }
+    int end = i;
+    while (end < items.count() && !anchored[end]) ++end;
+    const qint64 count = end - i;
+    const bool have_upper = end < items.count();
+    const qint64 upper = have_upper ? old_saved_items[old_indexes->at(end)].position : 0;
+    if (have_lower && have_upper && upper - lower <= count) return false;
+    for (qint64 j = 0; j < count; ++j) {
+      if (have_lower && have_upper) {
+        positions->append(lower + (upper - lower) * (j + 1) / (count + 1));
+      }
+      else if (have_upper) {
+        positions->append(upper - kPositionStep * (count - j));
+      }
+      else {
+        positions->append(lower + kPositionStep * (j + 1));
+      }
+    }
+    i = end;
+  }
+
+  return true;
+
+}
+
+bool PlaylistBackend::UpdatePlaylistItems(QSqlDatabase &db, const int playlist, const PlaylistItemPtrList &items, const SavedItemList &old_saved_items, const QList<int> &old_indexes, const QList<qint64> &positions, SavedItemList *saved_items) {
+
+  SqlQuery q_delete(db);
+  q_delete.prepare("DELETE FROM playlist_items WHERE ROWID = :id");
+  SqlQuery q_move(db);
+  q_move.prepare("UPDATE playlist_items SET position = :position WHERE ROWID = :id");
+  SqlQuery q_update(db);
+  q_update.prepare("UPDATE playlist_items SET type = :type, collection_id = :collection_id, " + Song::kUpdateSpec + " WHERE ROWID = :id");
+  SqlQuery q_insert(db);
+  q_insert.prepare("INSERT INTO playlist_items (playlist, type, collection_id, position, " + Song::kColumnSpec + ") VALUES (:playlist, :type, :collection_id, :position, " + Song::kBindSpec + ")");
+
+  QVector<bool> kept(old_saved_items.count(), false);
+  for (const int old_index : old_indexes) {
+    if (old_index != -1) kept[old_index] = true;
+  }
+  for (int i = 0; i < old_saved_items.count(); ++i) {
+    if (kept[i]) continue;
+    q_delete.BindValue(":id", old_saved_items[i].row_id);
+    if (!q_delete.Exec()) {
+      db_->ReportErrors(q_delete);
+      return false;
+    }
+  }
+
+  int moved = 0;
+  int updated = 0;
+  int inserted = 0;
+  saved_items->reserve(items.count());
+  for (int i = 0; i < items.count(); ++i) {
+    PlaylistItemPtr item = items[i];
+    const int old_index = old_indexes[i];
+    const qint64 position = positions[i];
+
+    // Take the saved state before binding, if the item changes in between it's just saved again next time.
+    if (old_index == -1) {
+      SavedItem saved_item = MakeSavedItem(item, -1, position);
+      q_insert.BindValue(":playlist", playlist);
+      q_insert.BindValue(":position", position);
+      item->BindToQuery(&q_insert);
+      if (!q_insert.Exec()) {
+        db_->ReportErrors(q_insert);
+        return false;
+      }
+      saved_item.row_id = q_insert.lastInsertId().toLongLong();
+      saved_items->append(saved_item);
+      ++inserted;
+      continue;
+    }
+
+    const SavedItem &old_saved_item = old_saved_items[old_index];
+    const SavedItem saved_item = MakeSavedItem(item, old_saved_item.row_id, position);
+    if (position != old_saved_item.position) {
+      q_move.BindValue(":position", position);
+      q_move.BindValue(":id", old_saved_item.row_id);
+      if (!q_move.Exec()) {
+        db_->ReportErrors(q_move);
+        return false;
+      }
+      ++moved;
+    }
+    if (!IsSavedItemEqual(old_saved_item, saved_item)) {
+      item->BindToQuery(&q_update);
+      q_update.BindValue(":id", old_saved_item.row_id);
+      if (!q_update.Exec()) {
+        db_->ReportErrors(q_update);
+        return false;
+      }
+      ++updated;
+    }
+    saved_items->append(saved_item);
+  }
+
+  qLog(Debug) << "Playlist" << playlist << "saved:" << inserted << "inserted," << old_saved_items.count() - (items.count() - inserted) << "removed," << moved << "moved," << updated << "updated";
+
+  return true;
+
+}
+
+bool PlaylistBackend::RewritePlaylistItems(QSqlDatabase &db, const int playlist, const PlaylistItemPtrList &items, SavedItemList *saved_items) {
+
+  // Clear the existing items in the playlist
+  {
+    SqlQuery q(db);
+    q.prepare("DELETE FROM playlist_items WHERE playlist = :playlist");
+    q.BindValue(":playlist", playlist);
+    if (!q.Exec()) {
+      db_->ReportErrors(q);
+      return false;
+    }
+  }
+
+  // Save the new ones
+  SqlQuery q(db);
+  q.prepare("INSERT INTO playlist_items (playlist, type, collection_id, position, " + Song::kColumnSpec + ") VALUES (:playlist, :type, :collection_id, :position, " + Song::kBindSpec + ")");
+  saved_items->reserve(items.count());
+  qint64 position = 0;
+  for (PlaylistItemPtr item : items) {  // clazy:exclude=range-loop-reference
+    position += kPositionStep;
+    SavedItem saved_item = MakeSavedItem(item, -1, position);
+    q.BindValue(":playlist", playlist);
+    q.BindValue(":position", position);
+    item->BindToQuery(&q);
+
+    if (!q.Exec()) {
+      db_->ReportErrors(q);
+      return false;
+    }
+    saved_item.row_id = q.lastInsertId().toLongLong();
+    saved_items->append(saved_item);
+  }
+
+  return true;
+
 }
 
 int PlaylistBackend::CreatePlaylist(const QString &name, const QString &special_type) {
@@ -407,6 +732,12 @@ void PlaylistBackend::RemovePlaylist(int id) {
   QMutexLocker l(db_->Mutex());
   QSqlDatabase db(db_->Connect());
 
+  {
+    QMutexLocker saved_items_locker(&saved_items_mutex_);
+    ++saves_;
+    saved_items_.remove(id);
+  }
+
   ScopedTransaction transaction(&db);
 
   {
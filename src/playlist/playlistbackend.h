@@ -30,6 +30,7 @@
 #include <QList>
 #include <QSet>
 #include <QString>
+#include <QVariant>
 #include <QSqlQuery>
 
 #include "core/shared_ptr.h"
@@ -48,6 +49,8 @@ class PlaylistBackend : public QObject {
 
  public:
   Q_INVOKABLE explicit PlaylistBackend(Application *app, QObject *parent = nullptr);
+  // Without the application, songs in CUE sheets are not looked up in the collection.
+  explicit PlaylistBackend(SharedPtr<Database> database, QObject *parent = nullptr);
 
   struct Playlist {
     Playlist() : id(-1), favorite(false), last_played(0) {}
@@ -64,7 +67,17 @@ class PlaylistBackend : public QObject {
   };
   using PlaylistList = QList<Playlist>;
 
+  struct PlaylistItemsPage {
+    PlaylistItemsPage() : last_position(0), last_row_id(-1), last_page(true) {}
+    PlaylistItemPtrList items;
+    // The next page starts after this row.
+    qint64 last_position;
+    qint64 last_row_id;
+    bool last_page;
+  };
+
   static const int kSongTableJoins;
+  static const qint64 kPositionStep;
 
   void Close();
   void ExitAsync();
@@ -74,7 +87,11 @@ class PlaylistBackend : public QObject {
   PlaylistList GetAllFavoritePlaylists();
   PlaylistBackend::Playlist GetPlaylist(const int id);
 
-  PlaylistItemPtrList GetPlaylistItems(const int playlist);
+  // Loads the items ordered by position, starting after the given row, or from the first row if after_row_id is -1.
+  // The CUE data is not restored, call RestoreCueItems() for the items with a CUE sheet afterwards.
+  PlaylistItemsPage GetPlaylistItemsPage(const int playlist, const qint64 after_position, const qint64 after_row_id, const int limit);
+  // Returns the items with the metadata from their CUE sheets, or nullptr for items that have to be reloaded from the file.
+  PlaylistItemPtrList RestoreCueItems(const PlaylistItemPtrList &items);
   SongList GetPlaylistSongs(const int playlist);
 
   void SetPlaylistOrder(const QList<int> &ids);
@@ -101,9 +118,30 @@ class PlaylistBackend : public QObject {
     QMutex mutex_;
   };
 
+  // An item as it was last written to playlist_items, so the next save only writes what changed.
+  struct SavedItem {
+    SavedItem() : row_id(-1), position(0), type(Song::Source::Unknown) {}
+    PlaylistItemPtr item;  // Also keeps the item alive, so a new item can't get the same address.
+    qint64 row_id;
+    qint64 position;
+    Song::Source type;
+    QVariant collection_id;
+    Song metadata;
+  };
+  using SavedItemList = QList<SavedItem>;
+
+  // Rows of a playlist being loaded in pages.
+  struct LoadingItems {
+    LoadingItems() : saves(0), all_items_restored(true) {}
+    quint64 saves;
+    SavedItemList saved_items;
+    bool all_items_restored;
+  };
+
   Song NewSongFromQuery(const SqlRow &row, SharedPtr<NewSongFromQueryState> state);
-  PlaylistItemPtr NewPlaylistItemFromQuery(const SqlRow &row, SharedPtr<NewSongFromQueryState> state);
+  PlaylistItemPtr NewPlaylistItemFromQuery(const SqlRow &row, SharedPtr<NewSongFromQueryState> state, SavedItem *saved_item = nullptr);
   PlaylistItemPtr RestoreCueData(PlaylistItemPtr item, SharedPtr<NewSongFromQueryState> state);
+  PlaylistItemPtr CueItem(PlaylistItemPtr item, SharedPtr<NewSongFromQueryState> state);
 
   enum GetPlaylistsFlags {
     GetPlaylists_OpenInUi = 1,
@@ -112,9 +150,21 @@ class PlaylistBackend : public QObject {
   };
   PlaylistList GetPlaylists(const GetPlaylistsFlags flags);
 
+  static SavedItem MakeSavedItem(PlaylistItemPtr item, const qint64 row_id, const qint64 position);
+  static bool IsSavedItemEqual(const SavedItem &saved_item1, const SavedItem &saved_item2);
+  static bool PlanPlaylistUpdate(const PlaylistItemPtrList &items, const SavedItemList &old_saved_items, QList<int> *old_indexes, QList<qint64> *positions);
+  bool UpdatePlaylistItems(QSqlDatabase &db, const int playlist, const PlaylistItemPtrList &items, const SavedItemList &old_saved_items, const QList<int> &old_indexes, const QList<qint64> &positions, SavedItemList *saved_items);
+  bool RewritePlaylistItems(QSqlDatabase &db, const int playlist, const PlaylistItemPtrList &items, SavedItemList *saved_items);
+
   Application *app_;
   SharedPtr<Database> db_;
   QThread *original_thread_;
+
+  // Rows of each playlist as they were last loaded or saved.
+  QMutex saved_items_mutex_;
+  QHash<int, SavedItemList> saved_items_;
+  QHash<int, LoadingItems> loading_items_;
+  quint64 saves_;
 };
 
 #endif  // PLAYLISTBACKEND_H
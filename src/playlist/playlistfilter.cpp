@@ -21,7 +21,11 @@
 
 #include "config.h"
 
+#include <utility>
+
 #include <QObject>
+#include <QList>
+#include <QMetaObject>
 #include <QString>
 #include <QAbstractItemModel>
 #include <QSortFilterProxyModel>
@@ -29,11 +33,13 @@
 #include "playlist/playlist.h"
 #include "playlistfilter.h"
 #include "playlistfilterparser.h"
+#include "playlistfilterindex.h"
 
 PlaylistFilter::PlaylistFilter(QObject *parent)
     : QSortFilterProxyModel(parent),
       filter_tree_(new NopFilter),
-      query_hash_(0) {
+      query_hash_(0),
+      index_(new PlaylistFilterIndex) {
 
   setDynamicSortFilter(true);
 
@@ -75,6 +81,30 @@ PlaylistFilter::PlaylistFilter(QObject *parent)
 
 PlaylistFilter::~PlaylistFilter() = default;
 
+void PlaylistFilter::setSourceModel(QAbstractItemModel *source_model) {
+
+  for (const QMetaObject::Connection &connection : std::as_const(source_model_connections_)) {
+    QObject::disconnect(connection);
+  }
+  source_model_connections_.clear();
+
+  index_->Clear();
+  index_->set_model(source_model);
+
+  // Connected before QSortFilterProxyModel connects, so the index is updated before the rows are filtered again.
+  if (source_model) {
+    source_model_connections_ << QObject::connect(source_model, &QAbstractItemModel::rowsInserted, this, [this](const QModelIndex&, const int first, const int last) { index_->RowsInserted(first, last); });
+    source_model_connections_ << QObject::connect(source_model, &QAbstractItemModel::rowsRemoved, this, [this](const QModelIndex&, const int first, const int last) { index_->RowsRemoved(first, last); });
+    source_model_connections_ << QObject::connect(source_model, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex &top_left, const QModelIndex &bottom_right) { index_->RowsChanged(top_left.row(), bottom_right.row()); });
+    source_model_connections_ << QObject::connect(source_model, &QAbstractItemModel::rowsMoved, this, [this]() { index_->Clear(); });
+    source_model_connections_ << QObject::connect(source_model, &QAbstractItemModel::layoutChanged, this, [this]() { index_->Clear(); });
+    source_model_connections_ << QObject::connect(source_model, &QAbstractItemModel::modelReset, this, [this]() { index_->Clear(); });
+  }
+
+  QSortFilterProxyModel::setSourceModel(source_model);
+
+}
+
 void PlaylistFilter::sort(int column, Qt::SortOrder order) {
   // Pass this through to the Playlist, it does sorting itself
   sourceModel()->sort(column, order);
@@ -82,6 +112,8 @@ void PlaylistFilter::sort(int column, Qt::SortOrder order) {
 
 bool PlaylistFilter::filterAcceptsRow(int row, const QModelIndex &parent) const {
 
+  Q_UNUSED(parent);
+
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
   size_t hash = qHash(filter_text_);
 #else
@@ -96,7 +128,7 @@ bool PlaylistFilter::filterAcceptsRow(int row, const QModelIndex &parent) const
   }
 
   // Test the row
-  return filter_tree_->accept(row, parent, sourceModel());
+  return filter_tree_->accept(row, &*index_);
 
 }
 
@@ -26,13 +26,18 @@
 
 #include <QtGlobal>
 #include <QObject>
+#include <QList>
 #include <QMap>
 #include <QSet>
 #include <QScopedPointer>
 #include <QString>
 #include <QSortFilterProxyModel>
 
+#include "core/scoped_ptr.h"
+
+class QAbstractItemModel;
 class FilterTree;
+class PlaylistFilterIndex;
 
 class PlaylistFilter : public QSortFilterProxyModel {
   Q_OBJECT
@@ -41,6 +46,9 @@ class PlaylistFilter : public QSortFilterProxyModel {
   explicit PlaylistFilter(QObject *parent = nullptr);
   ~PlaylistFilter() override;
 
+  // QAbstractProxyModel
+  void setSourceModel(QAbstractItemModel *source_model) override;
+
   // QAbstractItemModel
   void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
 
@@ -62,6 +70,9 @@ class PlaylistFilter : public QSortFilterProxyModel {
   mutable uint query_hash_;
 #endif
 
+  ScopedPtr<PlaylistFilterIndex> index_;
+  QList<QMetaObject::Connection> source_model_connections_;
+
   QMap<QString, int> column_names_;
   QSet<int> numerical_columns_;
   QString filter_text_;
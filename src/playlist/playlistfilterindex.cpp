@@ -0,0 +1,91 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <optional>
+
+#include <QtGlobal>
+#include <QHash>
+#include <QVector>
+#include <QString>
+#include <QVariant>
+#include <QAbstractItemModel>
+
+#include "playlistfilterindex.h"
+
+PlaylistFilterIndex::PlaylistFilterIndex() : model_(nullptr) {}
+
+QString PlaylistFilterIndex::Value(const int row, const int column) const {
+
+  QVector<std::optional<QString>> &values = columns_[column];
+  if (values.count() != model_->rowCount()) {
+    // First time this column is used.
+    values.clear();
+    values.resize(model_->rowCount());
+  }
+
+  std::optional<QString> &value = values[row];
+  if (!value) {
+    value = model_->index(row, column).data().toString().toLower();
+  }
+
+  return *value;
+
+}
+
+void PlaylistFilterIndex::RowsInserted(const int first, const int last) {
+
+  for (QVector<std::optional<QString>> &values : columns_) {
+    if (first > values.count()) {
+      values.clear();
+      continue;
+    }
+    values.insert(first, last - first + 1, std::nullopt);
+  }
+
+}
+
+void PlaylistFilterIndex::RowsRemoved(const int first, const int last) {
+
+  for (QVector<std::optional<QString>> &values : columns_) {
+    if (last >= values.count()) {
+      values.clear();
+      continue;
+    }
+    values.remove(first, last - first + 1);
+  }
+
+}
+
+void PlaylistFilterIndex::RowsChanged(const int first, const int last) {
+
+  for (QVector<std::optional<QString>> &values : columns_) {
+    for (int row = first; row <= last && row < values.count(); ++row) {
+      values[row].reset();
+    }
+  }
+
+}
+
+void PlaylistFilterIndex::Clear() {
+
+  columns_.clear();
+
+}
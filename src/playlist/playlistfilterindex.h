@@ -0,0 +1,57 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PLAYLISTFILTERINDEX_H
+#define PLAYLISTFILTERINDEX_H
+
+#include "config.h"
+
+#include <optional>
+
+#include <QtGlobal>
+#include <QHash>
+#include <QVector>
+#include <QString>
+
+class QAbstractItemModel;
+
+// Holds the lowercase display text of the playlist columns the filter looks at, one vector for each column.
+// The text is taken from the model the first time a row is filtered, so changing the filter text doesn't go through Playlist::data() for every row again.
+// The owner has to keep it in sync with the rows of the model, before the rows are filtered.
+class PlaylistFilterIndex {
+ public:
+  PlaylistFilterIndex();
+
+  void set_model(const QAbstractItemModel *model) { model_ = model; }
+
+  QString Value(const int row, const int column) const;
+
+  void RowsInserted(const int first, const int last);
+  void RowsRemoved(const int first, const int last);
+  void RowsChanged(const int first, const int last);
+  void Clear();
+
+ private:
+  const QAbstractItemModel *model_;
+  mutable QHash<int, QVector<std::optional<QString>>> columns_;
+
+  Q_DISABLE_COPY(PlaylistFilterIndex)
+};
+
+#endif  // PLAYLISTFILTERINDEX_H
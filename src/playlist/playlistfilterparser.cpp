@@ -30,10 +30,10 @@
 #include <QScopedPointer>
 #include <QString>
 #include <QtAlgorithms>
-#include <QAbstractItemModel>
 
 #include "playlist.h"
 #include "playlistfilterparser.h"
+#include "playlistfilterindex.h"
 #include "utilities/searchparserutils.h"
 
 class SearchTermComparator {
@@ -253,10 +253,9 @@ class FilterTerm : public FilterTree {
  public:
   explicit FilterTerm(SearchTermComparator *comparator, const QList<int> &columns) : cmp_(comparator), columns_(columns) {}
 
-  bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const override {
+  bool accept(const int row, const PlaylistFilterIndex *const index) const override {
     for (int i : columns_) {
-      QModelIndex idx(model->index(row, i, parent));
-      if (cmp_->Matches(idx.data().toString().toLower())) return true;
+      if (cmp_->Matches(index->Value(row, i))) return true;
     }
     return false;
   }
@@ -271,9 +270,8 @@ class FilterColumnTerm : public FilterTree {
  public:
   FilterColumnTerm(const int column, SearchTermComparator *comparator) : col(column), cmp_(comparator) {}
 
-  bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const override {
-    QModelIndex idx(model->index(row, col, parent));
-    return cmp_->Matches(idx.data().toString().toLower());
+  bool accept(const int row, const PlaylistFilterIndex *const index) const override {
+    return cmp_->Matches(index->Value(row, col));
   }
   FilterType type() override { return FilterType::Column; }
  private:
@@ -285,8 +283,8 @@ class NotFilter : public FilterTree {
  public:
   explicit NotFilter(const FilterTree *inv) : child_(inv) {}
 
-  bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const override {
-    return !child_->accept(row, parent, model);
+  bool accept(const int row, const PlaylistFilterIndex *const index) const override {
+    return !child_->accept(row, index);
   }
   FilterType type() override { return FilterType::Not; }
  private:
@@ -297,8 +295,8 @@ class OrFilter : public FilterTree {
  public:
   ~OrFilter() override { qDeleteAll(children_); }
   virtual void add(FilterTree *child) { children_.append(child); }
-  bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const override {
-    return std::any_of(children_.begin(), children_.end(), [row, parent, model](FilterTree *child) { return child->accept(row, parent, model); });
+  bool accept(const int row, const PlaylistFilterIndex *const index) const override {
+    return std::any_of(children_.begin(), children_.end(), [row, index](FilterTree *child) { return child->accept(row, index); });
   }
   FilterType type() override { return FilterType::Or; }
  private:
@@ -309,8 +307,8 @@ class AndFilter : public FilterTree {
  public:
   ~AndFilter() override { qDeleteAll(children_); }
   virtual void add(FilterTree *child) { children_.append(child); }
-  bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const override {
-    return !std::any_of(children_.begin(), children_.end(), [row, parent, model](FilterTree *child) { return !child->accept(row, parent, model); });
+  bool accept(const int row, const PlaylistFilterIndex *const index) const override {
+    return !std::any_of(children_.begin(), children_.end(), [row, index](FilterTree *child) { return !child->accept(row, index); });
   }
   FilterType type() override { return FilterType::And; }
  private:
@@ -27,15 +27,14 @@
 #include <QMap>
 #include <QString>
 
-class QAbstractItemModel;
-class QModelIndex;
+class PlaylistFilterIndex;
 
 // Structure for filter parse tree
 class FilterTree {
  public:
   FilterTree() = default;
   virtual ~FilterTree() {}
-  virtual bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const = 0;
+  virtual bool accept(const int row, const PlaylistFilterIndex *const index) const = 0;
   enum class FilterType {
     Nop = 0,
     Or,
@@ -52,7 +51,7 @@ class FilterTree {
 // Trivial filter that accepts *anything*
 class NopFilter : public FilterTree {
  public:
-  bool accept(int row, const QModelIndex &parent, const QAbstractItemModel *const model) const override { Q_UNUSED(row); Q_UNUSED(parent); Q_UNUSED(model); return true; }
+  bool accept(const int row, const PlaylistFilterIndex *const index) const override { Q_UNUSED(row); Q_UNUSED(index); return true; }
   FilterType type() override { return FilterType::Nop; }
 };
 
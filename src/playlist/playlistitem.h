@@ -73,6 +73,9 @@ class PlaylistItem : public enable_shared_from_this<PlaylistItem> {
 
   virtual bool InitFromQuery(const SqlRow &query) = 0;
   void BindToQuery(SqlQuery *query) const;
+  // The values BindToQuery() writes, to tell whether the item changed since it was saved.
+  QVariant DatabaseCollectionId() const { return DatabaseValue(Column_CollectionId); }
+  Song DatabaseMetadata() const { return DatabaseSongMetadata(); }
   virtual void Reload() {}
   QFuture<void> BackgroundReload();
 
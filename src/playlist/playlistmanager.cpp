@@ -108,6 +108,13 @@ void PlaylistManager::Init(SharedPtr<CollectionBackend> collection_backend, Shar
   // If no playlist exists then make a new one
   if (playlists_.isEmpty()) New(tr("Playlist"));
 
+  // Only the current playlist is restored right away, the others show their first rows and continue one at a time.
+  for (const Data &data : std::as_const(playlists_)) {
+    if (data.p->id() != current_) {
+      data.p->SetRestoreDeferred(true);
+    }
+  }
+
   emit PlaylistManagerInitialized();
 
 }
@@ -122,6 +129,13 @@ void PlaylistManager::PlaylistLoaded() {
     emit AllPlaylistsLoaded();
   }
 
+  for (const Data &data : std::as_const(playlists_)) {
+    if (data.p->restore_deferred()) {
+      data.p->SetRestoreDeferred(false);
+      break;
+    }
+  }
+
 }
 
 QList<Playlist*> PlaylistManager::GetAllPlaylists() const {
@@ -365,6 +379,7 @@ void PlaylistManager::SetCurrentPlaylist(const int id) {
   }
 
   current_ = id;
+  playlists_[id].p->SetRestoreDeferred(false);
   emit CurrentChanged(current(), playlists_[id].scroll_position);
   UpdateSummaryText();
 
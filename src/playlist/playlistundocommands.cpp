@@ -22,6 +22,7 @@
 
 #include <QtGlobal>
 #include <QList>
+#include <QHash>
 #include <QUndoStack>
 
 #include "playlist.h"
@@ -52,15 +53,14 @@ void InsertItems::undo() {
   playlist_->RemoveItemsWithoutUndo(start, static_cast<int>(items_.count()));
 }
 
-bool InsertItems::UpdateItem(const PlaylistItemPtr &updated_item) {
-  for (int i = 0; i < items_.size(); i++) {
-    PlaylistItemPtr item = items_[i];
-    if (item->Metadata().url() == updated_item->Metadata().url()) {
-      items_[i] = updated_item;
-      return true;
+void InsertItems::UpdateItems(QHash<const PlaylistItem*, PlaylistItemPtr> *updated_items) {
+  for (int i = 0; i < items_.size() && !updated_items->isEmpty(); i++) {
+    QHash<const PlaylistItem*, PlaylistItemPtr>::iterator it = updated_items->find(&*items_[i]);
+    if (it != updated_items->end()) {
+      items_[i] = it.value();
+      updated_items->erase(it);
     }
   }
-  return false;
 }
 
 
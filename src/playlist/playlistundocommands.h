@@ -25,6 +25,7 @@
 
 #include <QCoreApplication>
 #include <QList>
+#include <QHash>
 #include <QUndoStack>
 
 #include "playlistitem.h"
@@ -54,9 +55,9 @@ namespace PlaylistUndoCommands {
     void undo() override;
     void redo() override;
     // When load is async, items have already been pushed, so we need to update them.
-    // This function try to find the equivalent item, and replace it with the new (completely loaded) one.
-    // Return true if the was found (and updated), false otherwise
-    bool UpdateItem(const PlaylistItemPtr &updated_item);
+    // This function replaces the items found in updated_items, keyed by the old item, with the new (completely loaded) ones.
+    // Items that were found are removed from updated_items.
+    void UpdateItems(QHash<const PlaylistItem*, PlaylistItemPtr> *updated_items);
 
    private:
     PlaylistItemPtrList items_;
@@ -21,6 +21,8 @@
 
 #include "config.h"
 
+#include <utility>
+
 #include <QtConcurrent>
 #include <QtAlgorithms>
 #include <QList>
@@ -56,7 +58,7 @@ void SongLoaderInserter::Load(Playlist *destination, int row, bool play_now, boo
 
   QObject::connect(destination, &Playlist::destroyed, this, &SongLoaderInserter::DestinationDestroyed);
   QObject::connect(this, &SongLoaderInserter::PreloadFinished, this, &SongLoaderInserter::InsertSongs);
-  QObject::connect(this, &SongLoaderInserter::EffectiveLoadFinished, destination, &Playlist::UpdateItems);
+  QObject::connect(this, &SongLoaderInserter::SongsLoaded, destination, &Playlist::UpdateItems);
 
   for (const QUrl &url : urls) {
     SongLoader *loader = new SongLoader(collection_backend_, player_, this);
@@ -186,7 +188,7 @@ void SongLoaderInserter::AsyncLoad() {
     if (!first_loaded) {
       // Load everything from the first song.
       // It'll start playing as soon as we emit PreloadFinished, so it needs to have the duration set to show properly in the UI.
-      loader->LoadMetadataBlocking();
+      loader->LoadFirstSongMetadataBlocking();
       first_loaded = true;
     }
 
@@ -197,24 +199,24 @@ void SongLoaderInserter::AsyncLoad() {
   emit PreloadFinished();
 
   // Songs are inserted in playlist, now load them completely.
-  async_progress = 0;
+  // The partially-loaded items are replaced by the fully loaded ones in batches, as soon as each batch is loaded.
   async_load_id = task_manager_->StartTask(tr("Loading tracks info"));
-  task_manager_->SetTaskProgress(async_load_id, async_progress, songs_.count());
-  SongList songs;
-  for (int i = 0; i < pending_.count(); ++i) {
-    SongLoader *loader = pending_[i];
-    if (i != 0) {
-      // We already did this earlier for the first song.
-      loader->LoadMetadataBlocking();
-    }
-    songs << loader->songs();
-    task_manager_->SetTaskProgress(async_load_id, songs.count());
+  task_manager_->SetTaskProgress(async_load_id, 0, songs_.count());
+  int songs_loaded = 0;
+  for (SongLoader *loader : std::as_const(pending_)) {
+    int loader_songs_loaded = 0;
+    QMetaObject::Connection connection = QObject::connect(loader, &SongLoader::MetadataLoaded, this, [this, async_load_id, songs_loaded, &loader_songs_loaded](const SongList &songs) {
+      loader_songs_loaded += static_cast<int>(songs.count());
+      task_manager_->SetTaskProgress(async_load_id, songs_loaded + loader_songs_loaded);
+      emit SongsLoaded(songs);
+    }, Qt::DirectConnection);
+    loader->LoadMetadataBlocking();
+    QObject::disconnect(connection);
+    songs_loaded += static_cast<int>(loader->songs().count());
+    task_manager_->SetTaskProgress(async_load_id, songs_loaded);
   }
   task_manager_->SetTaskFinished(async_load_id);
 
-  // Replace the partially-loaded items by the new ones, fully loaded.
-  emit EffectiveLoadFinished(songs);
-
   deleteLater();
 
 }
@@ -51,7 +51,8 @@ class SongLoaderInserter : public QObject {
  signals:
   void Error(const QString &message);
   void PreloadFinished();
-  void EffectiveLoadFinished(const SongList &songs);
+  // Emitted for each batch of songs that are completely loaded, after they were inserted with partial metadata.
+  void SongsLoaded(const SongList &songs);
 
  private slots:
   void DestinationDestroyed();
@@ -71,19 +71,19 @@ SongList ASXParser::Load(QIODevice *device, const QString &playlist_path, const
 
   SongList ret;
   while (!reader.atEnd() && Utilities::ParseUntilElementCI(&reader, "entry")) {
-    Song song = ParseTrack(&reader, dir, collection_search);
-    if (song.is_valid()) {
-      ret << song;
-    }
+    ret << ParseTrack(&reader, dir);
   }
 
   buffer.close();
 
+  LoadSongs(&ret, collection_search);
+  RemoveInvalidSongs(&ret);
+
   return ret;
 
 }
 
-Song ASXParser::ParseTrack(QXmlStreamReader *reader, const QDir &dir, const bool collection_search) const {
+Song ASXParser::ParseTrack(QXmlStreamReader *reader, const QDir &dir) const {
 
   QString title, artist, album, ref;
 
@@ -117,14 +117,12 @@ Song ASXParser::ParseTrack(QXmlStreamReader *reader, const QDir &dir, const bool
   }
 
 return_song:
-  Song song = LoadSong(ref, 0, dir, collection_search);
+  Song song = NewSong(ref, 0, dir);
 
-  // Override metadata with what was in the playlist
-  if (song.source() != Song::Source::Collection) {
-    if (!title.isEmpty()) song.set_title(title);
-    if (!artist.isEmpty()) song.set_artist(artist);
-    if (!album.isEmpty()) song.set_album(album);
-  }
+  // Metadata from the playlist, used unless the song is found in the collection
+  if (!title.isEmpty()) song.set_title(title);
+  if (!artist.isEmpty()) song.set_artist(artist);
+  if (!album.isEmpty()) song.set_album(album);
 
   return song;
 
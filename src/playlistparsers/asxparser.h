@@ -56,7 +56,7 @@ class ASXParser : public XMLParser {
   void Save(const SongList &songs, QIODevice *device, const QDir &dir = QDir(), const PlaylistSettingsPage::PathType path_type = PlaylistSettingsPage::PathType::Automatic) const override;
 
  private:
-  Song ParseTrack(QXmlStreamReader *reader, const QDir &dir, const bool collection_search) const;
+  Song ParseTrack(QXmlStreamReader *reader, const QDir &dir) const;
 };
 
 #endif
@@ -242,11 +242,19 @@ SongList CueParser::Load(QIODevice *device, const QString &playlist_path, const
 
   QDateTime cue_mtime = QFileInfo(playlist_path).lastModified();
 
+  // Load all the songs at once, from the collection or the files
+  SongList songs;
+  songs.reserve(entries.count());
+  for (const CueEntry &entry : std::as_const(entries)) {
+    songs << NewSong(entry.file, IndexToMarker(entry.index), dir);
+  }
+  LoadSongs(&songs, collection_search);
+
   // Finalize parsing songs
   for (int i = 0; i < entries.length(); i++) {
     CueEntry entry = entries.at(i);
 
-    Song song = LoadSong(entry.file, IndexToMarker(entry.index), dir, collection_search);
+    Song song = songs[i];
 
     // Cue song has mtime equal to qMax(media_file_mtime, cue_sheet_mtime)
     if (cue_mtime.isValid()) {
@@ -71,7 +71,7 @@ SongList M3UParser::Load(QIODevice *device, const QString &playlist_path, const
       }
     }
     else if (!line.isEmpty()) {
-      Song song = LoadSong(line, 0, dir, collection_search);
+      Song song = NewSong(line, 0, dir);
       if (!current_metadata.title.isEmpty()) {
         song.set_title(current_metadata.title);
       }
@@ -93,6 +93,8 @@ SongList M3UParser::Load(QIODevice *device, const QString &playlist_path, const
 
   buffer.close();
 
+  LoadSongs(&ret, collection_search, PlaylistMetadata::Override);
+
   return ret;
 
 }
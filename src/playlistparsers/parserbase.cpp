@@ -19,47 +19,58 @@
  *
  */
 
+#include <algorithm>
+
 #include <QtGlobal>
+#include <QList>
+#include <QHash>
+#include <QPair>
 #include <QDir>
-#include <QFile>
 #include <QFileInfo>
 #include <QString>
+#include <QStringList>
 #include <QRegularExpression>
 #include <QUrl>
 
 #include "core/shared_ptr.h"
 #include "core/logging.h"
 #include "core/tagreaderclient.h"
+#include "core/filestatuscache.h"
 #include "collection/collectionbackend.h"
 #include "settings/playlistsettingspage.h"
 #include "parserbase.h"
 
+const int ParserBase::kMetadataBatchSize = 256;
+
 ParserBase::ParserBase(SharedPtr<CollectionBackendInterface> collection_backend, QObject *parent)
     : QObject(parent), collection_backend_(collection_backend) {}
 
-void ParserBase::LoadSong(const QString &filename_or_url, const qint64 beginning, const QDir &dir, Song *song, const bool collection_search) const {
+Song ParserBase::NewSong(const QString &filename_or_url, const qint64 beginning, const QDir &dir) const {
+
+  Song song(Song::Source::LocalFile);
 
   if (filename_or_url.isEmpty()) {
-    return;
+    return song;
   }
 
   QString filename = filename_or_url;
 
-  if (filename_or_url.contains(QRegularExpression("^[a-z]{2,}:", QRegularExpression::CaseInsensitiveOption))) {
+  static const QRegularExpression regex_url_scheme("^[a-z]{2,}:", QRegularExpression::CaseInsensitiveOption);
+  if (filename_or_url.contains(regex_url_scheme)) {
     QUrl url(filename_or_url);
-    song->set_source(Song::SourceFromURL(url));
-    if (song->source() == Song::Source::LocalFile) {
+    song.set_source(Song::SourceFromURL(url));
+    if (song.source() == Song::Source::LocalFile) {
       filename = url.toLocalFile();
     }
-    else if (song->is_stream()) {
-      song->set_url(QUrl::fromUserInput(filename_or_url));
-      song->set_filetype(Song::FileType::Stream);
-      song->set_valid(true);
-      return;
+    else if (song.is_stream()) {
+      song.set_url(QUrl::fromUserInput(filename_or_url));
+      song.set_filetype(Song::FileType::Stream);
+      song.set_valid(true);
+      return song;
     }
     else {
       qLog(Error) << "Don't know how to handle" << url;
-      return;
+      return song;
     }
   }
 
@@ -72,33 +83,110 @@ void ParserBase::LoadSong(const QString &filename_or_url, const qint64 beginning
     filename = dir.absoluteFilePath(filename);
   }
 
-  // Use the canonical path
-  if (QFile::exists(filename)) {
-    filename = QFileInfo(filename).canonicalFilePath();
+  song.set_url(QUrl::fromLocalFile(QDir::cleanPath(filename)));
+  song.set_beginning_nanosec(beginning);
+
+  return song;
+
+}
+
+QStringList ParserBase::CanonicalFilenames(const QStringList &filenames) {
+
+  const QHash<QString, bool> exists = FileStatusCache::Instance()->Exists(filenames);
+
+  // Each file is resolved by itself, so a symlinked file gets the path of the file it links to and is found in the collection by that.
+  QStringList canonical_filenames;
+  canonical_filenames.reserve(filenames.count());
+  for (const QString &filename : filenames) {
+    const QString canonical_filename = exists.value(filename, false) ? QFileInfo(filename).canonicalFilePath() : QString();
+    canonical_filenames << (canonical_filename.isEmpty() ? filename : canonical_filename);
+  }
+
+  return canonical_filenames;
+
+}
+
+void ParserBase::SetPlaylistMetadata(const Song &playlist_song, Song *song) {
+
+  if (!playlist_song.title().isEmpty()) song->set_title(playlist_song.title());
+  if (!playlist_song.artist().isEmpty()) song->set_artist(playlist_song.artist());
+  if (!playlist_song.album().isEmpty()) song->set_album(playlist_song.album());
+  if (playlist_song.art_manual().isValid()) song->set_art_manual(playlist_song.art_manual());
+  if (playlist_song.length_nanosec() > 0) song->set_length_nanosec(playlist_song.length_nanosec());
+  if (playlist_song.track() > 0) song->set_track(playlist_song.track());
+
+}
+
+void ParserBase::LoadSongs(SongList *songs, const bool collection_search, const PlaylistMetadata playlist_metadata) const {
+
+  QList<int> indexes;
+  QStringList filenames;
+  for (int i = 0; i < songs->count(); ++i) {
+    const Song &song = songs->at(i);
+    if (song.url().isLocalFile()) {
+      indexes << i;
+      filenames << song.url().toLocalFile();
+    }
   }
 
-  const QUrl url = QUrl::fromLocalFile(filename);
+  if (indexes.isEmpty()) return;
 
-  // Search in the collection
+  filenames = CanonicalFilenames(filenames);
+
+  // Search in the collection, all songs at once.
+  QHash<QPair<QUrl, qint64>, Song> collection_songs;
   if (collection_backend_ && collection_search) {
-    Song collection_song = collection_backend_->GetSongByUrl(url, beginning);
-    // If it was found in the collection then use it, otherwise load metadata from disk.
-    if (collection_song.is_valid()) {
-      *song = collection_song;
-      return;
+    QList<QUrl> urls;
+    urls.reserve(filenames.count());
+    for (const QString &filename : std::as_const(filenames)) {
+      urls << QUrl::fromLocalFile(filename);
+    }
+    const SongList songs_found = collection_backend_->GetSongsByUrls(urls);
+    for (const Song &song : songs_found) {
+      collection_songs.insert(qMakePair(song.url(), song.beginning_nanosec()), song);
     }
   }
 
-  TagReaderClient::Instance()->ReadFileBlocking(filename, song);
+  // If it was found in the collection then use it, otherwise load metadata from disk.
+  QList<int> tagreader_indexes;
+  QStringList tagreader_filenames;
+  SongList tagreader_songs;
+  for (int i = 0; i < indexes.count(); ++i) {
+    const Song &playlist_song = songs->at(indexes[i]);
+    const QPair<QUrl, qint64> key = qMakePair(QUrl::fromLocalFile(filenames[i]), playlist_song.beginning_nanosec());
+    if (collection_songs.contains(key)) {
+      Song song = collection_songs.value(key);
+      if (playlist_metadata == PlaylistMetadata::Override) {
+        SetPlaylistMetadata(playlist_song, &song);
+      }
+      (*songs)[indexes[i]] = song;
+    }
+    else {
+      tagreader_indexes << indexes[i];
+      tagreader_filenames << filenames[i];
+      tagreader_songs << Song(Song::Source::LocalFile);
+    }
+  }
 
-}
+  if (tagreader_indexes.isEmpty()) return;
+
+  // The files are read in batches, each batch is split over the tagreader workers.
+  for (qint64 i = 0; i < tagreader_indexes.count(); i += kMetadataBatchSize) {
+    SongList batch_songs = tagreader_songs.mid(i, kMetadataBatchSize);
+    TagReaderClient::Instance()->ReadFilesBlocking(tagreader_filenames.mid(i, kMetadataBatchSize), &batch_songs);
+    for (int j = 0; j < batch_songs.count(); ++j) {
+      const int song_index = tagreader_indexes[static_cast<int>(i) + j];
+      Song &song = batch_songs[j];
+      SetPlaylistMetadata(songs->at(song_index), &song);
+      (*songs)[song_index] = song;
+    }
+  }
 
-Song ParserBase::LoadSong(const QString &filename_or_url, const qint64 beginning, const QDir &dir, const bool collection_search) const {
+}
 
-  Song song(Song::Source::LocalFile);
-  LoadSong(filename_or_url, beginning, dir, &song, collection_search);
+void ParserBase::RemoveInvalidSongs(SongList *songs) {
 
-  return song;
+  songs->erase(std::remove_if(songs->begin(), songs->end(), [](const Song &song) { return !song.is_valid(); }), songs->end());
 
 }
 
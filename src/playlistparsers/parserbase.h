@@ -62,17 +62,36 @@ class ParserBase : public QObject {
   virtual void Save(const SongList &songs, QIODevice *device, const QDir &dir = QDir(), const PlaylistSettingsPage::PathType path_type = PlaylistSettingsPage::PathType::Automatic) const = 0;
 
  protected:
-  // Loads a song.  If filename_or_url is a URL (with a scheme other than "file") then it is set on the song and the song marked as a stream.
-  // If it is a filename or a file:// URL then it is made absolute and canonical and set as a file:// url on the song.
-  // Also sets the song's metadata by searching in the Collection, or loading from the file as a fallback.
-  // This function should always be used when loading a playlist.
-  Song LoadSong(const QString &filename_or_url, const qint64 beginning, const QDir &dir, const bool collection_search) const;
-  void LoadSong(const QString &filename_or_url, const qint64 beginning, const QDir &dir, Song *song, const bool collection_search) const;
+  // How the metadata from the playlist is combined with the metadata loaded by LoadSongs().
+  enum class PlaylistMetadata {
+    // The metadata from the playlist is always used.
+    Override,
+    // The metadata from the playlist is only used for songs that are not in the collection.
+    OverrideUnlessInCollection
+  };
+
+  // Creates a song without loading its metadata.  If filename_or_url is a URL (with a scheme other than "file") then it is set on the song and the song marked as a stream.
+  // If it is a filename or a file:// URL then it is made absolute and set as a file:// url on the song.
+  // Metadata from the playlist can be set on the song before it's passed to LoadSongs().
+  Song NewSong(const QString &filename_or_url, const qint64 beginning, const QDir &dir) const;
+
+  // Loads the metadata of the local files created by NewSong(), and makes their paths canonical.
+  // The songs are searched in the Collection in batches, the rest are loaded from the files in parallel.
+  // This function should always be used when loading a playlist, after parsing all the songs.
+  void LoadSongs(SongList *songs, const bool collection_search, const PlaylistMetadata playlist_metadata = PlaylistMetadata::OverrideUnlessInCollection) const;
+  static void RemoveInvalidSongs(SongList *songs);
 
   // If the URL is a file:// URL then returns its path, absolute or relative to the directory depending on the path_type option.
   // Otherwise, returns the URL as is. This function should always be used when saving a playlist.
   static QString URLOrFilename(const QUrl &url, const QDir &dir, const PlaylistSettingsPage::PathType path_type);
 
+ private:
+  // Maximum number of files LoadSongs() reads with one ReadFilesBlocking() call.
+  static const int kMetadataBatchSize;
+
+  static QStringList CanonicalFilenames(const QStringList &filenames);
+  static void SetPlaylistMetadata(const Song &playlist_song, Song *song);
+
  private:
   SharedPtr<CollectionBackendInterface> collection_backend_;
 };
@@ -62,7 +62,7 @@ SongList PLSParser::Load(QIODevice *device, const QString &playlist_path, const
     int n = re_match.captured(0).toInt();
 
     if (key.startsWith("file")) {
-      Song song = LoadSong(value, 0, dir, collection_search);
+      Song song = NewSong(value, 0, dir);
 
       // Use the title and length we've already loaded if any
       if (!songs[n].title().isEmpty()) song.set_title(songs[n].title());
@@ -83,7 +83,10 @@ SongList PLSParser::Load(QIODevice *device, const QString &playlist_path, const
     }
   }
 
-  return songs.values();
+  SongList ret = songs.values();
+  LoadSongs(&ret, collection_search, PlaylistMetadata::Override);
+
+  return ret;
 
 }
 
@@ -56,13 +56,17 @@ SongList WplParser::Load(QIODevice *device, const QString &playlist_path, const
   }
 
   while (!reader.atEnd() && Utilities::ParseUntilElement(&reader, "seq")) {
-    ParseSeq(dir, &reader, &ret, collection_search);
+    ParseSeq(dir, &reader, &ret);
   }
+
+  LoadSongs(&ret, collection_search);
+  RemoveInvalidSongs(&ret);
+
   return ret;
 
 }
 
-void WplParser::ParseSeq(const QDir &dir, QXmlStreamReader *reader, SongList *songs, const bool collection_search) const {
+void WplParser::ParseSeq(const QDir &dir, QXmlStreamReader *reader, SongList *songs) const {
 
   while (!reader->atEnd()) {
     QXmlStreamReader::TokenType type = reader->readNext();
@@ -72,10 +76,7 @@ void WplParser::ParseSeq(const QDir &dir, QXmlStreamReader *reader, SongList *so
         if (name == "media") {
           QString src = reader->attributes().value("src").toString();
           if (!src.isEmpty()) {
-            Song song = LoadSong(src, 0, dir, collection_search);
-            if (song.is_valid()) {
-              songs->append(song);
-            }
+            songs->append(NewSong(src, 0, dir));
           }
         }
         else {
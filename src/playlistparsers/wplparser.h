@@ -58,7 +58,7 @@ class WplParser : public XMLParser {
   void Save(const SongList &songs, QIODevice *device, const QDir &dir, const PlaylistSettingsPage::PathType path_type = PlaylistSettingsPage::PathType::Automatic) const override;
 
  private:
-  void ParseSeq(const QDir &dir, QXmlStreamReader *reader, SongList *songs, const bool collection_search = true) const;
+  void ParseSeq(const QDir &dir, QXmlStreamReader *reader, SongList *songs) const;
   static void WriteMeta(const QString &name, const QString &content, QXmlStreamWriter *writer);
 };
 
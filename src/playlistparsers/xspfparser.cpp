@@ -53,16 +53,17 @@ SongList XSPFParser::Load(QIODevice *device, const QString &playlist_path, const
   }
 
   while (!reader.atEnd() && Utilities::ParseUntilElement(&reader, "track")) {
-    Song song = ParseTrack(&reader, dir, collection_search);
-    if (song.is_valid()) {
-      ret << song;
-    }
+    ret << ParseTrack(&reader, dir);
   }
+
+  LoadSongs(&ret, collection_search);
+  RemoveInvalidSongs(&ret);
+
   return ret;
 
 }
 
-Song XSPFParser::ParseTrack(QXmlStreamReader *reader, const QDir &dir, const bool collection_search) const {
+Song XSPFParser::ParseTrack(QXmlStreamReader *reader, const QDir &dir) const {
 
   QString title, artist, album, location, art;
   qint64 nanosec = -1;
@@ -120,17 +121,15 @@ Song XSPFParser::ParseTrack(QXmlStreamReader *reader, const QDir &dir, const boo
   }
 
 return_song:
-  Song song = LoadSong(location, 0, dir, collection_search);
-
-  // Override metadata with what was in the playlist
-  if (song.source() != Song::Source::Collection) {
-    if (!title.isEmpty()) song.set_title(title);
-    if (!artist.isEmpty()) song.set_artist(artist);
-    if (!album.isEmpty()) song.set_album(album);
-    if (!art.isEmpty()) song.set_art_manual(QUrl(art));
-    if (nanosec > 0) song.set_length_nanosec(nanosec);
-    if (track_num > 0) song.set_track(track_num);
-  }
+  Song song = NewSong(location, 0, dir);
+
+  // Metadata from the playlist, used unless the song is found in the collection
+  if (!title.isEmpty()) song.set_title(title);
+  if (!artist.isEmpty()) song.set_artist(artist);
+  if (!album.isEmpty()) song.set_album(album);
+  if (!art.isEmpty()) song.set_art_manual(QUrl(art));
+  if (nanosec > 0) song.set_length_nanosec(nanosec);
+  if (track_num > 0) song.set_track(track_num);
 
   return song;
 
@@ -21,6 +21,7 @@
 
 #include <algorithm>
 
+#include <QtGlobal>
 #include <QObject>
 #include <QByteArray>
 #include <QPair>
@@ -39,6 +40,7 @@
 #include "core/logging.h"
 #include "core/shared_ptr.h"
 #include "core/networkaccessmanager.h"
+#include "internet/internetrequestscheduler.h"
 #include "qobuzservice.h"
 #include "qobuzbaserequest.h"
 
@@ -49,7 +51,7 @@ QobuzBaseRequest::QobuzBaseRequest(QobuzService *service, SharedPtr<NetworkAcces
 
 QobuzBaseRequest::~QobuzBaseRequest() = default;
 
-QNetworkReply *QobuzBaseRequest::CreateRequest(const QString &ressource_name, const ParamList &params_provided) {
+QNetworkReply *QobuzBaseRequest::CreateRequest(const QString &ressource_name, const ParamList &params_provided, const InternetRequestScheduler::Priority priority) {
 
   ParamList params = ParamList() << params_provided
                                  << Param("app_id", app_id());
@@ -66,10 +68,15 @@ QNetworkReply *QobuzBaseRequest::CreateRequest(const QString &ressource_name, co
   QNetworkRequest req(url);
   req.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
   req.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+  // The requests to the API share one connection when the server supports HTTP/2.
+  req.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+#endif
   req.setRawHeader("X-App-Id", app_id().toUtf8());
   if (authenticated()) req.setRawHeader("X-User-Auth-Token", user_auth_token().toUtf8());
 
   QNetworkReply *reply = network_->get(req);
+  request_scheduler()->AddReply(reply, priority);
   QObject::connect(reply, &QNetworkReply::sslErrors, this, &QobuzBaseRequest::HandleSSLErrors);
 
   qLog(Debug) << "Qobuz: Sending request" << url;
@@ -31,10 +31,12 @@
 #include <QByteArray>
 #include <QString>
 #include <QStringList>
+#include <QUrl>
 #include <QJsonObject>
 #include <QJsonValue>
 
 #include "core/shared_ptr.h"
+#include "internet/internetrequestscheduler.h"
 #include "core/song.h"
 #include "qobuzservice.h"
 
@@ -63,7 +65,8 @@ class QobuzBaseRequest : public QObject {
   using Param = QPair<QString, QString>;
   using ParamList = QList<Param>;
 
-  QNetworkReply *CreateRequest(const QString &ressource_name, const ParamList &params_provided);
+  QNetworkReply *CreateRequest(const QString &ressource_name, const ParamList &params_provided, const InternetRequestScheduler::Priority priority = InternetRequestScheduler::Priority::Interactive);
+  bool CanStartRequest(const InternetRequestScheduler::Priority priority) { return request_scheduler()->CanStart(QUrl(QobuzService::kApiUrl), priority); }
   QByteArray GetReplyData(QNetworkReply *reply);
   QJsonObject ExtractJsonObj(QByteArray &data);
   QJsonValue ExtractItems(QByteArray &data);
@@ -86,6 +89,8 @@ class QobuzBaseRequest : public QObject {
   QString device_id() { return service_->device_id(); }
   qint64 credential_id() { return service_->credential_id(); }
 
+  InternetRequestScheduler *request_scheduler() { return service_->request_scheduler(); }
+
   bool authenticated() { return service_->authenticated(); }
   bool login_sent() { return service_->login_sent(); }
   int max_login_attempts() { return service_->max_login_attempts(); }
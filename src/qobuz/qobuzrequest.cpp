@@ -47,12 +47,6 @@
 #include "qobuzbaserequest.h"
 #include "qobuzrequest.h"
 
-constexpr int QobuzRequest::kMaxConcurrentArtistsRequests = 3;
-constexpr int QobuzRequest::kMaxConcurrentAlbumsRequests = 3;
-constexpr int QobuzRequest::kMaxConcurrentSongsRequests = 3;
-constexpr int QobuzRequest::kMaxConcurrentArtistAlbumsRequests = 3;
-constexpr int QobuzRequest::kMaxConcurrentAlbumSongsRequests = 3;
-constexpr int QobuzRequest::kMaxConcurrentAlbumCoverRequests = 1;
 constexpr int QobuzRequest::kFlushRequestsDelay = 200;
 
 QobuzRequest::QobuzRequest(QobuzService *service, QobuzUrlHandler *url_handler, Application *app, SharedPtr<NetworkAccessManager> network, const QueryType query_type, QObject *parent)
@@ -155,6 +149,26 @@ void QobuzRequest::StartRequests() {
 
 }
 
+template<typename T>
+bool QobuzRequest::RequeueRequest(QNetworkReply *reply, QList<QNetworkReply*> &replies, QQueue<T> &queue, T request, int &requests_active) {
+
+  if (finished_ || !replies.contains(reply) || !InternetRequestScheduler::RetryLater(reply) || request.retries >= InternetRequestScheduler::kMaxRetries) return false;
+
+  replies.removeAll(reply);
+  QObject::disconnect(reply, nullptr, this, nullptr);
+  reply->deleteLater();
+
+  --requests_active;
+  ++request.retries;
+  queue.enqueue(request);
+
+  // The scheduler holds the request back until the server is ready again.
+  StartRequests();
+
+  return true;
+
+}
+
 void QobuzRequest::FlushRequests() {
 
   if (!artists_requests_queue_.isEmpty()) {
@@ -219,7 +233,7 @@ void QobuzRequest::AddArtistsRequest(const int offset, const int limit) {
 
 void QobuzRequest::FlushArtistsRequests() {
 
-  while (!artists_requests_queue_.isEmpty() && artists_requests_active_ < kMaxConcurrentArtistsRequests) {
+  while (!artists_requests_queue_.isEmpty() && CanStartRequest(RequestPriority())) {
 
     Request request = artists_requests_queue_.dequeue();
 
@@ -233,14 +247,17 @@ void QobuzRequest::FlushArtistsRequests() {
     if (request.offset > 0) params << Param("offset", QString::number(request.offset));
     QNetworkReply *reply = nullptr;
     if (query_type_ == QueryType::Artists) {
-      reply = CreateRequest(QString("favorite/getUserFavorites"), params);
+      reply = CreateRequest(QString("favorite/getUserFavorites"), params, RequestPriority());
     }
     else if (query_type_ == QueryType::SearchArtists) {
-      reply = CreateRequest("artist/search", params);
+      reply = CreateRequest("artist/search", params, RequestPriority());
     }
     if (!reply) continue;
     replies_ << reply;
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { ArtistsReplyReceived(reply, request.limit, request.offset); });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, replies_, artists_requests_queue_, request, artists_requests_active_)) return;
+      ArtistsReplyReceived(reply, request.limit, request.offset);
+    });
 
     ++artists_requests_active_;
 
@@ -271,7 +288,7 @@ void QobuzRequest::AddAlbumsRequest(const int offset, const int limit) {
 
 void QobuzRequest::FlushAlbumsRequests() {
 
-  while (!albums_requests_queue_.isEmpty() && albums_requests_active_ < kMaxConcurrentAlbumsRequests) {
+  while (!albums_requests_queue_.isEmpty() && CanStartRequest(RequestPriority())) {
 
     Request request = albums_requests_queue_.dequeue();
 
@@ -285,14 +302,17 @@ void QobuzRequest::FlushAlbumsRequests() {
     if (request.offset > 0) params << Param("offset", QString::number(request.offset));
     QNetworkReply *reply = nullptr;
     if (query_type_ == QueryType::Albums) {
-      reply = CreateRequest(QString("favorite/getUserFavorites"), params);
+      reply = CreateRequest(QString("favorite/getUserFavorites"), params, RequestPriority());
     }
     else if (query_type_ == QueryType::SearchAlbums) {
-      reply = CreateRequest("album/search", params);
+      reply = CreateRequest("album/search", params, RequestPriority());
     }
     if (!reply) continue;
     replies_ << reply;
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { AlbumsReplyReceived(reply, request.limit, request.offset); });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, replies_, albums_requests_queue_, request, albums_requests_active_)) return;
+      AlbumsReplyReceived(reply, request.limit, request.offset);
+    });
 
     ++albums_requests_active_;
 
@@ -323,7 +343,7 @@ void QobuzRequest::AddSongsRequest(const int offset, const int limit) {
 
 void QobuzRequest::FlushSongsRequests() {
 
-  while (!songs_requests_queue_.isEmpty() && songs_requests_active_ < kMaxConcurrentSongsRequests) {
+  while (!songs_requests_queue_.isEmpty() && CanStartRequest(RequestPriority())) {
 
     Request request = songs_requests_queue_.dequeue();
 
@@ -337,14 +357,17 @@ void QobuzRequest::FlushSongsRequests() {
     if (request.offset > 0) params << Param("offset", QString::number(request.offset));
     QNetworkReply *reply = nullptr;
     if (query_type_ == QueryType::Songs) {
-      reply = CreateRequest(QString("favorite/getUserFavorites"), params);
+      reply = CreateRequest(QString("favorite/getUserFavorites"), params, RequestPriority());
     }
     else if (query_type_ == QueryType::SearchSongs) {
-      reply = CreateRequest("track/search", params);
+      reply = CreateRequest("track/search", params, RequestPriority());
     }
     if (!reply) continue;
     replies_ << reply;
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { SongsReplyReceived(reply, request.limit, request.offset); });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, replies_, songs_requests_queue_, request, songs_requests_active_)) return;
+      SongsReplyReceived(reply, request.limit, request.offset);
+    });
 
     ++songs_requests_active_;
 
@@ -581,7 +604,7 @@ void QobuzRequest::AddArtistAlbumsRequest(const Artist &artist, const int offset
 
 void QobuzRequest::FlushArtistAlbumsRequests() {
 
-  while (!artist_albums_requests_queue_.isEmpty() && artist_albums_requests_active_ < kMaxConcurrentArtistAlbumsRequests) {
+  while (!artist_albums_requests_queue_.isEmpty() && CanStartRequest(RequestPriority())) {
 
     const ArtistAlbumsRequest request = artist_albums_requests_queue_.dequeue();
 
@@ -589,8 +612,11 @@ void QobuzRequest::FlushArtistAlbumsRequests() {
                                    << Param("extra", "albums");
 
     if (request.offset > 0) params << Param("offset", QString::number(request.offset));
-    QNetworkReply *reply = CreateRequest(QString("artist/get"), params);
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { ArtistAlbumsReplyReceived(reply, request.artist, request.offset); });
+    QNetworkReply *reply = CreateRequest(QString("artist/get"), params, RequestPriority());
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, replies_, artist_albums_requests_queue_, request, artist_albums_requests_active_)) return;
+      ArtistAlbumsReplyReceived(reply, request.artist, request.offset);
+    });
     replies_ << reply;
 
     ++artist_albums_requests_active_;
@@ -839,14 +865,17 @@ void QobuzRequest::AddAlbumSongsRequest(const Artist &artist, const Album &album
 
 void QobuzRequest::FlushAlbumSongsRequests() {
 
-  while (!album_songs_requests_queue_.isEmpty() && album_songs_requests_active_ < kMaxConcurrentAlbumSongsRequests) {
+  while (!album_songs_requests_queue_.isEmpty() && CanStartRequest(RequestPriority())) {
 
     AlbumSongsRequest request = album_songs_requests_queue_.dequeue();
     ParamList params = ParamList() << Param("album_id", request.album.album_id);
     if (request.offset > 0) params << Param("offset", QString::number(request.offset));
-    QNetworkReply *reply = CreateRequest(QString("album/get"), params);
+    QNetworkReply *reply = CreateRequest(QString("album/get"), params, RequestPriority());
     replies_ << reply;
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { AlbumSongsReplyReceived(reply, request.artist, request.album, request.offset); });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, replies_, album_songs_requests_queue_, request, album_songs_requests_active_)) return;
+      AlbumSongsReplyReceived(reply, request.artist, request.album, request.offset);
+    });
 
     ++album_songs_requests_active_;
 
@@ -1286,15 +1315,19 @@ void QobuzRequest::AddAlbumCoverRequest(const Song &song) {
 
 void QobuzRequest::FlushAlbumCoverRequests() {
 
-  while (!album_cover_requests_queue_.isEmpty() && album_covers_requests_active_ < kMaxConcurrentAlbumCoverRequests) {
+  while (!album_cover_requests_queue_.isEmpty() && request_scheduler()->CanStart(album_cover_requests_queue_.head().url, RequestPriority())) {
 
     AlbumCoverRequest request = album_cover_requests_queue_.dequeue();
 
     QNetworkRequest req(request.url);
     req.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
     QNetworkReply *reply = network_->get(req);
+    request_scheduler()->AddReply(reply, RequestPriority());
     album_cover_replies_ << reply;
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { AlbumCoverReceived(reply, request.url, request.filename); });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, album_cover_replies_, album_cover_requests_queue_, request, album_covers_requests_active_)) return;
+      AlbumCoverReceived(reply, request.url, request.filename);
+    });
 
     ++album_covers_requests_active_;
 
@@ -47,6 +47,7 @@
 #include "core/song.h"
 #include "utilities/macaddrutils.h"
 #include "internet/internetsearchview.h"
+#include "internet/internetstreamurlcache.h"
 #include "collection/collectionbackend.h"
 #include "collection/collectionmodel.h"
 #include "qobuzservice.h"
@@ -81,6 +82,7 @@ QobuzService::QobuzService(Application *app, QObject *parent)
       app_(app),
       network_(app->network()),
       url_handler_(new QobuzUrlHandler(app, this)),
+      stream_url_cache_(new InternetStreamUrlCache("qobuzstreamurls.cache", this)),
       artists_collection_backend_(nullptr),
       albums_collection_backend_(nullptr),
       songs_collection_backend_(nullptr),
@@ -158,6 +160,9 @@ QobuzService::QobuzService(Application *app, QObject *parent)
   QObject::connect(this, &QobuzService::RequestLogin, this, &QobuzService::SendLogin);
   QObject::connect(this, &QobuzService::LoginWithCredentials, this, &QobuzService::SendLoginWithCredentials);
 
+  // Stream URLs resolved for another login or session might not be valid anymore.
+  QObject::connect(this, &QobuzService::LoginSuccess, stream_url_cache_, &InternetStreamUrlCache::Clear);
+
   QObject::connect(this, &QobuzService::AddArtists, favorite_request_, &QobuzFavoriteRequest::AddArtists);
   QObject::connect(this, &QobuzService::AddAlbums, favorite_request_, &QobuzFavoriteRequest::AddAlbums);
   QObject::connect(this, &QobuzService::AddSongs, favorite_request_, QOverload<const SongList&>::of(&QobuzFavoriteRequest::AddSongs));
@@ -255,6 +260,8 @@ void QobuzService::ReloadSettings() {
 
   s.endGroup();
 
+  stream_url_cache_->set_variant(QString::number(format_));
+
   if (base64_secret) {
     app_secret_ = DecodeAppSecret(app_secret_);
   }
@@ -484,6 +491,8 @@ void QobuzService::Logout() {
   s.remove("user_auth_token");
   s.endGroup();
 
+  stream_url_cache_->Clear();
+
 }
 
 void QobuzService::ResetLoginAttempts() {
@@ -773,6 +782,8 @@ void QobuzService::HandleStreamURLSuccess(const uint id, const QUrl &media_url,
   if (!stream_url_requests_.contains(id)) return;
   stream_url_requests_.remove(id);
 
+  stream_url_cache_->Insert(media_url, stream_url, filetype, samplerate, bit_depth, duration);
+
   emit StreamURLSuccess(id, media_url, stream_url, filetype, samplerate, bit_depth, duration);
 
 }
@@ -51,6 +51,7 @@ class QobuzUrlHandler;
 class QobuzRequest;
 class QobuzFavoriteRequest;
 class QobuzStreamURLRequest;
+class InternetStreamUrlCache;
 class CollectionBackend;
 class CollectionModel;
 
@@ -95,6 +96,7 @@ class QobuzService : public InternetService {
   bool login_attempts() const { return login_attempts_; }
 
   uint GetStreamURL(const QUrl &url, QString &error);
+  InternetStreamUrlCache *stream_url_cache() const { return stream_url_cache_; }
 
   SharedPtr<CollectionBackend> artists_collection_backend() override { return artists_collection_backend_; }
   SharedPtr<CollectionBackend> albums_collection_backend() override { return albums_collection_backend_; }
@@ -163,6 +165,7 @@ class QobuzService : public InternetService {
   Application *app_;
   SharedPtr<NetworkAccessManager> network_;
   QobuzUrlHandler *url_handler_;
+  InternetStreamUrlCache *stream_url_cache_;
 
   SharedPtr<CollectionBackend> artists_collection_backend_;
   SharedPtr<CollectionBackend> albums_collection_backend_;
@@ -20,12 +20,15 @@
 #include "config.h"
 
 #include <QObject>
+#include <QHash>
 #include <QString>
 #include <QUrl>
 
+#include "core/logging.h"
 #include "core/application.h"
 #include "core/taskmanager.h"
 #include "core/song.h"
+#include "internet/internetstreamurlcache.h"
 #include "qobuz/qobuzservice.h"
 #include "qobuzurlhandler.h"
 
@@ -41,13 +44,30 @@ QobuzUrlHandler::QobuzUrlHandler(Application *app, QobuzService *service)
 
 UrlHandler::LoadResult QobuzUrlHandler::StartLoading(const QUrl &url) {
 
+  InternetStreamUrlCache::Entry entry;
+  if (service_->stream_url_cache()->Get(url, entry)) {
+    qLog(Debug) << "Using cached stream URL for" << url;
+    cached_stream_urls_.insert(url, entry.stream_url);
+    return LoadResult(url, LoadResult::Type::TrackAvailable, entry.stream_url, entry.filetype, entry.samplerate, entry.bit_depth, entry.length_nanosec);
+  }
+
+  cached_stream_urls_.remove(url);
+
   Request req;
   req.task_id = app_->task_manager()->StartTask(QString("Loading %1 stream...").arg(url.scheme()));
-  QString error;
-  req.id = service_->GetStreamURL(url, error);
-  if (req.id == 0) {
-    CancelTask(req.task_id);
-    return LoadResult(url, LoadResult::Type::Error, error);
+
+  // Take over the prefetch request if the stream URL is still being fetched.
+  req.id = prefetch_requests_.key(url, 0);
+  if (req.id != 0) {
+    prefetch_requests_.remove(req.id);
+  }
+  else {
+    QString error;
+    req.id = service_->GetStreamURL(url, error);
+    if (req.id == 0) {
+      CancelTask(req.task_id);
+      return LoadResult(url, LoadResult::Type::Error, error);
+    }
   }
 
   requests_.insert(req.id, req);
@@ -59,8 +79,41 @@ UrlHandler::LoadResult QobuzUrlHandler::StartLoading(const QUrl &url) {
 
 }
 
+void QobuzUrlHandler::Prefetch(const QUrl &url) {
+
+  if (service_->stream_url_cache()->Contains(url) || prefetch_requests_.key(url, 0) != 0) return;
+
+  QString error;
+  const uint id = service_->GetStreamURL(url, error);
+  if (id == 0) return;
+
+  prefetch_requests_.insert(id, url);
+
+}
+
+bool QobuzUrlHandler::LoadFailed(const QUrl &media_url, const QUrl &stream_url) {
+
+  // Don't hand out the stream URL again.
+  service_->stream_url_cache()->Remove(media_url);
+
+  // A stream URL that was just resolved is not tried again, it would most likely fail the same way.
+  QHash<QUrl, QUrl>::iterator it = cached_stream_urls_.find(media_url);
+  if (it == cached_stream_urls_.end() || it.value() != stream_url) return false;
+  cached_stream_urls_.erase(it);
+
+  qLog(Debug) << "Cached stream URL for" << media_url << "failed to play, resolving it again";
+
+  return true;
+
+}
+
 void QobuzUrlHandler::GetStreamURLFailure(const uint id, const QUrl &media_url, const QString &error) {
 
+  if (prefetch_requests_.remove(id) > 0) {
+    qLog(Debug) << "Could not prefetch stream URL for" << media_url << error;
+    return;
+  }
+
   if (!requests_.contains(id)) return;
   Request req = requests_.take(id);
   CancelTask(req.task_id);
@@ -71,6 +124,9 @@ void QobuzUrlHandler::GetStreamURLFailure(const uint id, const QUrl &media_url,
 
 void QobuzUrlHandler::GetStreamURLSuccess(const uint id, const QUrl &media_url, const QUrl &stream_url, const Song::FileType filetype, const int samplerate, const int bit_depth, const qint64 duration) {
 
+  // The service has stored the stream URL in the cache already.
+  if (prefetch_requests_.remove(id) > 0) return;
+
   if (!requests_.contains(id)) return;
   Request req = requests_.take(id);
   CancelTask(req.task_id);
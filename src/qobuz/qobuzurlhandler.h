@@ -23,6 +23,7 @@
 #include <QtGlobal>
 #include <QObject>
 #include <QMap>
+#include <QHash>
 #include <QString>
 #include <QUrl>
 
@@ -40,6 +41,8 @@ class QobuzUrlHandler : public UrlHandler {
 
   QString scheme() const { return service_->url_scheme(); }
   LoadResult StartLoading(const QUrl &url);
+  void Prefetch(const QUrl &url);
+  bool LoadFailed(const QUrl &media_url, const QUrl &stream_url);
 
  private:
   void CancelTask(const int task_id);
@@ -57,6 +60,10 @@ class QobuzUrlHandler : public UrlHandler {
   Application *app_;
   QobuzService *service_;
   QMap<uint, Request> requests_;
+  // Stream URL requests started by Prefetch(), the URLs are stored in the stream URL cache when they finish.
+  QMap<uint, QUrl> prefetch_requests_;
+  // Stream URLs StartLoading() took from the cache, they are resolved again once if they fail to play.
+  QHash<QUrl, QUrl> cached_stream_urls_;
 };
 
 #endif  // QOBUZURLHANDLER_H
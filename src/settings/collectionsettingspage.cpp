@@ -43,6 +43,7 @@
 
 #include "core/application.h"
 #include "core/iconloader.h"
+#include "core/tagreaderclient.h"
 #include "utilities/strutils.h"
 #include "utilities/timeutils.h"
 #include "collection/collection.h"
@@ -185,6 +186,9 @@ void CollectionSettingsPage::Load() {
   ui_->song_ebur128_loudness_analysis->setChecked(s.value("song_ebur128_loudness_analysis", false).toBool());
   ui_->mark_songs_unavailable->setChecked(ui_->song_tracking->isChecked() ? true : s.value("mark_songs_unavailable", true).toBool());
   ui_->expire_unavailable_songs_days->setValue(s.value("expire_unavailable_songs", 60).toInt());
+  ui_->parallel_scan->setChecked(s.value("parallel_scan", true).toBool());
+  ui_->in_process_tag_reading->setChecked(s.value(TagReaderClient::kSettingsInProcess, false).toBool());
+  ui_->tagreader_max_workers->setValue(s.value(TagReaderClient::kSettingsMaxWorkers, 0).toInt());
 
   QStringList filters = s.value("cover_art_patterns", QStringList() << "front" << "cover").toStringList();
   ui_->cover_art_patterns->setText(filters.join(","));
@@ -232,6 +236,9 @@ void CollectionSettingsPage::Save() {
   s.setValue("song_ebur128_loudness_analysis", ui_->song_ebur128_loudness_analysis->isChecked());
   s.setValue("mark_songs_unavailable", ui_->song_tracking->isChecked() ? true : ui_->mark_songs_unavailable->isChecked());
   s.setValue("expire_unavailable_songs", ui_->expire_unavailable_songs_days->value());
+  s.setValue("parallel_scan", ui_->parallel_scan->isChecked());
+  s.setValue(TagReaderClient::kSettingsInProcess, ui_->in_process_tag_reading->isChecked());
+  s.setValue(TagReaderClient::kSettingsMaxWorkers, ui_->tagreader_max_workers->value());
 
   QString filter_text = ui_->cover_art_patterns->text();
 
@@ -29,16 +29,20 @@
 #include <QSettings>
 #include <QCheckBox>
 #include <QComboBox>
+#include <QPushButton>
+#include <QMessageBox>
 #include <QSize>
 
 #include "core/iconloader.h"
 #include "core/logging.h"
+#include "core/application.h"
 
 #include "settingsdialog.h"
 #include "settingspage.h"
 
 #ifdef HAVE_MOODBAR
 #  include "moodbar/moodbarrenderer.h"
+#  include "moodbar/moodbarloader.h"
 #endif
 
 #include "moodbarsettingspage.h"
@@ -56,6 +60,8 @@ MoodbarSettingsPage::MoodbarSettingsPage(SettingsDialog *dialog, QWidget *parent
   ui_->setupUi(this);
   setWindowIcon(IconLoader::Load("moodbar", true, 0, 32));
 
+  QObject::connect(ui_->button_generate_collection, &QPushButton::clicked, this, &MoodbarSettingsPage::GenerateCollectionMoodbars);
+
   MoodbarSettingsPage::Load();
 
 }
@@ -93,6 +99,19 @@ void MoodbarSettingsPage::Save() {
 
 void MoodbarSettingsPage::Cancel() {}
 
+void MoodbarSettingsPage::GenerateCollectionMoodbars() {
+
+  QMessageBox confirmation_dialog(QMessageBox::Question, tr("Generate moodbars for the collection"), tr("Are you sure you want to generate the missing moodbars for all songs in your collection? This can take a long time."), QMessageBox::Yes | QMessageBox::Cancel);
+  if (confirmation_dialog.exec() != QMessageBox::Yes) {
+    return;
+  }
+
+#ifdef HAVE_MOODBAR
+  dialog()->app()->moodbar_loader()->GenerateCollectionMoodbars();
+#endif
+
+}
+
 void MoodbarSettingsPage::InitMoodbarPreviews() {
 
   if (initialized_) return;
@@ -43,6 +43,9 @@ class MoodbarSettingsPage : public SettingsPage {
   void Save() override;
   void Cancel() override;
 
+ private slots:
+  void GenerateCollectionMoodbars();
+
  private:
   static const int kMoodbarPreviewWidth;
   static const int kMoodbarPreviewHeight;
@@ -38,6 +38,7 @@
 #include <QJsonValue>
 
 #include "utilities/randutils.h"
+#include "internet/internetrequestscheduler.h"
 #include "subsonicservice.h"
 #include "subsonicbaserequest.h"
 
@@ -92,7 +93,7 @@ QUrl SubsonicBaseRequest::CreateUrl(const QUrl &server_url, const SubsonicSettin
 
 }
 
-QNetworkReply *SubsonicBaseRequest::CreateGetRequest(const QString &ressource_name, const ParamList &params_provided) const {
+QNetworkReply *SubsonicBaseRequest::CreateGetRequest(const QString &ressource_name, const ParamList &params_provided, const InternetRequestScheduler::Priority priority) const {
 
   QUrl url = CreateUrl(server_url(), auth_method(), username(), password(), ressource_name, params_provided);
   QNetworkRequest req(url);
@@ -111,6 +112,7 @@ QNetworkReply *SubsonicBaseRequest::CreateGetRequest(const QString &ressource_na
 #endif
 
   QNetworkReply *reply = network_->get(req);
+  request_scheduler()->AddReply(reply, priority);
   QObject::connect(reply, &QNetworkReply::sslErrors, this, &SubsonicBaseRequest::HandleSSLErrors);
 
   //qLog(Debug) << "Subsonic: Sending request" << url;
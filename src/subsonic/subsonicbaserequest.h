@@ -35,6 +35,7 @@
 #include <QJsonObject>
 
 #include "core/scoped_ptr.h"
+#include "internet/internetrequestscheduler.h"
 #include "subsonicservice.h"
 #include "settings/subsonicsettingspage.h"
 
@@ -55,7 +56,7 @@ class SubsonicBaseRequest : public QObject {
   static QUrl CreateUrl(const QUrl &server_url, const SubsonicSettingsPage::AuthMethod auth_method, const QString &username, const QString &password, const QString &ressource_name, const ParamList &params_provided);
 
  protected:
-  QNetworkReply *CreateGetRequest(const QString &ressource_name, const ParamList &params_provided) const;
+  QNetworkReply *CreateGetRequest(const QString &ressource_name, const ParamList &params_provided, const InternetRequestScheduler::Priority priority = InternetRequestScheduler::Priority::Interactive) const;
   QByteArray GetReplyData(QNetworkReply *reply);
   QJsonObject ExtractJsonObj(QByteArray &data);
 
@@ -69,6 +70,7 @@ class SubsonicBaseRequest : public QObject {
   bool http2() const { return service_->http2(); }
   bool verify_certificate() const { return service_->verify_certificate(); }
   bool download_album_covers() const { return service_->download_album_covers(); }
+  InternetRequestScheduler *request_scheduler() const { return service_->request_scheduler(); }
 
  private slots:
   void HandleSSLErrors(const QList<QSslError> &ssl_errors);
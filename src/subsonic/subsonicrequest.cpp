@@ -43,6 +43,7 @@
 #include "core/logging.h"
 #include "core/song.h"
 #include "core/networktimeouts.h"
+#include "internet/internetrequestscheduler.h"
 #include "utilities/imageutils.h"
 #include "utilities/timeconstants.h"
 #include "subsonicservice.h"
@@ -50,10 +51,6 @@
 #include "subsonicbaserequest.h"
 #include "subsonicrequest.h"
 
-const int SubsonicRequest::kMaxConcurrentAlbumsRequests = 3;
-const int SubsonicRequest::kMaxConcurrentAlbumSongsRequests = 3;
-const int SubsonicRequest::kMaxConcurrentAlbumCoverRequests = 1;
-
 SubsonicRequest::SubsonicRequest(SubsonicService *service, SubsonicUrlHandler *url_handler, Application *app, QObject *parent)
     : SubsonicBaseRequest(service, parent),
       service_(service),
@@ -69,10 +66,14 @@ SubsonicRequest::SubsonicRequest(SubsonicService *service, SubsonicUrlHandler *u
       album_covers_requests_active_(0),
       album_covers_requested_(0),
       album_covers_received_(0),
-      no_results_(false) {
+      collection_albums_loaded_(false),
+      albums_list_finished_(false),
+      albums_checked_(false) {
 
   network_->setRedirectPolicy(QNetworkRequest::NoLessSafeRedirectPolicy);
 
+  QObject::connect(request_scheduler(), &InternetRequestScheduler::Available, this, &SubsonicRequest::FlushRequests);
+
 }
 
 SubsonicRequest::~SubsonicRequest() {
@@ -114,12 +115,43 @@ void SubsonicRequest::Reset() {
   songs_.clear();
   cover_urls_.clear();
   errors_.clear();
-  no_results_ = false;
+  albums_list_finished_ = false;
+  albums_checked_ = false;
+  albums_updated_.clear();
   replies_.clear();
   album_cover_replies_.clear();
 
 }
 
+void SubsonicRequest::FlushRequests() {
+
+  if (finished_) return;
+
+  // The scheduler has room for more requests again, like after backing off.
+  if (!albums_requests_queue_.isEmpty()) FlushAlbumsRequests();
+  if (!album_songs_requests_queue_.isEmpty()) FlushAlbumSongsRequests();
+  if (!album_cover_requests_queue_.isEmpty()) FlushAlbumCoverRequests();
+
+}
+
+template<typename T>
+bool SubsonicRequest::RequeueRequest(QNetworkReply *reply, QList<QNetworkReply*> &replies, QQueue<T> &queue, T request, int &requests_active) {
+
+  if (finished_ || !replies.contains(reply) || !InternetRequestScheduler::RetryLater(reply) || request.retries >= InternetRequestScheduler::kMaxRetries) return false;
+
+  replies.removeAll(reply);
+  QObject::disconnect(reply, nullptr, this, nullptr);
+  reply->deleteLater();
+
+  --requests_active;
+  ++request.retries;
+  // It's sent again from FlushRequests() when the scheduler is available after the pause.
+  queue.enqueue(request);
+
+  return true;
+
+}
+
 void SubsonicRequest::GetAlbums() {
 
   emit UpdateStatus(tr("Retrieving albums..."));
@@ -134,13 +166,13 @@ void SubsonicRequest::AddAlbumsRequest(const int offset, const int size) {
   request.size = size;
   request.offset = offset;
   albums_requests_queue_.enqueue(request);
-  if (albums_requests_active_ < kMaxConcurrentAlbumsRequests) FlushAlbumsRequests();
+  FlushAlbumsRequests();
 
 }
 
 void SubsonicRequest::FlushAlbumsRequests() {
 
-  while (!albums_requests_queue_.isEmpty() && albums_requests_active_ < kMaxConcurrentAlbumsRequests) {
+  while (!albums_requests_queue_.isEmpty() && CanStartRequest()) {
 
     Request request = albums_requests_queue_.dequeue();
     ++albums_requests_active_;
@@ -149,9 +181,12 @@ void SubsonicRequest::FlushAlbumsRequests() {
     if (request.size > 0) params << Param("size", QString::number(request.size));
     if (request.offset > 0) params << Param("offset", QString::number(request.offset));
 
-    QNetworkReply *reply = CreateGetRequest(QString("getAlbumList2"), params);
+    QNetworkReply *reply = CreateGetRequest(QString("getAlbumList2"), params, InternetRequestScheduler::Priority::Background);
     replies_ << reply;
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { AlbumsReplyReceived(reply, request.offset, request.size); });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, replies_, albums_requests_queue_, request, albums_requests_active_)) return;
+      AlbumsReplyReceived(reply, request.offset, request.size);
+    });
     timeouts_->AddReply(reply);
 
   }
@@ -218,7 +253,6 @@ void SubsonicRequest::AlbumsReplyReceived(QNetworkReply *reply, const int offset
   }
   json_obj = value_albumlist.toObject();
   if (json_obj.isEmpty()) {
-    if (offset_requested == 0) no_results_ = true;
     AlbumsFinishCheck(offset_requested, size_requested);
     return;
   }
@@ -229,7 +263,6 @@ void SubsonicRequest::AlbumsReplyReceived(QNetworkReply *reply, const int offset
   }
   QJsonValue json_album = json_obj["album"];
   if (json_album.isNull()) {
-    if (offset_requested == 0) no_results_ = true;
     AlbumsFinishCheck(offset_requested, size_requested);
     return;
   }
@@ -240,7 +273,6 @@ void SubsonicRequest::AlbumsReplyReceived(QNetworkReply *reply, const int offset
   QJsonArray array_albums = json_album.toArray();
 
   if (array_albums.isEmpty()) {
-    if (offset_requested == 0) no_results_ = true;
     AlbumsFinishCheck(offset_requested, size_requested);
     return;
   }
@@ -278,9 +310,18 @@ void SubsonicRequest::AlbumsReplyReceived(QNetworkReply *reply, const int offset
 
     if (album_songs_requests_pending_.contains(album_id)) continue;
 
+    // Newer servers have the time the album last changed.
+    // Without it the album is always fetched, the time it was created stays the same when songs are added or edited.
+    qint64 album_changed = 0;
+    if (obj_album.contains("changed")) {
+      album_changed = QDateTime::fromString(obj_album["changed"].toString(), Qt::ISODate).toSecsSinceEpoch();
+    }
+
     Request request;
     request.album_id = album_id;
     request.album_artist = artist;
+    request.album_changed = album_changed;
+    if (obj_album.contains("songCount")) request.album_song_count = obj_album["songCount"].toInt();
     album_songs_requests_pending_.insert(album_id, request);
 
   }
@@ -300,57 +341,94 @@ void SubsonicRequest::AlbumsFinishCheck(const int offset, const int size, const
     }
   }
 
-  if (!albums_requests_queue_.isEmpty() && albums_requests_active_ < kMaxConcurrentAlbumsRequests) FlushAlbumsRequests();
+  if (!albums_requests_queue_.isEmpty()) FlushAlbumsRequests();
+
+  if (albums_requests_queue_.isEmpty() && albums_requests_active_ <= 0) { // Albums list is finished, get songs for new and changed albums.
+    albums_list_finished_ = true;
+    RequestChangedAlbums();
+  }
+
+  FinishCheck();
+
+}
+
+void SubsonicRequest::SetCollectionAlbums(const CollectionBackend::AlbumSyncStates &albums) {
+
+  collection_albums_ = albums;
+  collection_albums_loaded_ = true;
+
+  if (finished_) return;
+
+  RequestChangedAlbums();
+  FinishCheck();
+
+}
 
-  if (albums_requests_queue_.isEmpty() && albums_requests_active_ <= 0) { // Albums list is finished, get songs for all albums.
+void SubsonicRequest::RequestChangedAlbums() {
 
-    for (QHash<QString, Request> ::iterator it = album_songs_requests_pending_.begin(); it != album_songs_requests_pending_.end(); ++it) {
-      Request request = it.value();
-      AddAlbumSongsRequest(request.artist_id, request.album_id, request.album_artist);
+  if (!albums_list_finished_ || !collection_albums_loaded_ || albums_checked_) return;
+
+  albums_checked_ = true;
+
+  // The songs of albums that are gone from the server are deleted, unless the album list might be incomplete.
+  if (errors_.isEmpty()) {
+    for (CollectionBackend::AlbumSyncStates::const_iterator it = collection_albums_.constBegin(); it != collection_albums_.constEnd(); ++it) {
+      if (!album_songs_requests_pending_.contains(it.key())) albums_updated_.insert(it.key());
     }
-    album_songs_requests_pending_.clear();
+  }
 
-    if (album_songs_requested_ > 0) {
-      if (album_songs_requested_ == 1) emit UpdateStatus(tr("Retrieving songs for %1 album...").arg(album_songs_requested_));
-      else emit UpdateStatus(tr("Retrieving songs for %1 albums...").arg(album_songs_requested_));
-      emit ProgressSetMaximum(album_songs_requested_);
-      emit UpdateProgress(0);
+  for (QHash<QString, Request>::const_iterator it = album_songs_requests_pending_.constBegin(); it != album_songs_requests_pending_.constEnd(); ++it) {
+    const Request &request = it.value();
+    if (request.album_changed > 0 && collection_albums_.contains(request.album_id)) {
+      const CollectionBackend::AlbumSyncState &state = collection_albums_[request.album_id];
+      if (state.mtime == request.album_changed && (request.album_song_count < 0 || state.song_count == request.album_song_count)) continue;
     }
+    AddAlbumSongsRequest(request.artist_id, request.album_id, request.album_artist, request.album_changed);
   }
+  album_songs_requests_pending_.clear();
 
-  FinishCheck();
+  if (album_songs_requested_ > 0) {
+    if (album_songs_requested_ == 1) emit UpdateStatus(tr("Retrieving songs for %1 album...").arg(album_songs_requested_));
+    else emit UpdateStatus(tr("Retrieving songs for %1 albums...").arg(album_songs_requested_));
+    emit ProgressSetMaximum(album_songs_requested_);
+    emit UpdateProgress(0);
+  }
 
 }
 
-void SubsonicRequest::AddAlbumSongsRequest(const QString &artist_id, const QString &album_id, const QString &album_artist, const int offset) {
+void SubsonicRequest::AddAlbumSongsRequest(const QString &artist_id, const QString &album_id, const QString &album_artist, const qint64 album_changed, const int offset) {
 
   Request request;
   request.artist_id = artist_id;
   request.album_id = album_id;
   request.album_artist = album_artist;
+  request.album_changed = album_changed;
   request.offset = offset;
   album_songs_requests_queue_.enqueue(request);
   ++album_songs_requested_;
-  if (album_songs_requests_active_ < kMaxConcurrentAlbumSongsRequests) FlushAlbumSongsRequests();
+  FlushAlbumSongsRequests();
 
 }
 
 void SubsonicRequest::FlushAlbumSongsRequests() {
 
-  while (!album_songs_requests_queue_.isEmpty() && album_songs_requests_active_ < kMaxConcurrentAlbumSongsRequests) {
+  while (!album_songs_requests_queue_.isEmpty() && CanStartRequest()) {
 
     Request request = album_songs_requests_queue_.dequeue();
     ++album_songs_requests_active_;
-    QNetworkReply *reply = CreateGetRequest(QString("getAlbum"), ParamList() << Param("id", request.album_id));
+    QNetworkReply *reply = CreateGetRequest(QString("getAlbum"), ParamList() << Param("id", request.album_id), InternetRequestScheduler::Priority::Background);
     replies_ << reply;
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { AlbumSongsReplyReceived(reply, request.artist_id, request.album_id, request.album_artist); });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, replies_, album_songs_requests_queue_, request, album_songs_requests_active_)) return;
+      AlbumSongsReplyReceived(reply, request.artist_id, request.album_id, request.album_artist, request.album_changed);
+    });
     timeouts_->AddReply(reply);
 
   }
 
 }
 
-void SubsonicRequest::AlbumSongsReplyReceived(QNetworkReply *reply, const QString &artist_id, const QString &album_id, const QString &album_artist) {
+void SubsonicRequest::AlbumSongsReplyReceived(QNetworkReply *reply, const QString &artist_id, const QString &album_id, const QString &album_artist, const qint64 album_changed) {
 
   if (!replies_.contains(reply)) return;
   replies_.removeAll(reply);
@@ -454,8 +532,11 @@ void SubsonicRequest::AlbumSongsReplyReceived(QNetworkReply *reply, const QStrin
     if (!multidisc) {
       song.set_disc(0);
     }
+    // Stored as mtime, so the next sync can tell if the album changed.
+    if (album_changed > 0) song.set_mtime(album_changed);
     songs_.insert(song.song_id(), song);
   }
+  albums_updated_.insert(album_id);
 
   SongsFinishCheck();
 
@@ -465,7 +546,7 @@ void SubsonicRequest::SongsFinishCheck() {
 
   if (finished_) return;
 
-  if (!album_songs_requests_queue_.isEmpty() && album_songs_requests_active_ < kMaxConcurrentAlbumSongsRequests) FlushAlbumSongsRequests();
+  if (!album_songs_requests_queue_.isEmpty()) FlushAlbumSongsRequests();
 
   if (
       download_album_covers() &&
@@ -733,7 +814,7 @@ void SubsonicRequest::AddAlbumCoverRequest(const Song &song) {
 
 void SubsonicRequest::FlushAlbumCoverRequests() {
 
-  while (!album_cover_requests_queue_.isEmpty() && album_covers_requests_active_ < kMaxConcurrentAlbumCoverRequests) {
+  while (!album_cover_requests_queue_.isEmpty() && request_scheduler()->CanStart(album_cover_requests_queue_.head().url, InternetRequestScheduler::Priority::Background)) {
 
     AlbumCoverRequest request = album_cover_requests_queue_.dequeue();
     ++album_covers_requests_active_;
@@ -752,8 +833,12 @@ void SubsonicRequest::FlushAlbumCoverRequests() {
     }
 
     QNetworkReply *reply = network_->get(req);
+    request_scheduler()->AddReply(reply, InternetRequestScheduler::Priority::Background);
     album_cover_replies_ << reply;
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { AlbumCoverReceived(reply, request); });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, album_cover_replies_, album_cover_requests_queue_, request, album_covers_requests_active_)) return;
+      AlbumCoverReceived(reply, request);
+    });
     timeouts_->AddReply(reply);
 
   }
@@ -849,7 +934,7 @@ void SubsonicRequest::AlbumCoverReceived(QNetworkReply *reply, const AlbumCoverR
 
 void SubsonicRequest::AlbumCoverFinishCheck() {
 
-  if (!album_cover_requests_queue_.isEmpty() && album_covers_requests_active_ < kMaxConcurrentAlbumCoverRequests) {
+  if (!album_cover_requests_queue_.isEmpty()) {
     FlushAlbumCoverRequests();
   }
 
@@ -861,6 +946,7 @@ void SubsonicRequest::FinishCheck() {
 
   if (
       !finished_ &&
+      albums_checked_ &&
       albums_requests_queue_.isEmpty() &&
       album_songs_requests_queue_.isEmpty() &&
       album_cover_requests_queue_.isEmpty() &&
@@ -873,17 +959,7 @@ void SubsonicRequest::FinishCheck() {
       album_covers_received_ >= album_covers_requested_
   ) {
     finished_ = true;
-    if (no_results_ && songs_.isEmpty()) {
-      emit Results(SongMap(), QString());
-    }
-    else {
-      if (songs_.isEmpty() && errors_.isEmpty()) {
-        emit Results(songs_, tr("Unknown error"));
-      }
-      else {
-        emit Results(songs_, ErrorsToHTML(errors_));
-      }
-    }
+    emit Results(albums_updated_.values(), songs_, ErrorsToHTML(errors_));
 
   }
 
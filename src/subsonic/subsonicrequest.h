@@ -38,6 +38,7 @@
 #include <QJsonObject>
 
 #include "core/song.h"
+#include "collection/collectionbackend.h"
 #include "subsonicbaserequest.h"
 
 class QNetworkAccessManager;
@@ -59,44 +60,58 @@ class SubsonicRequest : public SubsonicBaseRequest {
   void GetAlbums();
   void Reset();
 
+  // The albums already in the collection, only albums that are new or changed since are fetched.
+  void SetCollectionAlbums(const CollectionBackend::AlbumSyncStates &albums);
+
  private:
   struct Request {
-    explicit Request() : offset(0), size(0) {}
+    explicit Request() : offset(0), size(0), album_changed(0), album_song_count(-1), retries(0) {}
     QString artist_id;
     QString album_id;
     QString song_id;
     int offset;
     int size;
     QString album_artist;
+    qint64 album_changed;
+    int album_song_count;
+    int retries;
   };
   struct AlbumCoverRequest {
+    AlbumCoverRequest() : retries(0) {}
     QString artist_id;
     QString album_id;
     QString cover_id;
     QUrl url;
     QString filename;
+    int retries;
   };
 
  signals:
-  void Results(const SongMap &songs, const QString &error);
+  void Results(const QStringList &album_ids, const SongMap &songs, const QString &error);
   void UpdateStatus(const QString &text);
   void ProgressSetMaximum(const int max);
   void UpdateProgress(const int progress);
 
  private slots:
   void AlbumsReplyReceived(QNetworkReply *reply, const int offset_requested, const int size_requested);
-  void AlbumSongsReplyReceived(QNetworkReply *reply, const QString &artist_id, const QString &album_id, const QString &album_artist);
+  void AlbumSongsReplyReceived(QNetworkReply *reply, const QString &artist_id, const QString &album_id, const QString &album_artist, const qint64 album_changed);
   void AlbumCoverReceived(QNetworkReply *reply, const AlbumCoverRequest &request);
+  void FlushRequests();
 
  private:
 
   void AddAlbumsRequest(const int offset = 0, const int size = 500);
   void FlushAlbumsRequests();
 
+  // Puts the request back in the queue if the server asked us to back off, returns true if it did.
+  template<typename T>
+  bool RequeueRequest(QNetworkReply *reply, QList<QNetworkReply*> &replies, QQueue<T> &queue, T request, int &requests_active);
+
   void AlbumsFinishCheck(const int offset = 0, const int size = 0, const int albums_received = 0);
   void SongsFinishCheck();
 
-  void AddAlbumSongsRequest(const QString &artist_id, const QString &album_id, const QString &album_artist, const int offset = 0);
+  void RequestChangedAlbums();
+  void AddAlbumSongsRequest(const QString &artist_id, const QString &album_id, const QString &album_artist, const qint64 album_changed, const int offset = 0);
   void FlushAlbumSongsRequests();
 
   QString ParseSong(Song &song, const QJsonObject &json_obj, const QString &artist_id_requested = QString(), const QString &album_id_requested = QString(), const QString &album_artist = QString(), const qint64 album_created = 0);
@@ -106,15 +121,11 @@ class SubsonicRequest : public SubsonicBaseRequest {
   void FlushAlbumCoverRequests();
   void AlbumCoverFinishCheck();
 
+  bool CanStartRequest() const { return request_scheduler()->CanStart(server_url(), InternetRequestScheduler::Priority::Background); }
   void FinishCheck();
   static void Warn(const QString &error, const QVariant &debug = QVariant());
   void Error(const QString &error, const QVariant &debug = QVariant()) override;
 
-  static const int kMaxConcurrentAlbumsRequests;
-  static const int kMaxConcurrentArtistAlbumsRequests;
-  static const int kMaxConcurrentAlbumSongsRequests;
-  static const int kMaxConcurrentAlbumCoverRequests;
-
   SubsonicService *service_;
   SubsonicUrlHandler *url_handler_;
   Application *app_;
@@ -143,7 +154,14 @@ class SubsonicRequest : public SubsonicBaseRequest {
   SongMap songs_;
   QMap<QString, QUrl> cover_urls_;
   QStringList errors_;
-  bool no_results_;
+
+  CollectionBackend::AlbumSyncStates collection_albums_;
+  bool collection_albums_loaded_;
+  bool albums_list_finished_;
+  bool albums_checked_;
+  // Albums that were fetched or deleted, the collection is updated for these only.
+  QSet<QString> albums_updated_;
+
   QList<QNetworkReply*> replies_;
   QList<QNetworkReply*> album_cover_replies_;
 };
@@ -41,6 +41,9 @@
 #include <QJsonObject>
 #include <QSettings>
 #include <QSortFilterProxyModel>
+#include <QtConcurrentRun>
+#include <QFuture>
+#include <QFutureWatcher>
 
 #include "core/logging.h"
 #include "core/shared_ptr.h"
@@ -438,6 +441,17 @@ void SubsonicService::GetSongs() {
 
   songs_request_->GetAlbums();
 
+  // Look up what's in the collection while the album list is downloaded, so only new and changed albums are fetched.
+  SharedPtr<SubsonicRequest> request = songs_request_;
+  SharedPtr<CollectionBackend> collection_backend = collection_backend_;
+  QFuture<CollectionBackend::AlbumSyncStates> future = QtConcurrent::run([collection_backend]() { return collection_backend->GetAlbumSyncStates(); });
+  QFutureWatcher<CollectionBackend::AlbumSyncStates> *watcher = new QFutureWatcher<CollectionBackend::AlbumSyncStates>();
+  QObject::connect(watcher, &QFutureWatcher<CollectionBackend::AlbumSyncStates>::finished, this, [this, watcher, request]() {
+    if (songs_request_ == request) request->SetCollectionAlbums(watcher->result());
+    watcher->deleteLater();
+  });
+  watcher->setFuture(future);
+
 }
 
 void SubsonicService::DeleteSongs() {
@@ -446,9 +460,9 @@ void SubsonicService::DeleteSongs() {
 
 }
 
-void SubsonicService::SongsResultsReceived(const SongMap &songs, const QString &error) {
+void SubsonicService::SongsResultsReceived(const QStringList &album_ids, const SongMap &songs, const QString &error) {
 
-  emit SongsResults(songs, error);
+  emit SongsAlbumsResults(album_ids, songs, error);
 
   ResetSongsRequest();
 
@@ -98,7 +98,7 @@ class SubsonicService : public InternetService {
  private slots:
   void HandlePingSSLErrors(const QList<QSslError> &ssl_errors);
   void HandlePingReply(QNetworkReply *reply, const QUrl &url, const QString &username, const QString &password, const SubsonicSettingsPage::AuthMethod auth_method);
-  void SongsResultsReceived(const SongMap &songs, const QString &error);
+  void SongsResultsReceived(const QStringList &album_ids, const SongMap &songs, const QString &error);
 
  private:
   void PingError(const QString &error = QString(), const QVariant &debug = QVariant());
@@ -19,6 +19,7 @@
 
 #include "config.h"
 
+#include <QtGlobal>
 #include <QObject>
 #include <QByteArray>
 #include <QPair>
@@ -37,6 +38,7 @@
 #include "core/logging.h"
 #include "core/shared_ptr.h"
 #include "core/networkaccessmanager.h"
+#include "internet/internetrequestscheduler.h"
 #include "tidalservice.h"
 #include "tidalbaserequest.h"
 
@@ -45,7 +47,7 @@ TidalBaseRequest::TidalBaseRequest(TidalService *service, SharedPtr<NetworkAcces
       service_(service),
       network_(network) {}
 
-QNetworkReply *TidalBaseRequest::CreateRequest(const QString &ressource_name, const ParamList &params_provided) {
+QNetworkReply *TidalBaseRequest::CreateRequest(const QString &ressource_name, const ParamList &params_provided, const InternetRequestScheduler::Priority priority) {
 
   ParamList params = ParamList() << params_provided
                                  << Param("countryCode", country_code());
@@ -60,10 +62,15 @@ QNetworkReply *TidalBaseRequest::CreateRequest(const QString &ressource_name, co
   QNetworkRequest req(url);
   req.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
   req.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+  // The requests to the API share one connection when the server supports HTTP/2.
+  req.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+#endif
   if (oauth() && !access_token().isEmpty()) req.setRawHeader("authorization", "Bearer " + access_token().toUtf8());
   else if (!session_id().isEmpty()) req.setRawHeader("X-Tidal-SessionId", session_id().toUtf8());
 
   QNetworkReply *reply = network_->get(req);
+  request_scheduler()->AddReply(reply, priority);
   QObject::connect(reply, &QNetworkReply::sslErrors, this, &TidalBaseRequest::HandleSSLErrors);
 
   //qLog(Debug) << "Tidal: Sending request" << url;
@@ -37,6 +37,7 @@
 #include <QJsonValue>
 
 #include "core/shared_ptr.h"
+#include "internet/internetrequestscheduler.h"
 #include "tidalservice.h"
 
 class QNetworkReply;
@@ -63,7 +64,8 @@ class TidalBaseRequest : public QObject {
   using Param = QPair<QString, QString>;
   using ParamList = QList<Param>;
 
-  QNetworkReply *CreateRequest(const QString &ressource_name, const ParamList &params_provided);
+  QNetworkReply *CreateRequest(const QString &ressource_name, const ParamList &params_provided, const InternetRequestScheduler::Priority priority = InternetRequestScheduler::Priority::Interactive);
+  bool CanStartRequest(const InternetRequestScheduler::Priority priority) { return request_scheduler()->CanStart(QUrl(TidalService::kApiUrl), priority); }
   QByteArray GetReplyData(QNetworkReply *reply, const bool send_login);
   QJsonObject ExtractJsonObj(const QByteArray &data);
   QJsonValue ExtractItems(const QByteArray &data);
@@ -87,6 +89,8 @@ class TidalBaseRequest : public QObject {
   QString access_token() { return service_->access_token(); }
   QString session_id() { return service_->session_id(); }
 
+  InternetRequestScheduler *request_scheduler() { return service_->request_scheduler(); }
+
   bool authenticated() { return service_->authenticated(); }
   bool login_sent() { return service_->login_sent(); }
   int max_login_attempts() { return service_->max_login_attempts(); }
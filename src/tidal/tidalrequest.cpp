@@ -48,12 +48,6 @@
 #include "tidalrequest.h"
 
 constexpr char TidalRequest::kResourcesUrl[] = "https://resources.tidal.com";
-constexpr int TidalRequest::kMaxConcurrentArtistsRequests = 3;
-constexpr int TidalRequest::kMaxConcurrentAlbumsRequests = 3;
-constexpr int TidalRequest::kMaxConcurrentSongsRequests = 3;
-constexpr int TidalRequest::kMaxConcurrentArtistAlbumsRequests = 3;
-constexpr int TidalRequest::kMaxConcurrentAlbumSongsRequests = 3;
-constexpr int TidalRequest::kMaxConcurrentAlbumCoverRequests = 1;
 constexpr int TidalRequest::kFlushRequestsDelay = 200;
 
 TidalRequest::TidalRequest(TidalService *service, TidalUrlHandler *url_handler, Application *app, SharedPtr<NetworkAccessManager> network, QueryType query_type, QObject *parent)
@@ -179,6 +173,26 @@ void TidalRequest::StartRequests() {
 
 }
 
+template<typename T>
+bool TidalRequest::RequeueRequest(QNetworkReply *reply, QList<QNetworkReply*> &replies, QQueue<T> &queue, T request, int &requests_active) {
+
+  if (finished_ || !replies.contains(reply) || !InternetRequestScheduler::RetryLater(reply) || request.retries >= InternetRequestScheduler::kMaxRetries) return false;
+
+  replies.removeAll(reply);
+  QObject::disconnect(reply, nullptr, this, nullptr);
+  reply->deleteLater();
+
+  --requests_active;
+  ++request.retries;
+  queue.enqueue(request);
+
+  // The scheduler holds the request back until the server is ready again.
+  StartRequests();
+
+  return true;
+
+}
+
 void TidalRequest::FlushRequests() {
 
   if (!artists_requests_queue_.isEmpty()) {
@@ -243,7 +257,7 @@ void TidalRequest::AddArtistsRequest(const int offset, const int limit) {
 
 void TidalRequest::FlushArtistsRequests() {
 
-  while (!artists_requests_queue_.isEmpty() && artists_requests_active_ < kMaxConcurrentArtistsRequests) {
+  while (!artists_requests_queue_.isEmpty() && CanStartRequest(RequestPriority())) {
 
     Request request = artists_requests_queue_.dequeue();
 
@@ -253,14 +267,17 @@ void TidalRequest::FlushArtistsRequests() {
     if (request.offset > 0) parameters << Param("offset", QString::number(request.offset));
     QNetworkReply *reply = nullptr;
     if (query_type_ == QueryType::Artists) {
-      reply = CreateRequest(QString("users/%1/favorites/artists").arg(service_->user_id()), parameters);
+      reply = CreateRequest(QString("users/%1/favorites/artists").arg(service_->user_id()), parameters, RequestPriority());
     }
     if (query_type_ == QueryType::SearchArtists) {
-      reply = CreateRequest("search/artists", parameters);
+      reply = CreateRequest("search/artists", parameters, RequestPriority());
     }
     if (!reply) continue;
     replies_ << reply;
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { ArtistsReplyReceived(reply, request.limit, request.offset); });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, replies_, artists_requests_queue_, request, artists_requests_active_)) return;
+      ArtistsReplyReceived(reply, request.limit, request.offset);
+    });
 
     ++artists_requests_active_;
 
@@ -291,7 +308,7 @@ void TidalRequest::AddAlbumsRequest(const int offset, const int limit) {
 
 void TidalRequest::FlushAlbumsRequests() {
 
-  while (!albums_requests_queue_.isEmpty() && albums_requests_active_ < kMaxConcurrentAlbumsRequests) {
+  while (!albums_requests_queue_.isEmpty() && CanStartRequest(RequestPriority())) {
 
     Request request = albums_requests_queue_.dequeue();
 
@@ -301,14 +318,17 @@ void TidalRequest::FlushAlbumsRequests() {
     if (request.offset > 0) parameters << Param("offset", QString::number(request.offset));
     QNetworkReply *reply = nullptr;
     if (query_type_ == QueryType::Albums) {
-      reply = CreateRequest(QString("users/%1/favorites/albums").arg(service_->user_id()), parameters);
+      reply = CreateRequest(QString("users/%1/favorites/albums").arg(service_->user_id()), parameters, RequestPriority());
     }
     if (query_type_ == QueryType::SearchAlbums) {
-      reply = CreateRequest("search/albums", parameters);
+      reply = CreateRequest("search/albums", parameters, RequestPriority());
     }
     if (!reply) continue;
     replies_ << reply;
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { AlbumsReplyReceived(reply, request.limit, request.offset); });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, replies_, albums_requests_queue_, request, albums_requests_active_)) return;
+      AlbumsReplyReceived(reply, request.limit, request.offset);
+    });
 
     ++albums_requests_active_;
 
@@ -339,7 +359,7 @@ void TidalRequest::AddSongsRequest(const int offset, const int limit) {
 
 void TidalRequest::FlushSongsRequests() {
 
-  while (!songs_requests_queue_.isEmpty() && songs_requests_active_ < kMaxConcurrentSongsRequests) {
+  while (!songs_requests_queue_.isEmpty() && CanStartRequest(RequestPriority())) {
 
     Request request = songs_requests_queue_.dequeue();
 
@@ -349,14 +369,17 @@ void TidalRequest::FlushSongsRequests() {
     if (request.offset > 0) parameters << Param("offset", QString::number(request.offset));
     QNetworkReply *reply = nullptr;
     if (query_type_ == QueryType::Songs) {
-      reply = CreateRequest(QString("users/%1/favorites/tracks").arg(service_->user_id()), parameters);
+      reply = CreateRequest(QString("users/%1/favorites/tracks").arg(service_->user_id()), parameters, RequestPriority());
     }
     if (query_type_ == QueryType::SearchSongs) {
-      reply = CreateRequest("search/tracks", parameters);
+      reply = CreateRequest("search/tracks", parameters, RequestPriority());
     }
     if (!reply) continue;
     replies_ << reply;
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { SongsReplyReceived(reply, request.limit, request.offset); });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, replies_, songs_requests_queue_, request, songs_requests_active_)) return;
+      SongsReplyReceived(reply, request.limit, request.offset);
+    });
 
     ++songs_requests_active_;
 
@@ -579,14 +602,17 @@ void TidalRequest::AddArtistAlbumsRequest(const Artist &artist, const int offset
 
 void TidalRequest::FlushArtistAlbumsRequests() {
 
-  while (!artist_albums_requests_queue_.isEmpty() && artist_albums_requests_active_ < kMaxConcurrentArtistAlbumsRequests) {
+  while (!artist_albums_requests_queue_.isEmpty() && CanStartRequest(RequestPriority())) {
 
     const ArtistAlbumsRequest request = artist_albums_requests_queue_.dequeue();
 
     ParamList parameters;
     if (request.offset > 0) parameters << Param("offset", QString::number(request.offset));
-    QNetworkReply *reply = CreateRequest(QString("artists/%1/albums").arg(request.artist.artist_id), parameters);
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { ArtistAlbumsReplyReceived(reply, request.artist, request.offset); });
+    QNetworkReply *reply = CreateRequest(QString("artists/%1/albums").arg(request.artist.artist_id), parameters, RequestPriority());
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, replies_, artist_albums_requests_queue_, request, artist_albums_requests_active_)) return;
+      ArtistAlbumsReplyReceived(reply, request.artist, request.offset);
+    });
     replies_ << reply;
 
     ++artist_albums_requests_active_;
@@ -855,14 +881,17 @@ void TidalRequest::AddAlbumSongsRequest(const Artist &artist, const Album &album
 
 void TidalRequest::FlushAlbumSongsRequests() {
 
-  while (!album_songs_requests_queue_.isEmpty() && album_songs_requests_active_ < kMaxConcurrentAlbumSongsRequests) {
+  while (!album_songs_requests_queue_.isEmpty() && CanStartRequest(RequestPriority())) {
 
     AlbumSongsRequest request = album_songs_requests_queue_.dequeue();
     ParamList parameters;
     if (request.offset > 0) parameters << Param("offset", QString::number(request.offset));
-    QNetworkReply *reply = CreateRequest(QString("albums/%1/tracks").arg(request.album.album_id), parameters);
+    QNetworkReply *reply = CreateRequest(QString("albums/%1/tracks").arg(request.album.album_id), parameters, RequestPriority());
     replies_ << reply;
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { AlbumSongsReplyReceived(reply, request.artist, request.album, request.offset); });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, replies_, album_songs_requests_queue_, request, album_songs_requests_active_)) return;
+      AlbumSongsReplyReceived(reply, request.artist, request.album, request.offset);
+    });
 
     ++album_songs_requests_active_;
 
@@ -1222,15 +1251,19 @@ void TidalRequest::AddAlbumCoverRequest(const Song &song) {
 
 void TidalRequest::FlushAlbumCoverRequests() {
 
-  while (!album_cover_requests_queue_.isEmpty() && album_covers_requests_active_ < kMaxConcurrentAlbumCoverRequests) {
+  while (!album_cover_requests_queue_.isEmpty() && request_scheduler()->CanStart(album_cover_requests_queue_.head().url, RequestPriority())) {
 
     AlbumCoverRequest request = album_cover_requests_queue_.dequeue();
 
     QNetworkRequest req(request.url);
     req.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
     QNetworkReply *reply = network_->get(req);
+    request_scheduler()->AddReply(reply, RequestPriority());
     album_cover_replies_ << reply;
-    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() { AlbumCoverReceived(reply, request.album_id, request.url, request.filename); });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, request]() {
+      if (RequeueRequest(reply, album_cover_replies_, album_cover_requests_queue_, request, album_covers_requests_active_)) return;
+      AlbumCoverReceived(reply, request.album_id, request.url, request.filename);
+    });
 
     ++album_covers_requests_active_;
 
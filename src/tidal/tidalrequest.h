@@ -75,28 +75,33 @@ class TidalRequest : public TidalBaseRequest {
     bool album_explicit;
   };
   struct Request {
-    Request() : offset(0), limit(0) {}
+    Request() : offset(0), limit(0), retries(0) {}
     int offset;
     int limit;
+    int retries;
   };
   struct ArtistAlbumsRequest {
-    ArtistAlbumsRequest() : offset(0), limit(0) {}
+    ArtistAlbumsRequest() : offset(0), limit(0), retries(0) {}
     Artist artist;
     int offset;
     int limit;
+    int retries;
   };
   struct AlbumSongsRequest {
-    AlbumSongsRequest() : offset(0), limit(0) {}
+    AlbumSongsRequest() : offset(0), limit(0), retries(0) {}
     Artist artist;
     Album album;
     int offset;
     int limit;
+    int retries;
   };
   struct AlbumCoverRequest {
+    AlbumCoverRequest() : retries(0) {}
     QString artist_id;
     QString album_id;
     QUrl url;
     QString filename;
+    int retries;
   };
 
  signals:
@@ -126,10 +131,15 @@ class TidalRequest : public TidalBaseRequest {
  private:
   bool IsQuery() { return (query_type_ == QueryType::Artists || query_type_ == QueryType::Albums || query_type_ == QueryType::Songs); }
   bool IsSearch() { return (query_type_ == QueryType::SearchArtists || query_type_ == QueryType::SearchAlbums || query_type_ == QueryType::SearchSongs); }
+  InternetRequestScheduler::Priority RequestPriority() { return IsSearch() ? InternetRequestScheduler::Priority::Interactive : InternetRequestScheduler::Priority::Background; }
 
   void StartRequests();
   void FlushRequests();
 
+  // Puts the request back in the queue if the server asked us to back off, returns true if it did.
+  template<typename T>
+  bool RequeueRequest(QNetworkReply *reply, QList<QNetworkReply*> &replies, QQueue<T> &queue, T request, int &requests_active);
+
   void GetArtists();
   void GetAlbums();
   void GetSongs();
@@ -173,12 +183,6 @@ class TidalRequest : public TidalBaseRequest {
   void Error(const QString &error, const QVariant &debug = QVariant()) override;
 
   static const char kResourcesUrl[];
-  static const int kMaxConcurrentArtistsRequests;
-  static const int kMaxConcurrentAlbumsRequests;
-  static const int kMaxConcurrentSongsRequests;
-  static const int kMaxConcurrentArtistAlbumsRequests;
-  static const int kMaxConcurrentAlbumSongsRequests;
-  static const int kMaxConcurrentAlbumCoverRequests;
   static const int kFlushRequestsDelay;
 
   TidalService *service_;
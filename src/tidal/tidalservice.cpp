@@ -51,6 +51,7 @@
 #include "utilities/randutils.h"
 #include "utilities/timeconstants.h"
 #include "internet/internetsearchview.h"
+#include "internet/internetstreamurlcache.h"
 #include "collection/collectionbackend.h"
 #include "collection/collectionmodel.h"
 #include "tidalservice.h"
@@ -91,6 +92,7 @@ TidalService::TidalService(Application *app, QObject *parent)
       app_(app),
       network_(app->network()),
       url_handler_(new TidalUrlHandler(app, this)),
+      stream_url_cache_(new InternetStreamUrlCache("tidalstreamurls.cache", this)),
       artists_collection_backend_(nullptr),
       albums_collection_backend_(nullptr),
       songs_collection_backend_(nullptr),
@@ -177,6 +179,9 @@ TidalService::TidalService(Application *app, QObject *parent)
   QObject::connect(this, &TidalService::RequestLogin, this, &TidalService::SendLogin);
   QObject::connect(this, &TidalService::LoginWithCredentials, this, &TidalService::SendLoginWithCredentials);
 
+  // Stream URLs resolved for another login or session might not be valid anymore.
+  QObject::connect(this, &TidalService::LoginSuccess, stream_url_cache_, &InternetStreamUrlCache::Clear);
+
   QObject::connect(this, &TidalService::AddArtists, favorite_request_, &TidalFavoriteRequest::AddArtists);
   QObject::connect(this, &TidalService::AddAlbums, favorite_request_, &TidalFavoriteRequest::AddAlbums);
   QObject::connect(this, &TidalService::AddSongs, favorite_request_, QOverload<const SongList&>::of(&TidalFavoriteRequest::AddSongs));
@@ -299,6 +304,8 @@ void TidalService::ReloadSettings() {
 
   s.endGroup();
 
+  stream_url_cache_->set_variant(QString("%1-%2").arg(quality_).arg(static_cast<int>(stream_url_method_)));
+
   timer_search_delay_->setInterval(static_cast<int>(search_delay));
 
 }
@@ -693,6 +700,8 @@ void TidalService::Logout() {
 
   timer_refresh_login_->stop();
 
+  stream_url_cache_->Clear();
+
 }
 
 void TidalService::ResetLoginAttempts() {
@@ -1015,6 +1024,8 @@ void TidalService::HandleStreamURLSuccess(const uint id, const QUrl &media_url,
   if (!stream_url_requests_.contains(id)) return;
   stream_url_requests_.remove(id);
 
+  stream_url_cache_->Insert(media_url, stream_url, filetype, samplerate, bit_depth, duration);
+
   emit StreamURLSuccess(id, media_url, stream_url, filetype, samplerate, bit_depth, duration);
 
 }
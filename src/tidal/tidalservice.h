@@ -52,6 +52,7 @@ class TidalUrlHandler;
 class TidalRequest;
 class TidalFavoriteRequest;
 class TidalStreamURLRequest;
+class InternetStreamUrlCache;
 class CollectionBackend;
 class CollectionModel;
 
@@ -102,6 +103,7 @@ class TidalService : public InternetService {
   bool login_attempts() const { return login_attempts_; }
 
   uint GetStreamURL(const QUrl &url, QString &error);
+  InternetStreamUrlCache *stream_url_cache() const { return stream_url_cache_; }
 
   SharedPtr<CollectionBackend> artists_collection_backend() override { return artists_collection_backend_; }
   SharedPtr<CollectionBackend> albums_collection_backend() override { return albums_collection_backend_; }
@@ -178,6 +180,7 @@ class TidalService : public InternetService {
   Application *app_;
   SharedPtr<NetworkAccessManager> network_;
   TidalUrlHandler *url_handler_;
+  InternetStreamUrlCache *stream_url_cache_;
 
   SharedPtr<CollectionBackend> artists_collection_backend_;
   SharedPtr<CollectionBackend> albums_collection_backend_;
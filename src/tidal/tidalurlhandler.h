@@ -25,6 +25,7 @@
 #include <QtGlobal>
 #include <QObject>
 #include <QMap>
+#include <QHash>
 #include <QString>
 #include <QUrl>
 
@@ -42,6 +43,8 @@ class TidalUrlHandler : public UrlHandler {
 
   QString scheme() const override { return service_->url_scheme(); }
   LoadResult StartLoading(const QUrl &url) override;
+  void Prefetch(const QUrl &url) override;
+  bool LoadFailed(const QUrl &media_url, const QUrl &stream_url) override;
 
  private:
   void CancelTask(const int task_id);
@@ -59,6 +62,10 @@ class TidalUrlHandler : public UrlHandler {
   Application *app_;
   TidalService *service_;
   QMap<uint, Request> requests_;
+  // Stream URL requests started by Prefetch(), the URLs are stored in the stream URL cache when they finish.
+  QMap<uint, QUrl> prefetch_requests_;
+  // Stream URLs StartLoading() took from the cache, they are resolved again once if they fail to play.
+  QHash<QUrl, QUrl> cached_stream_urls_;
 };
 
 #endif  // TIDALURLHANDLER_H
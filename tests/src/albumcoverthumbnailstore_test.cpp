@@ -0,0 +1,253 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <QtGlobal>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <QSize>
+#include <QColor>
+#include <QImage>
+#include <QStandardPaths>
+
+#include "covermanager/albumcoverthumbnailstore.h"
+
+// clazy:excludeall=non-pod-global-static
+
+namespace {
+
+class AlbumCoverThumbnailStoreTest : public ::testing::Test {
+ protected:
+  static constexpr char kName[] = "albumcoverthumbnailstore_test";
+
+  void SetUp() override {
+    // Keeps the files out of the real cache.
+    QStandardPaths::setTestModeEnabled(true);
+    RemoveFile(QSize(16, 16));
+    RemoveFile(QSize(512, 512));
+  }
+
+  void TearDown() override {
+    RemoveFile(QSize(16, 16));
+    RemoveFile(QSize(512, 512));
+    QStandardPaths::setTestModeEnabled(false);
+  }
+
+  static QString Filename(const QSize &tile_size) {
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/" + AlbumCoverThumbnailStore::kThumbnailsDir + "/" + QString("%1-%2x%3.atlas").arg(kName).arg(tile_size.width()).arg(tile_size.height());
+  }
+
+  static void RemoveFile(const QSize &tile_size) {
+    QFile::remove(Filename(tile_size));
+  }
+
+  // Room for this many thumbnails of the given size.
+  static qint64 MaxSize(const QSize &tile_size, const int count) {
+    return (static_cast<qint64>(tile_size.width()) * tile_size.height() * 4 + 16) * count;
+  }
+
+  static QImage MakeImage(const QSize &size, const QColor &color) {
+    QImage image(size, QImage::Format_ARGB32);
+    image.fill(color);
+    return image;
+  }
+};
+
+TEST_F(AlbumCoverThumbnailStoreTest, InsertAndImage) {
+
+  const QSize tile_size(16, 16);
+  AlbumCoverThumbnailStore store(kName, tile_size);
+  ASSERT_TRUE(store.Open(MaxSize(tile_size, 10)));
+  EXPECT_TRUE(store.is_open());
+  EXPECT_EQ(10, store.capacity());
+  EXPECT_EQ(0, store.count());
+  EXPECT_FALSE(store.Contains("red"));
+  EXPECT_TRUE(store.Image("red").isNull());
+
+  store.Insert("red", MakeImage(tile_size, Qt::red));
+  ASSERT_TRUE(store.Contains("red"));
+  EXPECT_EQ(1, store.count());
+
+  const QImage image = store.Image("red");
+  ASSERT_FALSE(image.isNull());
+  EXPECT_EQ(tile_size, image.size());
+  EXPECT_EQ(QColor(Qt::red).rgba(), image.pixel(0, 0));
+  EXPECT_EQ(QColor(Qt::red).rgba(), image.pixel(15, 15));
+
+  // Images that are not the size of a tile are scaled and centered.
+  store.Insert("wide", MakeImage(QSize(32, 16), Qt::blue));
+  const QImage wide_image = store.Image("wide");
+  ASSERT_FALSE(wide_image.isNull());
+  EXPECT_EQ(0, qAlpha(wide_image.pixel(8, 0)));
+  EXPECT_EQ(QColor(Qt::blue).rgba(), wide_image.pixel(8, 8));
+  EXPECT_EQ(0, qAlpha(wide_image.pixel(8, 15)));
+
+  // Inserting the same key again replaces the thumbnail.
+  store.Insert("red", MakeImage(tile_size, Qt::green));
+  EXPECT_EQ(2, store.count());
+  EXPECT_EQ(QColor(Qt::green).rgba(), store.Image("red").pixel(0, 0));
+
+  store.Remove("red");
+  EXPECT_FALSE(store.Contains("red"));
+  EXPECT_EQ(1, store.count());
+
+  store.Clear();
+  EXPECT_EQ(0, store.count());
+  EXPECT_FALSE(store.Contains("wide"));
+
+}
+
+TEST_F(AlbumCoverThumbnailStoreTest, FileGrowsInChunks) {
+
+  // 1 MB tiles, so the file grows by 4 tiles at a time.
+  const QSize tile_size(512, 512);
+  const qint64 tile_bytes = 512 * 512 * 4;
+  AlbumCoverThumbnailStore store(kName, tile_size);
+  ASSERT_TRUE(store.Open(MaxSize(tile_size, 10)));
+  EXPECT_EQ(10, store.capacity());
+
+  // Only the header and the slots are written when the store is created.
+  EXPECT_EQ(0, store.tile_count());
+  const qint64 tiles_offset = QFileInfo(Filename(tile_size)).size();
+  EXPECT_LT(tiles_offset, tile_bytes);
+
+  store.Insert("0", MakeImage(tile_size, Qt::red));
+  EXPECT_EQ(4, store.tile_count());
+  EXPECT_EQ(tiles_offset + tile_bytes * 4, QFileInfo(Filename(tile_size)).size());
+
+  for (int i = 1; i < 4; ++i) {
+    store.Insert(QString::number(i), MakeImage(tile_size, Qt::red));
+  }
+  EXPECT_EQ(4, store.tile_count());
+
+  store.Insert("4", MakeImage(tile_size, Qt::blue));
+  EXPECT_EQ(8, store.tile_count());
+  EXPECT_EQ(tiles_offset + tile_bytes * 8, QFileInfo(Filename(tile_size)).size());
+
+  // The earlier thumbnails are still there after the file was mapped again.
+  EXPECT_EQ(QColor(Qt::red).rgba(), store.Image("0").pixel(0, 0));
+  EXPECT_EQ(QColor(Qt::blue).rgba(), store.Image("4").pixel(0, 0));
+
+  // The file never grows past the capacity.
+  for (int i = 5; i < 20; ++i) {
+    store.Insert(QString::number(i), MakeImage(tile_size, Qt::red));
+  }
+  EXPECT_EQ(10, store.tile_count());
+  EXPECT_EQ(10, store.count());
+  EXPECT_EQ(tiles_offset + tile_bytes * 10, QFileInfo(Filename(tile_size)).size());
+
+}
+
+TEST_F(AlbumCoverThumbnailStoreTest, OldestThumbnailIsReplaced) {
+
+  const QSize tile_size(16, 16);
+  AlbumCoverThumbnailStore store(kName, tile_size);
+  ASSERT_TRUE(store.Open(MaxSize(tile_size, 3)));
+  ASSERT_EQ(3, store.capacity());
+
+  store.Insert("1", MakeImage(tile_size, Qt::red));
+  store.Insert("2", MakeImage(tile_size, Qt::green));
+  store.Insert("3", MakeImage(tile_size, Qt::blue));
+  store.Insert("4", MakeImage(tile_size, Qt::yellow));
+
+  EXPECT_EQ(3, store.count());
+  EXPECT_FALSE(store.Contains("1"));
+  EXPECT_TRUE(store.Contains("2"));
+  EXPECT_TRUE(store.Contains("3"));
+  EXPECT_EQ(QColor(Qt::yellow).rgba(), store.Image("4").pixel(0, 0));
+
+}
+
+TEST_F(AlbumCoverThumbnailStoreTest, Reopen) {
+
+  const QSize tile_size(16, 16);
+  const qint64 max_size = MaxSize(tile_size, 3);
+  {
+    AlbumCoverThumbnailStore store(kName, tile_size);
+    ASSERT_TRUE(store.Open(max_size));
+    store.Insert("1", MakeImage(tile_size, Qt::red));
+    store.Insert("2", MakeImage(tile_size, Qt::green));
+  }
+
+  AlbumCoverThumbnailStore store(kName, tile_size);
+  ASSERT_TRUE(store.Open(max_size));
+  EXPECT_EQ(2, store.count());
+  ASSERT_TRUE(store.Contains("1"));
+  EXPECT_EQ(QColor(Qt::red).rgba(), store.Image("1").pixel(0, 0));
+  EXPECT_EQ(QColor(Qt::green).rgba(), store.Image("2").pixel(0, 0));
+
+  // The store carries on with the next slot, so the oldest thumbnail is still the first one replaced.
+  store.Insert("3", MakeImage(tile_size, Qt::blue));
+  store.Insert("4", MakeImage(tile_size, Qt::yellow));
+  EXPECT_FALSE(store.Contains("1"));
+  EXPECT_TRUE(store.Contains("2"));
+  EXPECT_TRUE(store.Contains("3"));
+  EXPECT_TRUE(store.Contains("4"));
+
+}
+
+TEST_F(AlbumCoverThumbnailStoreTest, RecreatedWhenCapacityChanges) {
+
+  const QSize tile_size(16, 16);
+  {
+    AlbumCoverThumbnailStore store(kName, tile_size);
+    ASSERT_TRUE(store.Open(MaxSize(tile_size, 3)));
+    store.Insert("1", MakeImage(tile_size, Qt::red));
+  }
+
+  AlbumCoverThumbnailStore store(kName, tile_size);
+  ASSERT_TRUE(store.Open(MaxSize(tile_size, 5)));
+  EXPECT_EQ(5, store.capacity());
+  EXPECT_EQ(0, store.count());
+  EXPECT_FALSE(store.Contains("1"));
+
+}
+
+TEST_F(AlbumCoverThumbnailStoreTest, RecreatedWhenTileSizeDiffers) {
+
+  const QSize tile_size(16, 16);
+  const qint64 max_size = MaxSize(tile_size, 3);
+  {
+    AlbumCoverThumbnailStore store(kName, tile_size);
+    ASSERT_TRUE(store.Open(max_size));
+    store.Insert("1", MakeImage(tile_size, Qt::red));
+  }
+
+  // A file with the same size, but written for another tile size.
+  {
+    QFile file(Filename(tile_size));
+    ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+    ASSERT_TRUE(file.seek(8));
+    const quint32 tile_width = 8;
+    ASSERT_EQ(static_cast<qint64>(sizeof(tile_width)), file.write(reinterpret_cast<const char*>(&tile_width), sizeof(tile_width)));
+  }
+
+  AlbumCoverThumbnailStore store(kName, tile_size);
+  ASSERT_TRUE(store.Open(max_size));
+  EXPECT_EQ(0, store.count());
+  EXPECT_FALSE(store.Contains("1"));
+
+  store.Insert("1", MakeImage(tile_size, Qt::green));
+  EXPECT_EQ(QColor(Qt::green).rgba(), store.Image("1").pixel(0, 0));
+
+}
+
+}  // namespace
@@ -0,0 +1,197 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <atomic>
+#include <optional>
+
+#include <gtest/gtest.h>
+
+#include <QtConcurrentRun>
+#include <QObject>
+#include <QThread>
+#include <QFile>
+#include <QByteArray>
+#include <QString>
+#include <QUrl>
+#include <QTemporaryDir>
+
+#include "core/song.h"
+#include "engine/gststartup.h"
+#include "engine/audioanalyzer.h"
+#include "engine/audioanalyzerresult.h"
+#ifdef HAVE_SONGFINGERPRINTING
+#  include "engine/chromaprinter.h"
+#endif
+#ifdef HAVE_EBUR128
+#  include "engine/ebur128analysis.h"
+#  include "engine/ebur128measures.h"
+#endif
+#ifdef HAVE_MOODBAR
+#  include "moodbar/moodbarpipeline.h"
+#endif
+
+// clazy:excludeall=non-pod-global-static
+
+namespace {
+
+// The analyses are blocking and can't run on the application's thread, so they are run on the global thread pool.
+class AudioAnalyzerTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    gst_startup_ = new GstStartup;
+    gst_startup_->EnsureInitialized();
+  }
+
+  static void TearDownTestSuite() {
+    delete gst_startup_;
+    gst_startup_ = nullptr;
+  }
+
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.isValid());
+    filename_ = temp_dir_.path() + "/strawberry.wav";
+    ASSERT_TRUE(QFile::copy(":/audio/strawberry.wav", filename_));
+  }
+
+  AudioAnalyzerResult Analyze(const AudioAnalyzerResult::Analyses analyses) const {
+    const QString filename = filename_;
+    return QtConcurrent::run([filename, analyses]() {
+      AudioAnalyzer analyzer(filename, analyses);
+      return analyzer.Analyze();
+    }).result();
+  }
+
+  static GstStartup *gst_startup_;
+  QTemporaryDir temp_dir_;
+  QString filename_;
+};
+
+GstStartup *AudioAnalyzerTest::gst_startup_ = nullptr;
+
+TEST_F(AudioAnalyzerTest, OnlyAvailableAnalysesAreRun) {
+
+  const AudioAnalyzerResult::Analyses all = AudioAnalyzerResult::Analysis::Fingerprint | AudioAnalyzerResult::Analysis::Loudness | AudioAnalyzerResult::Analysis::Moodbar;
+  const AudioAnalyzerResult result = Analyze(all);
+  EXPECT_EQ(AudioAnalyzer::AvailableAnalyses(), result.analyses);
+
+  const AudioAnalyzerResult none = Analyze(AudioAnalyzerResult::Analysis::None);
+  EXPECT_FALSE(none.analyses);
+  EXPECT_TRUE(none.fingerprint.isEmpty());
+  EXPECT_FALSE(none.loudness);
+  EXPECT_TRUE(none.moodbar.isEmpty());
+
+}
+
+#ifdef HAVE_SONGFINGERPRINTING
+TEST_F(AudioAnalyzerTest, FingerprintMatchesChromaprinter) {
+
+  const AudioAnalyzerResult result = Analyze(AudioAnalyzerResult::Analysis::Fingerprint);
+  ASSERT_FALSE(result.fingerprint.isEmpty());
+  EXPECT_FALSE(result.loudness);
+  EXPECT_TRUE(result.moodbar.isEmpty());
+
+  const QString filename = filename_;
+  const QString fingerprint = QtConcurrent::run([filename]() { return Chromaprinter(filename).CreateFingerprint(); }).result();
+  EXPECT_EQ(fingerprint, result.fingerprint);
+
+}
+#endif
+
+#ifdef HAVE_EBUR128
+TEST_F(AudioAnalyzerTest, LoudnessMatchesEBUR128Analysis) {
+
+  const AudioAnalyzerResult result = Analyze(AudioAnalyzerResult::Analysis::Loudness);
+  ASSERT_TRUE(result.loudness);
+  ASSERT_TRUE(result.loudness->loudness_lufs);
+  ASSERT_TRUE(result.loudness->range_lu);
+
+  // Not a section of the file, so the whole file is analyzed.
+  Song song(Song::Source::LocalFile);
+  song.set_url(QUrl::fromLocalFile(filename_));
+  const std::optional<EBUR128Measures> loudness = QtConcurrent::run([song]() { return EBUR128Analysis::Compute(song); }).result();
+  ASSERT_TRUE(loudness);
+  ASSERT_TRUE(loudness->loudness_lufs);
+  ASSERT_TRUE(loudness->range_lu);
+
+  EXPECT_NEAR(*loudness->loudness_lufs, *result.loudness->loudness_lufs, 0.001);
+  EXPECT_NEAR(*loudness->range_lu, *result.loudness->range_lu, 0.001);
+
+}
+#endif
+
+#ifdef HAVE_MOODBAR
+TEST_F(AudioAnalyzerTest, MoodbarMatchesMoodbarPipeline) {
+
+  const AudioAnalyzerResult result = Analyze(AudioAnalyzerResult::Analysis::Moodbar);
+  ASSERT_FALSE(result.moodbar.isEmpty());
+
+  // The pipeline is started and deleted on its own thread, like the moodbar loader does, and finishes on a streaming thread.
+  QThread thread;
+  thread.start();
+  MoodbarPipeline *pipeline = new MoodbarPipeline(QUrl::fromLocalFile(filename_));
+  pipeline->moveToThread(&thread);
+  std::atomic<bool> finished(false);
+  std::atomic<bool> success(false);
+  QObject::connect(pipeline, &MoodbarPipeline::Finished, pipeline, [&finished, &success](const bool pipeline_success) {
+    success = pipeline_success;
+    finished = true;
+  }, Qt::DirectConnection);
+  QMetaObject::invokeMethod(pipeline, &MoodbarPipeline::Start);
+  for (int i = 0; i < 600 && !finished; ++i) {
+    QThread::msleep(100);
+  }
+  const QByteArray data = pipeline->data();
+
+  QMetaObject::invokeMethod(pipeline, [pipeline]() {
+    delete pipeline;
+    QThread::currentThread()->quit();
+  });
+  thread.wait();
+
+  ASSERT_TRUE(finished);
+  EXPECT_TRUE(success);
+  EXPECT_EQ(data, result.moodbar);
+
+}
+#endif
+
+TEST_F(AudioAnalyzerTest, AllAnalysesInOneDecode) {
+
+  // The analyses don't change each other's results when they share the decoded audio.
+  const AudioAnalyzerResult all = Analyze(AudioAnalyzer::AvailableAnalyses());
+#ifdef HAVE_SONGFINGERPRINTING
+  EXPECT_EQ(Analyze(AudioAnalyzerResult::Analysis::Fingerprint).fingerprint, all.fingerprint);
+#endif
+#ifdef HAVE_EBUR128
+  const AudioAnalyzerResult loudness = Analyze(AudioAnalyzerResult::Analysis::Loudness);
+  ASSERT_TRUE(all.loudness);
+  ASSERT_TRUE(loudness.loudness);
+  EXPECT_EQ(loudness.loudness->loudness_lufs, all.loudness->loudness_lufs);
+  EXPECT_EQ(loudness.loudness->range_lu, all.loudness->range_lu);
+#endif
+#ifdef HAVE_MOODBAR
+  EXPECT_EQ(Analyze(AudioAnalyzerResult::Analysis::Moodbar).moodbar, all.moodbar);
+#endif
+  Q_UNUSED(all);
+
+}
+
+}  // namespace
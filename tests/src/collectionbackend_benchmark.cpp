@@ -0,0 +1,95 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include <QString>
+#include <QUrl>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+
+#include "core/scoped_ptr.h"
+#include "core/shared_ptr.h"
+#include "core/song.h"
+#include "core/database.h"
+#include "core/logging.h"
+#include "collection/collectionbackend.h"
+#include "collection/collection.h"
+
+using std::make_unique;
+
+namespace {
+
+// Adds and then updates 100k synthetic songs through the bulk path of AddOrUpdateSongs().
+TEST(CollectionBackendBenchmark, AddOrUpdateSongs) {
+
+  static const int kSongCount = 100000;
+
+  SharedPtr<Database> database(new MemoryDatabase(nullptr));
+  ScopedPtr<CollectionBackend> backend = make_unique<CollectionBackend>();
+  backend->Init(database, nullptr, Song::Source::Collection, SCollection::kSongsTable, SCollection::kFtsTable, SCollection::kDirsTable, SCollection::kSubdirsTable);
+  backend->AddDirectory("/tmp");
+
+  SongList songs;
+  songs.reserve(kSongCount);
+  for (int i = 0; i < kSongCount; ++i) {
+    Song song;
+    song.set_directory_id(1);
+    song.set_url(QUrl::fromLocalFile(QString("/music/%1/%2.flac").arg(i / 10).arg(i)));
+    song.set_title(QString("Title %1").arg(i));
+    song.set_album(QString("Album %1").arg(i / 10));
+    song.set_artist(QString("Artist %1").arg(i / 100));
+    song.set_mtime(1);
+    song.set_ctime(1);
+    song.set_filesize(1);
+    songs << song;
+  }
+
+  {  // Add
+    QSignalSpy spy(&*backend, &CollectionBackend::SongsDiscovered);
+
+    QElapsedTimer timer;
+    timer.start();
+    backend->AddOrUpdateSongs(songs);
+    qLog(Info) << "Added" << kSongCount << "songs in" << timer.elapsed() << "ms";
+
+    SongList added_songs;
+    for (int i = 0; i < spy.count(); ++i) {
+      added_songs << spy[i][0].value<SongList>();
+    }
+    ASSERT_EQ(kSongCount, added_songs.count());
+    songs = added_songs;
+  }
+
+  {  // Update
+    for (Song &song : songs) {
+      song.set_title(song.title() + " (updated)");
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    backend->AddOrUpdateSongs(songs);
+    qLog(Info) << "Updated" << kSongCount << "songs in" << timer.elapsed() << "ms";
+  }
+
+}
+
+}  // namespace
@@ -32,6 +32,7 @@
 #include "core/shared_ptr.h"
 #include "core/song.h"
 #include "core/database.h"
+#include "core/sqlquery.h"
 #include "utilities/timeconstants.h"
 #include "collection/collectionbackend.h"
 #include "collection/collection.h"
@@ -112,6 +113,41 @@ TEST_F(CollectionBackendTest, RemoveDirectory) {
 
 }
 
+TEST_F(CollectionBackendTest, SubdirectoryJournal) {
+
+  backend_->AddDirectory("/tmp");
+
+  CollectionSubdirectory subdir;
+  subdir.directory_id = 1;
+  subdir.path = "/tmp/music";
+  subdir.mtime = 1000;
+  subdir.inode = 42;
+  subdir.child_count = 12;
+  subdir.entries_hash = -1234567890123LL;
+  backend_->AddOrUpdateSubdirs(CollectionSubdirectoryList() << subdir);
+
+  CollectionSubdirectoryList subdirs = backend_->SubdirsInDirectory(1);
+  ASSERT_EQ(1, subdirs.count());
+  EXPECT_EQ(1000, subdirs[0].mtime);
+  EXPECT_EQ(42U, subdirs[0].inode);
+  EXPECT_EQ(12U, subdirs[0].child_count);
+  EXPECT_EQ(-1234567890123LL, subdirs[0].entries_hash);
+
+  // Update the journal
+  subdir.mtime = 2000;
+  subdir.child_count = 13;
+  subdir.entries_hash = 99;
+  backend_->AddOrUpdateSubdirs(CollectionSubdirectoryList() << subdir);
+
+  subdirs = backend_->SubdirsInDirectory(1);
+  ASSERT_EQ(1, subdirs.count());
+  EXPECT_EQ(2000, subdirs[0].mtime);
+  EXPECT_EQ(42U, subdirs[0].inode);
+  EXPECT_EQ(13U, subdirs[0].child_count);
+  EXPECT_EQ(99, subdirs[0].entries_hash);
+
+}
+
 TEST_F(CollectionBackendTest, GetAlbumArtNonExistent) {}
 
 // Test adding a single song to the database, then getting various information back about it.
@@ -242,6 +278,27 @@ TEST_F(SingleSong, GetSongById) {
 
 }
 
+TEST_F(SingleSong, GetSongByIdReusesStatement) {
+
+  AddDummySong();
+  if (HasFatalFailure()) return;
+
+  Song song = backend_->GetSongById(1);
+  ASSERT_EQ(1, song.id());
+
+  const quint64 hits = SqlQuery::cache_hits();
+  const quint64 misses = SqlQuery::cache_misses();
+
+  song = backend_->GetSongById(1);
+  EXPECT_EQ(1, song.id());
+  EXPECT_EQ(song_.title(), song.title());
+  EXPECT_FALSE(backend_->GetSongById(2).is_valid());
+
+  EXPECT_EQ(hits + 2, SqlQuery::cache_hits());
+  EXPECT_EQ(misses, SqlQuery::cache_misses());
+
+}
+
 TEST_F(SingleSong, FindSongsInDirectory) {
 
   AddDummySong();
@@ -429,6 +486,14 @@ TEST_F(TestUrls, TestUrls) {
 
   }
 
+  // All songs in one lookup, with an URL that is not in the collection.
+  songs = backend_->GetSongsByUrls(QList<QUrl>() << urls << QUrl::fromLocalFile("/mnt/music/Not in the collection.flac"));
+  EXPECT_EQ(urls.count(), songs.count());
+  for (const Song &song : songs) {
+    EXPECT_TRUE(song.is_valid());
+    EXPECT_TRUE(urls.contains(song.url()));
+  }
+
 }
 
 class UpdateSongsBySongID : public CollectionBackendTest {
@@ -610,4 +675,228 @@ TEST_F(UpdateSongsBySongID, UpdateSongsBySongID) {
 
 }
 
+TEST_F(CollectionBackendTest, AddOrUpdateSongsInBatches) {
+
+  const int song_count = CollectionBackend::kBatchSize * 2 + 1;
+
+  backend_->AddDirectory("/tmp");
+
+  SongList songs;
+  songs.reserve(song_count);
+  for (int i = 0; i < song_count; ++i) {
+    Song song = MakeDummySong(1);
+    song.set_url(QUrl::fromLocalFile(QString("/music/%1/%2.flac").arg(i / 10).arg(i)));
+    song.set_title(QString("Title %1").arg(i));
+    songs << song;
+  }
+
+  {  // Add
+    QSignalSpy spy(&*backend_, &CollectionBackend::SongsDiscovered);
+    backend_->AddOrUpdateSongs(songs);
+
+    ASSERT_EQ(3, spy.count());
+    SongList added_songs;
+    for (int i = 0; i < spy.count(); ++i) {
+      added_songs << spy[i][0].value<SongList>();
+    }
+    ASSERT_EQ(song_count, added_songs.count());
+    EXPECT_EQ(1, added_songs.first().id());
+    EXPECT_EQ(song_count, added_songs.last().id());
+    songs = added_songs;
+  }
+
+  {  // Update
+    for (Song &song : songs) {
+      song.set_title(song.title() + " (updated)");
+    }
+
+    QSignalSpy deleted_spy(&*backend_, &CollectionBackend::SongsDeleted);
+    QSignalSpy added_spy(&*backend_, &CollectionBackend::SongsDiscovered);
+    backend_->AddOrUpdateSongs(songs);
+
+    EXPECT_EQ(3, deleted_spy.count());
+    EXPECT_EQ(3, added_spy.count());
+  }
+
+  Song song = backend_->GetSongById(song_count);
+  EXPECT_EQ(QString("Title %1 (updated)").arg(song_count - 1), song.title());
+
+}
+
+TEST_F(UpdateSongsBySongID, GetSongsBySongIdWithQuotes) {
+
+  SongMap songs;
+  for (const QString &song_id : QStringList() << "song1" << "song'2" << "song3") {
+    Song song(Song::Source::Collection);
+    song.set_song_id(song_id);
+    song.set_directory_id(1);
+    song.set_title("Test Title " + song_id);
+    song.set_url(QUrl::fromLocalFile("/music/" + song_id));
+    song.set_mtime(1);
+    song.set_ctime(1);
+    song.set_filesize(1);
+    song.set_valid(true);
+    songs.insert(song_id, song);
+  }
+  backend_->UpdateSongsBySongID(songs);
+
+  const SongList found_songs = backend_->GetSongsBySongId(QStringList() << "song1" << "song'2" << "song3");
+  EXPECT_EQ(3, found_songs.count());
+
+  // Updating again must not add the songs a second time.
+  QSignalSpy spy(&*backend_, &CollectionBackend::SongsDeleted);
+  backend_->UpdateSongsBySongID(songs);
+  EXPECT_EQ(0, spy.count());
+  EXPECT_EQ(3, backend_->GetAllSongs().count());
+
+}
+
+TEST_F(UpdateSongsBySongID, UpdateSongsByAlbumID) {
+
+  auto make_song = [](const QString &song_id, const QString &album_id, const qint64 mtime) {
+    Song song(Song::Source::Collection);
+    song.set_song_id(song_id);
+    song.set_album_id(album_id);
+    song.set_directory_id(1);
+    song.set_title("Test Title " + song_id);
+    song.set_album("Test Album " + album_id);
+    song.set_artist("Test Artist");
+    song.set_url(QUrl("file:///music/" + song_id));
+    song.set_length_nanosec(kNsecPerSec);
+    song.set_mtime(mtime);
+    song.set_ctime(1);
+    song.set_filesize(1);
+    song.set_valid(true);
+    return song;
+  };
+
+  {  // Add three albums
+    SongMap songs;
+    for (const QString &album_id : QStringList() << "album1" << "album2" << "album3") {
+      for (int i = 1; i <= 2; ++i) {
+        const QString song_id = album_id + "song" + QString::number(i);
+        songs.insert(song_id, make_song(song_id, album_id, 10));
+      }
+    }
+    backend_->UpdateSongsBySongID(songs);
+  }
+
+  CollectionBackend::AlbumSyncStates states = backend_->GetAlbumSyncStates();
+  ASSERT_EQ(3, states.count());
+  EXPECT_EQ(10, states["album1"].mtime);
+  EXPECT_EQ(2, states["album1"].song_count);
+
+  {  // Album 1 changed, album 2 is gone and album 3 wasn't fetched.
+    QSignalSpy deleted_spy(&*backend_, &CollectionBackend::SongsDeleted);
+    QSignalSpy added_spy(&*backend_, &CollectionBackend::SongsDiscovered);
+
+    SongMap songs;
+    songs.insert("album1song1", make_song("album1song1", "album1", 20));
+    songs.insert("album1song3", make_song("album1song3", "album1", 20));
+
+    backend_->UpdateSongsByAlbumID(QStringList() << "album1" << "album2", songs);
+
+    ASSERT_EQ(1, deleted_spy.count());
+    ASSERT_EQ(1, added_spy.count());
+    EXPECT_EQ(4, deleted_spy[0][0].value<SongList>().count());
+    EXPECT_EQ(2, added_spy[0][0].value<SongList>().count());
+  }
+
+  states = backend_->GetAlbumSyncStates();
+  ASSERT_EQ(2, states.count());
+  EXPECT_EQ(20, states["album1"].mtime);
+  EXPECT_EQ(2, states["album1"].song_count);
+  EXPECT_FALSE(states.contains("album2"));
+  EXPECT_EQ(10, states["album3"].mtime);
+  EXPECT_EQ(2, states["album3"].song_count);
+
+}
+
+class LoudnessCharacteristics : public CollectionBackendTest {
+ protected:
+  void SetUp() override {
+    CollectionBackendTest::SetUp();
+    backend_->AddDirectory("/mnt/music");
+
+    SongList songs;
+    for (int i = 1; i <= 5; ++i) {
+      Song song = MakeDummySong(1);
+      song.set_url(QUrl::fromLocalFile(QString("/mnt/music/%1.flac").arg(i)));
+      song.set_title(QString::number(i));
+      song.set_valid(true);
+      songs << song;
+    }
+    // Song 2 is analyzed already.
+    songs[1].set_ebur128_integrated_loudness_lufs(-14.0);
+    songs[1].set_ebur128_loudness_range_lu(6.0);
+    // Song 3 only has one of the characteristics.
+    songs[2].set_ebur128_integrated_loudness_lufs(-10.0);
+    backend_->AddOrUpdateSongs(songs);
+  }
+};
+
+TEST_F(LoudnessCharacteristics, CountSongsWithMissingLoudnessCharacteristics) {
+
+  EXPECT_EQ(4, backend_->CountSongsWithMissingLoudnessCharacteristics());
+
+  // Unavailable songs are not analyzed.
+  backend_->MarkSongsUnavailable(SongList() << backend_->GetSongById(5));
+  EXPECT_EQ(3, backend_->CountSongsWithMissingLoudnessCharacteristics());
+
+}
+
+TEST_F(LoudnessCharacteristics, NextSongsWithMissingLoudnessCharacteristics) {
+
+  SongList songs = backend_->NextSongsWithMissingLoudnessCharacteristics(-1, 2);
+  ASSERT_EQ(2, songs.count());
+  EXPECT_EQ(1, songs[0].id());
+  EXPECT_EQ(3, songs[1].id());
+  EXPECT_EQ("3", songs[1].title());
+
+  songs = backend_->NextSongsWithMissingLoudnessCharacteristics(songs.last().id(), 2);
+  ASSERT_EQ(2, songs.count());
+  EXPECT_EQ(4, songs[0].id());
+  EXPECT_EQ(5, songs[1].id());
+
+  EXPECT_TRUE(backend_->NextSongsWithMissingLoudnessCharacteristics(5, 2).isEmpty());
+
+  backend_->MarkSongsUnavailable(SongList() << backend_->GetSongById(4));
+  songs = backend_->NextSongsWithMissingLoudnessCharacteristics(3, 2);
+  ASSERT_EQ(1, songs.count());
+  EXPECT_EQ(5, songs[0].id());
+
+}
+
+TEST_F(LoudnessCharacteristics, UpdateLoudnessCharacteristics) {
+
+  Song song = backend_->GetSongById(1);
+  song.set_ebur128_integrated_loudness_lufs(-23.0);
+  song.set_ebur128_loudness_range_lu(8.5);
+
+  QSignalSpy spy(&*backend_, &CollectionBackend::SongsDiscovered);
+  backend_->UpdateLoudnessCharacteristics(SongList() << song);
+
+  ASSERT_EQ(1, spy.count());
+  SongList songs = spy[0][0].value<SongList>();
+  ASSERT_EQ(1, songs.count());
+  EXPECT_EQ(1, songs[0].id());
+
+  song = backend_->GetSongById(1);
+  ASSERT_TRUE(song.ebur128_integrated_loudness_lufs());
+  ASSERT_TRUE(song.ebur128_loudness_range_lu());
+  EXPECT_DOUBLE_EQ(-23.0, *song.ebur128_integrated_loudness_lufs());
+  EXPECT_DOUBLE_EQ(8.5, *song.ebur128_loudness_range_lu());
+  EXPECT_EQ("1", song.title());
+
+  EXPECT_EQ(3, backend_->CountSongsWithMissingLoudnessCharacteristics());
+  songs = backend_->NextSongsWithMissingLoudnessCharacteristics(-1, 10);
+  ASSERT_EQ(3, songs.count());
+  EXPECT_EQ(3, songs[0].id());
+
+  // Nothing to save, nothing is emitted.
+  backend_->UpdateLoudnessCharacteristics(SongList());
+  EXPECT_EQ(1, spy.count());
+
+}
+
 } // namespace
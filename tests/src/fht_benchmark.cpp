@@ -0,0 +1,67 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <QVector>
+#include <QElapsedTimer>
+
+#include "core/logging.h"
+#include "analyzer/fht.h"
+#include "analyzer/fhtkernels.h"
+
+namespace {
+
+using FHTKernels::InstructionSet;
+
+class FHTBenchmark : public ::testing::TestWithParam<InstructionSet> {};
+
+// Times the log spectrum the analyzers use for every kernel set the CPU supports.
+TEST_P(FHTBenchmark, LogSpectrum) {
+
+  const FHTKernels::Kernels *kernels = FHTKernels::Get(GetParam());
+  if (!kernels) GTEST_SKIP() << FHTKernels::Name(GetParam()) << " is not supported";
+
+  static const int kIterations = 10000;
+
+  // The analyzers use 2^7 to 2^9, the rest is to see how it scales.
+  for (uint exp = 7; exp <= 11; ++exp) {
+    FHT fht(exp, *kernels);
+    QVector<float> signal(fht.size());
+    for (int i = 0; i < fht.size(); ++i) {
+      signal[i] = static_cast<float>(std::sin(i * 0.3) * 0.5 + std::sin(i * 1.7) * 0.25);
+    }
+    QVector<float> data(fht.size());
+    QVector<float> out(fht.size());
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < kIterations; ++i) {
+      data = signal;
+      fht.logSpectrum(out.data(), data.data());
+    }
+    qLog(Info) << FHTKernels::Name(GetParam()) << kIterations << "spectrums of" << fht.size() << "samples in" << timer.elapsed() << "ms";
+  }
+
+}
+
+INSTANTIATE_TEST_SUITE_P(InstructionSets, FHTBenchmark, ::testing::Values(InstructionSet::Scalar, InstructionSet::SSE2, InstructionSet::AVX2));
+
+}  // namespace
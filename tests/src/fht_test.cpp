@@ -0,0 +1,170 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <algorithm>
+
+#include <QtGlobal>
+#include <QtMath>
+#include <QVector>
+
+#include "analyzer/fht.h"
+#include "analyzer/fhtkernels.h"
+
+namespace {
+
+using FHTKernels::InstructionSet;
+
+QVector<float> TestSignal(const int size) {
+
+  QVector<float> data(size);
+  for (int i = 0; i < size; ++i) {
+    data[i] = static_cast<float>(std::sin(i * 0.3) * 0.5 + std::sin(i * 1.7) * 0.25 + ((i * 7919) % 101) / 404.0);
+  }
+  return data;
+
+}
+
+float MaxDifference(const QVector<float> &a, const QVector<float> &b, const int size) {
+
+  float difference = 0;
+  for (int i = 0; i < size; ++i) {
+    difference = std::max(difference, std::abs(a[i] - b[i]) / std::max(1.0F, std::abs(b[i])));
+  }
+  return difference;
+
+}
+
+class FHTTest : public ::testing::TestWithParam<InstructionSet> {
+ protected:
+  void SetUp() override {
+    kernels_ = FHTKernels::Get(GetParam());
+    if (!kernels_) GTEST_SKIP() << FHTKernels::Name(GetParam()) << " is not supported";
+  }
+
+  const FHTKernels::Kernels *kernels_;
+};
+
+TEST_P(FHTTest, TransformMatchesScalar) {
+
+  for (uint exp = 3; exp <= 12; ++exp) {
+    FHT reference(exp, *FHTKernels::Get(InstructionSet::Scalar));
+    FHT fht(exp, *kernels_);
+    QVector<float> expected = TestSignal(fht.size());
+    QVector<float> actual = expected;
+    reference.transform(expected.data());
+    fht.transform(actual.data());
+    EXPECT_LT(MaxDifference(actual, expected, fht.size()), 1e-5F) << "size" << fht.size();
+  }
+
+}
+
+TEST_P(FHTTest, SpectrumMatchesScalar) {
+
+  for (uint exp = 4; exp <= 12; ++exp) {
+    FHT reference(exp, *FHTKernels::Get(InstructionSet::Scalar));
+    FHT fht(exp, *kernels_);
+    const QVector<float> signal = TestSignal(fht.size());
+
+    QVector<float> expected = signal;
+    QVector<float> actual = signal;
+    reference.power(expected.data());
+    fht.power(actual.data());
+    EXPECT_LT(MaxDifference(actual, expected, fht.size() / 2), 1e-5F) << "size" << fht.size();
+
+    QVector<float> expected_log(fht.size());
+    QVector<float> actual_log(fht.size());
+    expected = signal;
+    actual = signal;
+    reference.logSpectrum(expected_log.data(), expected.data());
+    fht.logSpectrum(actual_log.data(), actual.data());
+    EXPECT_LT(MaxDifference(actual_log, expected_log, fht.size() / 2), 1e-4F) << "size" << fht.size();
+
+    reference.scale(expected_log.data(), 0.05F);
+    fht.scale(actual_log.data(), 0.05F);
+    reference.ewma(expected_log.data(), expected.data(), 0.3F);
+    fht.ewma(actual_log.data(), actual.data(), 0.3F);
+    EXPECT_LT(MaxDifference(actual_log, expected_log, fht.size() / 2), 1e-4F) << "size" << fht.size();
+  }
+
+}
+
+// Output of the FHT before the kernels were split out, for TestSignal(16).
+TEST_P(FHTTest, MatchesOriginalFHT) {
+
+  static const float kTransform[] = { 3.488875F, 1.084752F, 0.7811256F, 0.9602628F, 2.478853F, -0.9903998F, -0.5838721F, 0.1233387F, 0.0827055F, 0.3145465F, -0.8292201F, -0.5599511F, 0.3751724F, -0.8705966F, -0.8784134F, -4.977178F };
+  static const float kPower[] = { 12.17225F, 12.97449F, 0.6908836F, 0.8400216F, 3.142732F, 0.6472185F, 0.5142564F, 0.05707596F };
+
+  FHT fht(4, *kernels_);
+  ASSERT_EQ(16, fht.size());
+
+  QVector<float> data = TestSignal(fht.size());
+  fht.transform(data.data());
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_NEAR(kTransform[i], data[i], 1e-5F) << "index" << i;
+  }
+
+  data = TestSignal(fht.size());
+  fht.power(data.data());
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_NEAR(kPower[i], data[i], 1e-4F) << "index" << i;
+  }
+
+}
+
+// The original FHT is a discrete Hartley transform, check the larger sizes against its definition.
+// The power spectrum is (H[i]^2 + H[n - i]^2) / 2, these sizes also run the vectorized power loops.
+TEST_P(FHTTest, MatchesHartleyTransform) {
+
+  for (uint exp = 5; exp <= 9; ++exp) {
+    FHT fht(exp, *kernels_);
+    const int n = fht.size();
+    const QVector<float> signal = TestSignal(n);
+
+    QVector<float> expected(n);
+    for (int k = 0; k < n; ++k) {
+      double sum = 0;
+      for (int i = 0; i < n; ++i) {
+        const double angle = 2.0 * M_PI * static_cast<double>((static_cast<qint64>(i) * k) % n) / n;
+        sum += signal[i] * (std::cos(angle) + std::sin(angle));
+      }
+      expected[k] = static_cast<float>(sum);
+    }
+
+    QVector<float> actual = signal;
+    fht.transform(actual.data());
+    EXPECT_LT(MaxDifference(actual, expected, n), 1e-4F) << "size" << n;
+
+    QVector<float> expected_power(n / 2);
+    expected_power[0] = expected[0] * expected[0];
+    for (int i = 1; i < n / 2; ++i) {
+      expected_power[i] = (expected[i] * expected[i] + expected[n - i] * expected[n - i]) / 2;
+    }
+    actual = signal;
+    fht.power(actual.data());
+    EXPECT_LT(MaxDifference(actual, expected_power, n / 2), 1e-3F) << "size" << n;
+  }
+
+}
+
+INSTANTIATE_TEST_SUITE_P(InstructionSets, FHTTest, ::testing::Values(InstructionSet::Scalar, InstructionSet::SSE2, InstructionSet::AVX2));
+
+}  // namespace
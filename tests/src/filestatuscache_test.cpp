@@ -0,0 +1,173 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <QThread>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include "core/filestatuscache.h"
+
+// clazy:excludeall=non-pod-global-static
+
+namespace {
+
+class FileStatusCacheTest : public ::testing::Test {
+ protected:
+  // Short enough to wait for in a test, long enough that the entries don't expire while the files are checked.
+  static constexpr qint64 kMaxAge = 1000;
+
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.isValid());
+  }
+
+  QString Filename(const QString &name) const {
+    return temp_dir_.path() + "/" + name;
+  }
+
+  QString CreateFile(const QString &name) const {
+    const QString filename = Filename(name);
+    QFile file(filename);
+    EXPECT_TRUE(file.open(QIODevice::WriteOnly));
+    return filename;
+  }
+
+  QStringList CreateFiles(const QString &prefix, const int count) const {
+    QStringList filenames;
+    for (int i = 0; i < count; ++i) {
+      filenames << CreateFile(QString("%1%2.mp3").arg(prefix).arg(i));
+    }
+    return filenames;
+  }
+
+  QTemporaryDir temp_dir_;
+};
+
+TEST_F(FileStatusCacheTest, FewFilesAreCheckedOneByOne) {
+
+  FileStatusCache cache;
+  const QStringList filenames = QStringList() << CreateFile("1.mp3") << CreateFile("2.mp3") << Filename("missing.mp3");
+  ASSERT_LT(filenames.count(), FileStatusCache::kMinFilesForListing);
+
+  const QHash<QString, bool> results = cache.Exists(filenames);
+  ASSERT_EQ(3, results.count());
+  EXPECT_TRUE(results[filenames[0]]);
+  EXPECT_TRUE(results[filenames[1]]);
+  EXPECT_FALSE(results[filenames[2]]);
+
+  EXPECT_TRUE(cache.Exists(filenames[0]));
+  EXPECT_FALSE(cache.Exists(Filename("other.mp3")));
+
+}
+
+TEST_F(FileStatusCacheTest, ManyFilesAreCheckedByListing) {
+
+  FileStatusCache cache;
+  QStringList filenames = CreateFiles("", 10);
+  filenames << Filename("missing1.mp3") << Filename("missing2.mp3") << temp_dir_.path() + "/missing/1.mp3";
+  // The same file twice is only checked once.
+  filenames << filenames.first();
+
+  const QHash<QString, bool> results = cache.Exists(filenames);
+  ASSERT_EQ(13, results.count());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(results[filenames[i]]);
+  }
+  EXPECT_FALSE(results[Filename("missing1.mp3")]);
+  EXPECT_FALSE(results[Filename("missing2.mp3")]);
+  EXPECT_FALSE(results[temp_dir_.path() + "/missing/1.mp3"]);
+
+}
+
+TEST_F(FileStatusCacheTest, BrokenSymlinksDontExist) {
+
+  const QString target = CreateFile("target.mp3");
+  ASSERT_TRUE(QFile::link(target, Filename("link.mp3")));
+  ASSERT_TRUE(QFile::link(Filename("gone.mp3"), Filename("broken.mp3")));
+
+  // One by one.
+  {
+    FileStatusCache cache;
+    const QHash<QString, bool> results = cache.Exists(QStringList() << Filename("link.mp3") << Filename("broken.mp3"));
+    EXPECT_TRUE(results[Filename("link.mp3")]);
+    EXPECT_FALSE(results[Filename("broken.mp3")]);
+  }
+
+  // By listing the directory.
+  {
+    FileStatusCache cache;
+    const QStringList filenames = CreateFiles("", FileStatusCache::kMinFilesForListing) << Filename("link.mp3") << Filename("broken.mp3");
+    const QHash<QString, bool> results = cache.Exists(filenames);
+    EXPECT_TRUE(results[Filename("link.mp3")]);
+    EXPECT_FALSE(results[Filename("broken.mp3")]);
+  }
+
+}
+
+TEST_F(FileStatusCacheTest, ResultsAreCached) {
+
+  FileStatusCache cache(kMaxAge);
+  const QString filename = CreateFile("1.mp3");
+  EXPECT_TRUE(cache.Exists(filename));
+
+  // The file is gone, but it was checked recently.
+  ASSERT_TRUE(QFile::remove(filename));
+  EXPECT_TRUE(cache.Exists(filename));
+
+  // Unless the files are checked again.
+  EXPECT_FALSE(cache.Exists(filename, true));
+
+  CreateFile("1.mp3");
+  EXPECT_FALSE(cache.Exists(filename));
+
+  // Or the result is too old.
+  QThread::msleep(kMaxAge + 100);
+  EXPECT_TRUE(cache.Exists(filename));
+
+  cache.Clear();
+  EXPECT_EQ(0, cache.count());
+
+}
+
+TEST_F(FileStatusCacheTest, OldEntriesAreDroppedWhenThereAreTooMany) {
+
+  FileStatusCache cache(kMaxAge, 10);
+  cache.Exists(CreateFiles("a", 20));
+  EXPECT_EQ(20, cache.count());
+
+  // Too many entries, but none of them are old.
+  cache.Exists(CreateFile("b.mp3"));
+  EXPECT_EQ(21, cache.count());
+
+  QThread::msleep(kMaxAge + 100);
+  cache.Exists(CreateFile("c.mp3"));
+  EXPECT_EQ(1, cache.count());
+
+  // Not too many entries, the old ones are kept until there are.
+  QThread::msleep(kMaxAge + 100);
+  cache.Exists(CreateFile("d.mp3"));
+  EXPECT_EQ(2, cache.count());
+
+}
+
+}  // namespace
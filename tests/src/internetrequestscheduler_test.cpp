@@ -0,0 +1,194 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <QtGlobal>
+#include <QObject>
+#include <QList>
+#include <QUrl>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+
+#include "mock_networkaccessmanager.h"
+#include "internet/internetrequestscheduler.h"
+
+namespace {
+
+using Priority = InternetRequestScheduler::Priority;
+
+// Time only moves when the test advances it.
+class TestRequestScheduler : public InternetRequestScheduler {
+ public:
+  TestRequestScheduler() : now_(0) {}
+  void Advance(const qint64 msec) { now_ += msec; }
+
+ protected:
+  qint64 Now() const override { return now_; }
+
+ private:
+  qint64 now_;
+};
+
+class InternetRequestSchedulerTest : public ::testing::Test {
+ protected:
+  InternetRequestSchedulerTest() : url_("https://api.example.com/v1/albums") {}
+  ~InternetRequestSchedulerTest() override { qDeleteAll(replies_); }
+
+  MockNetworkReply *Start(const Priority priority) {
+
+    MockNetworkReply *reply = new MockNetworkReply;
+    reply->setUrl(url_);
+    replies_ << reply;
+    scheduler_.AddReply(reply, priority);
+    return reply;
+
+  }
+
+  static void Finish(MockNetworkReply *reply, const int http_status) {
+
+    reply->setAttribute(QNetworkRequest::HttpStatusCodeAttribute, http_status);
+    reply->Done();
+
+  }
+
+  QUrl url_;
+  TestRequestScheduler scheduler_;
+  QList<MockNetworkReply*> replies_;
+};
+
+TEST_F(InternetRequestSchedulerTest, LimitsAndGrowsConcurrentRequests) {
+
+  int available = 0;
+  QObject::connect(&scheduler_, &InternetRequestScheduler::Available, &scheduler_, [&available]() { ++available; });
+
+  // Send as many requests as the scheduler allows, and answer all of them after the same time.
+  int started = 0;
+  while (started < 40) {
+    QList<MockNetworkReply*> replies;
+    while (started < 40 && scheduler_.CanStart(url_, Priority::Background)) {
+      replies << Start(Priority::Background);
+      ++started;
+      EXPECT_LE(scheduler_.ActiveRequests(url_), scheduler_.MaxRequests(url_));
+    }
+    ASSERT_FALSE(replies.isEmpty());
+    scheduler_.Advance(20);
+    for (MockNetworkReply *reply : replies) {
+      Finish(reply, 200);
+    }
+  }
+
+  EXPECT_EQ(40, available);
+  EXPECT_EQ(0, scheduler_.ActiveRequests(url_));
+  EXPECT_GT(scheduler_.MaxRequests(url_), InternetRequestScheduler::kInitialRequests);
+  EXPECT_LE(scheduler_.MaxRequests(url_), InternetRequestScheduler::kMaxRequests);
+
+}
+
+TEST_F(InternetRequestSchedulerTest, DecreasesWhenRepliesSlowDown) {
+
+  MockNetworkReply *reply = Start(Priority::Background);
+  scheduler_.Advance(20);
+  Finish(reply, 200);
+  EXPECT_EQ(InternetRequestScheduler::kInitialRequests, scheduler_.MaxRequests(url_));
+
+  reply = Start(Priority::Background);
+  scheduler_.Advance(1000);
+  Finish(reply, 200);
+  EXPECT_EQ(InternetRequestScheduler::kInitialRequests / 2, scheduler_.MaxRequests(url_));
+
+  // Replies that were sent at the same time only count once.
+  MockNetworkReply *reply1 = Start(Priority::Background);
+  MockNetworkReply *reply2 = Start(Priority::Background);
+  scheduler_.Advance(1000);
+  Finish(reply1, 200);
+  Finish(reply2, 200);
+  EXPECT_EQ(InternetRequestScheduler::kInitialRequests / 4, scheduler_.MaxRequests(url_));
+
+}
+
+TEST_F(InternetRequestSchedulerTest, BacksOffOnTooManyRequests) {
+
+  MockNetworkReply *reply = Start(Priority::Background);
+  reply->setRawHeader("Retry-After", "2");
+  scheduler_.Advance(20);
+  Finish(reply, 429);
+
+  EXPECT_TRUE(InternetRequestScheduler::RetryLater(reply));
+  EXPECT_EQ(InternetRequestScheduler::kInitialRequests / 2, scheduler_.MaxRequests(url_));
+  EXPECT_FALSE(scheduler_.CanStart(url_, Priority::Background));
+  EXPECT_FALSE(scheduler_.CanStart(url_, Priority::Interactive));
+
+  scheduler_.Advance(1999);
+  EXPECT_FALSE(scheduler_.CanStart(url_, Priority::Background));
+
+  scheduler_.Advance(1);
+  EXPECT_TRUE(scheduler_.CanStart(url_, Priority::Background));
+  EXPECT_TRUE(scheduler_.CanStart(url_, Priority::Interactive));
+
+  // Other hosts are not held back.
+  EXPECT_TRUE(scheduler_.CanStart(QUrl("https://images.example.com/cover.jpg"), Priority::Background));
+
+}
+
+TEST_F(InternetRequestSchedulerTest, BacksOffOnServiceUnavailable) {
+
+  MockNetworkReply *reply = Start(Priority::Interactive);
+  Finish(reply, 503);
+
+  EXPECT_TRUE(InternetRequestScheduler::RetryLater(reply));
+  EXPECT_FALSE(scheduler_.CanStart(url_, Priority::Interactive));
+
+  // Without Retry-After the host is paused for a second.
+  scheduler_.Advance(1000);
+  EXPECT_TRUE(scheduler_.CanStart(url_, Priority::Interactive));
+
+  reply = Start(Priority::Interactive);
+  Finish(reply, 404);
+  EXPECT_FALSE(InternetRequestScheduler::RetryLater(reply));
+  EXPECT_TRUE(scheduler_.CanStart(url_, Priority::Interactive));
+
+}
+
+TEST_F(InternetRequestSchedulerTest, InteractiveRequestsAreNotStarved) {
+
+  QList<MockNetworkReply*> replies;
+  while (scheduler_.CanStart(url_, Priority::Background)) {
+    replies << Start(Priority::Background);
+  }
+
+  EXPECT_EQ(InternetRequestScheduler::kInitialRequests - InternetRequestScheduler::kInteractiveRequests, replies.count());
+  EXPECT_TRUE(scheduler_.CanStart(url_, Priority::Interactive));
+
+  // Interactive requests can use the whole limit, and one always gets through.
+  replies << Start(Priority::Interactive);
+  EXPECT_FALSE(scheduler_.CanStart(url_, Priority::Background));
+  EXPECT_FALSE(scheduler_.CanStart(url_, Priority::Interactive));
+
+  // Cancelled requests don't change the limit.
+  for (MockNetworkReply *reply : replies) {
+    reply->setError(QNetworkReply::OperationCanceledError, "Operation canceled");
+    reply->Done();
+  }
+  EXPECT_EQ(0, scheduler_.ActiveRequests(url_));
+  EXPECT_EQ(InternetRequestScheduler::kInitialRequests, scheduler_.MaxRequests(url_));
+
+}
+
+}  // namespace
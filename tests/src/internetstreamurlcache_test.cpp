@@ -0,0 +1,110 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <QThread>
+#include <QString>
+#include <QUrl>
+#include <QDateTime>
+
+#include "core/song.h"
+#include "utilities/timeconstants.h"
+#include "internet/internetstreamurlcache.h"
+
+namespace {
+
+class InternetStreamUrlCacheTest : public ::testing::Test {
+ protected:
+  InternetStreamUrlCacheTest() : cache_(QString()), media_url_("tidal:12345") {}
+
+  InternetStreamUrlCache cache_;
+  QUrl media_url_;
+};
+
+TEST_F(InternetStreamUrlCacheTest, ExpiryFromUrl) {
+
+  EXPECT_EQ(1700000000, InternetStreamUrlCache::ExpiryFromUrl(QUrl("https://streaming.qobuz.com/file?uid=1&eid=2&fmt=27&etsp=1700000000&hmac=abc")));
+  EXPECT_EQ(1700000000, InternetStreamUrlCache::ExpiryFromUrl(QUrl("https://cdn.example.com/track.flac?Expires=1700000000&Signature=abc")));
+  EXPECT_EQ(1700000000, InternetStreamUrlCache::ExpiryFromUrl(QUrl("https://cdn.example.com/track.flac?token=1700000000~abcdef")));
+  EXPECT_EQ(1700000000, InternetStreamUrlCache::ExpiryFromUrl(QUrl("https://cdn.example.com/track.flac?__token__=st=1699990000~exp=1700000000~hmac=abc")));
+  EXPECT_EQ(1700000000, InternetStreamUrlCache::ExpiryFromUrl(QUrl("https://cdn.example.com/track.flac?exp=1700000000000")));
+  EXPECT_EQ(-1, InternetStreamUrlCache::ExpiryFromUrl(QUrl("https://cdn.example.com/track.flac?expires=3600")));
+  EXPECT_EQ(-1, InternetStreamUrlCache::ExpiryFromUrl(QUrl("https://cdn.example.com/track.flac")));
+
+}
+
+TEST_F(InternetStreamUrlCacheTest, InsertAndGet) {
+
+  const QUrl stream_url("https://cdn.example.com/track.flac");
+  cache_.Insert(media_url_, stream_url, Song::FileType::FLAC, 44100, 16, 200 * kNsecPerSec);
+
+  InternetStreamUrlCache::Entry entry;
+  ASSERT_TRUE(cache_.Get(media_url_, entry));
+  EXPECT_EQ(stream_url, entry.stream_url);
+  EXPECT_EQ(Song::FileType::FLAC, entry.filetype);
+  EXPECT_EQ(44100, entry.samplerate);
+  EXPECT_EQ(16, entry.bit_depth);
+  EXPECT_EQ(200 * kNsecPerSec, entry.length_nanosec);
+
+  cache_.Remove(media_url_);
+  EXPECT_FALSE(cache_.Contains(media_url_));
+
+}
+
+TEST_F(InternetStreamUrlCacheTest, ExpiringUrlIsNotUsed) {
+
+  // The URL would expire before the song has played.
+  const qint64 expires = QDateTime::currentSecsSinceEpoch() + 600;
+  cache_.Insert(media_url_, QUrl(QString("https://cdn.example.com/track.flac?etsp=%1").arg(expires)), Song::FileType::FLAC, 44100, 16, 400 * kNsecPerSec);
+  EXPECT_FALSE(cache_.Contains(media_url_));
+  EXPECT_EQ(0, cache_.Count());
+
+  cache_.Insert(media_url_, QUrl(QString("https://cdn.example.com/track.flac?etsp=%1").arg(expires)), Song::FileType::FLAC, 44100, 16, 200 * kNsecPerSec);
+  EXPECT_TRUE(cache_.Contains(media_url_));
+
+}
+
+TEST_F(InternetStreamUrlCacheTest, OtherVariantIsNotUsed) {
+
+  cache_.set_variant("LOSSLESS");
+  cache_.Insert(media_url_, QUrl("https://cdn.example.com/track.flac"));
+  EXPECT_TRUE(cache_.Contains(media_url_));
+
+  cache_.set_variant("HIGH");
+  EXPECT_FALSE(cache_.Contains(media_url_));
+
+}
+
+TEST_F(InternetStreamUrlCacheTest, UnusableEntriesAreRemovedOnInsert) {
+
+  // Valid long enough to play the song for about a second.
+  const qint64 expires = QDateTime::currentSecsSinceEpoch() + 400 + InternetStreamUrlCache::kExpiryMargin + 1;
+  cache_.Insert(media_url_, QUrl(QString("https://cdn.example.com/track.flac?etsp=%1").arg(expires)), Song::FileType::FLAC, 44100, 16, 400 * kNsecPerSec);
+  EXPECT_EQ(1, cache_.Count());
+
+  QThread::msleep(2100);
+  const QUrl other_media_url("tidal:67890");
+  cache_.Insert(other_media_url, QUrl("https://cdn.example.com/other.flac"));
+  EXPECT_EQ(1, cache_.Count());
+  EXPECT_TRUE(cache_.Contains(other_media_url));
+
+}
+
+}  // namespace
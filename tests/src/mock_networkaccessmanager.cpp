@@ -138,3 +138,15 @@ void MockNetworkReply::Done() {
 void MockNetworkReply::setAttribute(QNetworkRequest::Attribute code, const QVariant &value) {
   QNetworkReply::setAttribute(code, value);
 }
+
+void MockNetworkReply::setUrl(const QUrl &url) {
+  QNetworkReply::setUrl(url);
+}
+
+void MockNetworkReply::setRawHeader(const QByteArray &header_name, const QByteArray &value) {
+  QNetworkReply::setRawHeader(header_name, value);
+}
+
+void MockNetworkReply::setError(const QNetworkReply::NetworkError error_code, const QString &error_string) {
+  QNetworkReply::setError(error_code, error_string);
+}
@@ -46,6 +46,9 @@ class MockNetworkReply : public QNetworkReply {
   // Use these to set expectations.
   void SetData(const QByteArray &data);
   virtual void setAttribute(QNetworkRequest::Attribute code, const QVariant &value);
+  void setUrl(const QUrl &url);
+  void setRawHeader(const QByteArray &header_name, const QByteArray &value);
+  void setError(const QNetworkReply::NetworkError error_code, const QString &error_string);
 
   // Call this when you are ready for the finished() signal.
   void Done();
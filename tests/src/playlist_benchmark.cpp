@@ -0,0 +1,79 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include <QString>
+#include <QUrl>
+#include <QElapsedTimer>
+
+#include "core/logging.h"
+#include "core/song.h"
+#include "playlist/playlist.h"
+#include "playlist/playlistsequence.h"
+#include "playlist/songplaylistitem.h"
+#include "mock_settingsprovider.h"
+
+namespace {
+
+// Updates 10k songs in a 100k row playlist.
+TEST(PlaylistBenchmark, UpdateItems) {
+
+  static const int kRowCount = 100000;
+  static const int kUpdateEvery = 10;
+
+  Playlist playlist(nullptr, nullptr, nullptr, 1);
+  PlaylistSequence sequence(nullptr, new DummySettingsProvider);
+  playlist.set_sequence(&sequence);
+
+  PlaylistItemPtrList items;
+  items.reserve(kRowCount);
+  for (int i = 0; i < kRowCount; ++i) {
+    Song song(Song::Source::LocalFile);
+    song.set_url(QUrl::fromLocalFile(QString("/music/%1.mp3").arg(i)));
+    song.set_title(QString::number(i));
+    items << std::make_shared<SongPlaylistItem>(song);
+  }
+  playlist.InsertItems(items);
+  ASSERT_EQ(kRowCount, playlist.rowCount(QModelIndex()));
+
+  SongList songs;
+  songs.reserve(kRowCount / kUpdateEvery);
+  for (int i = 0; i < kRowCount; i += kUpdateEvery) {
+    Song song(Song::Source::LocalFile);
+    song.set_url(QUrl::fromLocalFile(QString("/music/%1.mp3").arg(i)));
+    song.set_title(QString("updated %1").arg(i));
+    songs << song;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  playlist.UpdateItems(songs);
+  qLog(Info) << "Updated" << songs.count() << "songs in" << playlist.rowCount(QModelIndex()) << "rows in" << timer.elapsed() << "ms";
+
+  EXPECT_EQ("updated 0", playlist.data(playlist.index(0, Playlist::Column_Title)));
+  EXPECT_EQ("1", playlist.data(playlist.index(1, Playlist::Column_Title)));
+  EXPECT_EQ("updated 50000", playlist.data(playlist.index(50000, Playlist::Column_Title)));
+  EXPECT_EQ("99999", playlist.data(playlist.index(99999, Playlist::Column_Title)));
+
+}
+
+}  // namespace
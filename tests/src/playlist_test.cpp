@@ -27,11 +27,15 @@
 
 #include "collection/collectionplaylistitem.h"
 #include "playlist/playlist.h"
+#include "playlist/playlistfilter.h"
+#include "playlist/playlistundocommands.h"
+#include "playlist/songplaylistitem.h"
 #include "mock_settingsprovider.h"
 #include "mock_playlistitem.h"
 
 #include <QtDebug>
 #include <QUndoStack>
+#include <QUrl>
 
 using ::testing::Return;
 
@@ -70,6 +74,55 @@ class PlaylistTest : public ::testing::Test {
 
 };
 
+// Gives the tests the pages of a restore without a backend.
+class RestoringPlaylist : public Playlist {
+ public:
+  RestoringPlaylist() : Playlist(nullptr, nullptr, nullptr, 1) {}
+
+  using Playlist::StartRestore;
+  using Playlist::ItemsPageLoaded;
+};
+
+class PlaylistRestoreTest : public ::testing::Test {
+ protected:
+  PlaylistRestoreTest() : sequence_(nullptr, new DummySettingsProvider) {}
+
+  void SetUp() override {
+    playlist_.set_sequence(&sequence_);
+    playlist_.StartRestore();
+    // Keeps the playlist from asking the backend for the next page.
+    playlist_.SetRestoreDeferred(true);
+  }
+
+  static PlaylistItemPtr MakeItem(const QString &title) {
+    Song song(Song::Source::LocalFile);
+    song.set_url(QUrl::fromLocalFile(QString("/music/%1.mp3").arg(title)));
+    song.set_title(title);
+    return std::make_shared<SongPlaylistItem>(song);
+  }
+
+  static PlaylistBackend::PlaylistItemsPage MakePage(const QStringList &titles) {
+    PlaylistBackend::PlaylistItemsPage page;
+    for (const QString &title : titles) {
+      page.items << MakeItem(title);
+    }
+    page.last_page = false;
+    return page;
+  }
+
+  QStringList Titles() const {
+    QStringList titles;
+    for (int row = 0; row < playlist_.rowCount(QModelIndex()); ++row) {
+      titles << playlist_.data(playlist_.index(row, Playlist::Column_Title)).toString();
+    }
+    return titles;
+  }
+
+  RestoringPlaylist playlist_;  // NOLINT(cppcoreguidelines-non-private-member-variables-in-classes)
+  PlaylistSequence sequence_;  // NOLINT(cppcoreguidelines-non-private-member-variables-in-classes)
+
+};
+
 TEST_F(PlaylistTest, Basic) {
   EXPECT_EQ(0, playlist_.rowCount(QModelIndex()));
 }
@@ -544,4 +597,162 @@ TEST_F(PlaylistTest, CollectionIdMapMulti) {
 }
 
 
+TEST_F(PlaylistTest, SortByTitle) {
+
+  playlist_.InsertItems(PlaylistItemPtrList() << MakeMockItemP("b") << MakeMockItemP("C") << MakeMockItemP("a"));
+
+  playlist_.sort(Playlist::Column_Title, Qt::AscendingOrder);
+  EXPECT_EQ("a", playlist_.data(playlist_.index(0, Playlist::Column_Title)));
+  EXPECT_EQ("b", playlist_.data(playlist_.index(1, Playlist::Column_Title)));
+  EXPECT_EQ("C", playlist_.data(playlist_.index(2, Playlist::Column_Title)));
+
+  playlist_.sort(Playlist::Column_Title, Qt::DescendingOrder);
+  EXPECT_EQ("C", playlist_.data(playlist_.index(0, Playlist::Column_Title)));
+  EXPECT_EQ("b", playlist_.data(playlist_.index(1, Playlist::Column_Title)));
+  EXPECT_EQ("a", playlist_.data(playlist_.index(2, Playlist::Column_Title)));
+
+}
+
+TEST_F(PlaylistTest, SortByAlbumThenTrack) {
+
+  Song one;
+  one.Init("title 1", "artist", "album b", 123);
+  one.set_track(2);
+  Song two;
+  two.Init("title 2", "artist", "album a", 123);
+  two.set_track(1);
+  Song three;
+  three.Init("title 3", "artist", "album b", 123);
+  three.set_track(1);
+
+  playlist_.InsertItems(PlaylistItemPtrList() << std::make_shared<CollectionPlaylistItem>(one) << std::make_shared<CollectionPlaylistItem>(two) << std::make_shared<CollectionPlaylistItem>(three));
+
+  playlist_.sort(Playlist::Column_Album, Qt::AscendingOrder);
+  EXPECT_EQ("title 2", playlist_.data(playlist_.index(0, Playlist::Column_Title)));
+  EXPECT_EQ("title 3", playlist_.data(playlist_.index(1, Playlist::Column_Title)));
+  EXPECT_EQ("title 1", playlist_.data(playlist_.index(2, Playlist::Column_Title)));
+
+}
+
+TEST_F(PlaylistTest, FilterFollowsChanges) {
+
+  playlist_.InsertItems(PlaylistItemPtrList() << MakeMockItemP("Foo") << MakeMockItemP("Bar"));
+
+  playlist_.filter()->SetFilterText("foo");
+  EXPECT_EQ(1, playlist_.filter()->rowCount());
+
+  // Rows inserted before and removed after the filtered rows.
+  playlist_.InsertItems(PlaylistItemPtrList() << MakeMockItemP("Another foo"), 0);
+  EXPECT_EQ(2, playlist_.filter()->rowCount());
+
+  playlist_.removeRow(1);
+  EXPECT_EQ(1, playlist_.filter()->rowCount());
+  EXPECT_EQ("Another foo", playlist_.filter()->index(0, Playlist::Column_Title).data());
+
+  playlist_.filter()->SetFilterText("bar");
+  EXPECT_EQ(1, playlist_.filter()->rowCount());
+
+}
+
+TEST_F(PlaylistTest, UpdateItems) {
+
+  PlaylistItemPtrList items;
+  items.reserve(1000);
+  for (int i = 0; i < 1000; ++i) {
+    Song song(Song::Source::LocalFile);
+    song.set_url(QUrl::fromLocalFile(QString("/music/%1.mp3").arg(i)));
+    song.set_title(QString::number(i));
+    items << std::make_shared<SongPlaylistItem>(song);
+  }
+  playlist_.InsertItems(items);
+  ASSERT_EQ(1000, playlist_.rowCount(QModelIndex()));
+
+  SongList songs;
+  songs.reserve(100);
+  for (int i = 0; i < 1000; i += 10) {
+    Song song(Song::Source::LocalFile);
+    song.set_url(QUrl::fromLocalFile(QString("/music/%1.mp3").arg(i)));
+    song.set_title(QString("updated %1").arg(i));
+    songs << song;
+  }
+
+  playlist_.UpdateItems(songs);
+
+  EXPECT_EQ("updated 0", playlist_.data(playlist_.index(0, Playlist::Column_Title)));
+  EXPECT_EQ("1", playlist_.data(playlist_.index(1, Playlist::Column_Title)));
+  EXPECT_EQ("updated 500", playlist_.data(playlist_.index(500, Playlist::Column_Title)));
+  EXPECT_EQ("999", playlist_.data(playlist_.index(999, Playlist::Column_Title)));
+
+}
+
+TEST_F(PlaylistTest, UpdateItemsWithSameUrlUpdatesUndo) {
+
+  const QUrl url = QUrl::fromLocalFile("/music/song.mp3");
+
+  // The same song added twice, in two undo steps.
+  for (const QString &title : QStringList() << "First" << "Second") {
+    Song song(Song::Source::LocalFile);
+    song.set_url(url);
+    song.set_title(title);
+    playlist_.InsertItems(PlaylistItemPtrList() << std::make_shared<SongPlaylistItem>(song));
+  }
+
+  SongList songs;
+  for (const QString &title : QStringList() << "Updated first" << "Updated second") {
+    Song song(Song::Source::LocalFile);
+    song.set_url(url);
+    song.set_title(title);
+    songs << song;
+  }
+  playlist_.UpdateItems(songs);
+
+  EXPECT_EQ("Updated first", playlist_.data(playlist_.index(0, Playlist::Column_Title)));
+  EXPECT_EQ("Updated second", playlist_.data(playlist_.index(1, Playlist::Column_Title)));
+
+  // Both undo steps have to re-add the updated items.
+  playlist_.undo_stack()->undo();
+  playlist_.undo_stack()->undo();
+  ASSERT_EQ(0, playlist_.rowCount(QModelIndex()));
+  playlist_.undo_stack()->redo();
+  playlist_.undo_stack()->redo();
+  ASSERT_EQ(2, playlist_.rowCount(QModelIndex()));
+  EXPECT_EQ("Updated first", playlist_.data(playlist_.index(0, Playlist::Column_Title)));
+  EXPECT_EQ("Updated second", playlist_.data(playlist_.index(1, Playlist::Column_Title)));
+
+}
+
+TEST_F(PlaylistRestoreTest, InsertBetweenPages) {
+
+  playlist_.ItemsPageLoaded(MakePage(QStringList() << "One" << "Two"));
+  playlist_.InsertItems(PlaylistItemPtrList() << MakeItem("Inserted"), 1);
+  playlist_.ItemsPageLoaded(MakePage(QStringList() << "Three" << "Four"));
+
+  EXPECT_EQ(QStringList() << "One" << "Inserted" << "Two" << "Three" << "Four", Titles());
+
+}
+
+TEST_F(PlaylistRestoreTest, AppendBetweenPages) {
+
+  playlist_.ItemsPageLoaded(MakePage(QStringList() << "One" << "Two"));
+  playlist_.InsertItems(PlaylistItemPtrList() << MakeItem("Appended"));
+  playlist_.ItemsPageLoaded(MakePage(QStringList() << "Three" << "Four"));
+
+  EXPECT_EQ(QStringList() << "One" << "Two" << "Three" << "Four" << "Appended", Titles());
+
+}
+
+TEST_F(PlaylistRestoreTest, RemoveAndMoveBetweenPages) {
+
+  playlist_.ItemsPageLoaded(MakePage(QStringList() << "One" << "Two" << "Three"));
+  playlist_.removeRows(0, 1);
+  playlist_.ItemsPageLoaded(MakePage(QStringList() << "Four"));
+  EXPECT_EQ(QStringList() << "Two" << "Three" << "Four", Titles());
+
+  // A row moved to the end stays after the rows that are still to be restored, like an appended row.
+  playlist_.undo_stack()->push(new PlaylistUndoCommands::MoveItems(&playlist_, QList<int>() << 0, -1));
+  playlist_.ItemsPageLoaded(MakePage(QStringList() << "Five"));
+  EXPECT_EQ(QStringList() << "Three" << "Four" << "Five" << "Two", Titles());
+
+}
+
 }  // namespace
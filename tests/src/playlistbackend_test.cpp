@@ -0,0 +1,343 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <memory>
+#include <limits>
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QSqlDatabase>
+
+#include "core/scoped_ptr.h"
+#include "core/shared_ptr.h"
+#include "core/song.h"
+#include "core/database.h"
+#include "core/sqlquery.h"
+#include "playlist/playlistitem.h"
+#include "playlist/songplaylistitem.h"
+#include "playlist/playlistbackend.h"
+
+using std::make_shared;
+
+// clazy:excludeall=non-pod-global-static
+
+namespace {
+
+// Saves a playlist, changes it and saves it again, and checks the rows that were written by loading the playlist again.
+class PlaylistBackendTest : public ::testing::Test {
+ protected:
+  struct Row {
+    qint64 row_id;
+    qint64 position;
+    QString title;
+  };
+
+  void SetUp() override {
+    database_.reset(new MemoryDatabase(nullptr));
+    backend_.reset(new PlaylistBackend(database_));
+    playlist_ = backend_->CreatePlaylist("Test", QString());
+    ASSERT_NE(-1, playlist_);
+  }
+
+  static PlaylistItemPtr MakeItem(const QString &title) {
+    Song song(Song::Source::LocalFile);
+    song.set_url(QUrl::fromLocalFile(QString("/music/%1.mp3").arg(title)));
+    song.set_title(title);
+    song.set_valid(true);
+    return make_shared<SongPlaylistItem>(song);
+  }
+
+  static PlaylistItemPtrList MakeItems(const int count) {
+    PlaylistItemPtrList items;
+    for (int i = 0; i < count; ++i) {
+      items << MakeItem(QString::number(i));
+    }
+    return items;
+  }
+
+  static QStringList Titles(const PlaylistItemPtrList &items) {
+    QStringList titles;
+    for (PlaylistItemPtr item : items) {  // clazy:exclude=range-loop-reference
+      titles << item->Metadata().title();
+    }
+    return titles;
+  }
+
+  void Save(const PlaylistItemPtrList &items) {
+    backend_->SavePlaylist(playlist_, items, -1, nullptr);
+  }
+
+  // The rows as they are in the database, in playlist order.
+  QList<Row> Rows() const {
+    QSqlDatabase db(database_->Connect());
+    SqlQuery q(db);
+    q.prepare("SELECT ROWID, position, title FROM playlist_items WHERE playlist = :playlist ORDER BY position, ROWID");
+    q.BindValue(":playlist", playlist_);
+    EXPECT_TRUE(q.Exec());
+    QList<Row> rows;
+    while (q.next()) {
+      rows << Row { q.value(0).toLongLong(), q.value(1).toLongLong(), q.value(2).toString() };
+    }
+    return rows;
+  }
+
+  // Loads the playlist in small pages, like the playlist does when it's opened.
+  QStringList Load() const {
+    PlaylistItemPtrList items;
+    PlaylistBackend::PlaylistItemsPage page;
+    page.last_position = std::numeric_limits<qint64>::min();
+    do {
+      page = backend_->GetPlaylistItemsPage(playlist_, page.last_position, page.last_row_id, 3);
+      items << page.items;
+    } while (!page.last_page);
+    return Titles(items);
+  }
+
+  static QList<qint64> RowIds(const QList<Row> &rows) {
+    QList<qint64> row_ids;
+    for (const Row &row : rows) row_ids << row.row_id;
+    return row_ids;
+  }
+
+  SharedPtr<Database> database_;  // NOLINT(cppcoreguidelines-non-private-member-variables-in-classes)
+  ScopedPtr<PlaylistBackend> backend_;  // NOLINT(cppcoreguidelines-non-private-member-variables-in-classes)
+  int playlist_ = -1;  // NOLINT(cppcoreguidelines-non-private-member-variables-in-classes)
+};
+
+TEST_F(PlaylistBackendTest, FirstSaveWritesAllRows) {
+
+  const PlaylistItemPtrList items = MakeItems(5);
+  Save(items);
+
+  const QList<Row> rows = Rows();
+  ASSERT_EQ(5, rows.count());
+  for (int i = 0; i < rows.count(); ++i) {
+    EXPECT_EQ(PlaylistBackend::kPositionStep * (i + 1), rows[i].position);
+  }
+  EXPECT_EQ(Titles(items), Load());
+
+}
+
+TEST_F(PlaylistBackendTest, InsertKeepsOtherRows) {
+
+  PlaylistItemPtrList items = MakeItems(10);
+  Save(items);
+  const QList<Row> old_rows = Rows();
+
+  items.insert(3, MakeItem("inserted 1"));
+  items.insert(4, MakeItem("inserted 2"));
+  items.prepend(MakeItem("first"));
+  items.append(MakeItem("last"));
+  Save(items);
+
+  const QList<Row> rows = Rows();
+  ASSERT_EQ(14, rows.count());
+  EXPECT_EQ(Titles(items), Load());
+
+  // The old rows are not written again, the new rows go between their positions.
+  QList<qint64> row_ids = RowIds(rows);
+  for (const Row &old_row : old_rows) {
+    EXPECT_TRUE(row_ids.contains(old_row.row_id));
+  }
+  EXPECT_EQ(old_rows[2].position, rows[3].position);
+  EXPECT_GT(rows[4].position, old_rows[2].position);
+  EXPECT_LT(rows[5].position, old_rows[3].position);
+  EXPECT_LT(rows[0].position, old_rows[0].position);
+  EXPECT_GT(rows[13].position, old_rows[9].position);
+
+  // Rows in front of the first one can get negative positions.
+  items.prepend(MakeItem("before first"));
+  Save(items);
+  EXPECT_LT(Rows().first().position, 0);
+  EXPECT_EQ(Titles(items), Load());
+
+}
+
+TEST_F(PlaylistBackendTest, RemoveDeletesOnlyRemovedRows) {
+
+  PlaylistItemPtrList items = MakeItems(10);
+  Save(items);
+  const QList<Row> old_rows = Rows();
+
+  items.removeAt(7);
+  items.removeAt(2);
+  items.removeFirst();
+  Save(items);
+
+  const QList<Row> rows = Rows();
+  ASSERT_EQ(7, rows.count());
+  EXPECT_EQ(Titles(items), Load());
+
+  const QList<qint64> row_ids = RowIds(rows);
+  EXPECT_FALSE(row_ids.contains(old_rows[0].row_id));
+  EXPECT_FALSE(row_ids.contains(old_rows[2].row_id));
+  EXPECT_FALSE(row_ids.contains(old_rows[7].row_id));
+  EXPECT_EQ(old_rows[1].row_id, rows[0].row_id);
+  EXPECT_EQ(old_rows[1].position, rows[0].position);
+  EXPECT_EQ(old_rows[9].row_id, rows[6].row_id);
+  EXPECT_EQ(old_rows[9].position, rows[6].position);
+
+}
+
+TEST_F(PlaylistBackendTest, MoveChangesOnlyMovedPositions) {
+
+  PlaylistItemPtrList items = MakeItems(10);
+  Save(items);
+  const QList<Row> old_rows = Rows();
+
+  // Move item 8 between items 1 and 2.
+  items.move(8, 2);
+  Save(items);
+
+  const QList<Row> rows = Rows();
+  ASSERT_EQ(10, rows.count());
+  EXPECT_EQ(Titles(items), Load());
+
+  // The moved row keeps its row ID and gets a new position, the others stay where they were.
+  EXPECT_EQ(old_rows[8].row_id, rows[2].row_id);
+  EXPECT_GT(rows[2].position, old_rows[1].position);
+  EXPECT_LT(rows[2].position, old_rows[2].position);
+  for (int i = 0; i < old_rows.count(); ++i) {
+    if (i == 8) continue;
+    const int row = i < 2 ? i : (i < 8 ? i + 1 : i);
+    EXPECT_EQ(old_rows[i].row_id, rows[row].row_id);
+    EXPECT_EQ(old_rows[i].position, rows[row].position);
+  }
+
+}
+
+TEST_F(PlaylistBackendTest, UpdateChangedItemInPlace) {
+
+  PlaylistItemPtrList items = MakeItems(10);
+  Save(items);
+  const QList<Row> old_rows = Rows();
+
+  // Changes the song of the item, which detaches it from the saved copy.
+  items[4]->SetArtManual(QUrl::fromLocalFile("/music/cover.jpg"));
+  Save(items);
+
+  const QList<Row> rows = Rows();
+  ASSERT_EQ(10, rows.count());
+  EXPECT_EQ(RowIds(old_rows), RowIds(rows));
+  for (int i = 0; i < rows.count(); ++i) {
+    EXPECT_EQ(old_rows[i].position, rows[i].position);
+  }
+
+  QSqlDatabase db(database_->Connect());
+  SqlQuery q(db);
+  q.prepare("SELECT art_manual FROM playlist_items WHERE ROWID = :id");
+  q.BindValue(":id", rows[4].row_id);
+  ASSERT_TRUE(q.Exec());
+  ASSERT_TRUE(q.next());
+  EXPECT_EQ(QUrl::fromLocalFile("/music/cover.jpg").toString(QUrl::FullyEncoded), q.value(0).toString());
+
+  EXPECT_EQ(Titles(items), Load());
+
+}
+
+TEST_F(PlaylistBackendTest, RewriteWhenPositionsAreExhausted) {
+
+  PlaylistItemPtrList items = MakeItems(40);
+  Save(items);
+
+  // Each insert halves the room between the first two rows, until there's no room left and the playlist is rewritten.
+  int inserts = 0;
+  bool rewritten = false;
+  while (!rewritten && inserts < 20) {
+    items.insert(1, MakeItem(QString("inserted %1").arg(inserts)));
+    Save(items);
+    ++inserts;
+    const QList<Row> rows = Rows();
+    ASSERT_EQ(items.count(), rows.count());
+    // A rewrite spreads all rows evenly again.
+    rewritten = true;
+    for (int i = 0; i < rows.count(); ++i) {
+      if (rows[i].position != PlaylistBackend::kPositionStep * (i + 1)) rewritten = false;
+    }
+    EXPECT_EQ(Titles(items), Load());
+  }
+
+  EXPECT_TRUE(rewritten);
+  // 1024 between the rows leaves room for 10 inserts at the same spot.
+  EXPECT_EQ(11, inserts);
+
+  // After the rewrite the rows are updated again.
+  const QList<qint64> old_row_ids = RowIds(Rows());
+  items.append(MakeItem("appended"));
+  Save(items);
+  EXPECT_TRUE(RowIds(Rows()).startsWith(old_row_ids));
+  EXPECT_EQ(Titles(items), Load());
+
+}
+
+TEST_F(PlaylistBackendTest, RewriteWhenMostRowsChange) {
+
+  PlaylistItemPtrList items = MakeItems(10);
+  Save(items);
+
+  std::reverse(items.begin(), items.end());
+  Save(items);
+
+  // The rows are written again in the new order, instead of moving all but one of them.
+  const QList<Row> rows = Rows();
+  ASSERT_EQ(10, rows.count());
+  for (int i = 0; i < rows.count(); ++i) {
+    EXPECT_EQ(PlaylistBackend::kPositionStep * (i + 1), rows[i].position);
+    if (i > 0) EXPECT_GT(rows[i].row_id, rows[i - 1].row_id);
+  }
+  EXPECT_EQ(Titles(items), Load());
+
+}
+
+TEST_F(PlaylistBackendTest, UpdateAfterLoad) {
+
+  PlaylistItemPtrList items = MakeItems(10);
+  Save(items);
+
+  // A new backend has not saved the playlist, so the rows are taken from loading it.
+  backend_.reset(new PlaylistBackend(database_));
+  const QList<Row> old_rows = Rows();
+  PlaylistItemPtrList loaded_items;
+  PlaylistBackend::PlaylistItemsPage page;
+  page.last_position = std::numeric_limits<qint64>::min();
+  do {
+    page = backend_->GetPlaylistItemsPage(playlist_, page.last_position, page.last_row_id, 4);
+    loaded_items << page.items;
+  } while (!page.last_page);
+  ASSERT_EQ(10, loaded_items.count());
+
+  loaded_items.removeAt(5);
+  loaded_items.insert(2, MakeItem("inserted"));
+  Save(loaded_items);
+
+  const QList<Row> rows = Rows();
+  ASSERT_EQ(10, rows.count());
+  EXPECT_EQ(old_rows[0].row_id, rows[0].row_id);
+  EXPECT_EQ(old_rows[9].row_id, rows[9].row_id);
+  EXPECT_FALSE(RowIds(rows).contains(old_rows[5].row_id));
+  EXPECT_EQ(Titles(loaded_items), Load());
+
+}
+
+}  // namespace
@@ -0,0 +1,145 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+
+#include <gtest/gtest.h>
+
+#include <QtConcurrentRun>
+#include <QFuture>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QString>
+
+#include "collection/prefetchedanalyses.h"
+#include "engine/audioanalyzerresult.h"
+
+// clazy:excludeall=non-pod-global-static
+
+namespace {
+
+class PrefetchedAnalysesTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // The only thread is kept busy, so the analyses started by the tests stay queued until Unblock() is called.
+    thread_pool_.setMaxThreadCount(1);
+    blocker_ = QtConcurrent::run(&thread_pool_, [this]() { blocked_.acquire(); });
+  }
+
+  void TearDown() override {
+    Unblock();
+    thread_pool_.waitForDone();
+  }
+
+  void Unblock() {
+    if (!unblocked_) {
+      blocked_.release();
+      unblocked_ = true;
+    }
+  }
+
+  // Stands in for an analysis of the file, the fingerprint tells which file it was.
+  QFuture<AudioAnalyzerResult> Analyze(const QString &file) {
+    return QtConcurrent::run(&thread_pool_, [this, file]() {
+      ++runs_;
+      AudioAnalyzerResult result;
+      result.analyses = AudioAnalyzerResult::Analysis::Fingerprint;
+      result.fingerprint = file;
+      return result;
+    });
+  }
+
+  QThreadPool thread_pool_;
+  QSemaphore blocked_;
+  QFuture<void> blocker_;
+  bool unblocked_ = false;
+  std::atomic<int> runs_{0};
+};
+
+TEST_F(PrefetchedAnalysesTest, TakeWaitsForTheAnalysis) {
+
+  PrefetchedAnalyses analyses;
+  analyses.Add("a.flac", Analyze("a.flac"));
+  EXPECT_TRUE(analyses.Contains("a.flac"));
+  Unblock();
+
+  AudioAnalyzerResult result;
+  ASSERT_TRUE(analyses.Take("a.flac", &result));
+  EXPECT_EQ("a.flac", result.fingerprint);
+  EXPECT_FALSE(analyses.Contains("a.flac"));
+
+  // Each analysis is only used once.
+  EXPECT_FALSE(analyses.Take("a.flac", &result));
+  EXPECT_FALSE(analyses.Take("b.flac", &result));
+
+}
+
+TEST_F(PrefetchedAnalysesTest, DiscardedAnalysesDontRun) {
+
+  PrefetchedAnalyses analyses;
+  analyses.Add("a.flac", Analyze("a.flac"));
+  analyses.Add("b.flac", Analyze("b.flac"));
+  analyses.Discard();
+  EXPECT_FALSE(analyses.Contains("a.flac"));
+
+  // The file is analyzed by the caller instead.
+  AudioAnalyzerResult result;
+  EXPECT_FALSE(analyses.Take("a.flac", &result));
+
+  Unblock();
+  thread_pool_.waitForDone();
+  EXPECT_EQ(0, runs_);
+
+}
+
+TEST_F(PrefetchedAnalysesTest, DiscardKeepsAnalysesOfOthersOnTheSamePool) {
+
+  PrefetchedAnalyses discarded;
+  PrefetchedAnalyses kept;
+  discarded.Add("a.flac", Analyze("a.flac"));
+  kept.Add("b.flac", Analyze("b.flac"));
+  discarded.Discard();
+  Unblock();
+
+  AudioAnalyzerResult result;
+  ASSERT_TRUE(kept.Take("b.flac", &result));
+  EXPECT_EQ("b.flac", result.fingerprint);
+  EXPECT_EQ(1, runs_);
+
+}
+
+TEST_F(PrefetchedAnalysesTest, CanceledAnalysisFallsBackToTheCaller) {
+
+  PrefetchedAnalyses analyses;
+  QFuture<AudioAnalyzerResult> future = Analyze("a.flac");
+  analyses.Add("a.flac", future);
+  analyses.Add("b.flac", Analyze("b.flac"));
+
+  // Canceled while the file is still expected by the scan.
+  future.cancel();
+  Unblock();
+
+  AudioAnalyzerResult result;
+  EXPECT_FALSE(analyses.Take("a.flac", &result));
+  ASSERT_TRUE(analyses.Take("b.flac", &result));
+  EXPECT_EQ("b.flac", result.fingerprint);
+
+}
+
+}  // namespace
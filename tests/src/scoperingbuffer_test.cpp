@@ -0,0 +1,212 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cmath>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "engine/scoperingbuffer.h"
+
+namespace {
+
+// Mono samples counting up from the given frame, so each sample tells which frame it was.
+std::vector<int16_t> Ramp(const quint64 first_frame, const int frames) {
+
+  std::vector<int16_t> samples(frames);
+  for (int i = 0; i < frames; ++i) {
+    samples[i] = static_cast<int16_t>((first_frame + i) % 32768);
+  }
+  return samples;
+
+}
+
+int Frame(const float sample) {
+
+  return static_cast<int>(std::lround(sample * 32768.0F));
+
+}
+
+// Checks that the samples are frames in a row, ending with the frame before end.
+void ExpectRamp(const std::vector<float> &samples, const quint64 end) {
+
+  const quint64 start = end - samples.size();
+  for (size_t i = 0; i < samples.size(); ++i) {
+    ASSERT_EQ(static_cast<int>((start + i) % 32768), Frame(samples[i])) << "at " << i;
+  }
+
+}
+
+class ScopeRingBufferTest : public ::testing::Test {
+ protected:
+  static constexpr int kMaxReadFrames = ScopeRingBuffer::kCapacity - ScopeRingBuffer::kMaxWriteFrames;
+
+  void SetUp() override {
+    buffer_ = std::make_unique<ScopeRingBuffer>();
+  }
+
+  void WriteRamp(const int frames) {
+    const std::vector<int16_t> samples = Ramp(written_, frames);
+    buffer_->Write(samples.data(), frames, 1);
+    written_ += frames;
+  }
+
+  std::unique_ptr<ScopeRingBuffer> buffer_;
+  quint64 written_ = 0;
+};
+
+TEST_F(ScopeRingBufferTest, NotEnoughData) {
+
+  std::vector<float> samples(100);
+  EXPECT_FALSE(buffer_->ReadLatest(samples.data(), 100));
+
+  WriteRamp(50);
+  EXPECT_FALSE(buffer_->ReadLatest(samples.data(), 51));
+  EXPECT_TRUE(buffer_->ReadLatest(samples.data(), 50));
+
+  EXPECT_FALSE(buffer_->ReadLatest(nullptr, 10));
+  EXPECT_FALSE(buffer_->ReadLatest(samples.data(), 0));
+
+}
+
+TEST_F(ScopeRingBufferTest, ReadsAreLimitedToWhatTheWriterCantReach) {
+
+  WriteRamp(ScopeRingBuffer::kCapacity);
+
+  std::vector<float> samples(kMaxReadFrames + 1);
+  EXPECT_FALSE(buffer_->ReadLatest(samples.data(), kMaxReadFrames + 1));
+  samples.resize(kMaxReadFrames);
+  ASSERT_TRUE(buffer_->ReadLatest(samples.data(), kMaxReadFrames));
+  ExpectRamp(samples, written_);
+
+}
+
+TEST_F(ScopeRingBufferTest, PartialReadsReturnTheNewestFrames) {
+
+  WriteRamp(1000);
+
+  std::vector<float> samples(10);
+  ASSERT_TRUE(buffer_->ReadLatest(samples.data(), 10));
+  ExpectRamp(samples, 1000);
+
+  samples.resize(1000);
+  ASSERT_TRUE(buffer_->ReadLatest(samples.data(), 1000));
+  ExpectRamp(samples, 1000);
+
+  WriteRamp(5);
+  samples.resize(10);
+  ASSERT_TRUE(buffer_->ReadLatest(samples.data(), 10));
+  ExpectRamp(samples, 1005);
+
+}
+
+TEST_F(ScopeRingBufferTest, Wraparound) {
+
+  // Small writes, the last ones wrap around the end of the ring.
+  for (int i = 0; i < 40; ++i) {
+    WriteRamp(1000);
+  }
+  ASSERT_GT(written_, static_cast<quint64>(ScopeRingBuffer::kCapacity * 2));
+
+  std::vector<float> samples(kMaxReadFrames);
+  ASSERT_TRUE(buffer_->ReadLatest(samples.data(), kMaxReadFrames));
+  ExpectRamp(samples, written_);
+
+  // One write larger than the ring, only the newest frames are kept.
+  WriteRamp(ScopeRingBuffer::kCapacity * 3 + 123);
+  ASSERT_TRUE(buffer_->ReadLatest(samples.data(), kMaxReadFrames));
+  ExpectRamp(samples, written_);
+
+}
+
+TEST_F(ScopeRingBufferTest, DownmixesToMono) {
+
+  const int16_t samples[] = { 1000, 3000, -2000, -4000, 32767, 32767 };
+  buffer_->Write(samples, 3, 2);
+
+  float mono[3];
+  ASSERT_TRUE(buffer_->ReadLatest(mono, 3));
+  EXPECT_FLOAT_EQ(2000.0F / 32768.0F, mono[0]);
+  EXPECT_FLOAT_EQ(-3000.0F / 32768.0F, mono[1]);
+  EXPECT_FLOAT_EQ(32767.0F / 32768.0F, mono[2]);
+
+}
+
+TEST_F(ScopeRingBufferTest, OverrunWhenTheWriterLapsTheReader) {
+
+  const quint64 start = 100000;
+  const quint64 end = start + kMaxReadFrames;
+
+  // Nothing was written while reading.
+  EXPECT_FALSE(ScopeRingBuffer::IsOverwritten(start, end));
+
+  // The writer can be a write ahead of what it published, that write would go up to the first frame read.
+  EXPECT_FALSE(ScopeRingBuffer::IsOverwritten(start, start + ScopeRingBuffer::kCapacity - ScopeRingBuffer::kMaxWriteFrames));
+  EXPECT_TRUE(ScopeRingBuffer::IsOverwritten(start, start + ScopeRingBuffer::kCapacity - ScopeRingBuffer::kMaxWriteFrames + 1));
+
+  // The writer went all the way around.
+  EXPECT_TRUE(ScopeRingBuffer::IsOverwritten(start, start + ScopeRingBuffer::kCapacity));
+  EXPECT_TRUE(ScopeRingBuffer::IsOverwritten(start, start + ScopeRingBuffer::kCapacity * 5));
+
+}
+
+TEST_F(ScopeRingBufferTest, ConcurrentReadsAreNeverTorn) {
+
+  // The writer runs far ahead of the reader, reads that raced with it have to be discarded.
+  static constexpr int kWrites = 20000;
+  static constexpr int kWriteFrames = 1500;
+
+  std::atomic<bool> done(false);
+  std::thread writer([this, &done]() {
+    quint64 pos = 0;
+    for (int i = 0; i < kWrites; ++i) {
+      const std::vector<int16_t> samples = Ramp(pos, kWriteFrames);
+      buffer_->Write(samples.data(), kWriteFrames, 1);
+      pos += kWriteFrames;
+    }
+    done = true;
+  });
+
+  std::vector<float> samples(kMaxReadFrames);
+  int torn_reads = 0;
+  while (!done) {
+    if (!buffer_->ReadLatest(samples.data(), kMaxReadFrames)) continue;
+    // Any successful read is frames in a row.
+    const int first = Frame(samples[0]);
+    for (int i = 1; i < kMaxReadFrames; ++i) {
+      if (Frame(samples[i]) != (first + i) % 32768) {
+        ++torn_reads;
+        break;
+      }
+    }
+  }
+  writer.join();
+  EXPECT_EQ(0, torn_reads);
+
+  // With the writer done, the read always succeeds.
+  ASSERT_TRUE(buffer_->ReadLatest(samples.data(), kMaxReadFrames));
+  ExpectRamp(samples, static_cast<quint64>(kWrites) * kWriteFrames);
+
+}
+
+}  // namespace
@@ -0,0 +1,173 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include <QObject>
+#include <QThread>
+#include <QDir>
+#include <QFile>
+#include <QByteArray>
+#include <QString>
+#include <QUrl>
+#include <QTemporaryDir>
+#include <QSignalSpy>
+
+#include "core/shared_ptr.h"
+#include "core/song.h"
+#include "core/database.h"
+#include "core/songloader.h"
+#include "core/tagreaderclient.h"
+#include "collection/collectionbackend.h"
+#include "collection/collection.h"
+
+using std::make_shared;
+
+// clazy:excludeall=non-pod-global-static
+
+namespace {
+
+// Loads a folder of songs like a drop on the playlist does, with a tagreader client on its own thread.
+class SongLoaderTest : public ::testing::Test {
+ protected:
+  // More files than SongLoader reads in one batch.
+  static constexpr int kFileCount = 300;
+
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.isValid());
+    for (int i = 0; i < kFileCount; ++i) {
+      ASSERT_TRUE(QFile::copy(":/audio/strawberry.mp3", QString("%1/%2.mp3").arg(temp_dir_.path()).arg(i, 3, 10, QLatin1Char('0'))));
+    }
+
+    database_.reset(new MemoryDatabase(nullptr));
+    backend_ = make_shared<CollectionBackend>();
+    backend_->Init(database_, nullptr, Song::Source::Collection, SCollection::kSongsTable, SCollection::kFtsTable, SCollection::kDirsTable, SCollection::kSubdirsTable);
+
+    // The tagreader client looks for the worker in the PATH.
+    qputenv("PATH", QByteArray(TAGREADER_WORKER_DIR) + QDir::listSeparator().toLatin1() + qgetenv("PATH"));
+    tagreader_thread_ = new QThread;
+    tagreader_client_ = new TagReaderClient;
+    tagreader_client_->moveToThread(tagreader_thread_);
+    tagreader_thread_->start();
+    tagreader_client_->Start();
+  }
+
+  void TearDown() override {
+    TagReaderClient *tagreader_client = tagreader_client_;
+    QMetaObject::invokeMethod(tagreader_client, [tagreader_client]() {
+      delete tagreader_client;
+      QThread::currentThread()->quit();
+    });
+    tagreader_thread_->wait();
+    delete tagreader_thread_;
+  }
+
+  QString Filename(const int i) const {
+    return QString("%1/%2.mp3").arg(QDir(temp_dir_.path()).canonicalPath()).arg(i, 3, 10, QLatin1Char('0'));
+  }
+
+  QTemporaryDir temp_dir_;
+  SharedPtr<Database> database_;
+  SharedPtr<CollectionBackend> backend_;
+  QThread *tagreader_thread_ = nullptr;
+  TagReaderClient *tagreader_client_ = nullptr;
+};
+
+TEST_F(SongLoaderTest, LoadMetadataInBatches) {
+
+  // One of the files is in the collection.
+  backend_->AddDirectory(QDir(temp_dir_.path()).canonicalPath());
+  Song collection_song(Song::Source::Collection);
+  collection_song.set_directory_id(1);
+  collection_song.set_title("In the collection");
+  collection_song.set_url(QUrl::fromLocalFile(Filename(150)));
+  collection_song.set_mtime(1);
+  collection_song.set_ctime(1);
+  collection_song.set_filesize(1);
+  collection_song.set_valid(true);
+  backend_->AddOrUpdateSongs(SongList() << collection_song);
+
+  SongLoader loader(backend_, nullptr);
+  ASSERT_EQ(SongLoader::Result::BlockingLoadRequired, loader.Load(QUrl::fromLocalFile(QDir(temp_dir_.path()).canonicalPath())));
+  ASSERT_EQ(SongLoader::Result::Success, loader.LoadFilenamesBlocking());
+
+  // The songs are placeholders named after the file, only the first one is loaded completely so it can start playing.
+  ASSERT_EQ(kFileCount, loader.songs().count());
+  EXPECT_TRUE(loader.songs()[0].init_from_file());
+  for (int i = 1; i < kFileCount; ++i) {
+    const Song &song = loader.songs()[i];
+    EXPECT_EQ(QUrl::fromLocalFile(Filename(i)), song.url());
+    EXPECT_EQ(QString("%1.mp3").arg(i, 3, 10, QLatin1Char('0')), song.title());
+    EXPECT_FALSE(song.init_from_file());
+  }
+
+  // This runs on the test's thread, which has no event loop, like the QtConcurrent thread used when songs are dropped.
+  QSignalSpy spy(&loader, &SongLoader::MetadataLoaded);
+  loader.LoadMetadataBlocking();
+
+  // The collection song comes first, then the other files in batches.
+  ASSERT_EQ(3, spy.count());
+  const SongList songs_from_collection = spy[0][0].value<SongList>();
+  ASSERT_EQ(1, songs_from_collection.count());
+  EXPECT_EQ("In the collection", songs_from_collection[0].title());
+
+  const SongList first_batch = spy[1][0].value<SongList>();
+  const SongList second_batch = spy[2][0].value<SongList>();
+  EXPECT_EQ(SongLoader::kMetadataBatchSize, first_batch.count());
+  EXPECT_EQ(kFileCount - 2 - SongLoader::kMetadataBatchSize, second_batch.count());
+  for (const Song &song : first_batch + second_batch) {
+    EXPECT_TRUE(song.init_from_file());
+    EXPECT_EQ(Song::FileType::MPEG, song.filetype());
+    EXPECT_GT(song.length_nanosec(), 0);
+  }
+
+  // The songs are loaded in place.
+  EXPECT_EQ("In the collection", loader.songs()[150].title());
+  EXPECT_EQ(first_batch[0].url(), loader.songs()[1].url());
+  EXPECT_TRUE(loader.songs()[1].init_from_file());
+  EXPECT_TRUE(loader.songs()[kFileCount - 1].init_from_file());
+
+}
+
+TEST_F(SongLoaderTest, UnreadableFilesKeepPlaceholders) {
+
+  SongLoader loader(backend_, nullptr);
+  ASSERT_EQ(SongLoader::Result::BlockingLoadRequired, loader.Load(QUrl::fromLocalFile(QDir(temp_dir_.path()).canonicalPath())));
+  ASSERT_EQ(SongLoader::Result::Success, loader.LoadFilenamesBlocking());
+  ASSERT_EQ(kFileCount, loader.songs().count());
+
+  // The file is gone by the time its metadata is read.
+  ASSERT_TRUE(QFile::remove(Filename(10)));
+  loader.LoadMetadataBlocking();
+
+  const Song &song = loader.songs()[10];
+  EXPECT_EQ(QUrl::fromLocalFile(Filename(10)), song.url());
+  EXPECT_EQ("010.mp3", song.title());
+  EXPECT_TRUE(song.is_valid());
+  EXPECT_FALSE(song.init_from_file());
+
+  EXPECT_TRUE(loader.songs()[11].init_from_file());
+
+}
+
+}  // namespace
@@ -0,0 +1,201 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <gtest/gtest.h>
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QTemporaryDir>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+#include "core/logging.h"
+#include "core/song.h"
+#include "core/tagreaderclient.h"
+#include "tagreaderworker.h"
+#include "tagreadermessages.pb.h"
+
+// clazy:excludeall=non-pod-global-static
+
+namespace {
+
+// Runs a TagReaderWorker in process, connected to a client handler through a local socket, to compare per-file and batched reads.
+class TagReaderWorkerBenchmark : public ::testing::Test {
+ protected:
+  static constexpr int kFileCount = 3000;
+  static constexpr int kTimeout = 60000;
+
+  static void SetUpTestCase() {
+    temp_dir_ = new QTemporaryDir;
+    const QStringList sources = QStringList() << ":/audio/strawberry.mp3" << ":/audio/strawberry.ogg" << ":/audio/strawberry.spx";
+    for (int i = 0; i < kFileCount; ++i) {
+      const QString &source = sources[i % sources.count()];
+      const QString filename = QString("%1/%2.%3").arg(temp_dir_->path()).arg(i).arg(QFileInfo(source).suffix());
+      if (QFile::copy(source, filename)) {
+        filenames_ << filename;
+      }
+    }
+  }
+
+  static void TearDownTestCase() {
+    filenames_.clear();
+    delete temp_dir_;
+    temp_dir_ = nullptr;
+  }
+
+  void SetUp() override {
+    ASSERT_EQ(kFileCount, filenames_.count());
+
+    ASSERT_TRUE(server_.listen(QString("strawberry_tagreaderworker_benchmark_%1").arg(QCoreApplication::applicationPid())));
+    client_socket_ = new QLocalSocket;
+    client_socket_->connectToServer(server_.fullServerName());
+    ASSERT_TRUE(server_.waitForNewConnection(5000));
+    worker_socket_ = server_.nextPendingConnection();
+    ASSERT_TRUE(client_socket_->waitForConnected(5000));
+
+    worker_ = new TagReaderWorker(worker_socket_);
+    client_ = new TagReaderMessageHandler(client_socket_, nullptr);
+  }
+
+  void TearDown() override {
+    delete client_;
+    delete worker_;
+    delete client_socket_;
+  }
+
+  TagReaderReply *SendRequest(spb::tagreader::Message *message) {
+    message->set_id(next_id_++);
+    TagReaderReply *reply = new TagReaderReply(*message);
+    client_->SendRequest(reply);
+    return reply;
+  }
+
+  TagReaderReply *ReadFile(const QString &filename) {
+    spb::tagreader::Message message;
+    const QByteArray filename_data = filename.toUtf8();
+    message.mutable_read_file_request()->set_filename(filename_data.constData(), filename_data.length());
+    return SendRequest(&message);
+  }
+
+  TagReaderReply *ReadFiles(const QStringList &filenames) {
+    spb::tagreader::Message message;
+    for (const QString &filename : filenames) {
+      const QByteArray filename_data = filename.toUtf8();
+      message.mutable_read_files_request()->add_filenames(filename_data.constData(), filename_data.length());
+    }
+    return SendRequest(&message);
+  }
+
+  // The worker and the client share this thread, so run the event loop instead of blocking.
+  static bool WaitForReplies(const QList<TagReaderReply*> &replies) {
+    QElapsedTimer timer;
+    timer.start();
+    for (TagReaderReply *reply : replies) {
+      while (!reply->is_finished()) {
+        if (timer.elapsed() > kTimeout) return false;
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
+      }
+    }
+    return true;
+  }
+
+  static QTemporaryDir *temp_dir_;
+  static QStringList filenames_;
+
+  QLocalServer server_;
+  QLocalSocket *client_socket_ = nullptr;
+  QLocalSocket *worker_socket_ = nullptr;
+  TagReaderWorker *worker_ = nullptr;
+  TagReaderMessageHandler *client_ = nullptr;
+  int next_id_ = 0;
+};
+
+QTemporaryDir *TagReaderWorkerBenchmark::temp_dir_ = nullptr;
+QStringList TagReaderWorkerBenchmark::filenames_;
+
+// Reads the files with one request per file, and with batched requests.
+TEST_F(TagReaderWorkerBenchmark, ReadFiles) {
+
+  SongList songs_per_file;
+  {
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<TagReaderReply*> replies;
+    for (const QString &filename : filenames_) {
+      replies << ReadFile(filename);
+    }
+    ASSERT_TRUE(WaitForReplies(replies));
+
+    qLog(Info) << "Read" << filenames_.count() << "files with one request per file in" << timer.elapsed() << "ms";
+
+    for (TagReaderReply *reply : replies) {
+      Song song;
+      song.InitFromProtobuf(reply->message().read_file_response().metadata());
+      songs_per_file << song;
+      delete reply;
+    }
+  }
+
+  SongList songs_batched;
+  {
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<TagReaderReply*> replies;
+    for (int i = 0; i < filenames_.count(); i += TagReaderClient::kReadFilesBatchSize) {
+      replies << ReadFiles(filenames_.mid(i, TagReaderClient::kReadFilesBatchSize));
+    }
+    ASSERT_TRUE(WaitForReplies(replies));
+
+    qLog(Info) << "Read" << filenames_.count() << "files with" << replies.count() << "batched requests in" << timer.elapsed() << "ms";
+
+    for (TagReaderReply *reply : replies) {
+      QList<spb::tagreader::Message> messages;
+      while (reply->WaitForNextReplies(&messages)) {
+        for (const spb::tagreader::Message &message : messages) {
+          for (const spb::tagreader::ReadFilesResponse_File &file : message.read_files_response().files()) {
+            Song song;
+            song.InitFromProtobuf(file.metadata());
+            songs_batched << song;
+          }
+        }
+      }
+      delete reply;
+    }
+  }
+
+  ASSERT_EQ(songs_per_file.count(), songs_batched.count());
+  for (int i = 0; i < songs_per_file.count(); ++i) {
+    EXPECT_EQ(songs_per_file[i].title(), songs_batched[i].title());
+    EXPECT_EQ(songs_per_file[i].length_nanosec(), songs_batched[i].length_nanosec());
+  }
+
+}
+
+}  // namespace
@@ -0,0 +1,280 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <gtest/gtest.h>
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QTemporaryDir>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSharedMemory>
+#include <QBuffer>
+#include <QImage>
+#include <QRandomGenerator>
+
+#include "core/sharedmemoryring.h"
+#include "core/tagreaderclient.h"
+#include "tagreaderworker.h"
+#include "tagreaderlocal.h"
+#include "tagreadermessages.pb.h"
+
+// clazy:excludeall=non-pod-global-static
+
+namespace {
+
+// Runs a TagReaderWorker in process, connected to a client handler through a local socket, to compare per-file and batched reads.
+class TagReaderWorkerTest : public ::testing::Test {
+ protected:
+  static constexpr int kFileCount = 100;
+  static constexpr int kTimeout = 60000;
+
+  static void SetUpTestCase() {
+    temp_dir_ = new QTemporaryDir;
+    const QStringList sources = QStringList() << ":/audio/strawberry.mp3" << ":/audio/strawberry.ogg" << ":/audio/strawberry.spx";
+    for (int i = 0; i < kFileCount; ++i) {
+      const QString &source = sources[i % sources.count()];
+      const QString filename = QString("%1/%2.%3").arg(temp_dir_->path()).arg(i).arg(QFileInfo(source).suffix());
+      if (QFile::copy(source, filename)) {
+        filenames_ << filename;
+      }
+    }
+  }
+
+  static void TearDownTestCase() {
+    filenames_.clear();
+    delete temp_dir_;
+    temp_dir_ = nullptr;
+  }
+
+  void SetUp() override {
+    ASSERT_EQ(kFileCount, filenames_.count());
+
+    ASSERT_TRUE(server_.listen(QString("strawberry_tagreaderworker_test_%1").arg(QCoreApplication::applicationPid())));
+    client_socket_ = new QLocalSocket;
+    client_socket_->connectToServer(server_.fullServerName());
+    ASSERT_TRUE(server_.waitForNewConnection(5000));
+    worker_socket_ = server_.nextPendingConnection();
+    ASSERT_TRUE(client_socket_->waitForConnected(5000));
+
+    worker_ = new TagReaderWorker(worker_socket_);
+    client_ = new TagReaderMessageHandler(client_socket_, nullptr);
+  }
+
+  void TearDown() override {
+    delete client_;
+    delete worker_;
+    delete client_socket_;
+  }
+
+  TagReaderReply *SendRequest(spb::tagreader::Message *message) {
+    message->set_id(next_id_++);
+    TagReaderReply *reply = new TagReaderReply(*message);
+    client_->SendRequest(reply);
+    return reply;
+  }
+
+  TagReaderReply *ReadFile(const QString &filename) {
+    spb::tagreader::Message message;
+    const QByteArray filename_data = filename.toUtf8();
+    message.mutable_read_file_request()->set_filename(filename_data.constData(), filename_data.length());
+    return SendRequest(&message);
+  }
+
+  TagReaderReply *ReadFiles(const QStringList &filenames) {
+    spb::tagreader::Message message;
+    for (const QString &filename : filenames) {
+      const QByteArray filename_data = filename.toUtf8();
+      message.mutable_read_files_request()->add_filenames(filename_data.constData(), filename_data.length());
+    }
+    return SendRequest(&message);
+  }
+
+  // The worker and the client share this thread, so run the event loop instead of blocking.
+  static bool WaitForReplies(const QList<TagReaderReply*> &replies) {
+    QElapsedTimer timer;
+    timer.start();
+    for (TagReaderReply *reply : replies) {
+      while (!reply->is_finished()) {
+        if (timer.elapsed() > kTimeout) return false;
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
+      }
+    }
+    return true;
+  }
+
+  static QTemporaryDir *temp_dir_;
+  static QStringList filenames_;
+
+  QLocalServer server_;
+  QLocalSocket *client_socket_ = nullptr;
+  QLocalSocket *worker_socket_ = nullptr;
+  TagReaderWorker *worker_ = nullptr;
+  TagReaderMessageHandler *client_ = nullptr;
+  int next_id_ = 0;
+};
+
+QTemporaryDir *TagReaderWorkerTest::temp_dir_ = nullptr;
+QStringList TagReaderWorkerTest::filenames_;
+
+TEST_F(TagReaderWorkerTest, ReadFilesPartialReplies) {
+
+  const QStringList filenames = filenames_.mid(0, 100);
+
+  TagReaderReply *reply = ReadFiles(filenames);
+  ASSERT_TRUE(WaitForReplies(QList<TagReaderReply*>() << reply));
+
+  QList<spb::tagreader::Message> messages;
+  ASSERT_TRUE(reply->WaitForNextReplies(&messages));
+
+  // One partial reply for each kReadFilesPartialReplySize files, the final reply has the rest.
+  EXPECT_EQ(13, messages.count());
+  QStringList read_filenames;
+  for (const spb::tagreader::Message &message : messages) {
+    for (const spb::tagreader::ReadFilesResponse_File &file : message.read_files_response().files()) {
+      EXPECT_TRUE(file.success());
+      read_filenames << QString::fromStdString(file.filename());
+    }
+  }
+  EXPECT_EQ(filenames, read_filenames);
+  EXPECT_FALSE(messages.last().read_files_response().partial());
+
+  // Nothing more to take.
+  EXPECT_FALSE(reply->WaitForNextReplies(&messages));
+
+  // Only the final reply counts as answered.
+  EXPECT_EQ(0, client_->pending_replies_count());
+  EXPECT_EQ(1, client_->replies_count());
+
+  delete reply;
+
+}
+
+TEST_F(TagReaderWorkerTest, SharedMemoryEmbeddedArt) {
+
+  QSharedMemory shared_memory;
+  shared_memory.setKey(QString("strawberry_tagreaderworker_test_shm_%1").arg(QCoreApplication::applicationPid()));
+  ASSERT_TRUE(shared_memory.create(SharedMemoryRing::kSegmentSize));
+  SharedMemoryRing::Initialize(&shared_memory);
+
+  client_->SetSharedMemory(&shared_memory, false);
+  worker_->SetSharedMemory(&shared_memory, true);
+
+  QElapsedTimer timer;
+  timer.start();
+  while (!client_->is_shared_memory_attached() && timer.elapsed() < kTimeout) {
+    QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
+  }
+  ASSERT_TRUE(client_->is_shared_memory_attached());
+
+  const QString filename = temp_dir_->path() + "/embeddedart.mp3";
+  ASSERT_TRUE(QFile::copy(filenames_.first(), filename));
+  QFile::setPermissions(filename, QFile::ReadOwner | QFile::WriteOwner);
+
+  // A noise image is large enough as PNG to go through the shared memory both ways.
+  QImage image(512, 512, QImage::Format_RGB32);
+  QRandomGenerator::global()->fillRange(reinterpret_cast<quint32*>(image.bits()), image.sizeInBytes() / 4);
+  QByteArray cover_data;
+  QBuffer buffer(&cover_data);
+  ASSERT_TRUE(buffer.open(QIODevice::WriteOnly));
+  ASSERT_TRUE(image.save(&buffer, "PNG"));
+  buffer.close();
+  ASSERT_GT(cover_data.size(), TagReaderMessageHandler::kSharedMemoryThreshold);
+
+  {
+    spb::tagreader::Message message;
+    const QByteArray filename_data = filename.toUtf8();
+    message.mutable_save_embedded_art_request()->set_filename(filename_data.constData(), filename_data.length());
+    message.mutable_save_embedded_art_request()->set_cover_data(cover_data.constData(), cover_data.size());
+    message.mutable_save_embedded_art_request()->set_cover_mime_type("image/png");
+    TagReaderReply *reply = SendRequest(&message);
+    ASSERT_TRUE(WaitForReplies(QList<TagReaderReply*>() << reply));
+    EXPECT_TRUE(reply->message().save_embedded_art_response().success());
+    delete reply;
+  }
+
+  {
+    spb::tagreader::Message message;
+    const QByteArray filename_data = filename.toUtf8();
+    message.mutable_load_embedded_art_request()->set_filename(filename_data.constData(), filename_data.length());
+    TagReaderReply *reply = SendRequest(&message);
+    ASSERT_TRUE(WaitForReplies(QList<TagReaderReply*>() << reply));
+    const std::string &data = reply->message().load_embedded_art_response().data();
+    EXPECT_EQ(cover_data, QByteArray(data.data(), static_cast<qint64>(data.size())));
+    delete reply;
+  }
+
+  delete client_;
+  client_ = nullptr;
+  delete worker_;
+  worker_ = nullptr;
+
+}
+
+TEST_F(TagReaderWorkerTest, InProcessMatchesWorker) {
+
+  const QStringList filenames = filenames_.mid(0, 30);
+
+  TagReaderReply *reply = ReadFiles(filenames);
+  ASSERT_TRUE(WaitForReplies(QList<TagReaderReply*>() << reply));
+  QList<spb::tagreader::Message> messages;
+  ASSERT_TRUE(reply->WaitForNextReplies(&messages));
+  delete reply;
+
+  QList<spb::tagreader::ReadFilesResponse_File> worker_files;
+  for (const spb::tagreader::Message &message : messages) {
+    for (const spb::tagreader::ReadFilesResponse_File &file : message.read_files_response().files()) {
+      worker_files << file;
+    }
+  }
+
+  TagReaderLocal local_reader;
+  spb::tagreader::Message request;
+  for (const QString &filename : filenames) {
+    request.mutable_read_files_request()->add_filenames(filename.toStdString());
+  }
+  ASSERT_TRUE(local_reader.CanHandle(request));
+  spb::tagreader::Message local_reply;
+  local_reader.HandleMessage(request, &local_reply);
+
+  ASSERT_EQ(worker_files.count(), local_reply.read_files_response().files_size());
+  for (int i = 0; i < worker_files.count(); ++i) {
+    const spb::tagreader::ReadFilesResponse_File &local_file = local_reply.read_files_response().files(i);
+    EXPECT_EQ(worker_files[i].filename(), local_file.filename());
+    EXPECT_EQ(worker_files[i].success(), local_file.success());
+    EXPECT_EQ(worker_files[i].metadata().SerializeAsString(), local_file.metadata().SerializeAsString());
+  }
+
+  // Game music files are left to the worker.
+  spb::tagreader::Message gme_request;
+  gme_request.mutable_read_file_request()->set_filename(QString(temp_dir_->path() + "/song.spc").toStdString());
+  EXPECT_FALSE(local_reader.CanHandle(gme_request));
+
+}
+
+}  // namespace
@@ -0,0 +1,121 @@
+/*
+ * Strawberry Music Player
+ * Copyright 2024, Jonas Kvinge <jonas@jkvinge.net>
+ *
+ * Strawberry is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Strawberry is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Strawberry.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <atomic>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include <QObject>
+#include <QThread>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QByteArray>
+#include <QTemporaryDir>
+
+#include "core/workerpool.h"
+#include "core/tagreaderclient.h"
+#include "tagreadermessages.pb.h"
+
+// clazy:excludeall=non-pod-global-static
+
+namespace {
+
+// Runs a pool of tagreader workers on its own thread, like TagReaderClient does.
+class WorkerPoolTest : public ::testing::Test {
+ protected:
+  static constexpr int kTimeout = 60000;
+
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.isValid());
+    filename_ = temp_dir_.path() + "/strawberry.mp3";
+    ASSERT_TRUE(QFile::copy(":/audio/strawberry.mp3", filename_));
+
+    pool_thread_ = new QThread;
+    pool_ = new WorkerPool<TagReaderMessageHandler>;
+    pool_->SetExecutableName(TAGREADER_WORKER_EXECUTABLE);
+    pool_->SetWorkerCount(1);
+    pool_->SetMaxWorkerCount(2);
+    pool_->moveToThread(pool_thread_);
+    pool_thread_->start();
+    pool_->Start();
+  }
+
+  void TearDown() override {
+    // Deleting the pool aborts the requests it still has, which also ends a waiter blocked on them.
+    if (pool_) {
+      WorkerPool<TagReaderMessageHandler> *pool = pool_;
+      QMetaObject::invokeMethod(pool, [pool]() {
+        delete pool;
+        QThread::currentThread()->quit();
+      });
+      pool_thread_->wait();
+    }
+    if (waiter_) {
+      waiter_->wait();
+      delete waiter_;
+    }
+    delete pool_thread_;
+    qDeleteAll(replies_);
+  }
+
+  TagReaderReply *IsMediaFile() {
+    spb::tagreader::Message message;
+    const QByteArray filename_data = filename_.toUtf8();
+    message.mutable_is_media_file_request()->set_filename(filename_data.constData(), filename_data.length());
+    return pool_->SendMessageWithReply(&message);
+  }
+
+  QTemporaryDir temp_dir_;
+  QString filename_;
+  QThread *pool_thread_ = nullptr;
+  WorkerPool<TagReaderMessageHandler> *pool_ = nullptr;
+  QThread *waiter_ = nullptr;
+  QList<TagReaderReply*> replies_;
+};
+
+TEST_F(WorkerPoolTest, MoreRequestsThanWorkersTake) {
+
+  // Each worker only takes a few requests at a time, so most of these wait in the pool's queue.
+  constexpr int kRequestCount = 100;
+
+  // The requests are sent all at once and waited on from a thread without an event loop, like ReadFilesBlocking() from a QtConcurrent thread.
+  std::atomic<int> successful(0);
+  waiter_ = QThread::create([this, &successful]() {
+    for (int i = 0; i < kRequestCount; ++i) {
+      replies_ << IsMediaFile();
+    }
+    for (TagReaderReply *reply : std::as_const(replies_)) {
+      if (reply->WaitForFinished() && reply->message().is_media_file_response().success()) {
+        ++successful;
+      }
+    }
+  });
+  waiter_->start();
+
+  ASSERT_TRUE(waiter_->wait(kTimeout));
+  EXPECT_EQ(kRequestCount, successful);
+  EXPECT_EQ(0, pool_->QueuedRequests());
+
+}
+
+}  // namespace